@@ -124,24 +124,6 @@ Context::Context() :
 	_session(nullptr)
 {
 	check(sr_init(&_structure));
-
-	if (struct sr_dev_driver **driver_list = sr_driver_list(_structure))
-		for (int i = 0; driver_list[i]; i++) {
-			unique_ptr<Driver> driver {new Driver{driver_list[i]}};
-			_drivers.emplace(driver->name(), move(driver));
-		}
-
-	if (const struct sr_input_module **input_list = sr_input_list())
-		for (int i = 0; input_list[i]; i++) {
-			unique_ptr<InputFormat> input {new InputFormat{input_list[i]}};
-			_input_formats.emplace(input->name(), move(input));
-		}
-
-	if (const struct sr_output_module **output_list = sr_output_list())
-		for (int i = 0; output_list[i]; i++) {
-			unique_ptr<OutputFormat> output {new OutputFormat{output_list[i]}};
-			_output_formats.emplace(output->name(), move(output));
-		}
 }
 
 string Context::package_version()
@@ -156,6 +138,14 @@ string Context::lib_version()
 
 map<string, shared_ptr<Driver>> Context::drivers()
 {
+	/* Only wrap the drivers once they are asked for. */
+	if (_drivers.empty())
+		if (struct sr_dev_driver **driver_list = sr_driver_list(_structure))
+			for (int i = 0; driver_list[i]; i++) {
+				unique_ptr<Driver> driver {new Driver{driver_list[i]}};
+				_drivers.emplace(driver->name(), move(driver));
+			}
+
 	map<string, shared_ptr<Driver>> result;
 	for (const auto &entry: _drivers) {
 		const auto &name = entry.first;
@@ -167,6 +157,13 @@ map<string, shared_ptr<Driver>> Context::drivers()
 
 map<string, shared_ptr<InputFormat>> Context::input_formats()
 {
+	if (_input_formats.empty())
+		if (const struct sr_input_module **input_list = sr_input_list())
+			for (int i = 0; input_list[i]; i++) {
+				unique_ptr<InputFormat> input {new InputFormat{input_list[i]}};
+				_input_formats.emplace(input->name(), move(input));
+			}
+
 	map<string, shared_ptr<InputFormat>> result;
 	for (const auto &entry: _input_formats) {
 		const auto &name = entry.first;
@@ -178,6 +175,13 @@ map<string, shared_ptr<InputFormat>> Context::input_formats()
 
 map<string, shared_ptr<OutputFormat>> Context::output_formats()
 {
+	if (_output_formats.empty())
+		if (const struct sr_output_module **output_list = sr_output_list())
+			for (int i = 0; output_list[i]; i++) {
+				unique_ptr<OutputFormat> output {new OutputFormat{output_list[i]}};
+				_output_formats.emplace(output->name(), move(output));
+			}
+
 	map<string, shared_ptr<OutputFormat>> result;
 	for (const auto &entry: _output_formats) {
 		const auto &name = entry.first;
@@ -517,6 +521,24 @@ Glib::VariantBase Configurable::config_get(const ConfigKey *key) const
 	return Glib::VariantBase(data);
 }
 
+map<const ConfigKey *, Glib::VariantBase> Configurable::config_get_multi(
+	const vector<const ConfigKey *> &keys) const
+{
+	vector<struct sr_config> configs(keys.size());
+	map<const ConfigKey *, Glib::VariantBase> result;
+
+	for (size_t i = 0; i < keys.size(); i++)
+		configs[i].key = keys[i]->id();
+	check(sr_config_get_multi(
+		config_driver, config_sdi, config_channel_group,
+		configs.data(), configs.size()));
+	for (size_t i = 0; i < keys.size(); i++)
+		if (configs[i].data)
+			result[keys[i]] = Glib::VariantBase(configs[i].data);
+
+	return result;
+}
+
 void Configurable::config_set(const ConfigKey *key, const Glib::VariantBase &value)
 {
 	check(sr_config_set(
@@ -321,6 +321,11 @@ public:
 	/** Read configuration for the given key.
 	 * @param key ConfigKey to read. */
 	Glib::VariantBase config_get(const ConfigKey *key) const;
+	/** Read configuration for several keys at once.
+	 * Keys which could not be read are missing from the result.
+	 * @param keys ConfigKeys to read. */
+	map<const ConfigKey *, Glib::VariantBase> config_get_multi(
+		const vector<const ConfigKey *> &keys) const;
 	/** Set configuration for the given key to a specified value.
 	 * @param key ConfigKey to set.
 	 * @param value Value to set. */
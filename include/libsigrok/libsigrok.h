@@ -986,6 +986,65 @@ enum sr_configkey {
 	/** Trigger level. */
 	SR_CONF_TRIGGER_LEVEL,
 
+	/**
+	 * Adapt the size and number of USB transfers to the host load
+	 * at runtime.
+	 */
+	SR_CONF_ADAPTIVE_TRANSFERS,
+
+	/** Lower and upper bound of the USB transfer size in bytes. */
+	SR_CONF_TRANSFER_SIZE_RANGE,
+
+	/** Lower and upper bound of the number of USB transfers in flight. */
+	SR_CONF_NUM_TRANSFERS_RANGE,
+
+	/** Current USB transfer size in bytes. */
+	SR_CONF_TRANSFER_SIZE,
+
+	/** Current number of USB transfers in flight. */
+	SR_CONF_NUM_TRANSFERS,
+
+	/**
+	 * Send analog data in the device's native sample encoding.
+	 *
+	 * When enabled, analog packets carry the raw ADC values along with
+	 * the encoding's scale and offset, instead of float values.
+	 */
+	SR_CONF_ANALOG_NATIVE,
+
+	/**
+	 * Generate data as fast as possible instead of pacing it to the
+	 * samplerate, and report the achieved throughput.
+	 */
+	SR_CONF_BENCHMARK,
+
+	/** Size in bytes of the logic packets sent to the session. */
+	SR_CONF_PACKET_SIZE,
+
+	/** Size in bytes of one logic sample. */
+	SR_CONF_LOGIC_UNITSIZE,
+
+	/** Mean number of samples between edges of a generated signal. */
+	SR_CONF_EDGE_INTERVAL,
+
+	/** Mean number of samples between glitches, or 0 for none. */
+	SR_CONF_GLITCH_INTERVAL,
+
+	/** Number of bytes per burst of generated bus traffic. */
+	SR_CONF_BURST_LENGTH,
+
+	/** Peak amplitude of noise added to generated analog signals. */
+	SR_CONF_NOISE_LEVEL,
+
+	/** Number of worker threads generating data, or 0 for none. */
+	SR_CONF_WORKER_THREADS,
+
+	/**
+	 * Maximum number of consecutive readings to send in one analog
+	 * packet, or 0 to send every reading on its own.
+	 */
+	SR_CONF_COALESCE_SAMPLES,
+
 	/* Update sr_key_info_config[] (hwdriver.c) upon changes! */
 
 	/*--- Special stuff -------------------------------------------------*/
@@ -1165,6 +1224,24 @@ struct sr_dev_driver {
 	/* Dynamic */
 	/** Device driver context, considered private. Initialized by init(). */
 	void *context;
+
+	/* Added after the initial API, kept last for binary compatibility. */
+	/** Query values of several configuration keys at once (optional).
+	 *  Fills in the data field of every entry it could read, and leaves
+	 *  the others NULL. Returns SR_ERR_NA if this device can't combine
+	 *  queries.
+	 *  @see sr_config_get_multi().
+	 */
+	int (*config_get_multi) (struct sr_config *configs,
+			unsigned int num_configs,
+			const struct sr_dev_inst *sdi,
+			const struct sr_channel_group *cg);
+	/** Set values of several configuration keys at once (optional).
+	 *  @see sr_config_set_multi(). */
+	int (*config_set_multi) (const struct sr_config *configs,
+			unsigned int num_configs,
+			const struct sr_dev_inst *sdi,
+			const struct sr_channel_group *cg);
 };
 
 /** Serial port descriptor. */
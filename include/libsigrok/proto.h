@@ -99,11 +99,17 @@ SR_API int sr_dev_inst_channel_add(struct sr_dev_inst *sdi, int index, int type,
 
 /*--- hwdriver.c ------------------------------------------------------------*/
 
+typedef void (*sr_driver_scan_callback)(struct sr_dev_driver *driver,
+		GSList *devices, void *cb_data);
+
 SR_API struct sr_dev_driver **sr_driver_list(const struct sr_context *ctx);
 SR_API int sr_driver_init(struct sr_context *ctx,
 		struct sr_dev_driver *driver);
 SR_API GArray *sr_driver_scan_options_list(const struct sr_dev_driver *driver);
 SR_API GSList *sr_driver_scan(struct sr_dev_driver *driver, GSList *options);
+SR_API int sr_driver_scan_all(struct sr_context *ctx,
+		struct sr_dev_driver **drivers, GSList *options,
+		int64_t timeout_us, sr_driver_scan_callback cb, void *cb_data);
 SR_API int sr_config_get(const struct sr_dev_driver *driver,
 		const struct sr_dev_inst *sdi,
 		const struct sr_channel_group *cg,
@@ -111,6 +117,13 @@ SR_API int sr_config_get(const struct sr_dev_driver *driver,
 SR_API int sr_config_set(const struct sr_dev_inst *sdi,
 		const struct sr_channel_group *cg,
 		uint32_t key, GVariant *data);
+SR_API int sr_config_get_multi(const struct sr_dev_driver *driver,
+		const struct sr_dev_inst *sdi,
+		const struct sr_channel_group *cg,
+		struct sr_config *configs, unsigned int num_configs);
+SR_API int sr_config_set_multi(const struct sr_dev_inst *sdi,
+		const struct sr_channel_group *cg,
+		struct sr_config *configs, unsigned int num_configs);
 SR_API int sr_config_commit(const struct sr_dev_inst *sdi);
 SR_API int sr_config_list(const struct sr_dev_driver *driver,
 		const struct sr_dev_inst *sdi,
@@ -119,6 +132,11 @@ SR_API int sr_config_list(const struct sr_dev_driver *driver,
 SR_API const struct sr_key_info *sr_key_info_get(int keytype, uint32_t key);
 SR_API const struct sr_key_info *sr_key_info_name_get(int keytype, const char *keyid);
 
+/*--- discovery.c -----------------------------------------------------------*/
+
+SR_API int sr_discovery_cache_enable(struct sr_context *ctx, const char *path);
+SR_API int sr_discovery_cache_invalidate(struct sr_context *ctx);
+
 /*--- session.c -------------------------------------------------------------*/
 
 typedef void (*sr_session_stopped_callback)(void *data);
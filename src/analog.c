@@ -207,10 +207,8 @@ SR_API int sr_analog_to_float(const struct sr_datafeed_analog *analog,
 					outbuf[i] += offset;
 				}
 			} else {
-				for (unsigned int i = 0; i < count; i++) {
-					outbuf[i] = scale * R8(data8 + i);
-					outbuf[i] += offset;
-				}
+				sr_conv_u8_to_float((const uint8_t *)data8,
+					outbuf, count, scale, offset);
 			}
 			break;
 		case 2:
@@ -225,10 +223,8 @@ SR_API int sr_analog_to_float(const struct sr_datafeed_analog *analog,
 					outbuf[i] += offset;
 				}
 			} else if (is_signed) {
-				for (unsigned int i = 0; i < count; i++) {
-					outbuf[i] = scale * RL16S(&data16[i]);
-					outbuf[i] += offset;
-				}
+				sr_conv_s16le_to_float((const uint8_t *)data16,
+					outbuf, count, scale, offset);
 			} else {
 				for (unsigned int i = 0; i < count; i++) {
 					outbuf[i] = scale * RL16(&data16[i]);
@@ -503,11 +503,27 @@ static int sanity_check_all_transform_modules(void)
 	return ret;
 }
 
+/*
+ * The sanity checks only catch mistakes in libsigrok itself. They are
+ * run when debugging, or when asked to, e.g. by the unit tests.
+ */
+static gboolean want_sanity_checks(void)
+{
+	return sr_log_loglevel_get() >= SR_LOG_DBG
+		|| g_getenv("SIGROK_SANITY_CHECKS");
+}
+
 /**
  * Initialize libsigrok.
  *
  * This function must be called before any other libsigrok function.
  *
+ * Initialization is kept cheap: drivers are initialized when they are
+ * first used (see sr_driver_init()), and libusb along with the first
+ * driver. The internal consistency checks of all drivers and modules
+ * only run at log level SR_LOG_DBG and above, or if the environment
+ * variable SIGROK_SANITY_CHECKS is set.
+ *
  * @param ctx Pointer to a libsigrok context struct pointer. Must not be NULL.
  *            This will be a pointer to a newly allocated libsigrok context
  *            object upon success, and is undefined upon errors.
@@ -527,7 +543,8 @@ SR_API int sr_init(struct sr_context **ctx)
 	WSADATA wsadata;
 #endif
 
-	print_versions();
+	if (sr_log_loglevel_get() >= SR_LOG_DBG)
+		print_versions();
 
 	if (!ctx) {
 		sr_err("%s(): libsigrok context was NULL.", __func__);
@@ -535,27 +552,31 @@ SR_API int sr_init(struct sr_context **ctx)
 	}
 
 	context = g_malloc0(sizeof(struct sr_context));
+	g_mutex_init(&context->resource_mutex);
+	g_mutex_init(&context->late_mutex);
 
 	sr_drivers_init(context);
 
-	if (sanity_check_all_drivers(context) < 0) {
-		sr_err("Internal driver error(s), aborting.");
-		return ret;
-	}
+	if (want_sanity_checks()) {
+		if (sanity_check_all_drivers(context) < 0) {
+			sr_err("Internal driver error(s), aborting.");
+			goto done;
+		}
 
-	if (sanity_check_all_input_modules() < 0) {
-		sr_err("Internal input module error(s), aborting.");
-		return ret;
-	}
+		if (sanity_check_all_input_modules() < 0) {
+			sr_err("Internal input module error(s), aborting.");
+			goto done;
+		}
 
-	if (sanity_check_all_output_modules() < 0) {
-		sr_err("Internal output module error(s), aborting.");
-		return ret;
-	}
+		if (sanity_check_all_output_modules() < 0) {
+			sr_err("Internal output module error(s), aborting.");
+			goto done;
+		}
 
-	if (sanity_check_all_transform_modules() < 0) {
-		sr_err("Internal transform module error(s), aborting.");
-		return ret;
+		if (sanity_check_all_transform_modules() < 0) {
+			sr_err("Internal transform module error(s), aborting.");
+			goto done;
+		}
 	}
 
 #ifdef _WIN32
@@ -566,27 +587,64 @@ SR_API int sr_init(struct sr_context **ctx)
 	}
 #endif
 
-#ifdef HAVE_LIBUSB_1_0
-	ret = libusb_init(&context->libusb_ctx);
-	if (LIBUSB_SUCCESS != ret) {
-		sr_err("libusb_init() returned %s.", libusb_error_name(ret));
-		ret = SR_ERR;
-		goto done;
-	}
-#endif
 	sr_resource_set_hooks(context, NULL, NULL, NULL, NULL);
 
 	*ctx = context;
 	context = NULL;
 	ret = SR_OK;
 
-#if defined(HAVE_LIBUSB_1_0) || defined(_WIN32)
 done:
-#endif
+	if (context) {
+		g_free(sr_driver_list(context));
+		g_mutex_clear(&context->resource_mutex);
+		g_mutex_clear(&context->late_mutex);
+	}
 	g_free(context);
 	return ret;
 }
 
+/**
+ * Initialize libusb for a libsigrok context, unless that was done already.
+ *
+ * Called before the first driver is initialized, so that programs which
+ * don't use any hardware don't pay for libusb's device enumeration.
+ *
+ * @param ctx The libsigrok context.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR libusb failed to initialize.
+ *
+ * @private
+ */
+SR_PRIV int sr_libusb_init(struct sr_context *ctx)
+{
+#ifdef HAVE_LIBUSB_1_0
+	static GMutex mutex;
+	int ret;
+
+	g_mutex_lock(&mutex);
+	ret = SR_OK;
+	if (!ctx->libusb_ctx) {
+		ret = libusb_init(&ctx->libusb_ctx);
+		if (ret != LIBUSB_SUCCESS) {
+			sr_err("libusb_init() returned %s.",
+				libusb_error_name(ret));
+			ctx->libusb_ctx = NULL;
+			ret = SR_ERR;
+		} else {
+			sr_dbg("Initialized libusb.");
+		}
+	}
+	g_mutex_unlock(&mutex);
+
+	return ret;
+#else
+	(void)ctx;
+
+	return SR_OK;
+#endif
+}
+
 /**
  * Shutdown libsigrok.
  *
@@ -604,6 +662,12 @@ SR_API int sr_exit(struct sr_context *ctx)
 		return SR_ERR;
 	}
 
+	/* Wait for driver scans which timed out. */
+	if (ctx->scan_pool)
+		g_thread_pool_free(ctx->scan_pool, FALSE, TRUE);
+	sr_scan_adopt_late(ctx);
+
+	sr_discovery_free(ctx);
 	sr_hw_cleanup_all(ctx);
 
 #ifdef _WIN32
@@ -611,9 +675,13 @@ SR_API int sr_exit(struct sr_context *ctx)
 #endif
 
 #ifdef HAVE_LIBUSB_1_0
-	libusb_exit(ctx->libusb_ctx);
+	if (ctx->libusb_ctx)
+		libusb_exit(ctx->libusb_ctx);
 #endif
 
+	sr_resource_images_free(ctx);
+	g_mutex_clear(&ctx->resource_mutex);
+	g_mutex_clear(&ctx->late_mutex);
 	g_free(sr_driver_list(ctx));
 	g_free(ctx);
 
@@ -23,6 +23,11 @@
  * Conversion helper functions.
  */
 
+#include <config.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <string.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
 
@@ -105,3 +110,164 @@ SR_API int sr_a2l_schmitt_trigger(const struct sr_datafeed_analog *analog,
 
 	return SR_OK;
 }
+
+/**
+ * Store count copies of a sample at dst.
+ *
+ * This is used by drivers that expand run-length encoded captures. The
+ * filled region doubles with each copy, so long runs take few memcpy()s.
+ *
+ * @param[out] dst The output buffer. Must provide space for count * size
+ *                 bytes.
+ * @param[in] sample The sample to replicate, size bytes.
+ * @param[in] size The size of one sample in bytes.
+ * @param[in] count The number of copies to store.
+ *
+ * @private
+ */
+SR_PRIV void sr_conv_fill_samples(uint8_t *dst, const uint8_t *sample,
+		size_t size, size_t count)
+{
+	size_t done, n;
+
+	if (count == 0)
+		return;
+
+	memcpy(dst, sample, size);
+	for (done = 1; done < count; done += n) {
+		n = MIN(done, count - done);
+		memcpy(dst + done * size, dst, n * size);
+	}
+}
+
+/**
+ * Split a stream of interleaved byte pairs into two separate streams.
+ *
+ * This is used by drivers whose hardware delivers e.g. a logic byte and
+ * an ADC byte per sample clock, and which need to send both as separate
+ * packets.
+ *
+ * @param[in] input The interleaved input, 2 * count bytes.
+ * @param[out] even Receives the bytes at even input offsets. Must provide
+ *                  space for count bytes.
+ * @param[out] odd Receives the bytes at odd input offsets. Must provide
+ *                 space for count bytes.
+ * @param[in] count The number of byte pairs to process.
+ *
+ * @private
+ */
+SR_PRIV void sr_conv_deinterleave_u8(const uint8_t *input, uint8_t *even,
+		uint8_t *odd, size_t count)
+{
+	size_t i;
+#ifdef __SSE2__
+	__m128i a, b, mask;
+
+	mask = _mm_set1_epi16(0x00ff);
+	for (i = 0; i + 16 <= count; i += 16) {
+		a = _mm_loadu_si128((const __m128i *)(input + 2 * i));
+		b = _mm_loadu_si128((const __m128i *)(input + 2 * i + 16));
+		_mm_storeu_si128((__m128i *)(even + i), _mm_packus_epi16(
+			_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+		_mm_storeu_si128((__m128i *)(odd + i), _mm_packus_epi16(
+			_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+	}
+#else
+	i = 0;
+#endif
+
+	for (; i < count; i++) {
+		even[i] = input[2 * i];
+		odd[i] = input[2 * i + 1];
+	}
+}
+
+/**
+ * Convert unsigned 8-bit samples to float, applying a linear transform.
+ *
+ * Each output value is computed as input * scale + offset, which is the
+ * same as sr_analog_to_float() does for an unsigned 8-bit encoding.
+ *
+ * @param[in] input The input samples.
+ * @param[out] output The converted output values. Must provide space for
+ *                    count floats.
+ * @param[in] count The number of samples to process.
+ * @param[in] scale The factor to multiply each sample by.
+ * @param[in] offset The value to add after scaling.
+ *
+ * @private
+ */
+SR_PRIV void sr_conv_u8_to_float(const uint8_t *input, float *output,
+		size_t count, float scale, float offset)
+{
+	size_t i;
+#ifdef __SSE2__
+	__m128i v, lo, hi, zero;
+	__m128 vscale, voffset;
+
+	zero = _mm_setzero_si128();
+	vscale = _mm_set1_ps(scale);
+	voffset = _mm_set1_ps(offset);
+	for (i = 0; i + 16 <= count; i += 16) {
+		v = _mm_loadu_si128((const __m128i *)(input + i));
+		lo = _mm_unpacklo_epi8(v, zero);
+		hi = _mm_unpackhi_epi8(v, zero);
+		_mm_storeu_ps(output + i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+			_mm_unpacklo_epi16(lo, zero)), vscale), voffset));
+		_mm_storeu_ps(output + i + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+			_mm_unpackhi_epi16(lo, zero)), vscale), voffset));
+		_mm_storeu_ps(output + i + 8, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+			_mm_unpacklo_epi16(hi, zero)), vscale), voffset));
+		_mm_storeu_ps(output + i + 12, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+			_mm_unpackhi_epi16(hi, zero)), vscale), voffset));
+	}
+#else
+	i = 0;
+#endif
+
+	for (; i < count; i++)
+		output[i] = scale * input[i] + offset;
+}
+
+/**
+ * Convert signed 16-bit little-endian samples to float, applying a linear
+ * transform.
+ *
+ * Each output value is computed as input * scale + offset, which is the
+ * same as sr_analog_to_float() does for a signed 16-bit little-endian
+ * encoding. The input need not be aligned.
+ *
+ * @param[in] input The input samples, 2 * count bytes.
+ * @param[out] output The converted output values. Must provide space for
+ *                    count floats.
+ * @param[in] count The number of samples to process.
+ * @param[in] scale The factor to multiply each sample by.
+ * @param[in] offset The value to add after scaling.
+ *
+ * @private
+ */
+SR_PRIV void sr_conv_s16le_to_float(const uint8_t *input, float *output,
+		size_t count, float scale, float offset)
+{
+	size_t i;
+#ifdef __SSE2__
+	__m128i v;
+	__m128 vscale, voffset;
+
+	vscale = _mm_set1_ps(scale);
+	voffset = _mm_set1_ps(offset);
+	for (i = 0; i + 8 <= count; i += 8) {
+		v = _mm_loadu_si128((const __m128i *)(input + 2 * i));
+		/* Sign extend by shifting each sample down from the top. */
+		_mm_storeu_ps(output + i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+			_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), vscale), voffset));
+		_mm_storeu_ps(output + i + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+			_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), vscale), voffset));
+	}
+#else
+	i = 0;
+#endif
+
+	for (; i < count; i++)
+		output[i] = scale * RL16S(&input[2 * i]) + offset;
+}
@@ -0,0 +1,613 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#ifdef HAVE_LIBSERIALPORT
+#include <libserialport.h>
+#endif
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+/** @cond PRIVATE */
+#define LOG_PREFIX "discovery"
+/** @endcond */
+
+/**
+ * @file
+ *
+ * Persistent cache of device discovery results.
+ */
+
+/**
+ * @addtogroup grp_driver
+ *
+ * @{
+ */
+
+/** @cond PRIVATE */
+#define DISCOVERY_GROUP		"discovery"
+#define DISCOVERY_VERSION	1
+
+struct sr_discovery {
+	char *path;
+	/* Fingerprint of the system the entries were recorded on. */
+	char *fingerprint;
+	/* List of struct sr_discovery_entry. */
+	GSList *entries;
+	/* Names of the drivers whose scans the entries were recorded from. */
+	GSList *drivers;
+	/* Set when a USB device arrived or left since the entries were made. */
+	gint changed;
+#ifdef HAVE_LIBUSB_1_0
+	libusb_context *libusb_ctx;
+	gboolean hotplug;
+	libusb_hotplug_callback_handle hotplug_handle;
+#endif
+};
+/** @endcond */
+
+static void entry_free(void *data)
+{
+	struct sr_discovery_entry *entry;
+
+	entry = data;
+	g_free(entry->driver);
+	g_free(entry->conn);
+	g_free(entry->serialcomm);
+	g_free(entry->connection_id);
+	g_free(entry->serial_num);
+	g_free(entry);
+}
+
+static void discovery_clear(struct sr_discovery *discovery)
+{
+	g_slist_free_full(discovery->entries, entry_free);
+	discovery->entries = NULL;
+	g_slist_free_full(discovery->drivers, g_free);
+	discovery->drivers = NULL;
+	g_free(discovery->fingerprint);
+	discovery->fingerprint = NULL;
+}
+
+static gboolean has_driver(struct sr_discovery *discovery, const char *name)
+{
+	return g_slist_find_custom(discovery->drivers, name,
+		(GCompareFunc)strcmp) != NULL;
+}
+
+/*
+ * Summary of the attached USB devices and serial ports. Devices which
+ * aren't attached to the same ports, or have been re-enumerated, give
+ * a different fingerprint.
+ */
+static char *fingerprint(struct sr_context *ctx)
+{
+	GPtrArray *items;
+	GChecksum *checksum;
+	char *result;
+	unsigned int i;
+#ifdef HAVE_LIBUSB_1_0
+	struct libusb_device **devlist;
+	struct libusb_device_descriptor des;
+	int cnt;
+#endif
+#ifdef HAVE_LIBSERIALPORT
+	struct sp_port **ports;
+#endif
+
+	(void)ctx;
+
+	items = g_ptr_array_new_with_free_func(g_free);
+
+#ifdef HAVE_LIBUSB_1_0
+	if ((cnt = libusb_get_device_list(ctx->libusb_ctx, &devlist)) >= 0) {
+		for (i = 0; i < (unsigned int)cnt; i++) {
+			if (libusb_get_device_descriptor(devlist[i], &des) < 0)
+				continue;
+			g_ptr_array_add(items, g_strdup_printf("usb %d.%d %04x:%04x",
+				libusb_get_bus_number(devlist[i]),
+				libusb_get_device_address(devlist[i]),
+				des.idVendor, des.idProduct));
+		}
+		libusb_free_device_list(devlist, 1);
+	}
+#endif
+
+#ifdef HAVE_LIBSERIALPORT
+	if (sp_list_ports(&ports) == SP_OK) {
+		for (i = 0; ports[i]; i++)
+			g_ptr_array_add(items, g_strdup_printf("serial %s",
+				sp_get_port_name(ports[i])));
+		sp_free_port_list(ports);
+	}
+#endif
+
+	g_ptr_array_sort(items, (GCompareFunc)g_strcmp0);
+	checksum = g_checksum_new(G_CHECKSUM_SHA1);
+	for (i = 0; i < items->len; i++) {
+		g_checksum_update(checksum, g_ptr_array_index(items, i), -1);
+		g_checksum_update(checksum, (const guchar *)"\n", 1);
+	}
+	result = g_strdup(g_checksum_get_string(checksum));
+	g_checksum_free(checksum);
+	g_ptr_array_free(items, TRUE);
+
+	return result;
+}
+
+#ifdef HAVE_LIBUSB_1_0
+static int LIBUSB_CALL hotplug_cb(libusb_context *libusb_ctx,
+		libusb_device *dev, libusb_hotplug_event event, void *user_data)
+{
+	struct sr_discovery *discovery;
+
+	(void)libusb_ctx;
+	(void)dev;
+	(void)event;
+
+	discovery = user_data;
+	g_atomic_int_set(&discovery->changed, 1);
+
+	return 0;
+}
+
+static void usb_ids(struct sr_context *ctx, struct sr_usb_dev_inst *usb,
+		uint16_t *vid, uint16_t *pid)
+{
+	struct libusb_device **devlist;
+	struct libusb_device_descriptor des;
+	int cnt, i;
+
+	*vid = *pid = 0;
+	if ((cnt = libusb_get_device_list(ctx->libusb_ctx, &devlist)) < 0)
+		return;
+	for (i = 0; i < cnt; i++) {
+		if (libusb_get_bus_number(devlist[i]) != usb->bus
+				|| libusb_get_device_address(devlist[i]) != usb->address)
+			continue;
+		if (libusb_get_device_descriptor(devlist[i], &des) == 0) {
+			*vid = des.idVendor;
+			*pid = des.idProduct;
+		}
+		break;
+	}
+	libusb_free_device_list(devlist, 1);
+}
+#endif
+
+static void discovery_load(struct sr_discovery *discovery)
+{
+	struct sr_discovery_entry *entry;
+	GKeyFile *kf;
+	char **groups, **names;
+	unsigned int i;
+
+	kf = g_key_file_new();
+	if (!g_key_file_load_from_file(kf, discovery->path, G_KEY_FILE_NONE, NULL)
+			|| g_key_file_get_integer(kf, DISCOVERY_GROUP, "version",
+				NULL) != DISCOVERY_VERSION) {
+		g_key_file_free(kf);
+		return;
+	}
+
+	discovery->fingerprint = g_key_file_get_string(kf, DISCOVERY_GROUP,
+		"fingerprint", NULL);
+	names = g_key_file_get_string_list(kf, DISCOVERY_GROUP, "drivers",
+		NULL, NULL);
+	for (i = 0; names && names[i]; i++)
+		discovery->drivers = g_slist_append(discovery->drivers,
+			g_strdup(names[i]));
+	g_strfreev(names);
+	groups = g_key_file_get_groups(kf, NULL);
+	for (i = 0; groups[i]; i++) {
+		if (!g_str_has_prefix(groups[i], "device "))
+			continue;
+		entry = g_malloc0(sizeof(*entry));
+		entry->driver = g_key_file_get_string(kf, groups[i], "driver", NULL);
+		entry->conn = g_key_file_get_string(kf, groups[i], "conn", NULL);
+		entry->serialcomm = g_key_file_get_string(kf, groups[i],
+			"serialcomm", NULL);
+		entry->connection_id = g_key_file_get_string(kf, groups[i],
+			"connection_id", NULL);
+		entry->vid = g_key_file_get_integer(kf, groups[i], "vid", NULL);
+		entry->pid = g_key_file_get_integer(kf, groups[i], "pid", NULL);
+		entry->serial_num = g_key_file_get_string(kf, groups[i],
+			"serial_num", NULL);
+		if (!entry->driver) {
+			entry_free(entry);
+			continue;
+		}
+		discovery->entries = g_slist_append(discovery->entries, entry);
+	}
+	g_strfreev(groups);
+	g_key_file_free(kf);
+
+	sr_dbg("Loaded %u cached devices from %s.",
+		g_slist_length(discovery->entries), discovery->path);
+}
+
+static void discovery_save(struct sr_discovery *discovery)
+{
+	struct sr_discovery_entry *entry;
+	GKeyFile *kf;
+	GSList *l;
+	GError *error;
+	const char **names;
+	char *dir, *data, group[32];
+	unsigned int i;
+	gsize len;
+
+	kf = g_key_file_new();
+	g_key_file_set_integer(kf, DISCOVERY_GROUP, "version", DISCOVERY_VERSION);
+	g_key_file_set_string(kf, DISCOVERY_GROUP, "fingerprint",
+		discovery->fingerprint);
+	names = g_malloc0_n(g_slist_length(discovery->drivers) + 1,
+		sizeof(*names));
+	for (l = discovery->drivers, i = 0; l; l = l->next, i++)
+		names[i] = l->data;
+	g_key_file_set_string_list(kf, DISCOVERY_GROUP, "drivers", names, i);
+	g_free(names);
+	for (l = discovery->entries, i = 0; l; l = l->next, i++) {
+		entry = l->data;
+		snprintf(group, sizeof(group), "device %u", i);
+		g_key_file_set_string(kf, group, "driver", entry->driver);
+		if (entry->conn)
+			g_key_file_set_string(kf, group, "conn", entry->conn);
+		if (entry->serialcomm)
+			g_key_file_set_string(kf, group, "serialcomm",
+				entry->serialcomm);
+		if (entry->connection_id)
+			g_key_file_set_string(kf, group, "connection_id",
+				entry->connection_id);
+		if (entry->vid || entry->pid) {
+			g_key_file_set_integer(kf, group, "vid", entry->vid);
+			g_key_file_set_integer(kf, group, "pid", entry->pid);
+		}
+		if (entry->serial_num)
+			g_key_file_set_string(kf, group, "serial_num",
+				entry->serial_num);
+	}
+
+	data = g_key_file_to_data(kf, &len, NULL);
+	g_key_file_free(kf);
+
+	dir = g_path_get_dirname(discovery->path);
+	g_mkdir_with_parents(dir, 0700);
+	g_free(dir);
+	error = NULL;
+	if (!g_file_set_contents(discovery->path, data, len, &error)) {
+		sr_warn("Failed to write %s: %s.", discovery->path,
+			error->message);
+		g_error_free(error);
+	}
+	g_free(data);
+}
+
+/**
+ * Enable the device discovery cache.
+ *
+ * With the cache enabled, sr_driver_scan_all() records which driver
+ * found which device on which connection, both in memory and in a file.
+ * As long as the same USB devices and serial ports are attached, later
+ * scans, also by later processes, only check that those devices are
+ * still there, instead of having every driver probe everything.
+ *
+ * The cache is invalidated when USB devices arrive or leave (if libusb
+ * supports hotplug notification on this platform), when the set of
+ * attached USB devices or serial ports differs from the one recorded,
+ * and when a cached device isn't found again.
+ *
+ * @param ctx A libsigrok context object allocated by a previous call to
+ *            sr_init(). Must not be NULL.
+ * @param path File to keep the cache in, or NULL for a file in the user's
+ *             cache directory.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ * @retval SR_ERR libusb failed to initialize.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_discovery_cache_enable(struct sr_context *ctx, const char *path)
+{
+	struct sr_discovery *discovery;
+
+	if (!ctx)
+		return SR_ERR_ARG;
+
+	sr_discovery_free(ctx);
+
+	if (sr_libusb_init(ctx) != SR_OK)
+		return SR_ERR;
+
+	discovery = g_malloc0(sizeof(*discovery));
+	if (path)
+		discovery->path = g_strdup(path);
+	else
+		discovery->path = g_build_filename(g_get_user_cache_dir(),
+			"libsigrok", "discovery.ini", NULL);
+	discovery_load(discovery);
+
+#ifdef HAVE_LIBUSB_1_0
+	discovery->libusb_ctx = ctx->libusb_ctx;
+	if (libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)
+			&& libusb_hotplug_register_callback(ctx->libusb_ctx,
+				LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED
+				| LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT, 0,
+				LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY,
+				LIBUSB_HOTPLUG_MATCH_ANY, hotplug_cb, discovery,
+				&discovery->hotplug_handle) == LIBUSB_SUCCESS)
+		discovery->hotplug = TRUE;
+#endif
+
+	ctx->discovery = discovery;
+
+	return SR_OK;
+}
+
+/**
+ * Drop the contents of the device discovery cache.
+ *
+ * The next sr_driver_scan_all() has all drivers scan.
+ *
+ * @param ctx A libsigrok context object allocated by a previous call to
+ *            sr_init(). Must not be NULL.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ * @retval SR_ERR_NA The cache is not enabled.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_discovery_cache_invalidate(struct sr_context *ctx)
+{
+	struct sr_discovery *discovery;
+
+	if (!ctx)
+		return SR_ERR_ARG;
+	if (!(discovery = ctx->discovery))
+		return SR_ERR_NA;
+
+	discovery_clear(discovery);
+	g_remove(discovery->path);
+
+	return SR_OK;
+}
+
+/** @private */
+SR_PRIV void sr_discovery_free(struct sr_context *ctx)
+{
+	struct sr_discovery *discovery;
+
+	if (!(discovery = ctx->discovery))
+		return;
+
+#ifdef HAVE_LIBUSB_1_0
+	if (discovery->hotplug)
+		libusb_hotplug_deregister_callback(discovery->libusb_ctx,
+			discovery->hotplug_handle);
+#endif
+	discovery_clear(discovery);
+	g_free(discovery->path);
+	g_free(discovery);
+	ctx->discovery = NULL;
+}
+
+/**
+ * Get the devices recorded in the discovery cache.
+ *
+ * @param ctx The libsigrok context.
+ * @param drivers NULL-terminated list of the drivers to scan with.
+ * @param entries Set to the list of struct sr_discovery_entry, which
+ *                remains owned by the cache. May be empty, and may hold
+ *                devices of other drivers.
+ *
+ * @return TRUE if the cache is enabled, still valid, and holds the results
+ *         of scans with all of the drivers.
+ *
+ * @private
+ */
+SR_PRIV gboolean sr_discovery_lookup(struct sr_context *ctx,
+		struct sr_dev_driver **drivers, GSList **entries)
+{
+	struct sr_discovery *discovery;
+	gboolean valid;
+	unsigned int i;
+	char *fp;
+
+	*entries = NULL;
+	if (!(discovery = ctx->discovery) || !discovery->fingerprint)
+		return FALSE;
+
+	if (g_atomic_int_get(&discovery->changed)) {
+		sr_dbg("USB devices changed, not using cached devices.");
+		return FALSE;
+	}
+
+	fp = fingerprint(ctx);
+	valid = !strcmp(fp, discovery->fingerprint);
+	g_free(fp);
+	if (!valid) {
+		sr_dbg("Attached devices differ, not using cached devices.");
+		return FALSE;
+	}
+
+	for (i = 0; drivers[i]; i++) {
+		if (!has_driver(discovery, drivers[i]->name)) {
+			sr_dbg("No cached scan of %s.", drivers[i]->name);
+			return FALSE;
+		}
+	}
+
+	*entries = discovery->entries;
+
+	return TRUE;
+}
+
+/**
+ * Check whether a device found is the one recorded in a cache entry.
+ *
+ * @private
+ */
+SR_PRIV gboolean sr_discovery_match(struct sr_context *ctx,
+		const struct sr_discovery_entry *entry,
+		const struct sr_dev_inst *sdi)
+{
+	const char *connection_id;
+#ifdef HAVE_LIBUSB_1_0
+	uint16_t vid, pid;
+#endif
+
+	(void)ctx;
+
+	if (strcmp(entry->driver, sdi->driver->name))
+		return FALSE;
+
+	connection_id = sr_dev_inst_connid_get(sdi);
+	if (entry->connection_id && g_strcmp0(entry->connection_id, connection_id))
+		return FALSE;
+	if (entry->serial_num && g_strcmp0(entry->serial_num, sdi->serial_num))
+		return FALSE;
+
+#ifdef HAVE_LIBUSB_1_0
+	if ((entry->vid || entry->pid) && sdi->inst_type == SR_INST_USB) {
+		usb_ids(ctx, sdi->conn, &vid, &pid);
+		if (vid != entry->vid || pid != entry->pid)
+			return FALSE;
+	}
+#endif
+
+	return TRUE;
+}
+
+/* How to find the device again, if a scan option can tell. */
+static void entry_conn(struct sr_context *ctx, struct sr_discovery_entry *entry,
+		const struct sr_dev_inst *sdi)
+{
+	char **parts;
+#ifdef HAVE_LIBUSB_1_0
+	struct sr_usb_dev_inst *usb;
+#endif
+#ifdef HAVE_LIBSERIALPORT
+	struct sr_serial_dev_inst *serial;
+#endif
+
+	(void)ctx;
+
+	switch (sdi->inst_type) {
+#ifdef HAVE_LIBUSB_1_0
+	case SR_INST_USB:
+		usb = sdi->conn;
+		entry->conn = g_strdup_printf("%d.%d", usb->bus, usb->address);
+		usb_ids(ctx, usb, &entry->vid, &entry->pid);
+		break;
+#endif
+#ifdef HAVE_LIBSERIALPORT
+	case SR_INST_SERIAL:
+		serial = sdi->conn;
+		entry->conn = g_strdup(serial->port);
+		entry->serialcomm = g_strdup(serial->serialcomm);
+		break;
+#endif
+	case SR_INST_SCPI:
+	case SR_INST_MODBUS:
+		/* Found by a resource scan, as "resource:serialcomm". */
+		if (!sdi->connection_id)
+			break;
+		parts = g_strsplit(sdi->connection_id, ":", 2);
+		entry->conn = g_strdup(parts[0]);
+		entry->serialcomm = g_strdup(parts[1]);
+		g_strfreev(parts);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Record the devices found by a scan, replacing what was recorded for
+ * the drivers scanned with.
+ *
+ * @param ctx The libsigrok context.
+ * @param drivers NULL-terminated list of the drivers scanned with.
+ * @param devices List of struct sr_dev_inst.
+ *
+ * @private
+ */
+SR_PRIV void sr_discovery_store(struct sr_context *ctx,
+		struct sr_dev_driver **drivers, GSList *devices)
+{
+	struct sr_discovery *discovery;
+	struct sr_discovery_entry *entry;
+	struct sr_dev_inst *sdi;
+	GSList *l, *next;
+	unsigned int i;
+	char *fp;
+
+	if (!(discovery = ctx->discovery))
+		return;
+
+	/* Entries recorded with other devices attached are of no use. */
+	fp = fingerprint(ctx);
+	if (!discovery->fingerprint || g_atomic_int_get(&discovery->changed)
+			|| strcmp(fp, discovery->fingerprint))
+		discovery_clear(discovery);
+	g_free(discovery->fingerprint);
+	discovery->fingerprint = fp;
+	g_atomic_int_set(&discovery->changed, 0);
+
+	for (l = discovery->entries; l; l = next) {
+		next = l->next;
+		entry = l->data;
+		for (i = 0; drivers[i]; i++) {
+			if (!strcmp(entry->driver, drivers[i]->name))
+				break;
+		}
+		if (!drivers[i])
+			continue;
+		entry_free(entry);
+		discovery->entries = g_slist_delete_link(discovery->entries, l);
+	}
+	for (i = 0; drivers[i]; i++) {
+		if (!has_driver(discovery, drivers[i]->name))
+			discovery->drivers = g_slist_append(discovery->drivers,
+				g_strdup(drivers[i]->name));
+	}
+
+	for (l = devices; l; l = l->next) {
+		sdi = l->data;
+		entry = g_malloc0(sizeof(*entry));
+		entry->driver = g_strdup(sdi->driver->name);
+		entry->connection_id = g_strdup(sr_dev_inst_connid_get(sdi));
+		entry->serial_num = g_strdup(sdi->serial_num);
+		entry_conn(ctx, entry, sdi);
+		discovery->entries = g_slist_append(discovery->entries, entry);
+	}
+
+	discovery_save(discovery);
+
+	sr_dbg("Cached %u devices in %s.", g_slist_length(devices),
+		discovery->path);
+}
+
+/** @} */
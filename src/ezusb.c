@@ -56,43 +56,42 @@ SR_PRIV int ezusb_install_firmware(struct sr_context *ctx,
 				   libusb_device_handle *hdl,
 				   const char *name)
 {
-	unsigned char *firmware;
-	size_t length, offset, chunksize;
-	int ret, result;
+	struct sr_resource_image *firmware;
+	size_t offset, chunksize;
+	int ret;
 
 	/* Max size is 64 kiB since the value field of the setup packet,
 	 * which holds the firmware offset, is only 16 bit wide.
 	 */
-	firmware = sr_resource_load(ctx, SR_RESOURCE_FIRMWARE,
-			name, &length, 1 << 16);
+	firmware = sr_resource_image_get(ctx, SR_RESOURCE_FIRMWARE,
+			name, 1 << 16);
 	if (!firmware)
 		return SR_ERR;
 
 	sr_info("Uploading firmware '%s'.", name);
 
-	result = SR_OK;
 	offset = 0;
-	while (offset < length) {
-		chunksize = MIN(length - offset, FW_CHUNKSIZE);
+	while (offset < firmware->size) {
+		chunksize = MIN(firmware->size - offset, FW_CHUNKSIZE);
 
 		ret = libusb_control_transfer(hdl, LIBUSB_REQUEST_TYPE_VENDOR |
 					      LIBUSB_ENDPOINT_OUT, 0xa0, offset,
-					      0x0000, firmware + offset,
+					      0x0000, firmware->data + offset,
 					      chunksize, 100);
 		if (ret < 0) {
 			sr_err("Unable to send firmware to device: %s.",
 					libusb_error_name(ret));
-			g_free(firmware);
+			sr_resource_image_unref(firmware);
 			return SR_ERR;
 		}
 		sr_info("Uploaded %zu bytes.", chunksize);
 		offset += chunksize;
 	}
-	g_free(firmware);
+	sr_resource_image_unref(firmware);
 
 	sr_info("Firmware upload done.");
 
-	return result;
+	return SR_OK;
 }
 
 SR_PRIV int ezusb_upload_firmware(struct sr_context *ctx, libusb_device *dev,
@@ -368,25 +368,18 @@ err:
 static int sigma_fw_2_bitbang(struct sr_context *ctx, const char *name,
 			      uint8_t **bb_cmd, gsize *bb_cmd_size)
 {
+	struct sr_resource_image *firmware;
 	size_t i, file_size, bb_size;
-	char *firmware;
-	uint8_t *bb_stream, *bbs;
+	uint8_t *bb_stream, *bbs, byte;
 	uint32_t imm;
 	int bit, v;
-	int ret = SR_OK;
 
 	/* Retrieve the on-disk firmware file content. */
-	firmware = sr_resource_load(ctx, SR_RESOURCE_FIRMWARE,
-			name, &file_size, 256 * 1024);
+	firmware = sr_resource_image_get(ctx, SR_RESOURCE_FIRMWARE,
+			name, 256 * 1024);
 	if (!firmware)
 		return SR_ERR;
-
-	/* Unscramble the file content (XOR with "random" sequence). */
-	imm = 0x3f6df2ab;
-	for (i = 0; i < file_size; i++) {
-		imm = (imm + 0xa853753) % 177 + (imm * 0x8034052);
-		firmware[i] ^= imm & 0xff;
-	}
+	file_size = firmware->size;
 
 	/*
 	 * Generate a sequence of bitbang samples. With two samples per
@@ -407,25 +400,31 @@ static int sigma_fw_2_bitbang(struct sr_context *ctx, const char *name,
 	bb_stream = (uint8_t *)g_try_malloc(bb_size);
 	if (!bb_stream) {
 		sr_err("%s: Failed to allocate bitbang stream", __func__);
-		ret = SR_ERR_MALLOC;
-		goto exit;
+		sr_resource_image_unref(firmware);
+		return SR_ERR_MALLOC;
 	}
 	bbs = bb_stream;
+	imm = 0x3f6df2ab;
 	for (i = 0; i < file_size; i++) {
+		/*
+		 * Unscramble the file content (XOR with "random" sequence),
+		 * leaving the cached image as it is.
+		 */
+		imm = (imm + 0xa853753) % 177 + (imm * 0x8034052);
+		byte = firmware->data[i] ^ (imm & 0xff);
 		for (bit = 7; bit >= 0; bit--) {
-			v = (firmware[i] & (1 << bit)) ? 0x40 : 0x00;
+			v = (byte & (1 << bit)) ? 0x40 : 0x00;
 			*bbs++ = v | 0x01;
 			*bbs++ = v;
 		}
 	}
+	sr_resource_image_unref(firmware);
 
 	/* The transformation completed successfully, return the result. */
 	*bb_cmd = bb_stream;
 	*bb_cmd_size = bb_size;
 
-exit:
-	g_free(firmware);
-	return ret;
+	return SR_OK;
 }
 
 static int upload_firmware(struct sr_context *ctx,
@@ -803,218 +802,314 @@ static void sigma_session_send(struct sr_dev_inst *sdi,
 }
 
 /*
- * This size translates to: event count (1K events per cluster), times
- * the sample width (unitsize, 16bits per event), times the maximum
- * number of samples per event.
+ * Sample data download. DRAM lines are read in blocks, and each block is
+ * decoded on a worker thread while the next block is being read. Slots
+ * hold a block from its retrieval until its samples were sent.
+ *
+ * Clusters only depend on their predecessor by means of the timestamp
+ * (RLE gaps) and the last sample value. Workers decode each cluster's
+ * samples in isolation. The reading thread emits the decoded blocks in
+ * order, inserting the gaps and locating the trigger as it goes.
  */
-#define SAMPLES_BUFFER_SIZE	(1024 * 2 * 4)
+#define DL_LINES_PER_BLOCK	32
+#define DL_NUM_SLOTS		4
+#define DL_CLUSTERS_PER_BLOCK	(DL_LINES_PER_BLOCK * 64)
+/* Up to 4 samples per event, plus room for get_trigger_offset(). */
+#define DL_SAMPLES_PER_BLOCK	(DL_CLUSTERS_PER_BLOCK * EVENTS_PER_CLUSTER * 4 + 8)
+/* Number of samples which get sent to the session in one packet. */
+#define DL_OUT_SAMPLES		(512 * 1024)
+
+struct sigma_dl_slot {
+	/* Filled in by the reading thread. */
+	struct sigma_dram_line lines[DL_LINES_PER_BLOCK];
+	unsigned int num_lines;
+	uint16_t events_in_line[DL_LINES_PER_BLOCK];
+	int trigger_cluster;
+
+	/* Filled in by the worker. */
+	uint8_t samples[DL_SAMPLES_PER_BLOCK * 2];
+	uint16_t ts[DL_CLUSTERS_PER_BLOCK];
+	uint32_t start[DL_CLUSTERS_PER_BLOCK + 1];
+	unsigned int num_clusters;
+
+	gboolean busy;
+	gboolean done;
+};
+
+struct sigma_dl_context {
+	struct sr_dev_inst *sdi;
+	uint64_t samplerate;
+	GMutex mutex;
+	GCond cond;
+	struct sigma_dl_slot *slots;
+	gboolean first_cluster;
+	uint8_t *out;
+	size_t out_count;
+};
 
-static void sigma_decode_dram_cluster(struct sigma_dram_cluster *dram_cluster,
-				      unsigned int events_in_cluster,
-				      unsigned int triggered,
-				      struct sr_dev_inst *sdi)
+/*
+ * Decode the events of a DRAM cluster into samples, starting at the given
+ * sample index. Returns the index after the last sample that was stored.
+ * Cope with memory layouts that vary with the samplerate.
+ */
+static size_t sigma_decode_dram_cluster(struct sigma_dram_cluster *dram_cluster,
+					unsigned int events_in_cluster,
+					uint64_t samplerate,
+					uint8_t *samples, size_t idx)
 {
-	struct dev_context *devc = sdi->priv;
-	struct sigma_state *ss = &devc->state;
-	struct sr_datafeed_packet packet;
-	struct sr_datafeed_logic logic;
-	uint16_t tsdiff, ts, sample, item16;
-	uint8_t samples[SAMPLES_BUFFER_SIZE];
-	uint8_t *send_ptr;
-	size_t send_count, trig_count;
+	uint16_t sample, item16;
 	unsigned int i;
-	int j;
-
-	ts = sigma_dram_cluster_ts(dram_cluster);
-	tsdiff = ts - ss->lastts;
-	ss->lastts = ts + EVENTS_PER_CLUSTER;
-
-	packet.type = SR_DF_LOGIC;
-	packet.payload = &logic;
-	logic.unitsize = 2;
-	logic.data = samples;
-
-	/*
-	 * If this cluster is not adjacent to the previously received
-	 * cluster, then send the appropriate number of samples with the
-	 * previous values to the sigrok session. This "decodes RLE".
-	 */
-	for (ts = 0; ts < tsdiff; ts++) {
-		i = ts % 1024;
-		store_sr_sample(samples, i, ss->lastsample);
 
-		/*
-		 * If we have 1024 samples ready or we're at the
-		 * end of submitting the padding samples, submit
-		 * the packet to Sigrok. Since constant data is
-		 * sent, duplication of data for rates above 50MHz
-		 * is simple.
-		 */
-		if ((i == 1023) || (ts == tsdiff - 1)) {
-			logic.length = (i + 1) * logic.unitsize;
-			for (j = 0; j < devc->samples_per_event; j++)
-				sigma_session_send(sdi, &packet);
-		}
-	}
-
-	/*
-	 * Parse the samples in current cluster and prepare them
-	 * to be submitted to Sigrok. Cope with memory layouts that
-	 * vary with the samplerate.
-	 */
-	send_ptr = &samples[0];
-	send_count = 0;
-	sample = 0;
 	for (i = 0; i < events_in_cluster; i++) {
 		item16 = sigma_dram_cluster_data(dram_cluster, i);
-		if (devc->cur_samplerate == SR_MHZ(200)) {
+		if (samplerate == SR_MHZ(200)) {
 			sample = sigma_deinterlace_200mhz_data(item16, 0);
-			store_sr_sample(samples, send_count++, sample);
+			store_sr_sample(samples, idx++, sample);
 			sample = sigma_deinterlace_200mhz_data(item16, 1);
-			store_sr_sample(samples, send_count++, sample);
+			store_sr_sample(samples, idx++, sample);
 			sample = sigma_deinterlace_200mhz_data(item16, 2);
-			store_sr_sample(samples, send_count++, sample);
+			store_sr_sample(samples, idx++, sample);
 			sample = sigma_deinterlace_200mhz_data(item16, 3);
-			store_sr_sample(samples, send_count++, sample);
-		} else if (devc->cur_samplerate == SR_MHZ(100)) {
+			store_sr_sample(samples, idx++, sample);
+		} else if (samplerate == SR_MHZ(100)) {
 			sample = sigma_deinterlace_100mhz_data(item16, 0);
-			store_sr_sample(samples, send_count++, sample);
+			store_sr_sample(samples, idx++, sample);
 			sample = sigma_deinterlace_100mhz_data(item16, 1);
-			store_sr_sample(samples, send_count++, sample);
+			store_sr_sample(samples, idx++, sample);
 		} else {
-			sample = item16;
-			store_sr_sample(samples, send_count++, sample);
-		}
-	}
-
-	/*
-	 * If a trigger position applies, then provide the datafeed with
-	 * the first part of data up to that position, then send the
-	 * trigger marker.
-	 */
-	int trigger_offset = 0;
-	if (triggered) {
-		/*
-		 * Trigger is not always accurate to sample because of
-		 * pipeline delay. However, it always triggers before
-		 * the actual event. We therefore look at the next
-		 * samples to pinpoint the exact position of the trigger.
-		 */
-		trigger_offset = get_trigger_offset(samples,
-					ss->lastsample, &devc->trigger);
-
-		if (trigger_offset > 0) {
-			trig_count = trigger_offset * devc->samples_per_event;
-			packet.type = SR_DF_LOGIC;
-			logic.length = trig_count * logic.unitsize;
-			sigma_session_send(sdi, &packet);
-			send_ptr += trig_count * logic.unitsize;
-			send_count -= trig_count;
-		}
-
-		/* Only send trigger if explicitly enabled. */
-		if (devc->use_triggers) {
-			packet.type = SR_DF_TRIGGER;
-			sr_session_send(sdi, &packet);
+			store_sr_sample(samples, idx++, item16);
 		}
 	}
 
-	/*
-	 * Send the data after the trigger, or all of the received data
-	 * if no trigger position applies.
-	 */
-	if (send_count) {
-		packet.type = SR_DF_LOGIC;
-		logic.length = send_count * logic.unitsize;
-		logic.data = send_ptr;
-		sigma_session_send(sdi, &packet);
-	}
-
-	ss->lastsample = sample;
+	return idx;
 }
 
 /*
- * Decode chunk of 1024 bytes, 64 clusters, 7 events per cluster.
- * Each event is 20ns apart, and can contain multiple samples.
+ * Decode a block of DRAM lines of 1024 bytes, 64 clusters, 7 events per
+ * cluster. Each event is 20ns apart, and can contain multiple samples.
  *
  * For 200 MHz, events contain 4 samples for each channel, spread 5 ns apart.
  * For 100 MHz, events contain 2 samples for each channel, spread 10 ns apart.
  * For 50 MHz and below, events contain one sample for each channel,
  * spread 20 ns apart.
+ *
+ * Runs on a worker thread.
  */
-static int decode_chunk_ts(struct sigma_dram_line *dram_line,
-			   uint16_t events_in_line,
-			   uint32_t trigger_event,
-			   struct sr_dev_inst *sdi)
+static void sigma_decode_block(gpointer data, gpointer user_data)
 {
+	struct sigma_dl_slot *slot;
+	struct sigma_dl_context *ctx;
 	struct sigma_dram_cluster *dram_cluster;
-	struct dev_context *devc;
-	unsigned int clusters_in_line;
-	unsigned int events_in_cluster;
-	unsigned int i;
-	uint32_t trigger_cluster, triggered;
+	unsigned int line, i, clusters_in_line, events_in_cluster;
+	uint16_t events_in_line;
+	size_t idx;
 
-	devc = sdi->priv;
-	clusters_in_line = events_in_line;
-	clusters_in_line += EVENTS_PER_CLUSTER - 1;
-	clusters_in_line /= EVENTS_PER_CLUSTER;
-	trigger_cluster = ~0;
-	triggered = 0;
-
-	/* Check if trigger is in this chunk. */
-	if (trigger_event < (64 * 7)) {
-		if (devc->cur_samplerate <= SR_MHZ(50)) {
-			trigger_event -= MIN(EVENTS_PER_CLUSTER - 1,
-					     trigger_event);
+	slot = data;
+	ctx = user_data;
+
+	idx = 0;
+	slot->num_clusters = 0;
+	for (line = 0; line < slot->num_lines; line++) {
+		events_in_line = slot->events_in_line[line];
+		clusters_in_line = events_in_line;
+		clusters_in_line += EVENTS_PER_CLUSTER - 1;
+		clusters_in_line /= EVENTS_PER_CLUSTER;
+
+		for (i = 0; i < clusters_in_line; i++) {
+			dram_cluster = &slot->lines[line].cluster[i];
+
+			/* The last cluster might not be full. */
+			if ((i == clusters_in_line - 1) &&
+			    (events_in_line % EVENTS_PER_CLUSTER)) {
+				events_in_cluster = events_in_line % EVENTS_PER_CLUSTER;
+			} else {
+				events_in_cluster = EVENTS_PER_CLUSTER;
+			}
+
+			slot->ts[slot->num_clusters] =
+				sigma_dram_cluster_ts(dram_cluster);
+			slot->start[slot->num_clusters++] = idx;
+			idx = sigma_decode_dram_cluster(dram_cluster,
+				events_in_cluster, ctx->samplerate,
+				slot->samples, idx);
 		}
+	}
+	slot->start[slot->num_clusters] = idx;
+
+	g_mutex_lock(&ctx->mutex);
+	slot->done = TRUE;
+	g_cond_broadcast(&ctx->cond);
+	g_mutex_unlock(&ctx->mutex);
+}
+
+static void sigma_dl_flush(struct sigma_dl_context *ctx)
+{
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+
+	if (!ctx->out_count)
+		return;
+
+	packet.type = SR_DF_LOGIC;
+	packet.payload = &logic;
+	logic.unitsize = 2;
+	logic.length = ctx->out_count * logic.unitsize;
+	logic.data = ctx->out;
+	sigma_session_send(ctx->sdi, &packet);
 
-		/* Find in which cluster the trigger occurred. */
-		trigger_cluster = trigger_event / EVENTS_PER_CLUSTER;
+	ctx->out_count = 0;
+}
+
+static void sigma_dl_put(struct sigma_dl_context *ctx,
+			 const uint8_t *samples, size_t count)
+{
+	size_t n;
+
+	while (count) {
+		n = MIN(count, DL_OUT_SAMPLES - ctx->out_count);
+		memcpy(ctx->out + ctx->out_count * 2, samples, n * 2);
+		ctx->out_count += n;
+		samples += n * 2;
+		count -= n;
+		if (ctx->out_count == DL_OUT_SAMPLES)
+			sigma_dl_flush(ctx);
 	}
+}
 
-	/* For each full DRAM cluster. */
-	for (i = 0; i < clusters_in_line; i++) {
-		dram_cluster = &dram_line->cluster[i];
+static void sigma_dl_put_repeat(struct sigma_dl_context *ctx,
+				uint16_t sample, size_t count)
+{
+	size_t n;
+
+	while (count) {
+		n = MIN(count, DL_OUT_SAMPLES - ctx->out_count);
+		count -= n;
+		while (n--)
+			store_sr_sample(ctx->out, ctx->out_count++, sample);
+		if (ctx->out_count == DL_OUT_SAMPLES)
+			sigma_dl_flush(ctx);
+	}
+}
 
-		/* The last cluster might not be full. */
-		if ((i == clusters_in_line - 1) &&
-		    (events_in_line % EVENTS_PER_CLUSTER)) {
-			events_in_cluster = events_in_line % EVENTS_PER_CLUSTER;
-		} else {
-			events_in_cluster = EVENTS_PER_CLUSTER;
+/* Wait for a slot's decoder to finish and send its samples. */
+static void sigma_dl_emit_block(struct sigma_dl_context *ctx,
+				struct sigma_dl_slot *slot)
+{
+	struct dev_context *devc;
+	struct sigma_state *ss;
+	struct sr_datafeed_packet packet;
+	const uint8_t *samples;
+	size_t count, trig_count;
+	unsigned int i;
+	uint16_t ts, tsdiff;
+	int trigger_offset;
+
+	devc = ctx->sdi->priv;
+	ss = &devc->state;
+
+	g_mutex_lock(&ctx->mutex);
+	while (!slot->done)
+		g_cond_wait(&ctx->cond, &ctx->mutex);
+	g_mutex_unlock(&ctx->mutex);
+	slot->busy = FALSE;
+
+	for (i = 0; i < slot->num_clusters; i++) {
+		ts = slot->ts[i];
+
+		/* This is the first DRAM cluster, take the initial timestamp. */
+		if (ctx->first_cluster) {
+			ss->lastts = ts;
+			ss->lastsample = 0;
+			ctx->first_cluster = FALSE;
 		}
+		tsdiff = ts - ss->lastts;
+		ss->lastts = ts + EVENTS_PER_CLUSTER;
 
-		triggered = (i == trigger_cluster);
-		sigma_decode_dram_cluster(dram_cluster, events_in_cluster,
-					  triggered, sdi);
-	}
+		/*
+		 * If this cluster is not adjacent to the previously received
+		 * cluster, then send the appropriate number of samples with
+		 * the previous values to the sigrok session. This "decodes
+		 * RLE". Since constant data is sent, duplication of data for
+		 * rates above 50MHz is simple.
+		 */
+		sigma_dl_put_repeat(ctx, ss->lastsample,
+			(size_t)tsdiff * devc->samples_per_event);
 
-	return SR_OK;
+		samples = &slot->samples[slot->start[i] * 2];
+		count = slot->start[i + 1] - slot->start[i];
+
+		/*
+		 * If a trigger position applies, then provide the datafeed
+		 * with the first part of data up to that position, then send
+		 * the trigger marker. A cluster without samples still gets
+		 * the marker.
+		 */
+		if ((int)i == slot->trigger_cluster) {
+			/*
+			 * Trigger is not always accurate to sample because of
+			 * pipeline delay. However, it always triggers before
+			 * the actual event. We therefore look at the next
+			 * samples to pinpoint the exact position of the trigger.
+			 */
+			trigger_offset = 0;
+			if (count)
+				trigger_offset = get_trigger_offset(
+						(uint8_t *)samples,
+						ss->lastsample, &devc->trigger);
+
+			if (trigger_offset > 0) {
+				trig_count = trigger_offset * devc->samples_per_event;
+				trig_count = MIN(trig_count, count);
+				sigma_dl_put(ctx, samples, trig_count);
+				samples += trig_count * 2;
+				count -= trig_count;
+			}
+			sigma_dl_flush(ctx);
+
+			/* Only send trigger if explicitly enabled. */
+			if (devc->use_triggers) {
+				packet.type = SR_DF_TRIGGER;
+				packet.payload = NULL;
+				sr_session_send(ctx->sdi, &packet);
+			}
+		}
+
+		if (!count)
+			continue;
+		sigma_dl_put(ctx, samples, count);
+		ss->lastsample = RL16(&slot->samples[(slot->start[i + 1] - 1) * 2]);
+	}
 }
 
 static int download_capture(struct sr_dev_inst *sdi)
 {
-	const uint32_t chunks_per_read = 32;
-
 	struct dev_context *devc;
-	struct sigma_dram_line *dram_line;
+	struct sigma_dl_context ctx;
+	struct sigma_dl_slot *slot;
+	GThreadPool *pool;
 	int bufsz;
 	uint32_t stoppos, triggerpos;
 	uint8_t modestatus;
-	uint32_t i;
+	uint32_t i, block;
 	uint32_t dl_lines_total, dl_lines_curr, dl_lines_done;
 	uint32_t dl_first_line, dl_line;
-	uint32_t dl_events_in_line;
-	uint32_t trg_line, trg_event;
+	uint32_t trg_line, trg_event, trigger_event;
 
 	devc = sdi->priv;
-	dl_events_in_line = 64 * 7;
 	trg_line = ~0;
 	trg_event = ~0;
 
-	dram_line = g_try_malloc0(chunks_per_read * sizeof(*dram_line));
-	if (!dram_line)
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.sdi = sdi;
+	ctx.samplerate = devc->cur_samplerate;
+	ctx.first_cluster = TRUE;
+	ctx.slots = g_try_malloc0(DL_NUM_SLOTS * sizeof(*ctx.slots));
+	ctx.out = g_try_malloc(DL_OUT_SAMPLES * 2);
+	if (!ctx.slots || !ctx.out) {
+		g_free(ctx.slots);
+		g_free(ctx.out);
 		return FALSE;
+	}
 
 	sr_info("Downloading sample data.");
 	devc->state.state = SIGMA_DOWNLOAD;
@@ -1063,42 +1158,77 @@ static int download_capture(struct sr_dev_inst *sdi)
 	} else {
 		dl_first_line = 0;
 	}
+
+	/* One slot is always being filled by this thread. */
+	g_mutex_init(&ctx.mutex);
+	g_cond_init(&ctx.cond);
+	pool = g_thread_pool_new(sigma_decode_block, &ctx,
+			DL_NUM_SLOTS - 1, FALSE, NULL);
+
 	dl_lines_done = 0;
+	block = 0;
 	while (dl_lines_total > dl_lines_done) {
+		/* Send the samples of the block which last used this slot. */
+		slot = &ctx.slots[block % DL_NUM_SLOTS];
+		if (slot->busy)
+			sigma_dl_emit_block(&ctx, slot);
+
 		/* We can download only up-to 32 DRAM lines in one go! */
-		dl_lines_curr = MIN(chunks_per_read, dl_lines_total - dl_lines_done);
+		dl_lines_curr = MIN(DL_LINES_PER_BLOCK, dl_lines_total - dl_lines_done);
 
 		dl_line = dl_first_line + dl_lines_done;
 		dl_line %= 0x8000;
 		bufsz = sigma_read_dram(dl_line, dl_lines_curr,
-					(uint8_t *)dram_line, devc);
+					(uint8_t *)slot->lines, devc);
 		/* TODO: Check bufsz. For now, just avoid compiler warnings. */
 		(void)bufsz;
 
-		/* This is the first DRAM line, so find the initial timestamp. */
-		if (dl_lines_done == 0) {
-			devc->state.lastts =
-				sigma_dram_cluster_ts(&dram_line[0].cluster[0]);
-			devc->state.lastsample = 0;
-		}
-
+		slot->num_lines = dl_lines_curr;
+		slot->trigger_cluster = -1;
 		for (i = 0; i < dl_lines_curr; i++) {
-			uint32_t trigger_event = ~0;
 			/* The last "DRAM line" can be only partially full. */
 			if (dl_lines_done + i == dl_lines_total - 1)
-				dl_events_in_line = stoppos & 0x1ff;
-
-			/* Test if the trigger happened on this line. */
-			if (dl_lines_done + i == trg_line)
-				trigger_event = trg_event;
-
-			decode_chunk_ts(dram_line + i, dl_events_in_line,
-					trigger_event, sdi);
+				slot->events_in_line[i] = stoppos & 0x1ff;
+			else
+				slot->events_in_line[i] = 64 * 7;
+
+			/*
+			 * Test if the trigger happened on this line, and find
+			 * in which cluster. All lines but the last one of the
+			 * download are full, so clusters are at fixed offsets.
+			 */
+			if (dl_lines_done + i != trg_line || trg_event >= 64 * 7)
+				continue;
+			trigger_event = trg_event;
+			if (devc->cur_samplerate <= SR_MHZ(50)) {
+				trigger_event -= MIN(EVENTS_PER_CLUSTER - 1,
+						     trigger_event);
+			}
+			slot->trigger_cluster = i * 64 +
+				trigger_event / EVENTS_PER_CLUSTER;
 		}
 
+		slot->busy = TRUE;
+		slot->done = FALSE;
+		g_thread_pool_push(pool, slot, NULL);
+
 		dl_lines_done += dl_lines_curr;
+		block++;
 	}
-	g_free(dram_line);
+
+	/* Send the remaining blocks, oldest first. */
+	for (i = 0; i < DL_NUM_SLOTS; i++) {
+		slot = &ctx.slots[(block + i) % DL_NUM_SLOTS];
+		if (slot->busy)
+			sigma_dl_emit_block(&ctx, slot);
+	}
+	sigma_dl_flush(&ctx);
+
+	g_thread_pool_free(pool, FALSE, TRUE);
+	g_cond_clear(&ctx.cond);
+	g_mutex_clear(&ctx.mutex);
+	g_free(ctx.slots);
+	g_free(ctx.out);
 
 	std_session_send_df_end(sdi);
 
@@ -22,6 +22,10 @@
 #include <time.h>
 #include <sys/timerfd.h>
 
+static const uint32_t scanopts[] = {
+	SR_CONF_CONN,
+};
+
 static const uint32_t drvopts[] = {
 	SR_CONF_THERMOMETER,
 	SR_CONF_POWERMETER,
@@ -60,10 +64,20 @@ static GSList *scan(struct sr_dev_driver *di, GSList *options)
 {
 	struct dev_context *devc;
 	struct sr_dev_inst *sdi;
+	struct sr_config *src;
+	const char *conn;
 	gboolean status;
+	GSList *l;
 	int i;
 
-	(void)options;
+	/* The conn option is the root directory, for a relocated sysfs. */
+	conn = NULL;
+	for (l = options; l; l = l->next) {
+		src = l->data;
+		if (src->key == SR_CONF_CONN)
+			conn = g_variant_get_string(src->data, NULL);
+	}
+	bl_acme_set_sysfs_root(conn);
 
 	devc = g_malloc0(sizeof(struct dev_context));
 	devc->samplerate = SR_HZ(10);
@@ -216,7 +230,7 @@ static int config_list(uint32_t key, GVariant **data,
 	if (!cg) {
 		switch (key) {
 		case SR_CONF_DEVICE_OPTIONS:
-			return STD_CONFIG_LIST(key, data, sdi, cg, NULL, drvopts, devopts);
+			return STD_CONFIG_LIST(key, data, sdi, cg, scanopts, drvopts, devopts);
 		case SR_CONF_SAMPLERATE:
 			*data = std_gvar_samplerates_steps(ARRAY_AND_SIZE(samplerates));
 			break;
@@ -241,32 +255,16 @@ static int config_list(uint32_t key, GVariant **data,
 	return SR_OK;
 }
 
-static void dev_acquisition_close(const struct sr_dev_inst *sdi)
+static int dev_open(struct sr_dev_inst *sdi)
 {
-	GSList *chl;
-	struct sr_channel *ch;
-
-	for (chl = sdi->channels; chl; chl = chl->next) {
-		ch = chl->data;
-		bl_acme_close_channel(ch);
-	}
+	return bl_acme_open_channels(sdi);
 }
 
-static int dev_acquisition_open(const struct sr_dev_inst *sdi)
+static int dev_close(struct sr_dev_inst *sdi)
 {
-	GSList *chl;
-	struct sr_channel *ch;
-
-	for (chl = sdi->channels; chl; chl = chl->next) {
-		ch = chl->data;
-		if (bl_acme_open_channel(ch)) {
-			sr_err("Error opening channel %s", ch->name);
-			dev_acquisition_close(sdi);
-			return SR_ERR;
-		}
-	}
+	bl_acme_close_channels(sdi);
 
-	return 0;
+	return SR_OK;
 }
 
 static int dev_acquisition_start(const struct sr_dev_inst *sdi)
@@ -277,9 +275,6 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 		.it_value = { 0, 0 }
 	};
 
-	if (dev_acquisition_open(sdi))
-		return SR_ERR;
-
 	devc = sdi->priv;
 	devc->samples_missed = 0;
 	devc->timer_fd = timerfd_create(CLOCK_MONOTONIC, 0);
@@ -288,12 +283,19 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 		return SR_ERR;
 	}
 
+	if (bl_acme_start_sampling(sdi) != SR_OK) {
+		bl_acme_stop_sampling(sdi);
+		close(devc->timer_fd);
+		return SR_ERR;
+	}
+
 	tspec.it_interval.tv_sec = 0;
 	tspec.it_interval.tv_nsec = SR_HZ_TO_NS(devc->samplerate);
 	tspec.it_value = tspec.it_interval;
 
 	if (timerfd_settime(devc->timer_fd, 0, &tspec, NULL)) {
 		sr_err("Failed to set timer");
+		bl_acme_stop_sampling(sdi);
 		close(devc->timer_fd);
 		return SR_ERR;
 	}
@@ -318,7 +320,7 @@ static int dev_acquisition_stop(struct sr_dev_inst *sdi)
 
 	devc = sdi->priv;
 
-	dev_acquisition_close(sdi);
+	bl_acme_stop_sampling(sdi);
 	sr_session_source_remove_channel(sdi->session, devc->channel);
 	g_io_channel_shutdown(devc->channel, FALSE, NULL);
 	g_io_channel_unref(devc->channel);
@@ -344,8 +346,8 @@ static struct sr_dev_driver baylibre_acme_driver_info = {
 	.config_get = config_get,
 	.config_set = config_set,
 	.config_list = config_list,
-	.dev_open = std_dummy_dev_open,
-	.dev_close = std_dummy_dev_close,
+	.dev_open = dev_open,
+	.dev_close = dev_close,
 	.dev_acquisition_start = dev_acquisition_start,
 	.dev_acquisition_stop = dev_acquisition_stop,
 	.context = NULL,
@@ -42,6 +42,14 @@ enum channel_type {
 struct channel_group_priv {
 	uint8_t rev;
 	int hwmon_num;
+	/* IIO device index, if the probe is bound to the IIO driver. */
+	int iio_num;
+	/* Buffered capture: device node, scan size and the latest scan. */
+	int iio_fd;
+	size_t scan_size;
+	uint8_t *scans;
+	uint8_t *scan;
+	gboolean have_scan;
 	int probe_type;
 	int index;
 	int has_pws;
@@ -50,12 +58,29 @@ struct channel_group_priv {
 
 struct channel_priv {
 	int ch_type;
+	/* Attribute file, kept open while the device is open. */
 	int fd;
-	int digits;
-	float val;
+	gboolean read_error;
+	/* From attribute or scan element value to the channel's unit. */
+	float scale;
+	/* Layout of the value in IIO buffer scans, offset -1 if unused. */
+	int scan_offset;
+	int scan_index;
+	gboolean scan_be;
+	gboolean scan_signed;
+	unsigned int scan_bits;
+	unsigned int scan_storage;
+	unsigned int scan_shift;
 	struct channel_group_priv *probe;
 };
 
+/* Enabled channels of one type, sent together in one analog packet. */
+struct sample_packet {
+	int ch_type;
+	GSList *channels;
+	float *values;
+};
+
 #define EEPROM_SERIAL_SIZE		16
 #define EEPROM_TAG_SIZE			32
 
@@ -101,6 +126,10 @@ static const uint32_t revB_pws_gpios[] = {
 	489, 491, 493, 495, 497, 499, 501, 503,
 };
 
+/* Scans read from an IIO buffer at once. */
+#define IIO_SCANS_PER_READ	64
+#define IIO_BUFFER_LENGTH	128
+
 #define MOHM_TO_UOHM(x) ((x) * 1000)
 #define UOHM_TO_MOHM(x) ((x) / 1000)
 
@@ -114,16 +143,38 @@ SR_PRIV uint8_t bl_acme_get_temp_addr(int index)
 	return temp_i2c_addrs[index];
 }
 
+/*
+ * Directory under which sysfs (and /dev) is looked up, set by the conn
+ * scan option. Normally the root directory. There is one ACME per
+ * system, so this is kept driver-wide.
+ */
+static char *sysfs_root_dir;
+
+static const char *sysfs_root(void)
+{
+	return sysfs_root_dir ? sysfs_root_dir : "";
+}
+
+/* Look up sysfs under the given directory, NULL for the root directory. */
+SR_PRIV void bl_acme_set_sysfs_root(const char *root)
+{
+	g_free(sysfs_root_dir);
+	sysfs_root_dir = g_strdup(root);
+}
+
 SR_PRIV gboolean bl_acme_is_sane(void)
 {
 	gboolean status;
+	char *path;
 
 	/*
 	 * We expect sysfs to be present and mounted at /sys, ina226 and
 	 * tmp435 sensors detected by the system and their appropriate
 	 * drivers loaded and functional.
 	 */
-	status = g_file_test("/sys", G_FILE_TEST_IS_DIR);
+	path = g_strdup_printf("%s/sys", sysfs_root());
+	status = g_file_test(path, G_FILE_TEST_IS_DIR);
+	g_free(path);
 	if (!status) {
 		sr_err("/sys/ directory not found - sysfs not mounted?");
 		return FALSE;
@@ -132,10 +183,16 @@ SR_PRIV gboolean bl_acme_is_sane(void)
 	return TRUE;
 }
 
+static void probe_dev_path(unsigned int addr, GString *path)
+{
+	g_string_printf(path, "%s/sys/class/i2c-adapter/i2c-1/1-00%02x",
+			sysfs_root(), addr);
+}
+
 static void probe_name_path(unsigned int addr, GString *path)
 {
-	g_string_printf(path,
-			"/sys/class/i2c-adapter/i2c-1/1-00%02x/name", addr);
+	probe_dev_path(addr, path);
+	g_string_append(path, "/name");
 }
 
 /*
@@ -143,15 +200,55 @@ static void probe_name_path(unsigned int addr, GString *path)
  */
 static void probe_hwmon_path(unsigned int addr, GString *path)
 {
-	g_string_printf(path,
-			"/sys/class/i2c-adapter/i2c-1/1-00%02x/hwmon", addr);
+	probe_dev_path(addr, path);
+	g_string_append(path, "/hwmon");
 }
 
 static void probe_eeprom_path(unsigned int addr, GString *path)
 {
 	g_string_printf(path,
-			"/sys/class/i2c-dev/i2c-1/device/1-00%02x/eeprom",
-			addr + 0x10);
+			"%s/sys/class/i2c-dev/i2c-1/device/1-00%02x/eeprom",
+			sysfs_root(), addr + 0x10);
+}
+
+/*
+ * Energy probes may be bound to the ina2xx IIO driver instead of the
+ * hwmon one, in which case the device directory has an iio:deviceX
+ * entry. Returns X, or -1.
+ */
+static int get_iio_index(unsigned int addr)
+{
+	GString *path;
+	GDir *dir;
+	const char *name;
+	int iio;
+
+	path = g_string_sized_new(64);
+	probe_dev_path(addr, path);
+	dir = g_dir_open(path->str, 0, NULL);
+	g_string_free(path, TRUE);
+	if (!dir)
+		return -1;
+
+	iio = -1;
+	while ((name = g_dir_read_name(dir)))
+		if (sscanf(name, "iio:device%d", &iio) == 1)
+			break;
+	g_dir_close(dir);
+
+	return iio;
+}
+
+/* Path of an attribute of the probe's hwmon or IIO device. */
+static char *probe_attr_path(const struct channel_group_priv *cgp,
+			     const char *attr)
+{
+	if (cgp->iio_num >= 0)
+		return g_strdup_printf("%s/sys/bus/iio/devices/iio:device%d/%s",
+				       sysfs_root(), cgp->iio_num, attr);
+
+	return g_strdup_printf("%s/sys/class/hwmon/hwmon%d/%s",
+			       sysfs_root(), cgp->hwmon_num, attr);
 }
 
 SR_PRIV gboolean bl_acme_detect_probe(unsigned int addr,
@@ -182,7 +279,7 @@ SR_PRIV gboolean bl_acme_detect_probe(unsigned int addr,
 		 */
 		probe_hwmon_path(addr, path);
 		status = g_file_test(path->str, G_FILE_TEST_IS_DIR);
-		if (status) {
+		if (status || get_iio_index(addr) >= 0) {
 			/* We have found an ACME probe. */
 			ret = TRUE;
 		}
@@ -324,16 +421,18 @@ SR_PRIV gboolean bl_acme_register_probe(struct sr_dev_inst *sdi, int type,
 	struct sr_channel_group *cg;
 	struct channel_group_priv *cgp;
 	struct probe_eeprom eeprom;
-	int hwmon, status;
+	int hwmon, iio, status;
 	uint32_t gpio;
 
-	/* Obtain the hwmon index. */
-	hwmon = get_hwmon_index(addr);
-	if (hwmon < 0)
+	/* Obtain the IIO or hwmon index. */
+	hwmon = -1;
+	iio = type == PROBE_ENRG ? get_iio_index(addr) : -1;
+	if (iio < 0 && (hwmon = get_hwmon_index(addr)) < 0)
 		return FALSE;
 
 	cg = g_malloc0(sizeof(struct sr_channel_group));
 	cgp = g_malloc0(sizeof(struct channel_group_priv));
+	cgp->iio_fd = -1;
 	cg->priv = cgp;
 
 	/*
@@ -347,6 +446,7 @@ SR_PRIV gboolean bl_acme_register_probe(struct sr_dev_inst *sdi, int type,
 	prb_num = cgp->rev == ACME_REV_A ? prb_num : revB_addr_to_num(addr);
 
 	cgp->hwmon_num = hwmon;
+	cgp->iio_num = iio;
 	cgp->probe_type = type;
 	cgp->index = prb_num - 1;
 	cg->name = g_strdup_printf("Probe_%d", prb_num);
@@ -408,6 +508,7 @@ static int get_shunt_path(const struct sr_channel_group *cg, GString *path)
 {
 	struct channel_group_priv *cgp;
 	int ret = SR_OK, status;
+	char *attr;
 
 	cgp = cg->priv;
 
@@ -416,9 +517,10 @@ static int get_shunt_path(const struct sr_channel_group *cg, GString *path)
 		return SR_ERR_ARG;
 	}
 
-	g_string_append_printf(path,
-			       "/sys/class/hwmon/hwmon%d/shunt_resistor",
-			       cgp->hwmon_num);
+	attr = probe_attr_path(cgp, cgp->iio_num >= 0 ?
+			       "in_shunt_resistor" : "shunt_resistor");
+	g_string_append(path, attr);
+	g_free(attr);
 
 	/*
 	 * The shunt_resistor sysfs attribute is available
@@ -444,7 +546,7 @@ SR_PRIV void bl_acme_maybe_set_update_interval(const struct sr_dev_inst *sdi,
 {
 	struct sr_channel_group *cg;
 	struct channel_group_priv *cgp;
-	GString *hwmon;
+	char *hwmon;
 	GSList *l;
 	FILE *fd;
 
@@ -452,15 +554,16 @@ SR_PRIV void bl_acme_maybe_set_update_interval(const struct sr_dev_inst *sdi,
 		cg = l->data;
 		cgp = cg->priv;
 
-		hwmon = g_string_sized_new(64);
-		g_string_append_printf(hwmon,
-				"/sys/class/hwmon/hwmon%d/update_interval",
-				cgp->hwmon_num);
+		/* IIO probes sample on their own, we pick the latest. */
+		if (cgp->iio_num >= 0)
+			continue;
 
-		if (g_file_test(hwmon->str, G_FILE_TEST_EXISTS)) {
-			fd = g_fopen(hwmon->str, "w");
+		hwmon = probe_attr_path(cgp, "update_interval");
+
+		if (g_file_test(hwmon, G_FILE_TEST_EXISTS)) {
+			fd = g_fopen(hwmon, "w");
 			if (!fd) {
-				g_string_free(hwmon, TRUE);
+				g_free(hwmon);
 				continue;
 			}
 
@@ -468,7 +571,7 @@ SR_PRIV void bl_acme_maybe_set_update_interval(const struct sr_dev_inst *sdi,
 			fclose(fd);
 		}
 
-		g_string_free(hwmon, TRUE);
+		g_free(hwmon);
 	}
 }
 
@@ -632,74 +735,502 @@ static int type_digits(int type)
 	}
 }
 
-static float read_sample(struct sr_channel *ch)
+static const char *hwmon_attr(int ch_type)
 {
-	struct channel_priv *chp;
-	char buf[16];
-	ssize_t len;
-	int fd;
+	switch (ch_type) {
+	case ENRG_PWR:	return "power1_input";
+	case ENRG_CURR:	return "curr1_input";
+	case ENRG_VOL:	return "in1_input";
+	case TEMP_IN:	return "temp1_input";
+	case TEMP_OUT:	return "temp2_input";
+	default:	return NULL;
+	}
+}
 
-	chp = ch->priv;
-	fd = chp->fd;
+/* Channel names used by the ina2xx IIO driver. */
+static const char *iio_channel(int ch_type)
+{
+	switch (ch_type) {
+	case ENRG_PWR:	return "power2";
+	case ENRG_CURR:	return "current3";
+	case ENRG_VOL:	return "voltage1";
+	default:	return NULL;
+	}
+}
+
+static int read_attr(const struct channel_group_priv *cgp, const char *attr,
+		     char **contents)
+{
+	char *path;
+	gboolean status;
 
-	lseek(fd, 0, SEEK_SET);
+	path = probe_attr_path(cgp, attr);
+	status = g_file_get_contents(path, contents, NULL, NULL);
+	if (!status)
+		sr_err("Error reading %s.", path);
+	g_free(path);
 
-	len = read(fd, buf, sizeof(buf));
-	if (len < 0) {
-		sr_err("Error reading from channel %s (hwmon: %d): %s",
-			ch->name, chp->probe->hwmon_num, g_strerror(errno));
-		ch->enabled = FALSE;
-		return -1.0;
+	return status ? SR_OK : SR_ERR_IO;
+}
+
+static int write_attr(const struct channel_group_priv *cgp, const char *attr,
+		      const char *value)
+{
+	char *path;
+	FILE *fd;
+
+	path = probe_attr_path(cgp, attr);
+	fd = g_fopen(path, "w");
+	if (!fd) {
+		sr_err("Error opening %s: %s", path, g_strerror(errno));
+		g_free(path);
+		return SR_ERR_IO;
 	}
+	g_free(path);
 
-	chp->digits = type_digits(chp->ch_type);
-	return strtol(buf, NULL, 10) * powf(10, -chp->digits);
+	g_fprintf(fd, "%s\n", value);
+	fclose(fd);
+
+	return SR_OK;
 }
 
-SR_PRIV int bl_acme_open_channel(struct sr_channel *ch)
+static int open_channel(struct sr_channel *ch)
 {
 	struct channel_priv *chp;
-	char path[64];
-	const char *file;
+	struct channel_group_priv *cgp;
+	char *attr, *path, *contents;
 	int fd;
 
 	chp = ch->priv;
+	cgp = chp->probe;
+	chp->scan_offset = -1;
+	chp->read_error = FALSE;
 
-	switch (chp->ch_type) {
-	case ENRG_PWR:	file = "power1_input";	break;
-	case ENRG_CURR:	file = "curr1_input";	break;
-	case ENRG_VOL:	file = "in1_input";	break;
-	case TEMP_IN:	file = "temp1_input";	break;
-	case TEMP_OUT:	file = "temp2_input";	break;
-	default:
+	if (!hwmon_attr(chp->ch_type)) {
 		sr_err("Invalid channel type: %d.", chp->ch_type);
 		return SR_ERR;
 	}
 
-	snprintf(path, sizeof(path), "/sys/class/hwmon/hwmon%d/%s",
-		 chp->probe->hwmon_num, file);
+	/*
+	 * hwmon attributes are in the channel's unit, scaled by its digits.
+	 * IIO raw values are scaled to mV, mA or mW.
+	 */
+	if (cgp->iio_num >= 0) {
+		attr = g_strdup_printf("in_%s_scale", iio_channel(chp->ch_type));
+		contents = NULL;
+		if (read_attr(cgp, attr, &contents) != SR_OK) {
+			g_free(attr);
+			return SR_ERR;
+		}
+		chp->scale = g_ascii_strtod(contents, NULL) / 1000;
+		g_free(contents);
+		g_free(attr);
+		attr = g_strdup_printf("in_%s_raw", iio_channel(chp->ch_type));
+	} else {
+		chp->scale = powf(10, -type_digits(chp->ch_type));
+		attr = g_strdup(hwmon_attr(chp->ch_type));
+	}
 
+	path = probe_attr_path(cgp, attr);
+	g_free(attr);
 	fd = open(path, O_RDONLY);
 	if (fd < 0) {
 		sr_err("Error opening %s: %s", path, g_strerror(errno));
-		ch->enabled = FALSE;
+		g_free(path);
 		return SR_ERR;
 	}
+	g_free(path);
 
 	chp->fd = fd;
 
-	return 0;
+	return SR_OK;
 }
 
-SR_PRIV void bl_acme_close_channel(struct sr_channel *ch)
+static void close_channel(struct sr_channel *ch)
 {
 	struct channel_priv *chp;
 
 	chp = ch->priv;
-	close(chp->fd);
+	if (chp->fd >= 0)
+		close(chp->fd);
 	chp->fd = -1;
 }
 
+/*
+ * Open the attribute files of all channels, and the buffer device of
+ * IIO probes. They stay open until the device is closed, so that each
+ * sample costs a seek and a read.
+ */
+SR_PRIV int bl_acme_open_channels(const struct sr_dev_inst *sdi)
+{
+	struct sr_channel_group *cg;
+	struct channel_group_priv *cgp;
+	struct channel_priv *chp;
+	struct sr_channel *ch;
+	GSList *l;
+	char *path;
+
+	for (l = sdi->channels; l; l = l->next) {
+		chp = ((struct sr_channel *)l->data)->priv;
+		chp->fd = -1;
+	}
+
+	for (l = sdi->channels; l; l = l->next) {
+		ch = l->data;
+		if (open_channel(ch) != SR_OK) {
+			sr_err("Error opening channel %s", ch->name);
+			bl_acme_close_channels(sdi);
+			return SR_ERR;
+		}
+	}
+
+	for (l = sdi->channel_groups; l; l = l->next) {
+		cg = l->data;
+		cgp = cg->priv;
+		if (cgp->iio_num < 0)
+			continue;
+		path = g_strdup_printf("%s/dev/iio:device%d", sysfs_root(),
+				       cgp->iio_num);
+		cgp->iio_fd = open(path, O_RDONLY | O_NONBLOCK);
+		if (cgp->iio_fd < 0)
+			sr_dbg("No buffered capture for %s (%s), reading "
+			       "attributes.", cg->name, g_strerror(errno));
+		g_free(path);
+	}
+
+	return SR_OK;
+}
+
+SR_PRIV void bl_acme_close_channels(const struct sr_dev_inst *sdi)
+{
+	struct channel_group_priv *cgp;
+	GSList *l;
+
+	for (l = sdi->channels; l; l = l->next)
+		close_channel(l->data);
+
+	for (l = sdi->channel_groups; l; l = l->next) {
+		cgp = ((struct sr_channel_group *)l->data)->priv;
+		if (cgp->iio_fd >= 0)
+			close(cgp->iio_fd);
+		cgp->iio_fd = -1;
+	}
+}
+
+static int read_scan_element(struct sr_channel *ch)
+{
+	struct channel_priv *chp;
+	char *attr, *contents, endian, sign;
+	int ret;
+
+	chp = ch->priv;
+
+	attr = g_strdup_printf("scan_elements/in_%s_index",
+			       iio_channel(chp->ch_type));
+	ret = read_attr(chp->probe, attr, &contents);
+	g_free(attr);
+	if (ret != SR_OK)
+		return ret;
+	chp->scan_index = strtol(contents, NULL, 10);
+	g_free(contents);
+
+	/* For example "le:s16/16>>0". */
+	attr = g_strdup_printf("scan_elements/in_%s_type",
+			       iio_channel(chp->ch_type));
+	ret = read_attr(chp->probe, attr, &contents);
+	g_free(attr);
+	if (ret != SR_OK)
+		return ret;
+	if (sscanf(contents, "%ce:%c%u/%u>>%u", &endian, &sign,
+		   &chp->scan_bits, &chp->scan_storage,
+		   &chp->scan_shift) != 5
+	    || (chp->scan_storage != 8 && chp->scan_storage != 16
+		&& chp->scan_storage != 32 && chp->scan_storage != 64)) {
+		sr_err("Unsupported scan element type '%s'.", contents);
+		g_free(contents);
+		return SR_ERR_DATA;
+	}
+	g_free(contents);
+	chp->scan_be = endian == 'b';
+	chp->scan_signed = sign == 's';
+	chp->scan_storage /= 8;
+
+	return SR_OK;
+}
+
+static void stop_buffer(struct sr_channel_group *cg)
+{
+	struct channel_group_priv *cgp;
+	struct channel_priv *chp;
+	GSList *l;
+
+	cgp = cg->priv;
+	for (l = cg->channels; l; l = l->next) {
+		chp = ((struct sr_channel *)l->data)->priv;
+		chp->scan_offset = -1;
+	}
+
+	if (!cgp->scans)
+		return;
+
+	write_attr(cgp, "buffer/enable", "0");
+	g_free(cgp->scans);
+	cgp->scans = cgp->scan = NULL;
+}
+
+/*
+ * Have the IIO driver capture the probe's energy channels into its
+ * buffer. Scans hold the enabled elements in index order, each aligned
+ * to its size, and are padded to the largest element.
+ */
+static int start_buffer(struct sr_channel_group *cg)
+{
+	struct channel_group_priv *cgp;
+	struct channel_priv *chp, *next;
+	GSList *l;
+	GDir *dir;
+	const char *name;
+	char *path, *element;
+	size_t offset, align;
+	int prev, ret;
+
+	cgp = cg->priv;
+	if (cgp->iio_fd < 0)
+		return SR_ERR_NA;
+
+	write_attr(cgp, "buffer/enable", "0");
+
+	/* Enable our channels' scan elements, and nothing else. */
+	path = probe_attr_path(cgp, "scan_elements");
+	dir = g_dir_open(path, 0, NULL);
+	g_free(path);
+	if (!dir)
+		return SR_ERR_NA;
+	while ((name = g_dir_read_name(dir))) {
+		if (!g_str_has_prefix(name, "in_") || !g_str_has_suffix(name, "_en"))
+			continue;
+		element = g_strndup(name + 3, strlen(name) - 6);
+		for (l = cg->channels; l; l = l->next) {
+			chp = ((struct sr_channel *)l->data)->priv;
+			if (!strcmp(element, iio_channel(chp->ch_type)))
+				break;
+		}
+		path = g_strdup_printf("scan_elements/%s", name);
+		ret = write_attr(cgp, path, l ? "1" : "0");
+		g_free(path);
+		g_free(element);
+		if (ret != SR_OK) {
+			g_dir_close(dir);
+			return ret;
+		}
+	}
+	g_dir_close(dir);
+
+	for (l = cg->channels; l; l = l->next)
+		if ((ret = read_scan_element(l->data)) != SR_OK)
+			return ret;
+
+	offset = align = 0;
+	prev = -1;
+	while (TRUE) {
+		next = NULL;
+		for (l = cg->channels; l; l = l->next) {
+			chp = ((struct sr_channel *)l->data)->priv;
+			if (chp->scan_index > prev
+			    && (!next || chp->scan_index < next->scan_index))
+				next = chp;
+		}
+		if (!next)
+			break;
+		offset = (offset + next->scan_storage - 1)
+			/ next->scan_storage * next->scan_storage;
+		next->scan_offset = offset;
+		offset += next->scan_storage;
+		align = MAX(align, next->scan_storage);
+		prev = next->scan_index;
+	}
+	cgp->scan_size = (offset + align - 1) / align * align;
+
+	path = g_strdup_printf("%d", IIO_BUFFER_LENGTH);
+	ret = write_attr(cgp, "buffer/length", path);
+	g_free(path);
+	if (ret == SR_OK)
+		ret = write_attr(cgp, "buffer/enable", "1");
+	if (ret != SR_OK)
+		return ret;
+
+	cgp->scans = g_malloc((IIO_SCANS_PER_READ + 1) * cgp->scan_size);
+	cgp->scan = cgp->scans + IIO_SCANS_PER_READ * cgp->scan_size;
+	cgp->have_scan = FALSE;
+
+	return SR_OK;
+}
+
+static void free_sample_packet(void *data)
+{
+	struct sample_packet *sp;
+
+	sp = data;
+	g_slist_free(sp->channels);
+	g_free(sp->values);
+	g_free(sp);
+}
+
+/*
+ * Prepare an acquisition: start buffered capture on IIO probes where
+ * the kernel supports it, and group the enabled channels by type, so
+ * that each sample period costs one analog packet per type.
+ */
+SR_PRIV int bl_acme_start_sampling(const struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	struct sr_channel_group *cg;
+	struct channel_group_priv *cgp;
+	struct channel_priv *chp;
+	struct sample_packet *sp;
+	struct sr_channel *ch;
+	GSList *l;
+	int type, ret;
+
+	devc = sdi->priv;
+
+	/*
+	 * Without kernel support for buffered capture the attributes are
+	 * read instead. Once supported, failing to set it up is an error.
+	 */
+	for (l = sdi->channel_groups; l; l = l->next) {
+		cg = l->data;
+		cgp = cg->priv;
+		if (cgp->iio_num < 0)
+			continue;
+		ret = start_buffer(cg);
+		if (ret == SR_ERR_NA) {
+			sr_dbg("Buffered capture unavailable for %s.", cg->name);
+			stop_buffer(cg);
+		} else if (ret != SR_OK) {
+			sr_err("Failed to start buffered capture for %s.",
+			       cg->name);
+			return ret;
+		}
+	}
+
+	for (type = ENRG_PWR; type <= TEMP_OUT; type++) {
+		sp = NULL;
+		for (l = sdi->channels; l; l = l->next) {
+			ch = l->data;
+			chp = ch->priv;
+			if (!ch->enabled || chp->ch_type != type)
+				continue;
+			if (!sp) {
+				sp = g_malloc0(sizeof(*sp));
+				sp->ch_type = type;
+			}
+			sp->channels = g_slist_append(sp->channels, ch);
+		}
+		if (!sp)
+			continue;
+		sp->values = g_malloc0_n(g_slist_length(sp->channels),
+					 sizeof(float));
+		devc->sample_packets = g_slist_append(devc->sample_packets, sp);
+	}
+
+	return SR_OK;
+}
+
+SR_PRIV void bl_acme_stop_sampling(const struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	GSList *l;
+
+	devc = sdi->priv;
+
+	for (l = sdi->channel_groups; l; l = l->next)
+		stop_buffer(l->data);
+
+	g_slist_free_full(devc->sample_packets, free_sample_packet);
+	devc->sample_packets = NULL;
+}
+
+/* Keep the most recent scan in the probe's IIO buffer. */
+static void read_scans(struct channel_group_priv *cgp)
+{
+	size_t size;
+	ssize_t len;
+
+	size = IIO_SCANS_PER_READ * cgp->scan_size;
+	while ((len = read(cgp->iio_fd, cgp->scans, size)) > 0) {
+		if ((size_t)len >= cgp->scan_size) {
+			memcpy(cgp->scan, cgp->scans +
+			       (len / cgp->scan_size - 1) * cgp->scan_size,
+			       cgp->scan_size);
+			cgp->have_scan = TRUE;
+		}
+		if ((size_t)len < size)
+			break;
+	}
+}
+
+static float scan_value(const struct channel_priv *chp, const uint8_t *scan)
+{
+	const uint8_t *p;
+	uint64_t raw;
+	int64_t value;
+
+	p = scan + chp->scan_offset;
+	switch (chp->scan_storage) {
+	case 1:
+		raw = R8(p);
+		break;
+	case 2:
+		raw = chp->scan_be ? RB16(p) : RL16(p);
+		break;
+	case 4:
+		raw = chp->scan_be ? RB32(p) : RL32(p);
+		break;
+	default:
+		raw = chp->scan_be ? RB64(p) : RL64(p);
+		break;
+	}
+
+	raw >>= chp->scan_shift;
+	if (chp->scan_bits < 64)
+		raw &= (UINT64_C(1) << chp->scan_bits) - 1;
+	value = raw;
+	if (chp->scan_signed && chp->scan_bits < 64
+	    && (raw & (UINT64_C(1) << (chp->scan_bits - 1))))
+		value -= (int64_t)1 << chp->scan_bits;
+
+	return value * chp->scale;
+}
+
+/* Update value with a new sample, or leave it if reading fails. */
+static void read_sample(struct sr_channel *ch, float *value)
+{
+	struct channel_priv *chp;
+	char buf[24];
+	ssize_t len;
+
+	chp = ch->priv;
+
+	if (chp->scan_offset >= 0) {
+		*value = scan_value(chp, chp->probe->scan);
+		return;
+	}
+
+	lseek(chp->fd, 0, SEEK_SET);
+	len = read(chp->fd, buf, sizeof(buf) - 1);
+	if (len < 0) {
+		if (!chp->read_error)
+			sr_err("Error reading from channel %s: %s",
+			       ch->name, g_strerror(errno));
+		chp->read_error = TRUE;
+		return;
+	}
+	buf[len] = '\0';
+
+	*value = strtol(buf, NULL, 10) * chp->scale;
+}
+
 SR_PRIV int bl_acme_receive_data(int fd, int revents, void *cb_data)
 {
 	uint64_t nrexpiration;
@@ -709,11 +1240,12 @@ SR_PRIV int bl_acme_receive_data(int fd, int revents, void *cb_data)
 	struct sr_analog_meaning meaning;
 	struct sr_analog_spec spec;
 	struct sr_dev_inst *sdi;
-	struct sr_channel *ch;
-	struct channel_priv *chp;
+	struct sr_channel_group *cg;
+	struct channel_group_priv *cgp;
+	struct sample_packet *sp;
 	struct dev_context *devc;
-	GSList *chl, chonly;
-	unsigned i;
+	GSList *l, *chl;
+	unsigned int i, n;
 
 	(void)fd;
 	(void)revents;
@@ -742,6 +1274,25 @@ SR_PRIV int bl_acme_receive_data(int fd, int revents, void *cb_data)
 	if (nrexpiration > 1)
 		devc->samples_missed += nrexpiration - 1;
 
+	/*
+	 * Read all channels in one pass. Until every buffered probe has
+	 * delivered its first scan there is nothing to send for it.
+	 */
+	for (l = sdi->channel_groups; l; l = l->next) {
+		cg = l->data;
+		cgp = cg->priv;
+		if (!cgp->scans)
+			continue;
+		read_scans(cgp);
+		if (!cgp->have_scan)
+			return TRUE;
+	}
+	for (l = devc->sample_packets; l; l = l->next) {
+		sp = l->data;
+		for (chl = sp->channels, n = 0; chl; chl = chl->next, n++)
+			read_sample(chl->data, &sp->values[n]);
+	}
+
 	/*
 	 * XXX This is a nasty workaround...
 	 *
@@ -763,28 +1314,18 @@ SR_PRIV int bl_acme_receive_data(int fd, int revents, void *cb_data)
 		sr_session_send(sdi, &framep);
 
 		/*
-		 * Due to different units used in each channel we're sending
-		 * samples one-by-one.
+		 * Channels of one type share their unit, send them in one
+		 * packet.
 		 */
-		for (chl = sdi->channels; chl; chl = chl->next) {
-			ch = chl->data;
-			chp = ch->priv;
-
-			if (!ch->enabled)
-				continue;
-			chonly.next = NULL;
-			chonly.data = ch;
+		for (l = devc->sample_packets; l; l = l->next) {
+			sp = l->data;
 			analog.num_samples = 1;
-			analog.meaning->channels = &chonly;
-			analog.meaning->mq = channel_to_mq(chl->data);
-			analog.meaning->unit = channel_to_unit(ch);
-
-			if (i < 1)
-				chp->val = read_sample(ch);
-
-			analog.encoding->digits  = chp->digits;
-			analog.spec->spec_digits = chp->digits;
-			analog.data = &chp->val;
+			analog.meaning->channels = sp->channels;
+			analog.meaning->mq = channel_to_mq(sp->channels->data);
+			analog.meaning->unit = channel_to_unit(sp->channels->data);
+			analog.encoding->digits = type_digits(sp->ch_type);
+			analog.spec->spec_digits = type_digits(sp->ch_type);
+			analog.data = sp->values;
 			sr_session_send(sdi, &packet);
 		}
 
@@ -792,7 +1333,7 @@ SR_PRIV int bl_acme_receive_data(int fd, int revents, void *cb_data)
 		sr_session_send(sdi, &framep);
 	}
 
-	sr_sw_limits_update_samples_read(&devc->limits, 1);
+	sr_sw_limits_update_samples_read(&devc->limits, nrexpiration);
 
 	if (sr_sw_limits_check(&devc->limits)) {
 		sr_dev_acquisition_stop(sdi);
@@ -57,11 +57,14 @@ struct dev_context {
 	uint64_t samples_missed;
 	int timer_fd;
 	GIOChannel *channel;
+	/* Enabled channels, grouped into one analog packet per type. */
+	GSList *sample_packets;
 };
 
 SR_PRIV uint8_t bl_acme_get_enrg_addr(int index);
 SR_PRIV uint8_t bl_acme_get_temp_addr(int index);
 
+SR_PRIV void bl_acme_set_sysfs_root(const char *root);
 SR_PRIV gboolean bl_acme_is_sane(void);
 
 SR_PRIV gboolean bl_acme_detect_probe(unsigned int addr,
@@ -84,9 +87,11 @@ SR_PRIV int bl_acme_read_power_state(const struct sr_channel_group *cg,
 SR_PRIV int bl_acme_set_power_off(const struct sr_channel_group *cg,
 				  gboolean off);
 
-SR_PRIV int bl_acme_receive_data(int fd, int revents, void *cb_data);
+SR_PRIV int bl_acme_open_channels(const struct sr_dev_inst *sdi);
+SR_PRIV void bl_acme_close_channels(const struct sr_dev_inst *sdi);
 
-SR_PRIV int bl_acme_open_channel(struct sr_channel *ch);
+SR_PRIV int bl_acme_start_sampling(const struct sr_dev_inst *sdi);
+SR_PRIV void bl_acme_stop_sampling(const struct sr_dev_inst *sdi);
 
-SR_PRIV void bl_acme_close_channel(struct sr_channel *ch);
+SR_PRIV int bl_acme_receive_data(int fd, int revents, void *cb_data);
 #endif
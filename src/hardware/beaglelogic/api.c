@@ -67,9 +67,11 @@ static GSList *scan(struct sr_dev_driver *di, GSList *options)
 	struct dev_context *devc;
 	const char *conn = NULL;
 	gchar **params;
+	gboolean nodelay, quickack;
 	int i, maxch;
 
 	maxch = NUM_CHANNELS;
+	nodelay = quickack = FALSE;
 	for (l = options; l; l = l->next) {
 		src = l->data;
 		if (src->key == SR_CONF_NUM_LOGIC_CHANNELS)
@@ -94,6 +96,18 @@ static GSList *scan(struct sr_dev_driver *di, GSList *options)
 			g_strfreev(params);
 			return NULL;
 		}
+		/* Optional latency tuning: tcp-raw/<host>/<port>[/nodelay][/quickack] */
+		for (i = 3; params[i]; i++) {
+			if (!g_ascii_strcasecmp(params[i], "nodelay")) {
+				nodelay = TRUE;
+			} else if (!g_ascii_strcasecmp(params[i], "quickack")) {
+				quickack = TRUE;
+			} else {
+				sr_err("Unknown connection flag '%s'.", params[i]);
+				g_strfreev(params);
+				return NULL;
+			}
+		}
 	}
 
 	maxch = (maxch > 8) ? NUM_CHANNELS : 8;
@@ -108,7 +122,6 @@ static GSList *scan(struct sr_dev_driver *di, GSList *options)
 	/* Default non-zero values (if any) */
 	devc->fd = -1;
 	devc->limit_samples = (uint64_t)10000000;
-	devc->tcp_buffer = 0;
 
 	if (!conn) {
 		devc->beaglelogic = &beaglelogic_native_ops;
@@ -118,6 +131,8 @@ static GSList *scan(struct sr_dev_driver *di, GSList *options)
 		devc->beaglelogic = &beaglelogic_tcp_ops;
 		devc->address = g_strdup(params[1]);
 		devc->port = g_strdup(params[2]);
+		devc->tcp_nodelay = nodelay;
+		devc->tcp_quickack = quickack;
 		g_strfreev(params);
 
 		if (devc->beaglelogic->open(devc) != SR_OK)
@@ -184,8 +199,6 @@ static int dev_open(struct sr_dev_inst *sdi)
 			devc->beaglelogic->close(devc);
 			return SR_ERR;
 		}
-	} else {
-		devc->tcp_buffer = g_malloc(TCP_BUFFER_SIZE);
 	}
 
 	return SR_OK;
@@ -205,7 +218,6 @@ static int dev_close(struct sr_dev_inst *sdi)
 
 static void clear_helper(struct dev_context *devc)
 {
-	g_free(devc->tcp_buffer);
 	g_free(devc->address);
 	g_free(devc->port);
 }
@@ -343,16 +355,24 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 		devc->trigger_fired = TRUE;
 	std_session_send_df_header(sdi);
 
-	/* Trigger and add poll on file */
+	/*
+	 * Trigger and add poll on file. Over TCP, a reader thread receives
+	 * the data and the session periodically picks it up.
+	 */
 	devc->beaglelogic->start(devc);
-	if (devc->beaglelogic == &beaglelogic_native_ops)
+	if (devc->beaglelogic == &beaglelogic_native_ops) {
 		sr_session_source_add_pollfd(sdi->session, &devc->pollfd,
 			BUFUNIT_TIMEOUT_MS(devc), beaglelogic_native_receive_data,
 			(void *)sdi);
-	else
-		sr_session_source_add_pollfd(sdi->session, &devc->pollfd,
-			BUFUNIT_TIMEOUT_MS(devc), beaglelogic_tcp_receive_data,
-			(void *)sdi);
+	} else {
+		if (beaglelogic_tcp_stream_start(devc) != SR_OK) {
+			devc->beaglelogic->stop(devc);
+			std_session_send_df_end(sdi);
+			return SR_ERR;
+		}
+		sr_session_source_add(sdi->session, -1, 0, TCP_STREAM_POLL_MS,
+			beaglelogic_tcp_receive_data, (void *)sdi);
+	}
 
 	return SR_OK;
 }
@@ -362,6 +382,8 @@ static int dev_acquisition_stop(struct sr_dev_inst *sdi)
 	struct dev_context *devc = sdi->priv;
 
 	/* Execute a stop on BeagleLogic */
+	if (devc->beaglelogic == &beaglelogic_tcp_ops)
+		beaglelogic_tcp_stream_stop(devc);
 	devc->beaglelogic->stop(devc);
 
 	/* Flush the cache */
@@ -371,7 +393,10 @@ static int dev_acquisition_stop(struct sr_dev_inst *sdi)
 		beaglelogic_tcp_drain(devc);
 
 	/* Remove session source and send EOT packet */
-	sr_session_source_remove_pollfd(sdi->session, &devc->pollfd);
+	if (devc->beaglelogic == &beaglelogic_native_ops)
+		sr_session_source_remove_pollfd(sdi->session, &devc->pollfd);
+	else
+		sr_session_source_remove(sdi->session, -1);
 	std_session_send_df_end(sdi);
 
 	return SR_OK;
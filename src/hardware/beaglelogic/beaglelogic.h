@@ -128,5 +128,11 @@ SR_PRIV extern const struct beaglelogic_ops beaglelogic_tcp_ops;
 
 SR_PRIV int beaglelogic_tcp_detect(struct dev_context *devc);
 SR_PRIV int beaglelogic_tcp_drain(struct dev_context *devc);
+SR_PRIV int beaglelogic_tcp_stream_start(struct dev_context *devc);
+SR_PRIV void beaglelogic_tcp_stream_stop(struct dev_context *devc);
+SR_PRIV size_t beaglelogic_tcp_stream_peek(struct dev_context *devc,
+		uint8_t **data, gboolean *eof);
+SR_PRIV void beaglelogic_tcp_stream_release(struct dev_context *devc,
+		size_t len);
 
 #endif
@@ -33,7 +33,9 @@
 #include <unistd.h>
 #ifndef _WIN32
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #endif
@@ -42,6 +44,29 @@
 #include "protocol.h"
 #include "beaglelogic.h"
 
+/*
+ * Ask for a large socket receive buffer, so that the sender can keep
+ * streaming while the session is busy. Commands are tiny and wait for a
+ * response, with "nodelay" Nagle doesn't hold them back. This is best
+ * effort only.
+ */
+static void beaglelogic_tcp_tune(struct dev_context *devc)
+{
+	int opt;
+
+	opt = TCP_STREAM_RCVBUF;
+	if (setsockopt(devc->socket, SOL_SOCKET, SO_RCVBUF,
+			(const void *)&opt, sizeof(opt)) < 0)
+		sr_dbg("Cannot set receive buffer size: %s", g_strerror(errno));
+
+	if (!devc->tcp_nodelay)
+		return;
+	opt = 1;
+	if (setsockopt(devc->socket, IPPROTO_TCP, TCP_NODELAY,
+			(const void *)&opt, sizeof(opt)) < 0)
+		sr_dbg("Cannot set TCP_NODELAY: %s", g_strerror(errno));
+}
+
 static int beaglelogic_tcp_open(struct dev_context *devc)
 {
 	struct addrinfo hints;
@@ -65,6 +90,8 @@ static int beaglelogic_tcp_open(struct dev_context *devc)
 		if ((devc->socket = socket(res->ai_family, res->ai_socktype,
 						res->ai_protocol)) < 0)
 			continue;
+		/* Must be set before connecting to get a large window. */
+		beaglelogic_tcp_tune(devc);
 		if (connect(devc->socket, res->ai_addr, res->ai_addrlen) != 0) {
 			close(devc->socket);
 			devc->socket = -1;
@@ -164,6 +191,157 @@ SR_PRIV int beaglelogic_tcp_drain(struct dev_context *devc)
 	return SR_OK;
 }
 
+/*
+ * Streaming reader. Sample data is received on a separate thread into a
+ * ring buffer, in as large pieces as the socket has ready, while the
+ * session thread consumes it in place. The session thread releases data
+ * only after it was sent, so the reader never overwrites data in use.
+ */
+static gpointer beaglelogic_tcp_stream_thread(gpointer data)
+{
+	struct dev_context *devc;
+	GPollFD pfd;
+	uint64_t head, tail;
+	size_t space, pos, first;
+	int len;
+#ifndef _WIN32
+	struct iovec iov[2];
+	int opt;
+#endif
+
+	devc = data;
+	pfd.fd = devc->socket;
+	pfd.events = G_IO_IN;
+
+	while (!g_atomic_int_get(&devc->tcp_stop)) {
+		g_mutex_lock(&devc->tcp_mutex);
+		head = devc->tcp_head;
+		tail = devc->tcp_tail;
+		g_mutex_unlock(&devc->tcp_mutex);
+
+		/* The session lags behind, give it some time. */
+		space = TCP_STREAM_RING_SIZE - (head - tail);
+		if (!space) {
+			g_usleep(1000);
+			continue;
+		}
+
+		/* Wake up regularly to check for a stop request. */
+		pfd.revents = 0;
+		if (g_poll(&pfd, 1, 100) <= 0)
+			continue;
+
+		pos = head % TCP_STREAM_RING_SIZE;
+		first = MIN(space, TCP_STREAM_RING_SIZE - pos);
+#ifndef _WIN32
+		/* Fill up the free space at the end and the start at once. */
+		iov[0].iov_base = devc->tcp_ring + pos;
+		iov[0].iov_len = first;
+		iov[1].iov_base = devc->tcp_ring;
+		iov[1].iov_len = space - first;
+		len = readv(devc->socket, iov, iov[1].iov_len ? 2 : 1);
+#else
+		len = recv(devc->socket, (char *)devc->tcp_ring + pos, first, 0);
+#endif
+		if (len < 0 && (errno == EINTR || errno == EAGAIN))
+			continue;
+		if (len <= 0) {
+			if (len < 0)
+				sr_err("Receive error: %s", g_strerror(errno));
+			g_atomic_int_set(&devc->tcp_eof, 1);
+			break;
+		}
+
+#if !defined(_WIN32) && defined(TCP_QUICKACK)
+		/* Quick ACKs get turned off by the stack, re-arm them. */
+		if (devc->tcp_quickack) {
+			opt = 1;
+			setsockopt(devc->socket, IPPROTO_TCP, TCP_QUICKACK,
+				&opt, sizeof(opt));
+		}
+#endif
+
+		g_mutex_lock(&devc->tcp_mutex);
+		devc->tcp_head += len;
+		g_mutex_unlock(&devc->tcp_mutex);
+	}
+
+	return NULL;
+}
+
+SR_PRIV int beaglelogic_tcp_stream_start(struct dev_context *devc)
+{
+	if (!(devc->tcp_ring = g_try_malloc(TCP_STREAM_RING_SIZE))) {
+		sr_err("Stream buffer malloc failed.");
+		return SR_ERR_MALLOC;
+	}
+	devc->tcp_head = devc->tcp_tail = 0;
+	devc->tcp_stop = 0;
+	devc->tcp_eof = 0;
+	g_mutex_init(&devc->tcp_mutex);
+
+	devc->tcp_thread = g_thread_try_new("beaglelogic-tcp",
+			beaglelogic_tcp_stream_thread, devc, NULL);
+	if (!devc->tcp_thread) {
+		sr_err("Failed to start the stream reader.");
+		g_mutex_clear(&devc->tcp_mutex);
+		g_free(devc->tcp_ring);
+		devc->tcp_ring = NULL;
+		return SR_ERR;
+	}
+
+	return SR_OK;
+}
+
+SR_PRIV void beaglelogic_tcp_stream_stop(struct dev_context *devc)
+{
+	if (!devc->tcp_thread)
+		return;
+
+	g_atomic_int_set(&devc->tcp_stop, 1);
+	g_thread_join(devc->tcp_thread);
+	devc->tcp_thread = NULL;
+
+	g_mutex_clear(&devc->tcp_mutex);
+	g_free(devc->tcp_ring);
+	devc->tcp_ring = NULL;
+}
+
+/*
+ * Get the oldest received data that is contiguous in the ring. Sets eof
+ * once the reader has stopped and all of its data was released.
+ */
+SR_PRIV size_t beaglelogic_tcp_stream_peek(struct dev_context *devc,
+		uint8_t **data, gboolean *eof)
+{
+	uint64_t head, tail;
+	size_t pos;
+	gboolean stopped;
+
+	/* Check this first, all data is in the ring once it is set. */
+	stopped = g_atomic_int_get(&devc->tcp_eof);
+
+	g_mutex_lock(&devc->tcp_mutex);
+	head = devc->tcp_head;
+	tail = devc->tcp_tail;
+	g_mutex_unlock(&devc->tcp_mutex);
+
+	*eof = stopped && (head == tail);
+
+	pos = tail % TCP_STREAM_RING_SIZE;
+	*data = devc->tcp_ring + pos;
+
+	return MIN(head - tail, TCP_STREAM_RING_SIZE - pos);
+}
+
+SR_PRIV void beaglelogic_tcp_stream_release(struct dev_context *devc,
+		size_t len)
+{
+	g_mutex_lock(&devc->tcp_mutex);
+	devc->tcp_tail += len;
+	g_mutex_unlock(&devc->tcp_mutex);
+}
+
 static int beaglelogic_tcp_get_string(struct dev_context *devc, const char *cmd,
 				      char **tcp_resp)
 {
@@ -21,14 +21,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#ifdef _WIN32
-#define _WIN32_WINNT 0x0501
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#else
-#include <sys/socket.h>
-#endif
-#include <errno.h>
 #include "protocol.h"
 #include "beaglelogic.h"
 
@@ -36,10 +28,45 @@
  * from the BeagleLogic kernel module */
 #define PACKET_SIZE	(512 * 1024)
 
+/*
+ * Number of bytes the kernel has filled beyond our read offset, derived
+ * from the index of the buffer unit it currently captures to. Returns -1
+ * if that is unknown. Only to be called when the descriptor is readable.
+ */
+static int64_t beaglelogic_native_available(int fd, struct dev_context *devc)
+{
+	uint32_t index, end, available;
+
+	if (!devc->bufunitsize || !devc->buffersize)
+		return -1;
+	if (ioctl(fd, IOCTL_BL_GET_CUR_INDEX, &index) < 0)
+		return -1;
+
+	end = ((uint64_t)index * devc->bufunitsize) % devc->buffersize;
+	available = (end + devc->buffersize - devc->offset) % devc->buffersize;
+
+	/*
+	 * With data pending, the kernel being back at our read offset
+	 * means it wrapped around: the whole buffer is filled, and the
+	 * oldest data may have been overwritten already.
+	 */
+	if (available == 0) {
+		sr_warn("Sample buffer full, samples may have been lost.");
+		available = devc->buffersize;
+	}
+
+	return available;
+}
+
 /* This implementation is zero copy from the libsigrok side.
  * It does not copy any data, just passes a pointer from the mmap'ed
  * kernel buffers appropriately. It is up to the application which is
  * using libsigrok to decide how to deal with the data.
+ *
+ * All buffer units which the kernel has filled are consumed in one go,
+ * as few large packets (the area may wrap around the end of the mmap'ed
+ * buffer). The read pointer only moves forward after the session has
+ * processed them, so the kernel can't reuse the memory too early.
  */
 SR_PRIV int beaglelogic_native_receive_data(int fd, int revents, void *cb_data)
 {
@@ -50,65 +77,81 @@ SR_PRIV int beaglelogic_native_receive_data(int fd, int revents, void *cb_data)
 
 	int trigger_offset;
 	int pre_trigger_samples;
-	uint32_t packetsize;
+	int64_t available;
+	uint32_t chunk, consumed;
 	uint64_t bytes_remaining;
+	gboolean eof;
 
 	if (!(sdi = cb_data) || !(devc = sdi->priv))
 		return TRUE;
 
-	packetsize = PACKET_SIZE;
+	eof = FALSE;
 	logic.unitsize = SAMPLEUNIT_TO_BYTES(devc->sampleunit);
 
 	if (revents == G_IO_IN) {
-		sr_info("In callback G_IO_IN, offset=%d", devc->offset);
-
-		bytes_remaining = (devc->limit_samples * logic.unitsize) -
-				devc->bytes_read;
-
-		/* Configure data packet */
-		packet.type = SR_DF_LOGIC;
-		packet.payload = &logic;
-		logic.data = devc->sample_buf + devc->offset;
-		logic.length = MIN(packetsize, bytes_remaining);
-
-		if (devc->trigger_fired) {
-			/* Send the incoming transfer to the session bus. */
-			sr_session_send(sdi, &packet);
-		} else {
-			/* Check for trigger */
-			trigger_offset = soft_trigger_logic_check(devc->stl,
-					logic.data, packetsize, &pre_trigger_samples);
-			if (trigger_offset > -1) {
-				devc->bytes_read += pre_trigger_samples * logic.unitsize;
-				trigger_offset *= logic.unitsize;
-				logic.length = MIN(packetsize - trigger_offset,
-						bytes_remaining);
-				logic.data += trigger_offset;
-
+		/* Fall back to one slice per wakeup if the fill level is unknown. */
+		available = beaglelogic_native_available(fd, devc);
+		if (available < 0)
+			available = PACKET_SIZE;
+
+		sr_dbg("In callback G_IO_IN, offset=%d, %" PRIi64 " bytes ready.",
+			devc->offset, available);
+
+		consumed = 0;
+		while (available > 0 && !eof &&
+				devc->bytes_read < devc->limit_samples * logic.unitsize) {
+			/* Don't run past the end of the mmap'ed buffer. */
+			chunk = MIN(available, devc->buffersize - devc->offset);
+
+			bytes_remaining = (devc->limit_samples * logic.unitsize) -
+					devc->bytes_read;
+
+			/* Configure data packet */
+			packet.type = SR_DF_LOGIC;
+			packet.payload = &logic;
+			logic.data = devc->sample_buf + devc->offset;
+			logic.length = MIN(chunk, bytes_remaining);
+
+			if (devc->trigger_fired) {
+				/* Send the incoming transfer to the session bus. */
 				sr_session_send(sdi, &packet);
+			} else {
+				/* Check for trigger, only in data not seen before. */
+				trigger_offset = soft_trigger_logic_check(devc->stl,
+						logic.data, chunk, &pre_trigger_samples);
+				if (trigger_offset > -1) {
+					devc->bytes_read += pre_trigger_samples * logic.unitsize;
+					trigger_offset *= logic.unitsize;
+					logic.length = MIN(chunk - trigger_offset,
+							bytes_remaining);
+					logic.data += trigger_offset;
+
+					sr_session_send(sdi, &packet);
+
+					devc->trigger_fired = TRUE;
+				}
+			}
 
-				devc->trigger_fired = TRUE;
+			/* Update byte count and offset (roll over if needed) */
+			devc->bytes_read += logic.length;
+			consumed += chunk;
+			available -= chunk;
+			if ((devc->offset += chunk) >= devc->buffersize) {
+				/* One shot capture, we abort and settle with less than
+				 * the required number of samples */
+				if (devc->triggerflags == BL_TRIGGERFLAGS_CONTINUOUS)
+					devc->offset = 0;
+				else
+					eof = TRUE;
 			}
 		}
 
-		/* Move the read pointer forward */
-		lseek(fd, packetsize, SEEK_CUR);
-
-		/* Update byte count and offset (roll over if needed) */
-		devc->bytes_read += logic.length;
-		if ((devc->offset += packetsize) >= devc->buffersize) {
-			/* One shot capture, we abort and settle with less than
-			 * the required number of samples */
-			if (devc->triggerflags == BL_TRIGGERFLAGS_CONTINUOUS)
-				devc->offset = 0;
-			else
-				packetsize = 0;
-		}
+		/* Move the read pointer forward, releasing the buffers. */
+		lseek(fd, consumed, SEEK_CUR);
 	}
 
 	/* EOF Received or we have reached the limit */
-	if (devc->bytes_read >= devc->limit_samples * logic.unitsize ||
-			packetsize == 0) {
+	if (devc->bytes_read >= devc->limit_samples * logic.unitsize || eof) {
 		/* Send EOA Packet, stop polling */
 		std_session_send_df_end(sdi);
 		sr_session_source_remove_pollfd(sdi->session, &devc->pollfd);
@@ -117,6 +160,10 @@ SR_PRIV int beaglelogic_native_receive_data(int fd, int revents, void *cb_data)
 	return TRUE;
 }
 
+/*
+ * Consume the data which the stream reader thread has received so far.
+ * Runs periodically, packets point into the reader's ring buffer.
+ */
 SR_PRIV int beaglelogic_tcp_receive_data(int fd, int revents, void *cb_data)
 {
 	const struct sr_dev_inst *sdi;
@@ -124,28 +171,26 @@ SR_PRIV int beaglelogic_tcp_receive_data(int fd, int revents, void *cb_data)
 	struct sr_datafeed_packet packet;
 	struct sr_datafeed_logic logic;
 
-	int len;
 	int pre_trigger_samples;
 	int trigger_offset;
-	uint32_t packetsize;
+	uint8_t *data;
+	size_t len;
 	uint64_t bytes_remaining;
+	gboolean eof;
+
+	(void)fd;
+	(void)revents;
 
 	if (!(sdi = cb_data) || !(devc = sdi->priv))
 		return TRUE;
 
-	packetsize = TCP_BUFFER_SIZE;
 	logic.unitsize = SAMPLEUNIT_TO_BYTES(devc->sampleunit);
+	eof = FALSE;
 
-	if (revents == G_IO_IN) {
-		sr_info("In callback G_IO_IN");
-
-		len = recv(fd, devc->tcp_buffer, TCP_BUFFER_SIZE, 0);
-		if (len < 0) {
-			sr_err("Receive error: %s", g_strerror(errno));
-			return SR_ERR;
-		}
-
-		packetsize = len;
+	while (!eof && devc->bytes_read < devc->limit_samples * logic.unitsize) {
+		len = beaglelogic_tcp_stream_peek(devc, &data, &eof);
+		if (!len)
+			break;
 
 		bytes_remaining = (devc->limit_samples * logic.unitsize) -
 				devc->bytes_read;
@@ -153,8 +198,8 @@ SR_PRIV int beaglelogic_tcp_receive_data(int fd, int revents, void *cb_data)
 		/* Configure data packet */
 		packet.type = SR_DF_LOGIC;
 		packet.payload = &logic;
-		logic.data = devc->tcp_buffer;
-		logic.length = MIN(packetsize, bytes_remaining);
+		logic.data = data;
+		logic.length = MIN(len, bytes_remaining);
 
 		if (devc->trigger_fired) {
 			/* Send the incoming transfer to the session bus. */
@@ -162,11 +207,11 @@ SR_PRIV int beaglelogic_tcp_receive_data(int fd, int revents, void *cb_data)
 		} else {
 			/* Check for trigger */
 			trigger_offset = soft_trigger_logic_check(devc->stl,
-					logic.data, packetsize, &pre_trigger_samples);
+					logic.data, len, &pre_trigger_samples);
 			if (trigger_offset > -1) {
 				devc->bytes_read += pre_trigger_samples * logic.unitsize;
 				trigger_offset *= logic.unitsize;
-				logic.length = MIN(packetsize - trigger_offset,
+				logic.length = MIN(len - trigger_offset,
 						bytes_remaining);
 				logic.data += trigger_offset;
 
@@ -176,29 +221,31 @@ SR_PRIV int beaglelogic_tcp_receive_data(int fd, int revents, void *cb_data)
 			}
 		}
 
+		beaglelogic_tcp_stream_release(devc, len);
+
 		/* Update byte count and offset (roll over if needed) */
 		devc->bytes_read += logic.length;
-		if ((devc->offset += packetsize) >= devc->buffersize) {
+		if ((devc->offset += len) >= devc->buffersize) {
 			/* One shot capture, we abort and settle with less than
 			 * the required number of samples */
 			if (devc->triggerflags == BL_TRIGGERFLAGS_CONTINUOUS)
 				devc->offset = 0;
 			else
-				packetsize = 0;
+				eof = TRUE;
 		}
 	}
 
 	/* EOF Received or we have reached the limit */
-	if (devc->bytes_read >= devc->limit_samples * logic.unitsize ||
-			packetsize == 0) {
+	if (devc->bytes_read >= devc->limit_samples * logic.unitsize || eof) {
 		/* Send EOA Packet, stop polling */
 		std_session_send_df_end(sdi);
+		beaglelogic_tcp_stream_stop(devc);
 		devc->beaglelogic->stop(devc);
 
 		/* Drain the receive buffer */
 		beaglelogic_tcp_drain(devc);
 
-		sr_session_source_remove_pollfd(sdi->session, &devc->pollfd);
+		sr_session_source_remove(sdi->session, -1);
 	}
 
 	return TRUE;
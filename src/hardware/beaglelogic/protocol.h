@@ -32,7 +32,10 @@
 
 #define SAMPLEUNIT_TO_BYTES(x)	((x) == 1 ? 1 : 2)
 
-#define TCP_BUFFER_SIZE         (128 * 1024)
+/* TCP streaming: ring size, socket receive buffer, session poll period */
+#define TCP_STREAM_RING_SIZE    (32 * 1024 * 1024)
+#define TCP_STREAM_RCVBUF       (8 * 1024 * 1024)
+#define TCP_STREAM_POLL_MS      10
 
 /** Private, per-device-instance driver context. */
 struct dev_context {
@@ -47,7 +50,18 @@ struct dev_context {
 	char *port;
 	int socket;
 	unsigned int read_timeout;
-	unsigned char *tcp_buffer;
+	/* Latency tuning, from the "nodelay" and "quickack" conn flags. */
+	gboolean tcp_nodelay;
+	gboolean tcp_quickack;
+
+	/* TCP streaming: ring buffer filled by a reader thread */
+	GThread *tcp_thread;
+	GMutex tcp_mutex;
+	uint8_t *tcp_ring;
+	uint64_t tcp_head;
+	uint64_t tcp_tail;
+	int tcp_stop;
+	int tcp_eof;
 
 	/* Acquisition settings: see beaglelogic.h */
 	uint64_t cur_samplerate;
@@ -147,7 +147,7 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 	std_session_send_df_header(sdi);
 
 	serial = sdi->conn;
-	serial_source_add(sdi->session, serial, G_IO_IN, 50,
+	serial_reactor_add(sdi->session, serial, G_IO_IN, 50,
 			brymen_dmm_receive_data, (void *)sdi);
 
 	return SR_OK;
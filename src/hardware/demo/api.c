@@ -34,6 +34,9 @@
 #define DEFAULT_NUM_ANALOG_CHANNELS	4
 #define DEFAULT_ANALOG_AMPLITUDE	10
 
+#define DEFAULT_EDGE_INTERVAL		1000
+#define DEFAULT_BURST_LENGTH		16
+
 /* Note: No spaces allowed because of sigrok-cli. */
 static const char *logic_pattern_str[] = {
 	"sigrok",
@@ -44,6 +47,9 @@ static const char *logic_pattern_str[] = {
 	"all-low",
 	"all-high",
 	"squid",
+	"sparse",
+	"spi",
+	"bus",
 };
 
 static const uint32_t scanopts[] = {
@@ -64,19 +70,28 @@ static const uint32_t devopts[] = {
 	SR_CONF_SAMPLERATE | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
 	SR_CONF_AVERAGING | SR_CONF_GET | SR_CONF_SET,
 	SR_CONF_AVG_SAMPLES | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_BENCHMARK | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_WORKER_THREADS | SR_CONF_GET | SR_CONF_SET,
 };
 
 static const uint32_t devopts_cg_logic[] = {
 	SR_CONF_PATTERN_MODE | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
+	SR_CONF_PACKET_SIZE | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_LOGIC_UNITSIZE | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_EDGE_INTERVAL | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_GLITCH_INTERVAL | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_BURST_LENGTH | SR_CONF_GET | SR_CONF_SET,
 };
 
 static const uint32_t devopts_cg_analog_group[] = {
 	SR_CONF_AMPLITUDE | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_NOISE_LEVEL | SR_CONF_GET | SR_CONF_SET,
 };
 
 static const uint32_t devopts_cg_analog_channel[] = {
 	SR_CONF_PATTERN_MODE | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
 	SR_CONF_AMPLITUDE | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_NOISE_LEVEL | SR_CONF_GET | SR_CONF_SET,
 };
 
 static const uint64_t samplerates[] = {
@@ -119,6 +134,9 @@ static GSList *scan(struct sr_dev_driver *di, GSList *options)
 	devc->cur_samplerate = SR_KHZ(200);
 	devc->num_logic_channels = num_logic_channels;
 	devc->logic_unitsize = (devc->num_logic_channels + 7) / 8;
+	devc->logic_bufsize = LOGIC_BUFSIZE;
+	devc->edge_interval = DEFAULT_EDGE_INTERVAL;
+	devc->burst_length = DEFAULT_BURST_LENGTH;
 	devc->logic_pattern = DEFAULT_LOGIC_PATTERN;
 	devc->num_analog_channels = num_analog_channels;
 
@@ -159,6 +177,7 @@ static GSList *scan(struct sr_dev_driver *di, GSList *options)
 			ag = g_malloc(sizeof(struct analog_gen));
 			ag->ch = ch;
 			ag->amplitude = DEFAULT_ANALOG_AMPLITUDE;
+			ag->noise_level = 0;
 			sr_analog_init(&ag->packet, &ag->encoding, &ag->meaning, &ag->spec, 2);
 			ag->packet.meaning->channels = cg->channels;
 			ag->packet.meaning->mq = 0;
@@ -190,6 +209,8 @@ static void clear_helper(struct dev_context *devc)
 	while (g_hash_table_iter_next(&iter, NULL, &value))
 		g_free(value);
 	g_hash_table_unref(devc->ch_ag);
+
+	demo_free_logic(devc);
 }
 
 static int dev_clear(const struct sr_dev_driver *di)
@@ -225,6 +246,27 @@ static int config_get(uint32_t key, GVariant **data,
 	case SR_CONF_AVG_SAMPLES:
 		*data = g_variant_new_uint64(devc->avg_samples);
 		break;
+	case SR_CONF_BENCHMARK:
+		*data = g_variant_new_boolean(devc->benchmark);
+		break;
+	case SR_CONF_WORKER_THREADS:
+		*data = g_variant_new_uint64(devc->worker_threads);
+		break;
+	case SR_CONF_PACKET_SIZE:
+		*data = g_variant_new_uint64(devc->logic_bufsize);
+		break;
+	case SR_CONF_LOGIC_UNITSIZE:
+		*data = g_variant_new_uint64(devc->logic_unitsize);
+		break;
+	case SR_CONF_EDGE_INTERVAL:
+		*data = g_variant_new_uint64(devc->edge_interval);
+		break;
+	case SR_CONF_GLITCH_INTERVAL:
+		*data = g_variant_new_uint64(devc->glitch_interval);
+		break;
+	case SR_CONF_BURST_LENGTH:
+		*data = g_variant_new_uint64(devc->burst_length);
+		break;
 	case SR_CONF_PATTERN_MODE:
 		if (!cg)
 			return SR_ERR_CHANNEL_GROUP;
@@ -250,6 +292,15 @@ static int config_get(uint32_t key, GVariant **data,
 		ag = g_hash_table_lookup(devc->ch_ag, ch);
 		*data = g_variant_new_double(ag->amplitude);
 		break;
+	case SR_CONF_NOISE_LEVEL:
+		if (!cg)
+			return SR_ERR_CHANNEL_GROUP;
+		ch = cg->channels->data;
+		if (ch->type != SR_CHANNEL_ANALOG)
+			return SR_ERR_ARG;
+		ag = g_hash_table_lookup(devc->ch_ag, ch);
+		*data = g_variant_new_double(ag->noise_level);
+		break;
 	default:
 		return SR_ERR_NA;
 	}
@@ -265,6 +316,7 @@ static int config_set(uint32_t key, GVariant *data,
 	struct sr_channel *ch;
 	GSList *l;
 	int logic_pattern, analog_pattern;
+	uint64_t u64;
 
 	devc = sdi->priv;
 
@@ -288,6 +340,47 @@ static int config_set(uint32_t key, GVariant *data,
 		devc->avg_samples = g_variant_get_uint64(data);
 		sr_dbg("Setting averaging rate to %" PRIu64, devc->avg_samples);
 		break;
+	case SR_CONF_BENCHMARK:
+		devc->benchmark = g_variant_get_boolean(data);
+		sr_dbg("%s benchmark mode", devc->benchmark ? "Enabling" : "Disabling");
+		break;
+	case SR_CONF_WORKER_THREADS:
+		u64 = g_variant_get_uint64(data);
+		if (u64 > DEMO_MAX_WORKER_THREADS)
+			return SR_ERR_ARG;
+		devc->worker_threads = u64;
+		break;
+	case SR_CONF_PACKET_SIZE:
+		u64 = g_variant_get_uint64(data);
+		if (u64 == 0 || u64 > LOGIC_MAX_BUFSIZE)
+			return SR_ERR_ARG;
+		devc->logic_bufsize = u64;
+		break;
+	case SR_CONF_LOGIC_UNITSIZE:
+		if (devc->num_logic_channels <= 0)
+			return SR_ERR_NA;
+		/* The pattern table is sized for the unit size at start. */
+		if (devc->logic_data)
+			return SR_ERR_NA;
+		u64 = g_variant_get_uint64(data);
+		if (u64 < (uint64_t)(devc->num_logic_channels + 7) / 8
+				|| u64 > LOGIC_MAX_UNITSIZE)
+			return SR_ERR_ARG;
+		devc->logic_unitsize = u64;
+		break;
+	case SR_CONF_EDGE_INTERVAL:
+		if ((u64 = g_variant_get_uint64(data)) == 0)
+			return SR_ERR_ARG;
+		devc->edge_interval = u64;
+		break;
+	case SR_CONF_GLITCH_INTERVAL:
+		devc->glitch_interval = g_variant_get_uint64(data);
+		break;
+	case SR_CONF_BURST_LENGTH:
+		if ((u64 = g_variant_get_uint64(data)) == 0)
+			return SR_ERR_ARG;
+		devc->burst_length = u64;
+		break;
 	case SR_CONF_PATTERN_MODE:
 		if (!cg)
 			return SR_ERR_CHANNEL_GROUP;
@@ -303,11 +396,6 @@ static int config_set(uint32_t key, GVariant *data,
 				sr_dbg("Setting logic pattern to %s",
 						logic_pattern_str[logic_pattern]);
 				devc->logic_pattern = logic_pattern;
-				/* Might as well do this now, these are static. */
-				if (logic_pattern == PATTERN_ALL_LOW)
-					memset(devc->logic_data, 0x00, LOGIC_BUFSIZE);
-				else if (logic_pattern == PATTERN_ALL_HIGH)
-					memset(devc->logic_data, 0xff, LOGIC_BUFSIZE);
 			} else if (ch->type == SR_CHANNEL_ANALOG) {
 				if (analog_pattern == -1)
 					return SR_ERR_ARG;
@@ -330,6 +418,17 @@ static int config_set(uint32_t key, GVariant *data,
 			ag->amplitude = g_variant_get_double(data);
 		}
 		break;
+	case SR_CONF_NOISE_LEVEL:
+		if (!cg)
+			return SR_ERR_CHANNEL_GROUP;
+		for (l = cg->channels; l; l = l->next) {
+			ch = l->data;
+			if (ch->type != SR_CHANNEL_ANALOG)
+				return SR_ERR_ARG;
+			ag = g_hash_table_lookup(devc->ch_ag, ch);
+			ag->noise_level = g_variant_get_double(data);
+		}
+		break;
 	default:
 		return SR_ERR_NA;
 	}
@@ -397,6 +496,7 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 	uint8_t mask;
 	GHashTableIter iter;
 	void *value;
+	int ret;
 
 	devc = sdi->priv;
 	devc->sent_samples = 0;
@@ -440,6 +540,10 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 		devc->first_partial_logic_index,
 		devc->first_partial_logic_mask);
 
+	/* Pre-render the logic pattern, or prepare the random generator. */
+	if ((ret = demo_prepare_logic(devc)) != SR_OK)
+		return ret;
+
 	/*
 	 * Have the waveform for analog patterns pre-generated. It's
 	 * supposed to be periodic, so the generator just needs to
@@ -449,7 +553,13 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 	while (g_hash_table_iter_next(&iter, NULL, &value))
 		demo_generate_analog_pattern(value, devc->cur_samplerate);
 
-	sr_session_source_add(sdi->session, -1, 0, 100,
+	/* Optionally render upcoming packets on worker threads. */
+	if ((ret = demo_render_start(devc)) != SR_OK) {
+		demo_free_logic(devc);
+		return ret;
+	}
+
+	sr_session_source_add(sdi->session, -1, 0, devc->benchmark ? 0 : 100,
 			demo_prepare_data, (struct sr_dev_inst *)sdi);
 
 	std_session_send_df_header(sdi);
@@ -467,7 +577,24 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 
 static int dev_acquisition_stop(struct sr_dev_inst *sdi)
 {
+	struct dev_context *devc;
+	int64_t elapsed_us;
+	double rate;
+
+	devc = sdi->priv;
+
 	sr_session_source_remove(sdi->session, -1);
+	demo_render_stop(devc);
+
+	if (devc->benchmark) {
+		elapsed_us = MAX(1, g_get_monotonic_time() - devc->start_us);
+		rate = (double)devc->sent_samples * G_USEC_PER_SEC / elapsed_us;
+		sr_info("Benchmark: %" PRIu64 " samples in %.3f s, %.2f MS/s "
+			"(%.2f MB/s logic).", devc->sent_samples,
+			elapsed_us / 1e6, rate / 1e6,
+			rate * devc->logic_unitsize / 1e6);
+	}
+	demo_free_logic(devc);
 
 	if (SAMPLES_PER_FRAME > 0)
 		std_session_send_frame_end(sdi);
@@ -172,6 +172,46 @@ static const uint8_t pattern_squid[128][128 / 8] = {
 	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, },
 };
 
+/*
+ * xoshiro256** by David Blackman and Sebastiano Vigna (public domain).
+ * Much cheaper than rand(), and yields 64 bits per step.
+ */
+static inline uint64_t rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t xoshiro_next(uint64_t *s)
+{
+	uint64_t result, t;
+
+	result = rotl(s[1] * 5, 7) * 9;
+	t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+
+	return result;
+}
+
+/* Seed the generator from splitmix64, as recommended by the authors. */
+static void xoshiro_seed(uint64_t *s, uint64_t seed)
+{
+	uint64_t z;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		z = (seed += 0x9e3779b97f4a7c15ULL);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		s[i] = z ^ (z >> 31);
+	}
+}
+
 SR_PRIV void demo_generate_analog_pattern(struct analog_gen *ag, uint64_t sample_rate)
 {
 	double t, frequency;
@@ -181,6 +221,9 @@ SR_PRIV void demo_generate_analog_pattern(struct analog_gen *ag, uint64_t sample
 
 	sr_dbg("Generating %s pattern.", analog_pattern_str[ag->pattern]);
 
+	/* Every channel gets its own, reproducible noise. */
+	xoshiro_seed(ag->xoshiro_state, ag->ch->index);
+
 	num_samples = ANALOG_BUFSIZE / sizeof(float);
 
 	switch (ag->pattern) {
@@ -245,86 +288,197 @@ SR_PRIV void demo_generate_analog_pattern(struct analog_gen *ag, uint64_t sample
 	}
 }
 
-static void logic_generator(struct sr_dev_inst *sdi, uint64_t size)
+/* Number of samples after which a logic pattern repeats. */
+static uint64_t logic_pattern_period(const struct dev_context *devc)
 {
-	struct dev_context *devc;
-	uint64_t i, j;
-	uint8_t pat;
+	switch (devc->logic_pattern) {
+	case PATTERN_SIGROK:
+		return sizeof(pattern_sigrok);
+	case PATTERN_INC:
+		return 256;
+	case PATTERN_WALKING_ONE:
+	case PATTERN_WALKING_ZERO:
+		/* One state per channel, plus the all-zero (all-one) state. */
+		return devc->num_logic_channels + 1;
+	case PATTERN_SQUID:
+		return ARRAY_SIZE(pattern_squid);
+	case PATTERN_RANDOM:
+	case PATTERN_SPARSE:
+	case PATTERN_SPI:
+	case PATTERN_BUS:
+		return 0;
+	default:
+		return 1;
+	}
+}
+
+/* A random interval in [1, 2 * mean - 1], i.e. averaging to mean. */
+static uint64_t random_interval(uint64_t *s, uint64_t mean)
+{
+	return 1 + xoshiro_next(s) % (2 * MAX(mean, 1) - 1);
+}
+
+/* Repeat one sample count times, doubling the copied range each round. */
+static void logic_fill_repeat(uint8_t *dst, const uint8_t *sample,
+		size_t unitsize, uint64_t count)
+{
+	uint64_t done, n;
+
+	if (unitsize == 1) {
+		memset(dst, sample[0], count);
+		return;
+	}
+
+	memcpy(dst, sample, unitsize);
+	for (done = 1; done < count; done += n) {
+		n = MIN(done, count - done);
+		memcpy(dst + done * unitsize, dst, n * unitsize);
+	}
+}
+
+/*
+ * Advance a workload profile to its next state: update the sample
+ * value, and the number of samples it is held for.
+ */
+static void logic_profile_step(struct dev_context *devc)
+{
+	uint64_t r, p, bit;
+	unsigned int ch, j;
+
+	switch (devc->logic_pattern) {
+	case PATTERN_SPARSE:
+		r = xoshiro_next(devc->xoshiro_state);
+		ch = r % devc->num_logic_channels;
+		devc->gen_value[ch / 8] ^= 1 << (ch % 8);
+		devc->gen_hold = random_interval(devc->xoshiro_state,
+			devc->edge_interval);
+		break;
+	case PATTERN_SPI:
+		/*
+		 * Phase 0 asserts CS#, then every bit takes two phases
+		 * (CLK low with new data, CLK high), and the last phase
+		 * releases CS# for the idle gap.
+		 */
+		p = devc->gen_phase++;
+		devc->gen_hold = 1;
+		if (p == 0) {
+			devc->gen_value[0] = 0x00;
+			break;
+		}
+		if (p > 16 * devc->burst_length) {
+			devc->gen_value[0] = 1 << 3;
+			devc->gen_hold = random_interval(devc->xoshiro_state,
+				devc->edge_interval);
+			devc->gen_phase = 0;
+			break;
+		}
+		p--;
+		if (p % 16 == 0) {
+			r = xoshiro_next(devc->xoshiro_state);
+			devc->gen_mosi = r & 0xff;
+			devc->gen_miso = (r >> 8) & 0xff;
+		}
+		bit = 7 - (p % 16) / 2;
+		devc->gen_value[0] = (p % 2)
+			| ((devc->gen_mosi >> bit) & 1) << 1
+			| ((devc->gen_miso >> bit) & 1) << 2;
+		break;
+	case PATTERN_BUS:
+		for (j = 0; j < devc->logic_unitsize; j += sizeof(r)) {
+			r = xoshiro_next(devc->xoshiro_state);
+			memcpy(devc->gen_value + j, &r,
+				MIN(sizeof(r), devc->logic_unitsize - j));
+		}
+		devc->gen_hold = devc->edge_interval;
+		break;
+	default:
+		sr_err("Unknown pattern: %d.", devc->logic_pattern);
+		devc->gen_hold = UINT64_MAX;
+		break;
+	}
+}
+
+/*
+ * Generate profile data. Stretches of a constant sample are filled
+ * in bulk, which keeps low activity profiles at memory bandwidth.
+ * Glitches, if enabled, invert one random channel for one sample.
+ */
+static void logic_profile_generate(struct dev_context *devc,
+		uint8_t *data, uint64_t count)
+{
+	uint64_t pos, n;
+	size_t unitsize;
+	unsigned int ch;
 	uint8_t *sample;
-	const uint8_t *image_col;
-	size_t col_count, col_height;
 
-	devc = sdi->priv;
+	unitsize = devc->logic_unitsize;
+	pos = 0;
+	while (pos < count) {
+		if (devc->gen_hold == 0) {
+			logic_profile_step(devc);
+			continue;
+		}
+		n = MIN(devc->gen_hold, count - pos);
+		if (devc->glitch_interval)
+			n = MIN(n, devc->gen_next_glitch);
+		if (n == 0) {
+			sample = data + pos * unitsize;
+			memcpy(sample, devc->gen_value, unitsize);
+			ch = xoshiro_next(devc->xoshiro_state) % devc->num_logic_channels;
+			sample[ch / 8] ^= 1 << (ch % 8);
+			devc->gen_next_glitch = random_interval(devc->xoshiro_state,
+				devc->glitch_interval);
+			devc->gen_hold--;
+			pos++;
+			continue;
+		}
+		logic_fill_repeat(data + pos * unitsize, devc->gen_value,
+			unitsize, n);
+		devc->gen_hold -= n;
+		if (devc->glitch_interval)
+			devc->gen_next_glitch -= n;
+		pos += n;
+	}
+}
+
+static void logic_render_sample(const struct dev_context *devc,
+		uint64_t step, uint8_t *sample)
+{
+	unsigned int j, unitsize;
+	uint8_t pat;
+
+	unitsize = devc->logic_unitsize;
 
 	switch (devc->logic_pattern) {
 	case PATTERN_SIGROK:
-		memset(devc->logic_data, 0x00, size);
-		for (i = 0; i < size; i += devc->logic_unitsize) {
-			for (j = 0; j < devc->logic_unitsize; j++) {
-				pat = pattern_sigrok[(devc->step + j) % sizeof(pattern_sigrok)] >> 1;
-				devc->logic_data[i + j] = ~pat;
-			}
-			devc->step++;
+		for (j = 0; j < unitsize; j++) {
+			pat = pattern_sigrok[(step + j) % sizeof(pattern_sigrok)] >> 1;
+			sample[j] = ~pat;
 		}
 		break;
-	case PATTERN_RANDOM:
-		for (i = 0; i < size; i++)
-			devc->logic_data[i] = (uint8_t)(rand() & 0xff);
-		break;
 	case PATTERN_INC:
-		for (i = 0; i < size; i++) {
-			for (j = 0; j < devc->logic_unitsize; j++)
-				devc->logic_data[i + j] = devc->step;
-			devc->step++;
-		}
+		memset(sample, step & 0xff, unitsize);
 		break;
 	case PATTERN_WALKING_ONE:
-		/* j contains the value of the highest bit */
-	        j = 1 << (devc->num_logic_channels - 1);
-		for (i = 0; i < size; i++) {
-			devc->logic_data[i] = devc->step;
-			if (devc->step == 0)
-				devc->step = 1;
-			else
-				if (devc->step == j)
-					devc->step = 0;
-				else
-					devc->step <<= 1;
-		}
-		break;
 	case PATTERN_WALKING_ZERO:
-		/* Same as walking one, only with inverted output */
-		/* j contains the value of the highest bit */
-	        j = 1 << (devc->num_logic_channels - 1);
-		for (i = 0; i < size; i++) {
-			devc->logic_data[i] = ~devc->step;
-			if (devc->step == 0)
-				devc->step = 1;
-			else
-				if (devc->step == j)
-					devc->step = 0;
-				else
-					devc->step <<= 1;
+		/* Step 0 is the all-zero state, step n has bit n - 1 set. */
+		memset(sample, 0x00, unitsize);
+		if (step > 0)
+			sample[(step - 1) / 8] = 1 << ((step - 1) % 8);
+		if (devc->logic_pattern == PATTERN_WALKING_ZERO) {
+			for (j = 0; j < unitsize; j++)
+				sample[j] = ~sample[j];
 		}
 		break;
 	case PATTERN_ALL_LOW:
+		memset(sample, 0x00, unitsize);
+		break;
 	case PATTERN_ALL_HIGH:
-		/* These were set when the pattern mode was selected. */
+		memset(sample, 0xff, unitsize);
 		break;
 	case PATTERN_SQUID:
-		memset(devc->logic_data, 0x00, size);
-		col_count = ARRAY_SIZE(pattern_squid);
-		col_height = ARRAY_SIZE(pattern_squid[0]);
-		for (i = 0; i < size; i += devc->logic_unitsize) {
-			sample = &devc->logic_data[i];
-			image_col = pattern_squid[devc->step];
-			for (j = 0; j < devc->logic_unitsize; j++) {
-				pat = image_col[j % col_height];
-				sample[j] = pat;
-			}
-			devc->step++;
-			devc->step %= col_count;
-		}
+		for (j = 0; j < unitsize; j++)
+			sample[j] = pattern_squid[step][j % ARRAY_SIZE(pattern_squid[0])];
 		break;
 	default:
 		sr_err("Unknown pattern: %d.", devc->logic_pattern);
@@ -339,8 +493,8 @@ static void logic_generator(struct sr_dev_inst *sdi, uint64_t size)
  * TODO: Need we apply a channel map, and enforce a dense representation
  * of the enabled channels' data?
  */
-static void logic_fixup_feed(struct dev_context *devc,
-		struct sr_datafeed_logic *logic)
+static void logic_fixup_feed(const struct dev_context *devc,
+		uint8_t *data, uint64_t length)
 {
 	size_t fp_off;
 	uint8_t fp_mask;
@@ -349,17 +503,132 @@ static void logic_fixup_feed(struct dev_context *devc,
 
 	fp_off = devc->first_partial_logic_index;
 	fp_mask = devc->first_partial_logic_mask;
-	if (fp_off == logic->unitsize)
+	if (fp_off >= devc->logic_unitsize)
 		return;
 
-	for (off = 0; off < logic->length; off += logic->unitsize) {
-		sample = logic->data + off;
+	for (off = 0; off < length; off += devc->logic_unitsize) {
+		sample = data + off;
 		sample[fp_off] &= fp_mask;
-		for (idx = fp_off + 1; idx < logic->unitsize; idx++)
+		for (idx = fp_off + 1; idx < devc->logic_unitsize; idx++)
 			sample[idx] = 0x00;
 	}
 }
 
+/*
+ * Allocate the logic buffer for an acquisition. Periodic patterns get
+ * rendered once, one period followed by as much of its repetition as
+ * a packet can hold. Every packet then is a window into that table,
+ * and needs neither generating nor copying.
+ */
+SR_PRIV int demo_prepare_logic(struct dev_context *devc)
+{
+	uint64_t rows, done, n;
+	size_t unitsize;
+
+	demo_free_logic(devc);
+
+	if (devc->num_logic_channels <= 0) {
+		devc->logic_packet_samples = LOGIC_BUFSIZE;
+		return SR_OK;
+	}
+
+	unitsize = devc->logic_unitsize;
+	devc->logic_packet_samples = MAX(1, devc->logic_bufsize / unitsize);
+	devc->logic_period = logic_pattern_period(devc);
+	rows = devc->logic_period + devc->logic_packet_samples;
+
+	devc->logic_data = g_try_malloc0(rows * unitsize);
+	if (!devc->logic_data) {
+		sr_err("Logic buffer malloc failed.");
+		return SR_ERR_MALLOC;
+	}
+
+	if (devc->logic_period == 0) {
+		xoshiro_seed(devc->xoshiro_state, 0);
+		memset(devc->gen_value, 0x00, sizeof(devc->gen_value));
+		devc->gen_hold = 0;
+		devc->gen_phase = 0;
+		devc->gen_next_glitch = random_interval(devc->xoshiro_state,
+			devc->glitch_interval);
+		return SR_OK;
+	}
+
+	for (done = 0; done < devc->logic_period; done++)
+		logic_render_sample(devc, done, devc->logic_data + done * unitsize);
+	logic_fixup_feed(devc, devc->logic_data, done * unitsize);
+
+	while (done < rows) {
+		n = MIN(done, rows - done);
+		memcpy(devc->logic_data + done * unitsize, devc->logic_data,
+			n * unitsize);
+		done += n;
+	}
+
+	return SR_OK;
+}
+
+SR_PRIV void demo_free_logic(struct dev_context *devc)
+{
+	g_free(devc->logic_data);
+	devc->logic_data = NULL;
+}
+
+/*
+ * Generate size bytes of logic data. Periodic patterns return a window
+ * into the pre-rendered table, all others get generated into buf.
+ */
+static uint8_t *logic_generator(struct dev_context *devc, uint8_t *buf,
+		uint64_t size)
+{
+	uint8_t *data;
+	uint64_t i, r;
+
+	if (devc->logic_period) {
+		data = devc->logic_data + devc->step * devc->logic_unitsize;
+		devc->step += size / devc->logic_unitsize;
+		devc->step %= devc->logic_period;
+		return data;
+	}
+
+	data = buf;
+	if (devc->logic_pattern != PATTERN_RANDOM) {
+		logic_profile_generate(devc, data, size / devc->logic_unitsize);
+		logic_fixup_feed(devc, data, size);
+		return data;
+	}
+
+	for (i = 0; i + sizeof(r) <= size; i += sizeof(r)) {
+		r = xoshiro_next(devc->xoshiro_state);
+		memcpy(data + i, &r, sizeof(r));
+	}
+	if (i < size) {
+		r = xoshiro_next(devc->xoshiro_state);
+		memcpy(data + i, &r, size - i);
+	}
+	logic_fixup_feed(devc, data, size);
+
+	return data;
+}
+
+/* Add uniformly distributed noise in [-noise_level, noise_level). */
+static void analog_add_noise(struct analog_gen *ag, const float *in,
+		float *out, uint64_t count)
+{
+	uint64_t i, r;
+	float scale;
+
+	scale = ag->noise_level / 2147483648.0f;
+	for (i = 0; i + 1 < count; i += 2) {
+		r = xoshiro_next(ag->xoshiro_state);
+		out[i] = in[i] + (int32_t)(uint32_t)r * scale;
+		out[i + 1] = in[i + 1] + (int32_t)(r >> 32) * scale;
+	}
+	if (i < count) {
+		r = xoshiro_next(ag->xoshiro_state);
+		out[i] = in[i] + (int32_t)(uint32_t)r * scale;
+	}
+}
+
 static void send_analog_packet(struct analog_gen *ag,
 		struct sr_dev_inst *sdi, uint64_t *analog_sent,
 		uint64_t analog_pos, uint64_t analog_todo)
@@ -369,6 +638,7 @@ static void send_analog_packet(struct analog_gen *ag,
 	uint64_t sending_now, to_avg;
 	int ag_pattern_pos;
 	unsigned int i;
+	float value;
 
 	if (!ag->ch || !ag->ch->enabled)
 		return;
@@ -381,6 +651,11 @@ static void send_analog_packet(struct analog_gen *ag,
 		ag_pattern_pos = analog_pos % ag->num_samples;
 		sending_now = MIN(analog_todo, ag->num_samples - ag_pattern_pos);
 		ag->packet.data = ag->pattern_data + ag_pattern_pos;
+		if (ag->noise_level > 0) {
+			analog_add_noise(ag, ag->packet.data, ag->noise_data,
+				sending_now);
+			ag->packet.data = ag->noise_data;
+		}
 		ag->packet.num_samples = sending_now;
 		sr_session_send(sdi, &packet);
 
@@ -391,9 +666,10 @@ static void send_analog_packet(struct analog_gen *ag,
 		to_avg = MIN(analog_todo, ag->num_samples - ag_pattern_pos);
 
 		for (i = 0; i < to_avg; i++) {
-			ag->avg_val = (ag->avg_val +
-					*(ag->pattern_data +
-					  ag_pattern_pos + i)) / 2;
+			value = ag->pattern_data[ag_pattern_pos + i];
+			if (ag->noise_level > 0)
+				analog_add_noise(ag, &value, &value, 1);
+			ag->avg_val = (ag->avg_val + value) / 2;
 			ag->num_avgs++;
 			/* Time to send averaged data? */
 			if (devc->avg_samples > 0 &&
@@ -421,6 +697,231 @@ do_send:
 	}
 }
 
+/*
+ * Threaded rendering: every enabled logic channel group and analog
+ * channel is a "lane" with its own generator state. For each block of
+ * upcoming samples, one task per lane goes to the worker pool. A lane
+ * renders its blocks in order under its mutex, different lanes (and a
+ * lane's next block against the main loop's emission of the current
+ * one) run in parallel. The main loop emits completed blocks in order.
+ */
+static void analog_render(struct analog_gen *ag, float *out,
+		uint64_t pos, uint64_t count)
+{
+	uint64_t p, n;
+
+	while (count > 0) {
+		p = pos % ag->num_samples;
+		n = MIN(count, ag->num_samples - p);
+		if (ag->noise_level > 0)
+			analog_add_noise(ag, ag->pattern_data + p, out, n);
+		else
+			memcpy(out, ag->pattern_data + p, n * sizeof(float));
+		out += n;
+		pos += n;
+		count -= n;
+	}
+}
+
+static void render_lane(gpointer data, gpointer user_data)
+{
+	struct demo_lane *lane;
+	struct dev_context *devc;
+	struct demo_block *block;
+
+	lane = data;
+	devc = user_data;
+
+	g_mutex_lock(&lane->mutex);
+	block = &devc->blocks[lane->next_seq++ % DEMO_NUM_BLOCKS];
+	if (lane->ag)
+		analog_render(lane->ag, block->analog[lane->index],
+			block->start, block->num_samples);
+	else
+		block->logic = logic_generator(devc, block->logic_buf,
+			block->num_samples * devc->logic_unitsize);
+	g_mutex_unlock(&lane->mutex);
+
+	g_mutex_lock(&devc->render_mutex);
+	if (--block->pending == 0)
+		g_cond_signal(&devc->render_cond);
+	g_mutex_unlock(&devc->render_mutex);
+}
+
+static void render_submit(struct dev_context *devc, uint64_t seq)
+{
+	struct demo_block *block;
+	size_t i;
+
+	block = &devc->blocks[seq % DEMO_NUM_BLOCKS];
+	block->start = seq * devc->logic_packet_samples;
+	block->num_samples = devc->logic_packet_samples;
+	block->emitted = 0;
+
+	g_mutex_lock(&devc->render_mutex);
+	block->pending = devc->num_lanes;
+	g_mutex_unlock(&devc->render_mutex);
+
+	for (i = 0; i < devc->num_lanes; i++)
+		g_thread_pool_push(devc->render_pool, &devc->lanes[i], NULL);
+}
+
+SR_PRIV int demo_render_start(struct dev_context *devc)
+{
+	struct demo_lane *lane;
+	struct demo_block *block;
+	struct analog_gen *ag;
+	GHashTableIter iter;
+	void *value;
+	size_t i, n;
+	uint64_t seq;
+
+	/* Averaging is cheap and stateful, keep it on the main loop. */
+	if (devc->worker_threads == 0 || devc->avg)
+		return SR_OK;
+
+	n = devc->enabled_logic_channels ? 1 : 0;
+	n += devc->enabled_analog_channels;
+	if (n == 0)
+		return SR_OK;
+
+	devc->lanes = g_malloc0(n * sizeof(struct demo_lane));
+	devc->num_lanes = 0;
+	if (devc->enabled_logic_channels)
+		devc->lanes[devc->num_lanes++].ag = NULL;
+	g_hash_table_iter_init(&iter, devc->ch_ag);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		ag = value;
+		if (ag->ch && ag->ch->enabled && devc->num_lanes < n)
+			devc->lanes[devc->num_lanes++].ag = ag;
+	}
+	for (i = 0; i < devc->num_lanes; i++) {
+		lane = &devc->lanes[i];
+		lane->index = i;
+		lane->next_seq = 0;
+		g_mutex_init(&lane->mutex);
+	}
+
+	for (seq = 0; seq < DEMO_NUM_BLOCKS; seq++) {
+		block = &devc->blocks[seq];
+		block->analog = g_malloc0(devc->num_lanes * sizeof(float *));
+		for (i = 0; i < devc->num_lanes; i++) {
+			if (!devc->lanes[i].ag) {
+				block->logic_buf = g_try_malloc(devc->logic_packet_samples
+					* devc->logic_unitsize);
+				if (!block->logic_buf)
+					goto err_malloc;
+			} else {
+				block->analog[i] = g_try_malloc(devc->logic_packet_samples
+					* sizeof(float));
+				if (!block->analog[i])
+					goto err_malloc;
+			}
+		}
+	}
+
+	g_mutex_init(&devc->render_mutex);
+	g_cond_init(&devc->render_cond);
+	devc->render_pool = g_thread_pool_new(render_lane, devc,
+		devc->worker_threads, FALSE, NULL);
+	devc->emit_seq = 0;
+	for (seq = 0; seq < DEMO_NUM_BLOCKS; seq++)
+		render_submit(devc, seq);
+
+	sr_dbg("Rendering %zu lane(s) on %" PRIu64 " worker thread(s).",
+		devc->num_lanes, devc->worker_threads);
+
+	return SR_OK;
+
+err_malloc:
+	sr_err("Render buffer malloc failed.");
+	demo_render_stop(devc);
+
+	return SR_ERR_MALLOC;
+}
+
+SR_PRIV void demo_render_stop(struct dev_context *devc)
+{
+	struct demo_block *block;
+	size_t i, seq;
+
+	if (!devc->lanes)
+		return;
+
+	if (devc->render_pool) {
+		/* Drop queued blocks, wait for the ones in progress. */
+		g_thread_pool_free(devc->render_pool, TRUE, TRUE);
+		devc->render_pool = NULL;
+		g_cond_clear(&devc->render_cond);
+		g_mutex_clear(&devc->render_mutex);
+	}
+
+	for (seq = 0; seq < DEMO_NUM_BLOCKS; seq++) {
+		block = &devc->blocks[seq];
+		if (block->analog) {
+			for (i = 0; i < devc->num_lanes; i++)
+				g_free(block->analog[i]);
+		}
+		g_free(block->analog);
+		g_free(block->logic_buf);
+		memset(block, 0, sizeof(*block));
+	}
+
+	for (i = 0; i < devc->num_lanes; i++)
+		g_mutex_clear(&devc->lanes[i].mutex);
+	g_free(devc->lanes);
+	devc->lanes = NULL;
+	devc->num_lanes = 0;
+}
+
+/* Send samples_todo samples from rendered blocks, in order. */
+static void render_emit(struct sr_dev_inst *sdi, uint64_t samples_todo)
+{
+	struct dev_context *devc;
+	struct demo_block *block;
+	struct demo_lane *lane;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+	uint64_t done, n;
+	size_t i;
+
+	devc = sdi->priv;
+
+	for (done = 0; done < samples_todo; done += n) {
+		block = &devc->blocks[devc->emit_seq % DEMO_NUM_BLOCKS];
+
+		g_mutex_lock(&devc->render_mutex);
+		while (block->pending)
+			g_cond_wait(&devc->render_cond, &devc->render_mutex);
+		g_mutex_unlock(&devc->render_mutex);
+
+		n = MIN(samples_todo - done, block->num_samples - block->emitted);
+		for (i = 0; i < devc->num_lanes; i++) {
+			lane = &devc->lanes[i];
+			if (lane->ag) {
+				packet.type = SR_DF_ANALOG;
+				packet.payload = &lane->ag->packet;
+				lane->ag->packet.data = block->analog[i] + block->emitted;
+				lane->ag->packet.num_samples = n;
+			} else {
+				packet.type = SR_DF_LOGIC;
+				packet.payload = &logic;
+				logic.length = n * devc->logic_unitsize;
+				logic.unitsize = devc->logic_unitsize;
+				logic.data = (uint8_t *)block->logic
+					+ block->emitted * devc->logic_unitsize;
+			}
+			sr_session_send(sdi, &packet);
+		}
+
+		block->emitted += n;
+		if (block->emitted == block->num_samples) {
+			render_submit(devc, devc->emit_seq + DEMO_NUM_BLOCKS);
+			devc->emit_seq++;
+		}
+	}
+}
+
 /* Callback handling data */
 SR_PRIV int demo_prepare_data(int fd, int revents, void *cb_data)
 {
@@ -456,9 +957,17 @@ SR_PRIV int demo_prepare_data(int fd, int revents, void *cb_data)
 	else
 		todo_us = MAX(0, elapsed_us - devc->spent_us);
 
-	/* How many samples are outstanding since the last round? */
-	samples_todo = (todo_us * devc->cur_samplerate + G_USEC_PER_SEC - 1)
-			/ G_USEC_PER_SEC;
+	if (devc->benchmark) {
+		/*
+		 * Don't pace to the samplerate, just send a batch of full
+		 * packets. Keep it bounded so the main loop stays responsive.
+		 */
+		samples_todo = BENCHMARK_PACKETS_PER_RUN * devc->logic_packet_samples;
+	} else {
+		/* How many samples are outstanding since the last round? */
+		samples_todo = (todo_us * devc->cur_samplerate + G_USEC_PER_SEC - 1)
+				/ G_USEC_PER_SEC;
+	}
 
 	if (devc->limit_samples > 0) {
 		if (devc->limit_samples < devc->sent_samples)
@@ -490,18 +999,22 @@ SR_PRIV int demo_prepare_data(int fd, int revents, void *cb_data)
 	if (!devc->enabled_analog_channels)
 		analog_done = samples_todo;
 
+	if (devc->render_pool) {
+		render_emit(sdi, samples_todo);
+		logic_done = analog_done = samples_todo;
+	}
+
 	while (logic_done < samples_todo || analog_done < samples_todo) {
 		/* Logic */
 		if (logic_done < samples_todo) {
 			sending_now = MIN(samples_todo - logic_done,
-					LOGIC_BUFSIZE / devc->logic_unitsize);
-			logic_generator(sdi, sending_now * devc->logic_unitsize);
+					devc->logic_packet_samples);
 			packet.type = SR_DF_LOGIC;
 			packet.payload = &logic;
 			logic.length = sending_now * devc->logic_unitsize;
 			logic.unitsize = devc->logic_unitsize;
-			logic.data = devc->logic_data;
-			logic_fixup_feed(devc, &logic);
+			logic.data = logic_generator(devc, devc->logic_data,
+					logic.length);
 			sr_session_send(sdi, &packet);
 			logic_done += sending_now;
 		}
@@ -528,7 +1041,10 @@ SR_PRIV int demo_prepare_data(int fd, int revents, void *cb_data)
 	}
 	devc->sent_samples += samples_todo;
 	devc->sent_frame_samples += samples_todo;
-	devc->spent_us += todo_us;
+	if (devc->benchmark)
+		devc->spent_us = g_get_monotonic_time() - devc->start_us;
+	else
+		devc->spent_us += todo_us;
 
 #if (SAMPLES_PER_FRAME > 0) /* Avoid "comparison >= 0 always true" warning. */
 	if (devc->sent_frame_samples >= SAMPLES_PER_FRAME) {
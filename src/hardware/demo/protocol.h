@@ -29,13 +29,45 @@
 
 #define LOG_PREFIX "demo"
 
-/* The size in bytes of chunks to send through the session bus. */
+/* The default size in bytes of chunks to send through the session bus. */
 #define LOGIC_BUFSIZE			4096
+/* Upper limits for the configurable logic packet and unit sizes. */
+#define LOGIC_MAX_BUFSIZE		(16 * 1024 * 1024)
+#define LOGIC_MAX_UNITSIZE		64
+/* In benchmark mode, generate at most this many packets per callback. */
+#define BENCHMARK_PACKETS_PER_RUN	64
 /* Size of the analog pattern space per channel. */
 #define ANALOG_BUFSIZE			4096
+/* Number of packets rendered ahead when generating on worker threads. */
+#define DEMO_NUM_BLOCKS			8
+/* Upper limit for the number of worker threads. */
+#define DEMO_MAX_WORKER_THREADS		64
 /* This is a development feature: it starts a new frame every n samples. */
 #define SAMPLES_PER_FRAME		0
 
+struct analog_gen;
+
+/* A generator with its own state, rendering its blocks in order. */
+struct demo_lane {
+	GMutex mutex;
+	size_t index;
+	/* The analog generator, or NULL for the logic channel group. */
+	struct analog_gen *ag;
+	uint64_t next_seq;
+};
+
+/* One packet's worth of upcoming samples, for all lanes. */
+struct demo_block {
+	uint64_t start;
+	uint64_t num_samples;
+	uint64_t emitted;
+	/* Lanes yet to finish rendering, protected by render_mutex. */
+	size_t pending;
+	uint8_t *logic_buf;
+	const uint8_t *logic;
+	float **analog;
+};
+
 struct dev_context {
 	uint64_t cur_samplerate;
 	uint64_t limit_samples;
@@ -45,12 +77,40 @@ struct dev_context {
 	int64_t start_us;
 	int64_t spent_us;
 	uint64_t step;
+	gboolean benchmark;
 	/* Logic */
 	int32_t num_logic_channels;
 	unsigned int logic_unitsize;
+	uint64_t logic_bufsize;
+	uint64_t logic_packet_samples;
 	/* There is only ever one logic channel group, so its pattern goes here. */
 	uint8_t logic_pattern;
-	unsigned char logic_data[LOGIC_BUFSIZE];
+	/*
+	 * Periodic patterns are pre-rendered into a table of one period
+	 * plus one packet, so that any packet is a window into the table.
+	 * Random data gets generated into the same buffer per packet.
+	 */
+	uint8_t *logic_data;
+	uint64_t logic_period;
+	uint64_t xoshiro_state[4];
+	/* Parameters and state of the synthetic workload profiles. */
+	uint64_t edge_interval;
+	uint64_t glitch_interval;
+	uint64_t burst_length;
+	uint8_t gen_value[LOGIC_MAX_UNITSIZE];
+	uint64_t gen_hold;
+	uint64_t gen_next_glitch;
+	uint64_t gen_phase;
+	uint8_t gen_mosi, gen_miso;
+	/* Threaded rendering */
+	uint64_t worker_threads;
+	GThreadPool *render_pool;
+	GMutex render_mutex;
+	GCond render_cond;
+	struct demo_lane *lanes;
+	size_t num_lanes;
+	struct demo_block blocks[DEMO_NUM_BLOCKS];
+	uint64_t emit_seq;
 	/* Analog */
 	int32_t num_analog_channels;
 	GHashTable *ch_ag;
@@ -103,6 +163,25 @@ enum {
 	 * something that can get recognized.
 	 */
 	PATTERN_SQUID,
+
+	/**
+	 * Sparse edges: one random channel toggles at random intervals,
+	 * SR_CONF_EDGE_INTERVAL samples apart on average.
+	 */
+	PATTERN_SPARSE,
+
+	/**
+	 * Bursts of SR_CONF_BURST_LENGTH random SPI bytes (mode 0, MSB
+	 * first) on D0 (CLK), D1 (MOSI), D2 (MISO) and D3 (CS#), with
+	 * idle gaps of SR_CONF_EDGE_INTERVAL samples on average.
+	 */
+	PATTERN_SPI,
+
+	/**
+	 * Random words across all channels, each held for
+	 * SR_CONF_EDGE_INTERVAL samples, like transfers on a wide bus.
+	 */
+	PATTERN_BUS,
 };
 
 /* Analog patterns we can generate. */
@@ -124,7 +203,10 @@ struct analog_gen {
 	struct sr_channel *ch;
 	int pattern;
 	float amplitude;
+	float noise_level;
 	float pattern_data[ANALOG_BUFSIZE];
+	float noise_data[ANALOG_BUFSIZE];
+	uint64_t xoshiro_state[4];
 	unsigned int num_samples;
 	struct sr_datafeed_analog packet;
 	struct sr_analog_encoding encoding;
@@ -135,6 +217,10 @@ struct analog_gen {
 };
 
 SR_PRIV void demo_generate_analog_pattern(struct analog_gen *ag, uint64_t sample_rate);
+SR_PRIV int demo_prepare_logic(struct dev_context *devc);
+SR_PRIV void demo_free_logic(struct dev_context *devc);
+SR_PRIV int demo_render_start(struct dev_context *devc);
+SR_PRIV void demo_render_stop(struct dev_context *devc);
 SR_PRIV int demo_prepare_data(int fd, int revents, void *cb_data);
 
 #endif
@@ -350,7 +350,8 @@ static int dev_open(struct sr_dev_inst *sdi)
 		return SR_ERR;
 	}
 
-
+	/* The FPGA configuration can't be read back, upload it again. */
+	devc->fpga_checksum[0] = '\0';
 	if ((ret = dslogic_fpga_firmware_upload(sdi)) != SR_OK)
 		return ret;
 
@@ -138,6 +138,9 @@ struct fpga_config {
  */
 #define FW_BUFSIZE (1024 * 1024)
 
+/* Upper limit for the size of an FPGA bitstream, for safety. */
+#define FPGA_FIRMWARE_MAX_SIZE (8 * 1024 * 1024)
+
 #define FPGA_UPLOAD_DELAY (10 * 1000)
 
 #define USB_TIMEOUT (3 * 1000)
@@ -223,15 +226,13 @@ static int command_stop_acquisition(const struct sr_dev_inst *sdi)
 SR_PRIV int dslogic_fpga_firmware_upload(const struct sr_dev_inst *sdi)
 {
 	const char *name = NULL;
-	uint64_t sum;
-	struct sr_resource bitstream;
+	struct sr_resource_image *bitstream;
 	struct drv_context *drvc;
 	struct dev_context *devc;
 	struct sr_usb_dev_inst *usb;
-	unsigned char *buf;
-	ssize_t chunksize;
+	size_t offset, chunksize;
 	int transferred;
-	int result, ret;
+	int ret;
 	const uint8_t cmd[3] = {0, 0, 0};
 
 	drvc = sdi->driver->context;
@@ -256,60 +257,63 @@ SR_PRIV int dslogic_fpga_firmware_upload(const struct sr_dev_inst *sdi)
 		return SR_ERR;
 	}
 
-	sr_dbg("Uploading FPGA firmware '%s'.", name);
+	bitstream = sr_resource_image_get(drvc->sr_ctx, SR_RESOURCE_FIRMWARE,
+			name, FPGA_FIRMWARE_MAX_SIZE);
+	if (!bitstream)
+		return SR_ERR;
+
+	/*
+	 * Skip the upload if the bitstream was uploaded since the device
+	 * was opened, e.g. for the previous voltage threshold.
+	 */
+	if (!strcmp(devc->fpga_checksum, bitstream->checksum)) {
+		sr_dbg("FPGA firmware '%s' already configured.", name);
+		sr_resource_image_unref(bitstream);
+		return SR_OK;
+	}
+	devc->fpga_checksum[0] = '\0';
 
-	result = sr_resource_open(drvc->sr_ctx, &bitstream,
-			SR_RESOURCE_FIRMWARE, name);
-	if (result != SR_OK)
-		return result;
+	sr_dbg("Uploading FPGA firmware '%s'.", name);
 
 	/* Tell the device firmware is coming. */
 	if ((ret = libusb_control_transfer(usb->devhdl, LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_ENDPOINT_OUT, DS_CMD_CONFIG, 0x0000, 0x0000,
 			(unsigned char *)&cmd, sizeof(cmd), USB_TIMEOUT)) < 0) {
 		sr_err("Failed to upload FPGA firmware: %s.", libusb_error_name(ret));
-		sr_resource_close(drvc->sr_ctx, &bitstream);
+		sr_resource_image_unref(bitstream);
 		return SR_ERR;
 	}
 
 	/* Give the FX2 time to get ready for FPGA firmware upload. */
 	g_usleep(FPGA_UPLOAD_DELAY);
 
-	buf = g_malloc(FW_BUFSIZE);
-	sum = 0;
-	result = SR_OK;
-	while (1) {
-		chunksize = sr_resource_read(drvc->sr_ctx, &bitstream,
-				buf, FW_BUFSIZE);
-		if (chunksize < 0)
-			result = SR_ERR;
-		if (chunksize <= 0)
-			break;
+	for (offset = 0; offset < bitstream->size; offset += chunksize) {
+		chunksize = MIN(bitstream->size - offset, FW_BUFSIZE);
 
 		if ((ret = libusb_bulk_transfer(usb->devhdl, 2 | LIBUSB_ENDPOINT_OUT,
-				buf, chunksize, &transferred, USB_TIMEOUT)) < 0) {
+				bitstream->data + offset, chunksize, &transferred,
+				USB_TIMEOUT)) < 0) {
 			sr_err("Unable to configure FPGA firmware: %s.",
 					libusb_error_name(ret));
-			result = SR_ERR;
-			break;
+			sr_resource_image_unref(bitstream);
+			return SR_ERR;
 		}
-		sum += transferred;
-		sr_spew("Uploaded %" PRIu64 "/%" PRIu64 " bytes.",
-			sum, bitstream.size);
+		sr_spew("Uploaded %zu/%zu bytes.", offset + transferred,
+			bitstream->size);
 
-		if (transferred != chunksize) {
+		if ((size_t)transferred != chunksize) {
 			sr_err("Short transfer while uploading FPGA firmware.");
-			result = SR_ERR;
-			break;
+			sr_resource_image_unref(bitstream);
+			return SR_ERR;
 		}
 	}
-	g_free(buf);
-	sr_resource_close(drvc->sr_ctx, &bitstream);
 
-	if (result == SR_OK)
-		sr_dbg("FPGA firmware upload done.");
+	g_strlcpy(devc->fpga_checksum, bitstream->checksum,
+		sizeof(devc->fpga_checksum));
+	sr_resource_image_unref(bitstream);
+	sr_dbg("FPGA firmware upload done.");
 
-	return result;
+	return SR_OK;
 }
 
 static unsigned int enabled_channel_count(const struct sr_dev_inst *sdi)
@@ -112,6 +112,9 @@ struct dev_context {
 	 */
 	int64_t fw_updated;
 
+	/* Checksum of the FPGA bitstream uploaded since the device was opened. */
+	char fpga_checksum[SR_RESOURCE_CHECKSUM_SIZE];
+
 	const uint64_t *samplerates;
 	int num_samplerates;
 
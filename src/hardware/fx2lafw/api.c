@@ -123,6 +123,12 @@ static const uint32_t devopts[] = {
 	SR_CONF_SAMPLERATE | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
 	SR_CONF_TRIGGER_MATCH | SR_CONF_LIST,
 	SR_CONF_CAPTURE_RATIO | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_ADAPTIVE_TRANSFERS | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_TRANSFER_SIZE_RANGE | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_NUM_TRANSFERS_RANGE | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_TRANSFER_SIZE | SR_CONF_GET,
+	SR_CONF_NUM_TRANSFERS | SR_CONF_GET,
+	SR_CONF_ANALOG_NATIVE | SR_CONF_GET | SR_CONF_SET,
 };
 
 static const int32_t trigger_matches[] = {
@@ -489,6 +495,26 @@ static int config_get(uint32_t key, GVariant **data,
 	case SR_CONF_CAPTURE_RATIO:
 		*data = g_variant_new_uint64(devc->capture_ratio);
 		break;
+	case SR_CONF_ADAPTIVE_TRANSFERS:
+		*data = g_variant_new_boolean(devc->adaptive);
+		break;
+	case SR_CONF_ANALOG_NATIVE:
+		*data = g_variant_new_boolean(devc->analog_native);
+		break;
+	case SR_CONF_TRANSFER_SIZE_RANGE:
+		*data = std_gvar_tuple_u64(devc->min_transfer_size,
+				devc->max_transfer_size);
+		break;
+	case SR_CONF_NUM_TRANSFERS_RANGE:
+		*data = std_gvar_tuple_u64(devc->min_num_transfers,
+				devc->max_num_transfers);
+		break;
+	case SR_CONF_TRANSFER_SIZE:
+		*data = g_variant_new_uint64(fx2lafw_get_transfer_size(devc));
+		break;
+	case SR_CONF_NUM_TRANSFERS:
+		*data = g_variant_new_uint64(fx2lafw_get_num_transfers(devc));
+		break;
 	default:
 		return SR_ERR_NA;
 	}
@@ -500,6 +526,7 @@ static int config_set(uint32_t key, GVariant *data,
 	const struct sr_dev_inst *sdi, const struct sr_channel_group *cg)
 {
 	struct dev_context *devc;
+	uint64_t low, high;
 	int idx;
 
 	(void)cg;
@@ -521,6 +548,28 @@ static int config_set(uint32_t key, GVariant *data,
 	case SR_CONF_CAPTURE_RATIO:
 		devc->capture_ratio = g_variant_get_uint64(data);
 		break;
+	case SR_CONF_ADAPTIVE_TRANSFERS:
+		devc->adaptive = g_variant_get_boolean(data);
+		break;
+	case SR_CONF_ANALOG_NATIVE:
+		devc->analog_native = g_variant_get_boolean(data);
+		break;
+	case SR_CONF_TRANSFER_SIZE_RANGE:
+		g_variant_get(data, "(tt)", &low, &high);
+		/* Transfers are made of 512 byte bulk packets. */
+		if (low < MIN_TRANSFER_SIZE || high > MAX_TRANSFER_SIZE
+				|| low > high || (low % 512) || (high % 512))
+			return SR_ERR_ARG;
+		devc->min_transfer_size = low;
+		devc->max_transfer_size = high;
+		break;
+	case SR_CONF_NUM_TRANSFERS_RANGE:
+		g_variant_get(data, "(tt)", &low, &high);
+		if (low < 1 || high > MAX_SIMUL_TRANSFERS || low > high)
+			return SR_ERR_ARG;
+		devc->min_num_transfers = low;
+		devc->max_num_transfers = high;
+		break;
 	default:
 		return SR_ERR_NA;
 	}
@@ -259,6 +259,11 @@ SR_PRIV struct dev_context *fx2lafw_dev_new(void)
 	devc->capture_ratio = 0;
 	devc->sample_wide = FALSE;
 	devc->stl = NULL;
+	devc->adaptive = FALSE;
+	devc->min_transfer_size = MIN_TRANSFER_SIZE;
+	devc->max_transfer_size = DEFAULT_MAX_TRANSFER_SIZE;
+	devc->min_num_transfers = DEFAULT_MIN_NUM_TRANSFERS;
+	devc->max_num_transfers = DEFAULT_MAX_NUM_TRANSFERS;
 
 	return devc;
 }
@@ -269,6 +274,10 @@ SR_PRIV void fx2lafw_abort_acquisition(struct dev_context *devc)
 
 	devc->acq_aborted = TRUE;
 
+	/* Transfers must not get resubmitted while they are cancelled. */
+	if (devc->usb_thread)
+		usb_thread_abort(devc->usb_thread);
+
 	for (i = devc->num_transfers - 1; i >= 0; i--) {
 		if (devc->transfers[i])
 			libusb_cancel_transfer(devc->transfers[i]);
@@ -284,15 +293,18 @@ static void finish_acquisition(struct sr_dev_inst *sdi)
 	std_session_send_df_end(sdi);
 
 	usb_source_remove(sdi->session, devc->ctx);
+	devc->usb_thread = NULL;
 
 	devc->num_transfers = 0;
 	g_free(devc->transfers);
 
 	/* Free the deinterlace buffers if we had them. */
-	if (g_slist_length(devc->enabled_analog_channels) > 0) {
-		g_free(devc->logic_buffer);
-		g_free(devc->analog_buffer);
-	}
+	g_free(devc->logic_buffer);
+	g_free(devc->analog_raw_buffer);
+	g_free(devc->analog_buffer);
+	devc->logic_buffer = NULL;
+	devc->analog_raw_buffer = NULL;
+	devc->analog_buffer = NULL;
 
 	if (devc->stl) {
 		soft_trigger_logic_free(devc->stl);
@@ -309,7 +321,7 @@ static void free_transfer(struct libusb_transfer *transfer)
 	sdi = transfer->user_data;
 	devc = sdi->priv;
 
-	g_free(transfer->buffer);
+	usb_thread_buffer_free(devc->usb_thread, transfer->buffer);
 	transfer->buffer = NULL;
 	libusb_free_transfer(transfer);
 
@@ -327,8 +339,16 @@ static void free_transfer(struct libusb_transfer *transfer)
 
 static void resubmit_transfer(struct libusb_transfer *transfer)
 {
+	struct sr_dev_inst *sdi;
+	struct dev_context *devc;
 	int ret;
 
+	sdi = transfer->user_data;
+	devc = sdi->priv;
+
+	/* The transfer size may have changed since the last submission. */
+	transfer->length = devc->transfer_size;
+
 	if ((ret = libusb_submit_transfer(transfer)) == LIBUSB_SUCCESS)
 		return;
 
@@ -340,7 +360,6 @@ static void resubmit_transfer(struct libusb_transfer *transfer)
 static void mso_send_data_proc(struct sr_dev_inst *sdi,
 	uint8_t *data, size_t length, size_t sample_width)
 {
-	size_t i;
 	struct dev_context *devc;
 	struct sr_datafeed_analog analog;
 	struct sr_analog_encoding encoding;
@@ -353,13 +372,11 @@ static void mso_send_data_proc(struct sr_dev_inst *sdi,
 
 	length /= 2;
 
-	/* Send the logic */
-	for (i = 0; i < length; i++) {
-		devc->logic_buffer[i] = data[i * 2];
-		/* Rescale to -10V - +10V from 0-255. */
-		devc->analog_buffer[i] = (data[i * 2 + 1] - 128.0f) / 12.8f;
-	};
+	/* Split the logic and ADC bytes. */
+	sr_conv_deinterleave_u8(data, devc->logic_buffer,
+		devc->analog_raw_buffer, length);
 
+	/* Send the logic */
 	const struct sr_datafeed_logic logic = {
 		.length = length,
 		.unitsize = 1,
@@ -379,7 +396,23 @@ static void mso_send_data_proc(struct sr_dev_inst *sdi,
 	analog.meaning->unit = SR_UNIT_VOLT;
 	analog.meaning->mqflags = 0 /* SR_MQFLAG_DC */;
 	analog.num_samples = length;
-	analog.data = devc->analog_buffer;
+
+	/*
+	 * Rescale to -10V - +10V from 0-255, i.e. (x - 128) / 12.8, which
+	 * is exactly x * 5 / 64 - 10.
+	 */
+	if (devc->analog_native) {
+		analog.encoding->unitsize = 1;
+		analog.encoding->is_float = FALSE;
+		analog.encoding->is_signed = FALSE;
+		sr_rational_set(&analog.encoding->scale, 5, 64);
+		sr_rational_set(&analog.encoding->offset, -10, 1);
+		analog.data = devc->analog_raw_buffer;
+	} else {
+		sr_conv_u8_to_float(devc->analog_raw_buffer,
+			devc->analog_buffer, length, 5 / 64.0f, -10.0f);
+		analog.data = devc->analog_buffer;
+	}
 
 	const struct sr_datafeed_packet analog_packet = {
 		.type = SR_DF_ANALOG,
@@ -410,95 +443,30 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 {
 	struct sr_dev_inst *sdi;
 	struct dev_context *devc;
-	gboolean packet_has_error = FALSE;
-	unsigned int num_samples;
-	int trigger_offset, cur_sample_count, unitsize;
-	int pre_trigger_samples;
 
 	sdi = transfer->user_data;
 	devc = sdi->priv;
 
 	/*
-	 * If acquisition has already ended, just free any queued up
-	 * transfer that come in.
+	 * This runs on the USB event thread. Get the transfer back in
+	 * flight as soon as possible, and leave the data processing to
+	 * receive_completion() on the session thread.
 	 */
-	if (devc->acq_aborted) {
-		free_transfer(transfer);
-		return;
-	}
-
-	sr_dbg("receive_transfer(): status %s received %d bytes.",
-		libusb_error_name(transfer->status), transfer->actual_length);
-
-	/* Save incoming transfer before reusing the transfer struct. */
-	unitsize = devc->sample_wide ? 2 : 1;
-	cur_sample_count = transfer->actual_length / unitsize;
-
-	switch (transfer->status) {
-	case LIBUSB_TRANSFER_NO_DEVICE:
-		fx2lafw_abort_acquisition(devc);
-		free_transfer(transfer);
-		return;
-	case LIBUSB_TRANSFER_COMPLETED:
-	case LIBUSB_TRANSFER_TIMED_OUT: /* We may have received some data though. */
-		break;
-	default:
-		packet_has_error = TRUE;
-		break;
-	}
-
-	if (transfer->actual_length == 0 || packet_has_error) {
-		devc->empty_transfer_count++;
-		if (devc->empty_transfer_count > MAX_EMPTY_TRANSFERS) {
-			/*
-			 * The FX2 gave up. End the acquisition, the frontend
-			 * will work out that the samplecount is short.
-			 */
-			fx2lafw_abort_acquisition(devc);
-			free_transfer(transfer);
-		} else {
-			resubmit_transfer(transfer);
-		}
-		return;
-	} else {
-		devc->empty_transfer_count = 0;
-	}
-	if (devc->trigger_fired) {
-		if (!devc->limit_samples || devc->sent_samples < devc->limit_samples) {
-			/* Send the incoming transfer to the session bus. */
-			if (devc->limit_samples && devc->sent_samples + cur_sample_count > devc->limit_samples)
-				num_samples = devc->limit_samples - devc->sent_samples;
-			else
-				num_samples = cur_sample_count;
-
-			devc->send_data_proc(sdi, (uint8_t *)transfer->buffer,
-				num_samples * unitsize, unitsize);
-			devc->sent_samples += num_samples;
-		}
-	} else {
-		trigger_offset = soft_trigger_logic_check(devc->stl,
-			transfer->buffer, transfer->actual_length, &pre_trigger_samples);
-		if (trigger_offset > -1) {
-			devc->sent_samples += pre_trigger_samples;
-			num_samples = cur_sample_count - trigger_offset;
-			if (devc->limit_samples &&
-					num_samples > devc->limit_samples - devc->sent_samples)
-				num_samples = devc->limit_samples - devc->sent_samples;
-
-			devc->send_data_proc(sdi, (uint8_t *)transfer->buffer
-					+ trigger_offset * unitsize,
-					num_samples * unitsize, unitsize);
-			devc->sent_samples += num_samples;
+	usb_thread_transfer_done(devc->usb_thread, transfer);
+}
 
-			devc->trigger_fired = TRUE;
-		}
-	}
+static void continue_transfer(const struct sr_usb_completion *completion)
+{
+	/* Transfers which were resubmitted already need no attention. */
+	if (completion->transfer)
+		resubmit_transfer(completion->transfer);
+}
 
-	if (devc->limit_samples && devc->sent_samples >= devc->limit_samples) {
-		fx2lafw_abort_acquisition(devc);
-		free_transfer(transfer);
-	} else
-		resubmit_transfer(transfer);
+static void end_transfer(const struct sr_usb_completion *completion)
+{
+	/* In-flight transfers will come back as cancelled. */
+	if (completion->transfer)
+		free_transfer(completion->transfer);
 }
 
 static int configure_channels(const struct sr_dev_inst *sdi)
@@ -535,9 +503,15 @@ static int configure_channels(const struct sr_dev_inst *sdi)
 	return SR_OK;
 }
 
-static unsigned int to_bytes_per_ms(unsigned int samplerate)
+static unsigned int to_bytes_per_ms(const struct dev_context *devc)
 {
-	return samplerate / 1000;
+	return devc->cur_samplerate / 1000 * (devc->sample_wide ? 2 : 1);
+}
+
+static size_t round_transfer_size(uint64_t size)
+{
+	/* Transfers must be a multiple of the 512 byte bulk packet size. */
+	return MAX((size + 511) & ~511, MIN_TRANSFER_SIZE);
 }
 
 static size_t get_buffer_size(struct dev_context *devc)
@@ -548,8 +522,12 @@ static size_t get_buffer_size(struct dev_context *devc)
 	 * The buffer should be large enough to hold 10ms of data and
 	 * a multiple of 512.
 	 */
-	s = 10 * to_bytes_per_ms(devc->cur_samplerate);
-	return (s + 511) & ~511;
+	s = round_transfer_size(10 * to_bytes_per_ms(devc));
+
+	if (devc->adaptive)
+		s = CLAMP(s, devc->min_transfer_size, devc->max_transfer_size);
+
+	return s;
 }
 
 static unsigned int get_number_of_transfers(struct dev_context *devc)
@@ -557,13 +535,15 @@ static unsigned int get_number_of_transfers(struct dev_context *devc)
 	unsigned int n;
 
 	/* Total buffer size should be able to hold about 500ms of data. */
-	n = (500 * to_bytes_per_ms(devc->cur_samplerate) /
-		get_buffer_size(devc));
+	n = (500 * to_bytes_per_ms(devc) / get_buffer_size(devc));
+
+	if (devc->adaptive)
+		return CLAMP(n, devc->min_num_transfers, devc->max_num_transfers);
 
 	if (n > NUM_SIMUL_TRANSFERS)
 		return NUM_SIMUL_TRANSFERS;
 
-	return n;
+	return MAX(n, 1);
 }
 
 static unsigned int get_timeout(struct dev_context *devc)
@@ -573,43 +553,309 @@ static unsigned int get_timeout(struct dev_context *devc)
 
 	total_size = get_buffer_size(devc) *
 			get_number_of_transfers(devc);
-	timeout = total_size / to_bytes_per_ms(devc->cur_samplerate);
+	timeout = total_size / to_bytes_per_ms(devc);
 	return timeout + timeout / 4; /* Leave a headroom of 25% percent. */
 }
 
-static int receive_data(int fd, int revents, void *cb_data)
+SR_PRIV uint64_t fx2lafw_get_transfer_size(struct dev_context *devc)
 {
-	struct timeval tv;
-	struct drv_context *drvc;
+	/* Report what the next acquisition would start with, if idle. */
+	if (!devc->transfer_size && devc->cur_samplerate)
+		return get_buffer_size(devc);
+
+	return devc->transfer_size;
+}
+
+SR_PRIV uint64_t fx2lafw_get_num_transfers(struct dev_context *devc)
+{
+	if (!devc->target_transfers && devc->cur_samplerate)
+		return get_number_of_transfers(devc);
+
+	return devc->target_transfers;
+}
 
-	(void)fd;
-	(void)revents;
+static int submit_new_transfer(const struct sr_dev_inst *sdi,
+		unsigned int slot, unsigned int timeout)
+{
+	struct dev_context *devc;
+	struct sr_usb_dev_inst *usb;
+	struct libusb_transfer *transfer;
+	unsigned char *buf;
+	int ret;
 
-	drvc = (struct drv_context *)cb_data;
+	devc = sdi->priv;
+	usb = sdi->conn;
 
-	tv.tv_sec = tv.tv_usec = 0;
-	libusb_handle_events_timeout(drvc->sr_ctx->libusb_ctx, &tv);
+	if (!(buf = usb_thread_buffer_alloc(devc->usb_thread))) {
+		sr_err("USB transfer buffer malloc failed.");
+		return SR_ERR_MALLOC;
+	}
+	transfer = libusb_alloc_transfer(0);
+	libusb_fill_bulk_transfer(transfer, usb->devhdl,
+			2 | LIBUSB_ENDPOINT_IN, buf, devc->transfer_size,
+			receive_transfer, (void *)sdi, timeout);
+	sr_info("submitting transfer: %d", slot);
+	if ((ret = libusb_submit_transfer(transfer)) != 0) {
+		sr_err("Failed to submit transfer: %s.",
+		       libusb_error_name(ret));
+		libusb_free_transfer(transfer);
+		usb_thread_buffer_free(devc->usb_thread, buf);
+		return SR_ERR;
+	}
+	devc->transfers[slot] = transfer;
+	devc->submitted_transfers++;
 
-	return TRUE;
+	return SR_OK;
+}
+
+static void set_number_of_transfers(const struct sr_dev_inst *sdi,
+		unsigned int n)
+{
+	struct dev_context *devc;
+	unsigned int i, timeout;
+	int excess;
+
+	devc = sdi->priv;
+	timeout = get_timeout(devc);
+
+	sr_dbg("Adjusting number of transfers from %u to %u.",
+		devc->target_transfers, n);
+
+	devc->target_transfers = n;
+
+	/* Fill up free slots with new transfers. */
+	for (i = 0; i < devc->num_transfers; i++) {
+		if ((unsigned int)devc->submitted_transfers >= n)
+			break;
+		if (devc->transfers[i])
+			continue;
+		if (submit_new_transfer(sdi, i, timeout) != SR_OK)
+			break;
+	}
+
+	/*
+	 * Cancel surplus transfers from the end. They are freed when
+	 * they come back, see receive_completion().
+	 */
+	excess = devc->submitted_transfers - (int)n;
+	for (i = devc->num_transfers; i > 0 && excess > 0; i--) {
+		if (!devc->transfers[i - 1])
+			continue;
+		if (libusb_cancel_transfer(devc->transfers[i - 1]) == 0)
+			excess--;
+	}
+}
+
+static void set_transfer_size(struct dev_context *devc, size_t size)
+{
+	sr_dbg("Adjusting transfer size from %zu to %zu bytes.",
+		devc->transfer_size, size);
+
+	devc->transfer_size = size;
+	usb_thread_set_transfer_length(devc->usb_thread, size);
+}
+
+/*
+ * Runtime adaptation of the transfer queue. Every ADAPT_WINDOW
+ * completions, look at the largest gap between two completions that
+ * the session thread observed, and at the transfers which the USB
+ * event thread could not hand over without waiting for the session.
+ * If either eats into the time covered by the transfers in flight,
+ * add more or bigger transfers. If transfers keep coming back short
+ * or empty, shrink them to reduce latency. If the host keeps up with
+ * plenty of margin, slowly give back memory.
+ */
+static void adapt_transfers(const struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	int64_t now_us, headroom_us;
+	unsigned int overruns, n;
+	size_t size;
+
+	devc = sdi->priv;
+
+	now_us = g_get_monotonic_time();
+	if (devc->last_completion_us)
+		devc->max_gap_us = MAX(devc->max_gap_us,
+				now_us - devc->last_completion_us);
+	devc->last_completion_us = now_us;
+
+	if (++devc->window_count < ADAPT_WINDOW)
+		return;
+
+	overruns = usb_thread_get_overruns(devc->usb_thread);
+	headroom_us = (int64_t)devc->target_transfers * devc->transfer_size
+			* 1000 / MAX(to_bytes_per_ms(devc), 1);
+
+	if (overruns != devc->last_overruns
+			|| devc->max_gap_us > headroom_us / 2) {
+		devc->calm_windows = 0;
+		if (devc->target_transfers < devc->max_num_transfers) {
+			n = MIN(devc->target_transfers * 2,
+				devc->max_num_transfers);
+			set_number_of_transfers(sdi, n);
+		} else if (devc->transfer_size < devc->max_transfer_size) {
+			size = MIN(devc->transfer_size * 2,
+				devc->max_transfer_size);
+			set_transfer_size(devc, size);
+		}
+	} else if (devc->window_short > ADAPT_WINDOW / 4
+			&& devc->transfer_size > devc->min_transfer_size) {
+		devc->calm_windows = 0;
+		size = MAX(round_transfer_size(devc->transfer_size / 2),
+			devc->min_transfer_size);
+		set_transfer_size(devc, size);
+	} else if (devc->max_gap_us < headroom_us / 8
+			&& ++devc->calm_windows >= ADAPT_CALM_WINDOWS) {
+		devc->calm_windows = 0;
+		n = MAX(devc->target_transfers - devc->target_transfers / 4,
+			devc->min_num_transfers);
+		if (n < devc->target_transfers)
+			set_number_of_transfers(sdi, n);
+	}
+
+	devc->last_overruns = overruns;
+	devc->window_count = 0;
+	devc->window_short = 0;
+	devc->max_gap_us = 0;
+}
+
+static void receive_completion(const struct sr_usb_completion *completion,
+		void *cb_data)
+{
+	struct sr_dev_inst *sdi;
+	struct dev_context *devc;
+	gboolean packet_has_error = FALSE;
+	gboolean retiring = FALSE;
+	unsigned int num_samples;
+	int trigger_offset, cur_sample_count, unitsize;
+	int pre_trigger_samples;
+
+	sdi = cb_data;
+	devc = sdi->priv;
+
+	/*
+	 * If acquisition has already ended, just free any queued up
+	 * transfer that come in.
+	 */
+	if (devc->acq_aborted) {
+		end_transfer(completion);
+		return;
+	}
+
+	sr_dbg("receive_completion(): status %s received %d bytes.",
+		libusb_error_name(completion->status), completion->length);
+
+	unitsize = devc->sample_wide ? 2 : 1;
+	cur_sample_count = completion->length / unitsize;
+
+	switch (completion->status) {
+	case LIBUSB_TRANSFER_NO_DEVICE:
+		fx2lafw_abort_acquisition(devc);
+		end_transfer(completion);
+		return;
+	case LIBUSB_TRANSFER_COMPLETED:
+	case LIBUSB_TRANSFER_TIMED_OUT: /* We may have received some data though. */
+		break;
+	case LIBUSB_TRANSFER_CANCELLED:
+		/* Cancelled by adapt_transfers(), keep whatever it got. */
+		if (devc->submitted_transfers > (int)devc->target_transfers) {
+			retiring = TRUE;
+			break;
+		}
+		packet_has_error = TRUE;
+		break;
+	default:
+		packet_has_error = TRUE;
+		break;
+	}
+
+	if (completion->length == 0 || packet_has_error) {
+		devc->empty_transfer_count++;
+		devc->window_short++;
+		if (devc->empty_transfer_count > MAX_EMPTY_TRANSFERS) {
+			/*
+			 * The FX2 gave up. End the acquisition, the frontend
+			 * will work out that the samplecount is short.
+			 */
+			fx2lafw_abort_acquisition(devc);
+			end_transfer(completion);
+		} else if (retiring) {
+			end_transfer(completion);
+		} else {
+			continue_transfer(completion);
+		}
+		return;
+	} else {
+		devc->empty_transfer_count = 0;
+	}
+	if (devc->trigger_fired) {
+		if (!devc->limit_samples || devc->sent_samples < devc->limit_samples) {
+			/* Send the incoming transfer to the session bus. */
+			if (devc->limit_samples && devc->sent_samples + cur_sample_count > devc->limit_samples)
+				num_samples = devc->limit_samples - devc->sent_samples;
+			else
+				num_samples = cur_sample_count;
+
+			devc->send_data_proc(sdi, (uint8_t *)completion->buffer,
+				num_samples * unitsize, unitsize);
+			devc->sent_samples += num_samples;
+		}
+	} else {
+		trigger_offset = soft_trigger_logic_check(devc->stl,
+			completion->buffer, completion->length, &pre_trigger_samples);
+		if (trigger_offset > -1) {
+			devc->sent_samples += pre_trigger_samples;
+			num_samples = cur_sample_count - trigger_offset;
+			if (devc->limit_samples &&
+					num_samples > devc->limit_samples - devc->sent_samples)
+				num_samples = devc->limit_samples - devc->sent_samples;
+
+			devc->send_data_proc(sdi, (uint8_t *)completion->buffer
+					+ trigger_offset * unitsize,
+					num_samples * unitsize, unitsize);
+			devc->sent_samples += num_samples;
+
+			devc->trigger_fired = TRUE;
+		}
+	}
+
+	if (devc->limit_samples && devc->sent_samples >= devc->limit_samples) {
+		fx2lafw_abort_acquisition(devc);
+		end_transfer(completion);
+		return;
+	}
+
+	if (completion->length < (int)devc->transfer_size)
+		devc->window_short++;
+
+	if (retiring)
+		end_transfer(completion);
+	else
+		continue_transfer(completion);
+
+	if (devc->adaptive && !devc->acq_aborted)
+		adapt_transfers(sdi);
 }
 
 static int start_transfers(const struct sr_dev_inst *sdi)
 {
 	struct dev_context *devc;
-	struct sr_usb_dev_inst *usb;
 	struct sr_trigger *trigger;
-	struct libusb_transfer *transfer;
 	unsigned int i, num_transfers;
 	int timeout, ret;
-	unsigned char *buf;
-	size_t size;
 
 	devc = sdi->priv;
-	usb = sdi->conn;
 
 	devc->sent_samples = 0;
 	devc->acq_aborted = FALSE;
 	devc->empty_transfer_count = 0;
+	devc->last_completion_us = 0;
+	devc->max_gap_us = 0;
+	devc->window_count = 0;
+	devc->window_short = 0;
+	devc->calm_windows = 0;
+	devc->last_overruns = 0;
 
 	if ((trigger = sr_session_trigger_get(sdi->session))) {
 		int pre_trigger_samples = 0;
@@ -622,39 +868,25 @@ static int start_transfers(const struct sr_dev_inst *sdi)
 	} else
 		devc->trigger_fired = TRUE;
 
-	num_transfers = get_number_of_transfers(devc);
-
-	size = get_buffer_size(devc);
+	num_transfers = devc->target_transfers;
 	devc->submitted_transfers = 0;
 
-	devc->transfers = g_try_malloc0(sizeof(*devc->transfers) * num_transfers);
+	/* Leave room for the adaptive mode to add transfers. */
+	devc->num_transfers = devc->adaptive ?
+			devc->max_num_transfers : num_transfers;
+	devc->transfers = g_try_malloc0(sizeof(*devc->transfers)
+			* devc->num_transfers);
 	if (!devc->transfers) {
 		sr_err("USB transfers malloc failed.");
 		return SR_ERR_MALLOC;
 	}
 
 	timeout = get_timeout(devc);
-	devc->num_transfers = num_transfers;
 	for (i = 0; i < num_transfers; i++) {
-		if (!(buf = g_try_malloc(size))) {
-			sr_err("USB transfer buffer malloc failed.");
-			return SR_ERR_MALLOC;
-		}
-		transfer = libusb_alloc_transfer(0);
-		libusb_fill_bulk_transfer(transfer, usb->devhdl,
-				2 | LIBUSB_ENDPOINT_IN, buf, size,
-				receive_transfer, (void *)sdi, timeout);
-		sr_info("submitting transfer: %d", i);
-		if ((ret = libusb_submit_transfer(transfer)) != 0) {
-			sr_err("Failed to submit transfer: %s.",
-			       libusb_error_name(ret));
-			libusb_free_transfer(transfer);
-			g_free(buf);
+		if ((ret = submit_new_transfer(sdi, i, timeout)) != SR_OK) {
 			fx2lafw_abort_acquisition(devc);
-			return SR_ERR;
+			return ret;
 		}
-		devc->transfers[i] = transfer;
-		devc->submitted_transfers++;
 	}
 
 	/*
@@ -677,12 +909,15 @@ SR_PRIV int fx2lafw_start_acquisition(const struct sr_dev_inst *sdi)
 	struct sr_dev_driver *di;
 	struct drv_context *drvc;
 	struct dev_context *devc;
-	int timeout, ret;
-	size_t size;
+	struct sr_usb_dev_inst *usb;
+	unsigned int max_transfers;
+	int ret;
+	size_t size, capacity;
 
 	di = sdi->driver;
 	drvc = di->context;
 	devc = sdi->priv;
+	usb = sdi->conn;
 
 	devc->ctx = drvc->sr_ctx;
 	devc->sent_samples = 0;
@@ -694,16 +929,43 @@ SR_PRIV int fx2lafw_start_acquisition(const struct sr_dev_inst *sdi)
 		return SR_ERR;
 	}
 
-	timeout = get_timeout(devc);
-	usb_source_add(sdi->session, devc->ctx, timeout, receive_data, drvc);
-
 	size = get_buffer_size(devc);
+	devc->transfer_size = size;
+	devc->target_transfers = get_number_of_transfers(devc);
+
+	/* In adaptive mode, buffers must fit the largest transfer size. */
+	capacity = devc->adaptive ? devc->max_transfer_size : size;
+	max_transfers = devc->adaptive ?
+			devc->max_num_transfers : devc->target_transfers;
+
+	ret = usb_thread_source_add(sdi->session, devc->ctx,
+			max_transfers, usb->devhdl, capacity,
+			devc->target_transfers, TRUE,
+			receive_completion, (void *)sdi, &devc->usb_thread);
+	if (ret != SR_OK)
+		return ret;
+
 	/* Prepare for analog sampling. */
 	if (g_slist_length(devc->enabled_analog_channels) > 0) {
-		/* We need a buffer half the size of a transfer. */
-		devc->logic_buffer = g_try_malloc(size / 2);
-		devc->analog_buffer = g_try_malloc(
-			sizeof(float) * size / 2);
+		/* We need buffers half the size of a transfer. */
+		devc->logic_buffer = g_try_malloc(capacity / 2);
+		devc->analog_raw_buffer = g_try_malloc(capacity / 2);
+		if (!devc->analog_native)
+			devc->analog_buffer = g_try_malloc(
+				sizeof(float) * capacity / 2);
+		if (!devc->logic_buffer || !devc->analog_raw_buffer
+				|| (!devc->analog_native && !devc->analog_buffer)) {
+			sr_err("Deinterleave buffer malloc failed.");
+			g_free(devc->logic_buffer);
+			g_free(devc->analog_raw_buffer);
+			g_free(devc->analog_buffer);
+			devc->logic_buffer = NULL;
+			devc->analog_raw_buffer = NULL;
+			devc->analog_buffer = NULL;
+			usb_source_remove(sdi->session, devc->ctx);
+			devc->usb_thread = NULL;
+			return SR_ERR_MALLOC;
+		}
 	}
 	start_transfers(sdi);
 	if ((ret = command_start_acquisition(sdi)) != SR_OK) {
@@ -39,6 +39,18 @@
 #define NUM_SIMUL_TRANSFERS	32
 #define MAX_EMPTY_TRANSFERS	(NUM_SIMUL_TRANSFERS * 2)
 
+/* Bounds for the adaptive transfer mode. */
+#define MIN_TRANSFER_SIZE		512
+#define MAX_TRANSFER_SIZE		(16 * 1024 * 1024)
+#define DEFAULT_MAX_TRANSFER_SIZE	(512 * 1024)
+#define MAX_SIMUL_TRANSFERS		256
+#define DEFAULT_MIN_NUM_TRANSFERS	2
+#define DEFAULT_MAX_NUM_TRANSFERS	(NUM_SIMUL_TRANSFERS * 2)
+
+/* Completions per adaptation step, and calm steps before shrinking. */
+#define ADAPT_WINDOW		32
+#define ADAPT_CALM_WINDOWS	4
+
 #define NUM_CHANNELS		16
 
 #define FX2LAFW_REQUIRED_VERSION_MAJOR	1
@@ -116,10 +128,32 @@ struct dev_context {
 
 	unsigned int num_transfers;
 	struct libusb_transfer **transfers;
+	struct sr_usb_thread *usb_thread;
+
+	/* Transfer size and number, and their bounds in adaptive mode. */
+	gboolean adaptive;
+	size_t transfer_size;
+	unsigned int target_transfers;
+	uint64_t min_transfer_size;
+	uint64_t max_transfer_size;
+	uint64_t min_num_transfers;
+	uint64_t max_num_transfers;
+
+	/* Adaptive mode state, see adapt_transfers(). */
+	int64_t last_completion_us;
+	int64_t max_gap_us;
+	unsigned int window_count;
+	unsigned int window_short;
+	unsigned int calm_windows;
+	unsigned int last_overruns;
+
 	struct sr_context *ctx;
 	void (*send_data_proc)(struct sr_dev_inst *sdi,
 		uint8_t *data, size_t length, size_t sample_width);
+	/* MSO deinterleave buffers, see mso_send_data_proc(). */
+	gboolean analog_native;
 	uint8_t *logic_buffer;
+	uint8_t *analog_raw_buffer;
 	float *analog_buffer;
 };
 
@@ -127,5 +161,7 @@ SR_PRIV int fx2lafw_dev_open(struct sr_dev_inst *sdi, struct sr_dev_driver *di);
 SR_PRIV struct dev_context *fx2lafw_dev_new(void);
 SR_PRIV int fx2lafw_start_acquisition(const struct sr_dev_inst *sdi);
 SR_PRIV void fx2lafw_abort_acquisition(struct dev_context *devc);
+SR_PRIV uint64_t fx2lafw_get_transfer_size(struct dev_context *devc);
+SR_PRIV uint64_t fx2lafw_get_num_transfers(struct dev_context *devc);
 
 #endif
@@ -31,6 +31,21 @@ static const char *manufacturers[] = {
 	"Rohde&Schwarz",
 };
 
+/*
+ * Acquired points and waveform data change on their own. The sample
+ * rate is derived from the points of the first enabled channel or pod.
+ */
+static const struct sr_scpi_cache_rule cache_rules[] = {
+	{ ":CHAN1:DATA", 0 },
+	{ ":CHAN2:DATA", 0 },
+	{ ":CHAN3:DATA", 0 },
+	{ ":CHAN4:DATA", 0 },
+	{ ":POD0:DATA", 0 },
+	{ ":POD1:DATA", 0 },
+	{ ":POD2:DATA", 0 },
+	{ NULL, 0 },
+};
+
 static const uint32_t scanopts[] = {
 	SR_CONF_CONN,
 	SR_CONF_SERIALCOMM,
@@ -81,6 +96,9 @@ static struct sr_dev_inst *probe_device(struct sr_scpi_dev_inst *scpi)
 
 	sdi->priv = devc;
 
+	sr_scpi_cache_enable(scpi, SCPI_CACHE_TTL_DEFAULT_US, cache_rules,
+		TRUE);
+
 	if (hmo_init_device(sdi) != SR_OK)
 		goto fail;
 
@@ -104,6 +122,8 @@ static void clear_helper(struct dev_context *devc)
 	hmo_scope_state_free(devc->model_state);
 	g_free(devc->analog_groups);
 	g_free(devc->digital_groups);
+	if (devc->block_data)
+		g_byte_array_free(devc->block_data, TRUE);
 }
 
 static int dev_clear(const struct sr_dev_driver *di)
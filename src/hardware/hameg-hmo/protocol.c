@@ -834,8 +834,6 @@ SR_PRIV int hmo_receive_data(int fd, int revents, void *cb_data)
 	(void)fd;
 	(void)revents;
 
-	data = NULL;
-
 	if (!(sdi = cb_data))
 		return TRUE;
 
@@ -852,6 +850,11 @@ SR_PRIV int hmo_receive_data(int fd, int revents, void *cb_data)
 	ch = devc->current_channel->data;
 	state = devc->model_state;
 
+	/* Blocks are received into the same buffer, frame after frame. */
+	if (!devc->block_data)
+		devc->block_data = g_byte_array_new();
+	data = devc->block_data;
+
 	/*
 	 * Send "frame begin" packet upon reception of data for the
 	 * first enabled channel.
@@ -866,12 +869,8 @@ SR_PRIV int hmo_receive_data(int fd, int revents, void *cb_data)
 	 */
 	switch (ch->type) {
 	case SR_CHANNEL_ANALOG:
-		if (sr_scpi_get_block(sdi->conn, NULL, &data) != SR_OK) {
-			if (data)
-				g_byte_array_free(data, TRUE);
-
+		if (sr_scpi_get_block_buf(sdi->conn, NULL, data) != SR_OK)
 			return TRUE;
-		}
 
 		packet.type = SR_DF_ANALOG;
 
@@ -910,14 +909,10 @@ SR_PRIV int hmo_receive_data(int fd, int revents, void *cb_data)
 		packet.payload = &analog;
 		sr_session_send(sdi, &packet);
 		g_slist_free(meaning.channels);
-		g_byte_array_free(data, TRUE);
-		data = NULL;
 		break;
 	case SR_CHANNEL_LOGIC:
-		if (sr_scpi_get_block(sdi->conn, NULL, &data) != SR_OK) {
-			g_free(data);
+		if (sr_scpi_get_block_buf(sdi->conn, NULL, data) != SR_OK)
 			return TRUE;
-		}
 
 		/*
 		 * If only data from the first pod is involved in the
@@ -943,9 +938,6 @@ SR_PRIV int hmo_receive_data(int fd, int revents, void *cb_data)
 			group = ch->index / 8;
 			hmo_queue_logic_data(devc, group, data);
 		}
-
-		g_byte_array_free(data, TRUE);
-		data = NULL;
 		break;
 	default:
 		sr_err("Invalid channel type.");
@@ -44,6 +44,7 @@ static const uint32_t devopts[] = {
 	SR_CONF_HORIZ_TRIGGERPOS | SR_CONF_GET | SR_CONF_SET,
 	SR_CONF_TRIGGER_SOURCE | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
 	SR_CONF_TRIGGER_SLOPE | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
+	SR_CONF_ANALOG_NATIVE | SR_CONF_GET | SR_CONF_SET,
 };
 
 static const uint32_t devopts_cg_analog[] = {
@@ -85,6 +86,8 @@ static struct sr_dev_inst *probe_device(struct sr_scpi_dev_inst *scpi)
 	devc = g_malloc0(sizeof(struct dev_context));
 	sdi->priv = devc;
 
+	sr_scpi_cache_enable(scpi, SCPI_CACHE_TTL_DEFAULT_US, NULL, TRUE);
+
 	if (lecroy_xstream_init_device(sdi) != SR_OK)
 		goto fail;
 
@@ -188,6 +191,9 @@ static int config_get(uint32_t key, GVariant **data,
 	case SR_CONF_ENABLED:
 		*data = g_variant_new_boolean(FALSE);
 		break;
+	case SR_CONF_ANALOG_NATIVE:
+		*data = g_variant_new_boolean(devc->analog_native);
+		break;
 	default:
 		return SR_ERR_NA;
 	}
@@ -220,6 +226,10 @@ static int config_set(uint32_t key, GVariant *data,
 		devc->frame_limit = g_variant_get_uint64(data);
 		ret = SR_OK;
 		break;
+	case SR_CONF_ANALOG_NATIVE:
+		devc->analog_native = g_variant_get_boolean(data);
+		ret = SR_OK;
+		break;
 	case SR_CONF_TRIGGER_SOURCE:
 		if ((idx = std_str_idx(data, *model->trigger_sources, model->num_trigger_sources)) < 0)
 			return SR_ERR_ARG;
@@ -445,6 +455,7 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 	 * Start acquisition on the first enabled channel. The
 	 * receive routine will continue driving the acquisition.
 	 */
+	lecroy_xstream_buffers_alloc(devc);
 	sr_scpi_source_add(sdi->session, scpi, G_IO_IN, 50,
 			lecroy_xstream_receive_data, (void *)sdi);
 
@@ -475,6 +486,7 @@ static int dev_acquisition_stop(struct sr_dev_inst *sdi)
 	devc->enabled_channels = NULL;
 	scpi = sdi->conn;
 	sr_scpi_source_remove(sdi->session, scpi);
+	lecroy_xstream_buffers_free(devc);
 
 	return SR_OK;
 }
@@ -23,6 +23,9 @@
 #include "scpi.h"
 #include "protocol.h"
 
+/* Waveforms are converted and sent in chunks of up to this many bytes. */
+#define WAVEFORM_CHUNK_SIZE (256 * 1024)
+
 struct lecroy_wavedesc_2_x {
 	uint16_t comm_type;
 	uint16_t comm_order; /* 1 - little endian */
@@ -542,30 +545,13 @@ SR_PRIV int lecroy_xstream_init_device(struct sr_dev_inst *sdi)
 	return SR_OK;
 }
 
-static int lecroy_waveform_2_x_to_analog(GByteArray *data,
-		struct lecroy_wavedesc *desc, struct sr_datafeed_analog *analog)
+/* Fill in the description of an analog packet, all but its samples. */
+static void lecroy_waveform_2_x_init_analog(const struct lecroy_wavedesc *desc,
+		struct sr_datafeed_analog *analog)
 {
 	struct sr_analog_encoding *encoding = analog->encoding;
 	struct sr_analog_meaning *meaning = analog->meaning;
 	struct sr_analog_spec *spec = analog->spec;
-	float *data_float;
-	int16_t *waveform_data;
-	unsigned int i, num_samples;
-
-	data_float = g_malloc(desc->version_2_x.wave_array_count * sizeof(float));
-	num_samples = desc->version_2_x.wave_array_count;
-
-	waveform_data = (int16_t*)(data->data +
-		+ desc->version_2_x.wave_descriptor_length
-		+ desc->version_2_x.user_text_len);
-
-	for (i = 0; i < num_samples; i++)
-		data_float[i] = (float)waveform_data[i]
-			* desc->version_2_x.vertical_gain
-			+ desc->version_2_x.vertical_offset;
-
-	analog->data = data_float;
-	analog->num_samples = num_samples;
 
 	encoding->unitsize = sizeof(float);
 	encoding->is_signed = TRUE;
@@ -590,27 +576,159 @@ static int lecroy_waveform_2_x_to_analog(GByteArray *data,
 
 	meaning->mqflags = 0;
 	spec->spec_digits = 3;
+}
 
-	return SR_OK;
+static int lecroy_waveform_check(const struct lecroy_wavedesc *desc)
+{
+	if (!strncmp(desc->template_name, "LECROY_2_2", 16) ||
+	    !strncmp(desc->template_name, "LECROY_2_3", 16))
+		return SR_OK;
+
+	sr_err("Waveformat template '%.16s' not supported.", desc->template_name);
+	return SR_ERR;
 }
 
-static int lecroy_waveform_to_analog(GByteArray *data,
-		struct sr_datafeed_analog *analog)
+/* Reception of one channel's waveform, see waveform_receive(). */
+struct waveform_stream {
+	const struct sr_dev_inst *sdi;
+	struct sr_channel *ch;
+	struct lecroy_wavedesc desc;
+	gboolean have_desc;
+	/* Bytes between the descriptor's start and the first sample. */
+	size_t skip;
+	size_t num_samples;
+	size_t samples_sent;
+};
+
+SR_PRIV void lecroy_xstream_buffers_alloc(struct dev_context *devc)
 {
-	struct lecroy_wavedesc *desc;
+	devc->block = g_malloc(WAVEFORM_CHUNK_SIZE);
+	devc->data_float = g_malloc(WAVEFORM_CHUNK_SIZE / sizeof(int16_t) * sizeof(float));
+}
 
-	if (data->len < sizeof(struct lecroy_wavedesc))
-		return SR_ERR;
+SR_PRIV void lecroy_xstream_buffers_free(struct dev_context *devc)
+{
+	g_free(devc->block);
+	g_free(devc->data_float);
+	devc->block = NULL;
+	devc->data_float = NULL;
+}
 
-	desc = (struct lecroy_wavedesc*)data->data;
+/* Express a float exactly, as its 24 bit mantissa over a power of two. */
+static void waveform_rational(struct sr_rational *r, float value)
+{
+	int64_t p;
+	int exp, shift;
+
+	p = (int64_t)ldexpf(frexpf(value, &exp), 24);
+	shift = 24 - exp;
+	if (shift <= 0)
+		sr_rational_set(r, llroundf(value), 1);
+	else if (shift > 62)
+		sr_rational_set(r, p >> (shift - 62), UINT64_C(1) << 62);
+	else
+		sr_rational_set(r, p, UINT64_C(1) << shift);
+}
 
-	if (!strncmp(desc->template_name, "LECROY_2_2", 16) ||
-	    !strncmp(desc->template_name, "LECROY_2_3", 16)) {
-		return lecroy_waveform_2_x_to_analog(data, desc, analog);
+/*
+ * Send samples as they are in the received block, or converted to float.
+ * In native mode the int16 samples are passed on without a copy, the
+ * gain and offset go into the packet's encoding.
+ */
+static void waveform_send(struct waveform_stream *ws, const uint8_t *data,
+		size_t num_samples)
+{
+	struct dev_context *devc;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	float gain, offset;
+
+	devc = ws->sdi->priv;
+	gain = ws->desc.version_2_x.vertical_gain;
+	offset = ws->desc.version_2_x.vertical_offset;
+
+	sr_analog_init(&analog, &encoding, &meaning, &spec, 0);
+	lecroy_waveform_2_x_init_analog(&ws->desc, &analog);
+	if (devc->analog_native) {
+		encoding.unitsize = sizeof(int16_t);
+		encoding.is_float = FALSE;
+		waveform_rational(&encoding.scale, gain);
+		waveform_rational(&encoding.offset, offset);
+		analog.data = (void *)data;
+	} else {
+		sr_conv_s16le_to_float(data, devc->data_float, num_samples,
+			gain, offset);
+		analog.data = devc->data_float;
 	}
+	analog.num_samples = num_samples;
+	meaning.channels = g_slist_append(NULL, ws->ch);
+	packet.type = SR_DF_ANALOG;
+	packet.payload = &analog;
+	sr_session_send(ws->sdi, &packet);
+	g_slist_free(meaning.channels);
 
-	sr_err("Waveformat template '%.16s' not supported.", desc->template_name);
-	return SR_ERR;
+	ws->samples_sent += num_samples;
+}
+
+/*
+ * Convert and send the samples of a waveform while it is being received,
+ * rather than after the complete block (with multiple megasamples) has
+ * arrived.
+ */
+static int waveform_receive(const uint8_t *data, size_t len, size_t remaining,
+		void *cb_data)
+{
+	struct waveform_stream *ws;
+	struct dev_context *devc;
+	struct sr_datafeed_packet packet;
+	size_t used, count;
+
+	ws = cb_data;
+	devc = ws->sdi->priv;
+
+	if (!ws->have_desc) {
+		if (len < sizeof(ws->desc))
+			return remaining ? 0 : SR_ERR_DATA;
+		memcpy(&ws->desc, data, sizeof(ws->desc));
+		if (lecroy_waveform_check(&ws->desc) != SR_OK)
+			return SR_ERR_DATA;
+		ws->have_desc = TRUE;
+		ws->skip = ws->desc.version_2_x.wave_descriptor_length
+			+ ws->desc.version_2_x.user_text_len;
+		ws->num_samples = ws->desc.version_2_x.wave_array_count;
+
+		/* No data available, the caller acquires data first. */
+		if (!ws->num_samples)
+			return len;
+
+		/*
+		 * Send "frame begin" packet upon reception of data for the
+		 * first enabled channel.
+		 */
+		if (devc->current_channel == devc->enabled_channels) {
+			packet.type = SR_DF_FRAME_BEGIN;
+			sr_session_send(ws->sdi, &packet);
+		}
+	}
+
+	used = MIN(ws->skip, len);
+	ws->skip -= used;
+
+	count = MIN((len - used) / sizeof(int16_t),
+		ws->num_samples - ws->samples_sent);
+	if (count) {
+		waveform_send(ws, data + used, count);
+		used += count * sizeof(int16_t);
+	}
+
+	/* Samples come first in the block, ignore any trailing arrays. */
+	if (ws->samples_sent == ws->num_samples)
+		return len;
+
+	return used;
 }
 
 SR_PRIV int lecroy_xstream_receive_data(int fd, int revents, void *cb_data)
@@ -621,18 +739,13 @@ SR_PRIV int lecroy_xstream_receive_data(int fd, int revents, void *cb_data)
 	struct dev_context *devc;
 	struct scope_state *state;
 	struct sr_datafeed_packet packet;
-	GByteArray *data;
-	struct sr_datafeed_analog analog;
-	struct sr_analog_encoding encoding;
-	struct sr_analog_meaning meaning;
-	struct sr_analog_spec spec;
+	struct waveform_stream ws;
 	char buf[8];
+	int ret;
 
 	(void)fd;
 	(void)revents;
 
-	data = NULL;
-
 	if (!(sdi = cb_data))
 		return TRUE;
 
@@ -651,53 +764,36 @@ SR_PRIV int lecroy_xstream_receive_data(int fd, int revents, void *cb_data)
 		return TRUE;
 	}
 
-	if (sr_scpi_get_block(sdi->conn, NULL, &data) != SR_OK) {
-		if (data)
-			g_byte_array_free(data, TRUE);
-		return TRUE;
-	}
-
-	analog.encoding = &encoding;
-	analog.meaning = &meaning;
-	analog.spec = &spec;
+	memset(&ws, 0, sizeof(ws));
+	ws.sdi = sdi;
+	ws.ch = ch;
+	ret = sr_scpi_get_block_cb(sdi->conn, NULL, devc->block,
+		WAVEFORM_CHUNK_SIZE, waveform_receive, &ws);
 
-	if (lecroy_waveform_to_analog(data, &analog) != SR_OK)
+	if (ret != SR_OK) {
+		if (!ws.have_desc)
+			return TRUE;
 		return SR_ERR;
+	}
 
-	if (analog.num_samples == 0) {
+	if (ws.num_samples == 0) {
 		/* No data available, we have to acquire data first. */
 		g_snprintf(command, sizeof(command), "ARM;WAIT;*OPC;C%d:WAVEFORM?", ch->index + 1);
 		sr_scpi_send(sdi->conn, command);
 
 		state->sample_rate = 0;
 		return TRUE;
-	} else {
-		/* Update sample rate if needed. */
-		if (state->sample_rate == 0)
-			if (lecroy_xstream_update_sample_rate(sdi, analog.num_samples) != SR_OK)
-				return SR_ERR;
 	}
 
 	/*
-	 * Send "frame begin" packet upon reception of data for the
-	 * first enabled channel.
+	 * Update the sample rate if needed. Not before the block has been
+	 * read completely, the query would end up in the middle of it.
 	 */
-	if (devc->current_channel == devc->enabled_channels) {
-		packet.type = SR_DF_FRAME_BEGIN;
-		sr_session_send(sdi, &packet);
+	if (state->sample_rate == 0) {
+		if (lecroy_xstream_update_sample_rate(sdi, ws.num_samples) != SR_OK)
+			return SR_ERR;
 	}
 
-	meaning.channels = g_slist_append(NULL, ch);
-	packet.payload = &analog;
-	packet.type = SR_DF_ANALOG;
-	sr_session_send(sdi, &packet);
-
-	g_byte_array_free(data, TRUE);
-	data = NULL;
-
-	g_slist_free(meaning.channels);
-	g_free(analog.data);
-
 	/*
 	 * Advance to the next enabled channel. When data for all enabled
 	 * channels was received, then flush potentially queued logic data,
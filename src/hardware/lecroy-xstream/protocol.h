@@ -88,11 +88,18 @@ struct dev_context {
 	uint64_t num_frames;
 
 	uint64_t frame_limit;
+	gboolean analog_native;
+
+	/* Waveform reception buffers, while acquisition is running. */
+	uint8_t *block;
+	float *data_float;
 };
 
 SR_PRIV int lecroy_xstream_init_device(struct sr_dev_inst *sdi);
 SR_PRIV int lecroy_xstream_request_data(const struct sr_dev_inst *sdi);
 SR_PRIV int lecroy_xstream_receive_data(int fd, int revents, void *cb_data);
+SR_PRIV void lecroy_xstream_buffers_alloc(struct dev_context *devc);
+SR_PRIV void lecroy_xstream_buffers_free(struct dev_context *devc);
 
 SR_PRIV void lecroy_xstream_state_free(struct scope_state *state);
 SR_PRIV int lecroy_xstream_state_get(struct sr_dev_inst *sdi);
@@ -143,6 +143,8 @@ static struct sr_dev_inst *probe_device(struct sr_modbus_dev_inst *modbus)
 	sdi->version = g_strdup_printf("v%d.%d", version/10, version%10);
 	sdi->conn = modbus;
 	sdi->driver = &maynuo_m97_driver_info;
+	/* The register map is dense, and the line slow. */
+	modbus->merge_gap = 16;
 	sdi->inst_type = SR_INST_MODBUS;
 
 	cg = g_malloc0(sizeof(struct sr_channel_group));
@@ -236,14 +238,11 @@ static int config_get(uint32_t key, GVariant **data,
 	const struct sr_dev_inst *sdi, const struct sr_channel_group *cg)
 {
 	struct dev_context *devc;
-	struct sr_modbus_dev_inst *modbus;
-	enum maynuo_m97_mode mode;
-	int ret, ivalue;
-	float fvalue;
+	struct sr_config src;
+	int ret;
 
 	(void)cg;
 
-	modbus = sdi->conn;
 	devc = sdi->priv;
 
 	ret = SR_OK;
@@ -252,70 +251,38 @@ static int config_get(uint32_t key, GVariant **data,
 	case SR_CONF_LIMIT_MSEC:
 		ret = sr_sw_limits_config_get(&devc->limits, key, data);
 		break;
-	case SR_CONF_ENABLED:
-		if ((ret = maynuo_m97_get_bit(modbus, ISTATE, &ivalue)) == SR_OK)
-			*data = g_variant_new_boolean(ivalue);
-		break;
-	case SR_CONF_REGULATION:
-		if ((ret = maynuo_m97_get_bit(modbus, UNREG, &ivalue)) != SR_OK)
-			break;
-		if (ivalue)
-			*data = g_variant_new_string("UR");
-		else if ((ret = maynuo_m97_get_mode(modbus, &mode)) == SR_OK)
-			*data = g_variant_new_string(maynuo_m97_mode_to_str(mode));
-		break;
-	case SR_CONF_VOLTAGE:
-		if ((ret = maynuo_m97_get_float(modbus, U, &fvalue)) == SR_OK)
-			*data = g_variant_new_double(fvalue);
-		break;
-	case SR_CONF_VOLTAGE_TARGET:
-		if ((ret = maynuo_m97_get_float(modbus, UFIX, &fvalue)) == SR_OK)
-			*data = g_variant_new_double(fvalue);
-		break;
-	case SR_CONF_CURRENT:
-		if ((ret = maynuo_m97_get_float(modbus, I, &fvalue)) == SR_OK)
-			*data = g_variant_new_double(fvalue);
-		break;
-	case SR_CONF_CURRENT_LIMIT:
-		if ((ret = maynuo_m97_get_float(modbus, IFIX, &fvalue)) == SR_OK)
-			*data = g_variant_new_double(fvalue);
-		break;
 	case SR_CONF_OVER_VOLTAGE_PROTECTION_ENABLED:
 		*data = g_variant_new_boolean(TRUE);
 		break;
-	case SR_CONF_OVER_VOLTAGE_PROTECTION_ACTIVE:
-		if ((ret = maynuo_m97_get_bit(modbus, UOVER, &ivalue)) == SR_OK)
-			*data = g_variant_new_boolean(ivalue);
-		break;
-	case SR_CONF_OVER_VOLTAGE_PROTECTION_THRESHOLD:
-		if ((ret = maynuo_m97_get_float(modbus, UMAX, &fvalue)) == SR_OK)
-			*data = g_variant_new_double(fvalue);
-		break;
 	case SR_CONF_OVER_CURRENT_PROTECTION_ENABLED:
 		*data = g_variant_new_boolean(TRUE);
 		break;
-	case SR_CONF_OVER_CURRENT_PROTECTION_ACTIVE:
-		if ((ret = maynuo_m97_get_bit(modbus, IOVER, &ivalue)) == SR_OK)
-			*data = g_variant_new_boolean(ivalue);
-		break;
-	case SR_CONF_OVER_CURRENT_PROTECTION_THRESHOLD:
-		if ((ret = maynuo_m97_get_float(modbus, IMAX, &fvalue)) == SR_OK)
-			*data = g_variant_new_double(fvalue);
-		break;
 	case SR_CONF_OVER_TEMPERATURE_PROTECTION:
 		*data = g_variant_new_boolean(TRUE);
 		break;
-	case SR_CONF_OVER_TEMPERATURE_PROTECTION_ACTIVE:
-		if ((ret = maynuo_m97_get_bit(modbus, HEAT, &ivalue)) == SR_OK)
-			*data = g_variant_new_boolean(ivalue);
-		break;
 	default:
-		return SR_ERR_NA;
+		src.key = key;
+		src.data = NULL;
+		ret = maynuo_m97_config_get_multi(sdi->conn, &src, 1);
+		if (ret == SR_OK)
+			*data = src.data;
+		break;
 	}
 
 	return ret;
 }
 
+static int config_get_multi(struct sr_config *configs, unsigned int num_configs,
+	const struct sr_dev_inst *sdi, const struct sr_channel_group *cg)
+{
+	(void)cg;
+
+	if (!sdi)
+		return SR_ERR_ARG;
+
+	return maynuo_m97_config_get_multi(sdi->conn, configs, num_configs);
+}
+
 static int config_set(uint32_t key, GVariant *data,
 	const struct sr_dev_inst *sdi, const struct sr_channel_group *cg)
 {
@@ -424,5 +391,6 @@ static struct sr_dev_driver maynuo_m97_driver_info = {
 	.dev_acquisition_start = dev_acquisition_start,
 	.dev_acquisition_stop = dev_acquisition_stop,
 	.context = NULL,
+	.config_get_multi = config_get_multi,
 };
 SR_REGISTER_DEV_DRIVER(maynuo_m97_driver_info);
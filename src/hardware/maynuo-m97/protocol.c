@@ -20,31 +20,12 @@
 #include <config.h>
 #include "protocol.h"
 
-SR_PRIV int maynuo_m97_get_bit(struct sr_modbus_dev_inst *modbus,
-		enum maynuo_m97_coil address, int *value)
-{
-	uint8_t coil;
-	int ret = sr_modbus_read_coils(modbus, address, 1, &coil);
-	*value = coil & 1;
-	return ret;
-}
-
 SR_PRIV int maynuo_m97_set_bit(struct sr_modbus_dev_inst *modbus,
 		enum maynuo_m97_coil address, int value)
 {
 	return sr_modbus_write_coil(modbus, address, value);
 }
 
-SR_PRIV int maynuo_m97_get_float(struct sr_modbus_dev_inst *modbus,
-		enum maynuo_m97_register address, float *value)
-{
-	uint16_t registers[2];
-	int ret = sr_modbus_read_holding_registers(modbus, address, 2, registers);
-	if (ret == SR_OK)
-		*value = RBFL(registers);
-	return ret;
-}
-
 SR_PRIV int maynuo_m97_set_float(struct sr_modbus_dev_inst *modbus,
 		enum maynuo_m97_register address, float value)
 {
@@ -100,6 +81,113 @@ SR_PRIV int maynuo_m97_get_model_version(struct sr_modbus_dev_inst *modbus,
 	return ret;
 }
 
+/* Coil and registers to read for each key, -1 if none. */
+static const struct {
+	uint32_t key;
+	int coil;
+	int reg;
+	int num_regs;
+	/* The register holds a setting, rather than a measurement. */
+	gboolean setting;
+} key_map[] = {
+	{ SR_CONF_ENABLED, ISTATE, -1, 0, FALSE },
+	{ SR_CONF_REGULATION, UNREG, SETMODE, 1, TRUE },
+	{ SR_CONF_VOLTAGE, -1, U, 2, FALSE },
+	{ SR_CONF_VOLTAGE_TARGET, -1, UFIX, 2, TRUE },
+	{ SR_CONF_CURRENT, -1, I, 2, FALSE },
+	{ SR_CONF_CURRENT_LIMIT, -1, IFIX, 2, TRUE },
+	{ SR_CONF_OVER_VOLTAGE_PROTECTION_ACTIVE, UOVER, -1, 0, FALSE },
+	{ SR_CONF_OVER_VOLTAGE_PROTECTION_THRESHOLD, -1, UMAX, 2, TRUE },
+	{ SR_CONF_OVER_CURRENT_PROTECTION_ACTIVE, IOVER, -1, 0, FALSE },
+	{ SR_CONF_OVER_CURRENT_PROTECTION_THRESHOLD, -1, IMAX, 2, TRUE },
+	{ SR_CONF_OVER_TEMPERATURE_PROTECTION_ACTIVE, HEAT, -1, 0, FALSE },
+};
+
+struct key_values {
+	int map;
+	int coil_read;
+	int reg_read;
+	uint8_t coil;
+	uint16_t registers[2];
+};
+
+/*
+ * Read the values of several keys, with as few Modbus transactions as
+ * possible. Keys which aren't device readings are left alone.
+ */
+SR_PRIV int maynuo_m97_config_get_multi(struct sr_modbus_dev_inst *modbus,
+		struct sr_config *configs, unsigned int num_configs)
+{
+	struct sr_modbus_read *reads, *read;
+	struct key_values *values, *v;
+	enum maynuo_m97_mode mode;
+	unsigned int i, j, num_reads;
+	int ret;
+
+	reads = g_malloc0_n(2 * num_configs, sizeof(*reads));
+	values = g_malloc0_n(num_configs, sizeof(*values));
+	num_reads = 0;
+	ret = SR_OK;
+	for (i = 0; i < num_configs; i++) {
+		v = &values[i];
+		v->map = -1;
+		for (j = 0; j < ARRAY_SIZE(key_map); j++)
+			if (key_map[j].key == configs[i].key)
+				v->map = j;
+		if (v->map < 0) {
+			ret = SR_ERR_NA;
+			continue;
+		}
+		v->coil_read = v->reg_read = -1;
+		if (key_map[v->map].coil >= 0) {
+			read = &reads[v->coil_read = num_reads++];
+			read->table = SR_MODBUS_COILS;
+			read->address = key_map[v->map].coil;
+			read->count = 1;
+			read->data = &v->coil;
+		}
+		if (key_map[v->map].reg >= 0) {
+			read = &reads[v->reg_read = num_reads++];
+			read->table = SR_MODBUS_HOLDING_REGISTERS;
+			read->address = key_map[v->map].reg;
+			read->count = key_map[v->map].num_regs;
+			read->data = v->registers;
+			if (key_map[v->map].setting)
+				read->ttl_us = MODBUS_CACHE_TTL_DEFAULT_US;
+		}
+	}
+
+	if (num_reads && sr_modbus_read_multi(modbus, reads, num_reads) != SR_OK)
+		ret = SR_ERR;
+
+	for (i = 0; i < num_configs; i++) {
+		v = &values[i];
+		if (v->map < 0)
+			continue;
+		if ((v->coil_read >= 0 && reads[v->coil_read].ret != SR_OK)
+				|| (v->reg_read >= 0 && reads[v->reg_read].ret != SR_OK))
+			continue;
+		switch (configs[i].key) {
+		case SR_CONF_REGULATION:
+			mode = RB16(v->registers) & 0xFF;
+			configs[i].data = g_variant_new_string((v->coil & 1) ?
+				"UR" : maynuo_m97_mode_to_str(mode));
+			break;
+		default:
+			if (key_map[v->map].reg >= 0)
+				configs[i].data = g_variant_new_double(RBFL(v->registers));
+			else
+				configs[i].data = g_variant_new_boolean(v->coil & 1);
+			break;
+		}
+	}
+
+	g_free(values);
+	g_free(reads);
+
+	return ret;
+}
+
 
 SR_PRIV const char *maynuo_m97_mode_to_str(enum maynuo_m97_mode mode)
 {
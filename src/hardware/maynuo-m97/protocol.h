@@ -130,12 +130,8 @@ enum maynuo_m97_mode {
 	INPUT_OFF     = 43,
 };
 
-SR_PRIV int maynuo_m97_get_bit(struct sr_modbus_dev_inst *modbus,
-		enum maynuo_m97_coil address, int *value);
 SR_PRIV int maynuo_m97_set_bit(struct sr_modbus_dev_inst *modbus,
 		enum maynuo_m97_coil address, int value);
-SR_PRIV int maynuo_m97_get_float(struct sr_modbus_dev_inst *modbus,
-		enum maynuo_m97_register address, float *value);
 SR_PRIV int maynuo_m97_set_float(struct sr_modbus_dev_inst *modbus,
 		enum maynuo_m97_register address, float value);
 
@@ -146,6 +142,8 @@ SR_PRIV int maynuo_m97_set_mode(struct sr_modbus_dev_inst *modbus,
 SR_PRIV int maynuo_m97_set_input(struct sr_modbus_dev_inst *modbus, int enable);
 SR_PRIV int maynuo_m97_get_model_version(struct sr_modbus_dev_inst *modbus,
 		uint16_t *model, uint16_t *version);
+SR_PRIV int maynuo_m97_config_get_multi(struct sr_modbus_dev_inst *modbus,
+		struct sr_config *configs, unsigned int num_configs);
 
 SR_PRIV const char *maynuo_m97_mode_to_str(enum maynuo_m97_mode mode);
 
@@ -332,6 +332,83 @@ SR_PRIV void abort_acquisition(const struct sr_dev_inst *sdi)
 	std_session_send_df_end(sdi);
 }
 
+static void ols_process_sample(struct dev_context *devc, int num_ols_changrp)
+{
+	uint32_t sample;
+	unsigned int i;
+	int offset, j;
+
+	devc->cnt_samples++;
+	devc->cnt_samples_rle++;
+	devc->num_bytes = 0;
+
+	/*
+	 * Got a full sample. Convert from the OLS's little-endian
+	 * sample to the local format.
+	 */
+	sample = devc->sample[0] | (devc->sample[1] << 8) \
+			| (devc->sample[2] << 16) | (devc->sample[3] << 24);
+	if (devc->flag_reg & FLAG_RLE) {
+		/*
+		 * In RLE mode the high bit of the sample is the
+		 * "count" flag, meaning this sample is the number
+		 * of times the previous sample occurred.
+		 */
+		if (devc->sample[num_ols_changrp - 1] & 0x80) {
+			/* Clear the high bit. */
+			sample &= ~(0x80 << (num_ols_changrp - 1) * 8);
+			devc->rle_count = sample;
+			devc->cnt_samples_rle += devc->rle_count;
+			return;
+		}
+	}
+	devc->num_samples += devc->rle_count + 1;
+	if (devc->num_samples > devc->limit_samples) {
+		/* Save us from overrunning the buffer. */
+		devc->rle_count -= devc->num_samples - devc->limit_samples;
+		devc->num_samples = devc->limit_samples;
+	}
+
+	if (num_ols_changrp < 4) {
+		/*
+		 * Some channel groups may have been turned
+		 * off, to speed up transfer between the
+		 * hardware and the PC. Expand that here before
+		 * submitting it over the session bus --
+		 * whatever is listening on the bus will be
+		 * expecting a full 32-bit sample, based on
+		 * the number of channels.
+		 */
+		j = 0;
+		memset(devc->tmp_sample, 0, 4);
+		for (i = 0; i < 4; i++) {
+			if (((devc->flag_reg >> 2) & (1 << i)) == 0) {
+				/*
+				 * This channel group was
+				 * enabled, copy from received
+				 * sample.
+				 */
+				devc->tmp_sample[i] = devc->sample[j++];
+			} else if (devc->flag_reg & FLAG_DEMUX && (i > 2)) {
+				/* group 2 & 3 get added to 0 & 1 */
+				devc->tmp_sample[i - 2] = devc->sample[j++];
+			}
+		}
+		memcpy(devc->sample, devc->tmp_sample, 4);
+	}
+
+	/*
+	 * the OLS sends its sample buffer backwards.
+	 * store it in reverse order here, so we can dump
+	 * this on the session bus later.
+	 */
+	offset = (devc->limit_samples - devc->num_samples) * 4;
+	sr_conv_fill_samples(devc->raw_sample_buf + offset, devc->sample, 4,
+		devc->rle_count + 1);
+	memset(devc->sample, 0, 4);
+	devc->rle_count = 0;
+}
+
 SR_PRIV int ols_receive_data(int fd, int revents, void *cb_data)
 {
 	struct dev_context *devc;
@@ -339,10 +416,8 @@ SR_PRIV int ols_receive_data(int fd, int revents, void *cb_data)
 	struct sr_serial_dev_inst *serial;
 	struct sr_datafeed_packet packet;
 	struct sr_datafeed_logic logic;
-	uint32_t sample;
-	int num_ols_changrp, offset, j;
+	int num_ols_changrp, len, pos, n;
 	unsigned int i;
-	unsigned char byte;
 
 	(void)fd;
 
@@ -373,92 +448,30 @@ SR_PRIV int ols_receive_data(int fd, int revents, void *cb_data)
 	}
 
 	if (revents == G_IO_IN && devc->num_samples < devc->limit_samples) {
-		if (serial_read_nonblocking(serial, &byte, 1) != 1)
-			return FALSE;
-		devc->cnt_bytes++;
-
-		/* Ignore it if we've read enough. */
-		if (devc->num_samples >= devc->limit_samples)
-			return TRUE;
-
-		devc->sample[devc->num_bytes++] = byte;
-		sr_spew("Received byte 0x%.2x.", byte);
-		if (devc->num_bytes == num_ols_changrp) {
-			devc->cnt_samples++;
-			devc->cnt_samples_rle++;
-			/*
-			 * Got a full sample. Convert from the OLS's little-endian
-			 * sample to the local format.
-			 */
-			sample = devc->sample[0] | (devc->sample[1] << 8) \
-					| (devc->sample[2] << 16) | (devc->sample[3] << 24);
-			sr_dbg("Received sample 0x%.*x.", devc->num_bytes * 2, sample);
-			if (devc->flag_reg & FLAG_RLE) {
-				/*
-				 * In RLE mode the high bit of the sample is the
-				 * "count" flag, meaning this sample is the number
-				 * of times the previous sample occurred.
-				 */
-				if (devc->sample[devc->num_bytes - 1] & 0x80) {
-					/* Clear the high bit. */
-					sample &= ~(0x80 << (devc->num_bytes - 1) * 8);
-					devc->rle_count = sample;
-					devc->cnt_samples_rle += devc->rle_count;
-					sr_dbg("RLE count: %u.", devc->rle_count);
-					devc->num_bytes = 0;
-					return TRUE;
-				}
-			}
-			devc->num_samples += devc->rle_count + 1;
-			if (devc->num_samples > devc->limit_samples) {
-				/* Save us from overrunning the buffer. */
-				devc->rle_count -= devc->num_samples - devc->limit_samples;
-				devc->num_samples = devc->limit_samples;
-			}
-
-			if (num_ols_changrp < 4) {
-				/*
-				 * Some channel groups may have been turned
-				 * off, to speed up transfer between the
-				 * hardware and the PC. Expand that here before
-				 * submitting it over the session bus --
-				 * whatever is listening on the bus will be
-				 * expecting a full 32-bit sample, based on
-				 * the number of channels.
-				 */
-				j = 0;
-				memset(devc->tmp_sample, 0, 4);
-				for (i = 0; i < 4; i++) {
-					if (((devc->flag_reg >> 2) & (1 << i)) == 0) {
-						/*
-						 * This channel group was
-						 * enabled, copy from received
-						 * sample.
-						 */
-						devc->tmp_sample[i] = devc->sample[j++];
-					} else if (devc->flag_reg & FLAG_DEMUX && (i > 2)) {
-						/* group 2 & 3 get added to 0 & 1 */
-						devc->tmp_sample[i - 2] = devc->sample[j++];
-					}
-				}
-				memcpy(devc->sample, devc->tmp_sample, 4);
-				sr_spew("Expanded sample: 0x%.8x.", sample);
-			}
-
-			/*
-			 * the OLS sends its sample buffer backwards.
-			 * store it in reverse order here, so we can dump
-			 * this on the session bus later.
-			 */
-			offset = (devc->limit_samples - devc->num_samples) * 4;
-			for (i = 0; i <= devc->rle_count; i++) {
-				memcpy(devc->raw_sample_buf + offset + (i * 4),
-				       devc->sample, 4);
+		/*
+		 * Drain whatever the port has buffered. A sample may be
+		 * split across reads, devc->sample keeps the partial one.
+		 */
+		do {
+			len = serial_read_nonblocking(serial, devc->rx_buf,
+					sizeof(devc->rx_buf));
+			if (len < 0)
+				return FALSE;
+			devc->cnt_bytes += len;
+			sr_spew("Received %d bytes.", len);
+
+			/* Anything beyond the requested samples is ignored. */
+			pos = 0;
+			while (pos < len && devc->num_samples < devc->limit_samples) {
+				n = MIN(num_ols_changrp - devc->num_bytes, len - pos);
+				memcpy(devc->sample + devc->num_bytes,
+					devc->rx_buf + pos, n);
+				devc->num_bytes += n;
+				pos += n;
+				if (devc->num_bytes == num_ols_changrp)
+					ols_process_sample(devc, num_ols_changrp);
 			}
-			memset(devc->sample, 0, 4);
-			devc->num_bytes = 0;
-			devc->rle_count = 0;
-		}
+		} while (len == (int)sizeof(devc->rx_buf));
 	} else {
 		/*
 		 * This is the main loop telling us a timeout was reached, or
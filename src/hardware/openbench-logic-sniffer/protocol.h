@@ -34,6 +34,7 @@
 #define CLOCK_RATE                 SR_MHZ(100)
 #define MIN_NUM_SAMPLES            4
 #define DEFAULT_SAMPLERATE         SR_KHZ(200)
+#define RX_BUF_SIZE                (4 * 1024)
 
 /* Command opcodes */
 #define CMD_RESET                  0x00
@@ -94,6 +95,7 @@ struct dev_context {
 	unsigned char sample[4];
 	unsigned char tmp_sample[4];
 	unsigned char *raw_sample_buf;
+	unsigned char rx_buf[RX_BUF_SIZE];
 };
 
 SR_PRIV extern const char *ols_channel_names[];
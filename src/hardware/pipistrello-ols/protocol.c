@@ -371,17 +371,187 @@ SR_PRIV int p_ols_set_samplerate(const struct sr_dev_inst *sdi,
 	return SR_OK;
 }
 
+/*
+ * RLE in demux mode must be processed differently since in this case
+ * the RLE encoder is operating on pairs of samples.
+ */
+static void p_ols_process_sample_pair(struct dev_context *devc,
+		int num_channels)
+{
+	uint32_t sample;
+	unsigned char pair[8];
+	unsigned int i;
+	int offset, j, last;
+
+	devc->cnt_samples += 2;
+	devc->cnt_samples_rle += 2;
+	last = num_channels * 2 - 1;
+	devc->num_bytes = 0;
+
+	/*
+	 * Got a sample pair. Convert from the OLS's little-endian
+	 * sample to the local format.
+	 */
+	sample = devc->sample[0] | (devc->sample[1] << 8) \
+			| (devc->sample[2] << 16) | (devc->sample[3] << 24);
+
+	/*
+	 * In RLE mode the high bit of the sample pair is the
+	 * "count" flag, meaning this sample pair is the number
+	 * of times the previous sample pair occurred.
+	 */
+	if (devc->sample[last] & 0x80) {
+		/* Clear the high bit. */
+		sample &= ~(0x80 << last * 8);
+		devc->rle_count = sample;
+		devc->cnt_samples_rle += devc->rle_count * 2;
+		return;
+	}
+	devc->num_samples += (devc->rle_count + 1) * 2;
+	if (devc->num_samples > devc->limit_samples) {
+		/* Save us from overrunning the buffer. */
+		devc->rle_count -= (devc->num_samples - devc->limit_samples) / 2;
+		devc->num_samples = devc->limit_samples;
+	}
+
+	/*
+	 * Some channel groups may have been turned
+	 * off, to speed up transfer between the
+	 * hardware and the PC. Expand that here before
+	 * submitting it over the session bus --
+	 * whatever is listening on the bus will be
+	 * expecting a full 32-bit sample, based on
+	 * the number of channels.
+	 */
+	j = 0;
+	/* expand first sample */
+	memset(devc->tmp_sample, 0, 4);
+	for (i = 0; i < 2; i++) {
+		if (((devc->flag_reg >> 2) & (1 << i)) == 0) {
+			/*
+			 * This channel group was
+			 * enabled, copy from received
+			 * sample.
+			 */
+			devc->tmp_sample[i] = devc->sample[j++];
+		}
+	}
+	/* Clear out the most significant bit of the sample */
+	devc->tmp_sample[last] &= 0x7f;
+
+	/* expand second sample */
+	memset(devc->tmp_sample2, 0, 4);
+	for (i = 0; i < 2; i++) {
+		if (((devc->flag_reg >> 2) & (1 << i)) == 0) {
+			/*
+			 * This channel group was
+			 * enabled, copy from received
+			 * sample.
+			 */
+			devc->tmp_sample2[i] = devc->sample[j++];
+		}
+	}
+	/* Clear out the most significant bit of the sample */
+	devc->tmp_sample2[last] &= 0x7f;
+
+	/*
+	 * OLS sends its sample buffer backwards.
+	 * store it in reverse order here, so we can dump
+	 * this on the session bus later.
+	 */
+	memcpy(pair, devc->tmp_sample2, 4);
+	memcpy(pair + 4, devc->tmp_sample, 4);
+	offset = (devc->limit_samples - devc->num_samples) * 4;
+	sr_conv_fill_samples(devc->raw_sample_buf + offset, pair, 8,
+		devc->rle_count + 1);
+	memset(devc->sample, 0, 4);
+	devc->rle_count = 0;
+}
+
+static void p_ols_process_sample(struct dev_context *devc, int num_channels)
+{
+	uint32_t sample;
+	unsigned int i;
+	int offset, j;
+
+	devc->cnt_samples++;
+	devc->cnt_samples_rle++;
+	devc->num_bytes = 0;
+
+	/*
+	 * Got a full sample. Convert from the OLS's little-endian
+	 * sample to the local format.
+	 */
+	sample = devc->sample[0] | (devc->sample[1] << 8) \
+			| (devc->sample[2] << 16) | (devc->sample[3] << 24);
+	if (devc->flag_reg & FLAG_RLE) {
+		/*
+		 * In RLE mode the high bit of the sample is the
+		 * "count" flag, meaning this sample is the number
+		 * of times the previous sample occurred.
+		 */
+		if (devc->sample[num_channels - 1] & 0x80) {
+			/* Clear the high bit. */
+			sample &= ~(0x80 << (num_channels - 1) * 8);
+			devc->rle_count = sample;
+			devc->cnt_samples_rle += devc->rle_count;
+			return;
+		}
+	}
+	devc->num_samples += devc->rle_count + 1;
+	if (devc->num_samples > devc->limit_samples) {
+		/* Save us from overrunning the buffer. */
+		devc->rle_count -= devc->num_samples - devc->limit_samples;
+		devc->num_samples = devc->limit_samples;
+	}
+
+	if (num_channels < 4) {
+		/*
+		 * Some channel groups may have been turned
+		 * off, to speed up transfer between the
+		 * hardware and the PC. Expand that here before
+		 * submitting it over the session bus --
+		 * whatever is listening on the bus will be
+		 * expecting a full 32-bit sample, based on
+		 * the number of channels.
+		 */
+		j = 0;
+		memset(devc->tmp_sample, 0, 4);
+		for (i = 0; i < 4; i++) {
+			if (((devc->flag_reg >> 2) & (1 << i)) == 0) {
+				/*
+				 * This channel group was
+				 * enabled, copy from received
+				 * sample.
+				 */
+				devc->tmp_sample[i] = devc->sample[j++];
+			}
+		}
+		memcpy(devc->sample, devc->tmp_sample, 4);
+	}
+
+	/*
+	 * Pipistrello OLS sends its sample buffer backwards.
+	 * store it in reverse order here, so we can dump
+	 * this on the session bus later.
+	 */
+	offset = (devc->limit_samples - devc->num_samples) * 4;
+	sr_conv_fill_samples(devc->raw_sample_buf + offset, devc->sample, 4,
+		devc->rle_count + 1);
+	memset(devc->sample, 0, 4);
+	devc->rle_count = 0;
+}
+
 SR_PRIV int p_ols_receive_data(int fd, int revents, void *cb_data)
 {
 	struct dev_context *devc;
 	struct sr_dev_inst *sdi;
 	struct sr_datafeed_packet packet;
 	struct sr_datafeed_logic logic;
-	uint32_t sample;
-	int num_channels, offset, j;
+	int num_channels, sample_bytes, n;
 	int bytes_read, index;
+	gboolean pairs;
 	unsigned int i;
-	unsigned char byte;
 
 	(void)fd;
 	(void)revents;
@@ -407,6 +577,8 @@ SR_PRIV int p_ols_receive_data(int fd, int revents, void *cb_data)
 				num_channels++;
 			}
 		}
+		pairs = (devc->flag_reg & FLAG_DEMUX) && (devc->flag_reg & FLAG_RLE);
+		sample_bytes = pairs ? num_channels * 2 : num_channels;
 
 		/* Get a block of data. */
 		bytes_read = ftdi_read_data(devc->ftdic, devc->ftdi_buf, FTDI_BUF_SIZE);
@@ -422,191 +594,26 @@ SR_PRIV int p_ols_receive_data(int fd, int revents, void *cb_data)
 		}
 
 		sr_dbg("Received %d bytes", bytes_read);
+		devc->cnt_bytes += bytes_read;
 
+		/*
+		 * Assemble samples from the block. A sample may be split
+		 * across blocks, devc->sample keeps the partial one.
+		 * Anything beyond the requested samples is dropped.
+		 */
 		index = 0;
-		while (index < bytes_read) {
-			byte = devc->ftdi_buf[index++];
-			devc->cnt_bytes++;
-
-			devc->sample[devc->num_bytes++] = byte;
-			sr_spew("Received byte 0x%.2x.", byte);
-
-			if ((devc->flag_reg & FLAG_DEMUX) && (devc->flag_reg & FLAG_RLE)) {
-				/* RLE in demux mode must be processed differently
-				* since in this case the RLE encoder is operating on pairs of samples.
-				*/
-				if (devc->num_bytes == num_channels * 2) {
-					devc->cnt_samples += 2;
-					devc->cnt_samples_rle += 2;
-					/*
-					 * Got a sample pair. Convert from the OLS's little-endian
-					 * sample to the local format.
-					 */
-					sample = devc->sample[0] | (devc->sample[1] << 8) \
-							| (devc->sample[2] << 16) | (devc->sample[3] << 24);
-					sr_spew("Received sample pair 0x%.*x.", devc->num_bytes * 2, sample);
-
-					/*
-					 * In RLE mode the high bit of the sample pair is the
-					 * "count" flag, meaning this sample pair is the number
-					 * of times the previous sample pair occurred.
-					 */
-					if (devc->sample[devc->num_bytes - 1] & 0x80) {
-						/* Clear the high bit. */
-						sample &= ~(0x80 << (devc->num_bytes - 1) * 8);
-						devc->rle_count = sample;
-						devc->cnt_samples_rle += devc->rle_count * 2;
-						sr_dbg("RLE count: %u.", devc->rle_count * 2);
-						devc->num_bytes = 0;
-						continue;
-					}
-					devc->num_samples += (devc->rle_count + 1) * 2;
-					if (devc->num_samples > devc->limit_samples) {
-						/* Save us from overrunning the buffer. */
-						devc->rle_count -= (devc->num_samples - devc->limit_samples) / 2;
-						devc->num_samples = devc->limit_samples;
-						index = bytes_read;
-					}
-
-					/*
-					 * Some channel groups may have been turned
-					 * off, to speed up transfer between the
-					 * hardware and the PC. Expand that here before
-					 * submitting it over the session bus --
-					 * whatever is listening on the bus will be
-					 * expecting a full 32-bit sample, based on
-					 * the number of channels.
-					 */
-					j = 0;
-					/* expand first sample */
-					memset(devc->tmp_sample, 0, 4);
-					for (i = 0; i < 2; i++) {
-						if (((devc->flag_reg >> 2) & (1 << i)) == 0) {
-							/*
-							 * This channel group was
-							 * enabled, copy from received
-							 * sample.
-							 */
-							devc->tmp_sample[i] = devc->sample[j++];
-						}
-					}
-					/* Clear out the most significant bit of the sample */
-					devc->tmp_sample[devc->num_bytes - 1] &= 0x7f;
-					sr_spew("Expanded sample 1: 0x%.2x%.2x%.2x%.2x.",
-						devc->tmp_sample[3], devc->tmp_sample[2],
-						devc->tmp_sample[1], devc->tmp_sample[0]);
-
-					/* expand second sample */
-					memset(devc->tmp_sample2, 0, 4);
-					for (i = 0; i < 2; i++) {
-						if (((devc->flag_reg >> 2) & (1 << i)) == 0) {
-							/*
-							 * This channel group was
-							 * enabled, copy from received
-							 * sample.
-							 */
-							devc->tmp_sample2[i] = devc->sample[j++];
-						}
-					}
-					/* Clear out the most significant bit of the sample */
-					devc->tmp_sample2[devc->num_bytes - 1] &= 0x7f;
-					sr_spew("Expanded sample 2: 0x%.2x%.2x%.2x%.2x.",
-						devc->tmp_sample2[3], devc->tmp_sample2[2],
-						devc->tmp_sample2[1], devc->tmp_sample2[0]);
-
-					/*
-					 * OLS sends its sample buffer backwards.
-					 * store it in reverse order here, so we can dump
-					 * this on the session bus later.
-					 */
-					offset = (devc->limit_samples - devc->num_samples) * 4;
-					for (i = 0; i <= devc->rle_count; i++) {
-						memcpy(devc->raw_sample_buf + offset + (i * 8),
-									 devc->tmp_sample2, 4);
-						memcpy(devc->raw_sample_buf + offset + (4 + (i * 8)),
-									 devc->tmp_sample, 4);
-					}
-					memset(devc->sample, 0, 4);
-					devc->num_bytes = 0;
-					devc->rle_count = 0;
-				}
-			}
-			else {
-				if (devc->num_bytes == num_channels) {
-					devc->cnt_samples++;
-					devc->cnt_samples_rle++;
-					/*
-					 * Got a full sample. Convert from the OLS's little-endian
-					 * sample to the local format.
-					 */
-					sample = devc->sample[0] | (devc->sample[1] << 8) \
-							| (devc->sample[2] << 16) | (devc->sample[3] << 24);
-					sr_spew("Received sample 0x%.*x.", devc->num_bytes * 2, sample);
-					if (devc->flag_reg & FLAG_RLE) {
-						/*
-						 * In RLE mode the high bit of the sample is the
-						 * "count" flag, meaning this sample is the number
-						 * of times the previous sample occurred.
-						 */
-						if (devc->sample[devc->num_bytes - 1] & 0x80) {
-							/* Clear the high bit. */
-							sample &= ~(0x80 << (devc->num_bytes - 1) * 8);
-							devc->rle_count = sample;
-							devc->cnt_samples_rle += devc->rle_count;
-							sr_dbg("RLE count: %u.", devc->rle_count);
-							devc->num_bytes = 0;
-							continue;
-						}
-					}
-					devc->num_samples += devc->rle_count + 1;
-					if (devc->num_samples > devc->limit_samples) {
-						/* Save us from overrunning the buffer. */
-						devc->rle_count -= devc->num_samples - devc->limit_samples;
-						devc->num_samples = devc->limit_samples;
-						index = bytes_read;
-					}
-
-					if (num_channels < 4) {
-						/*
-						 * Some channel groups may have been turned
-						 * off, to speed up transfer between the
-						 * hardware and the PC. Expand that here before
-						 * submitting it over the session bus --
-						 * whatever is listening on the bus will be
-						 * expecting a full 32-bit sample, based on
-						 * the number of channels.
-						 */
-						j = 0;
-						memset(devc->tmp_sample, 0, 4);
-						for (i = 0; i < 4; i++) {
-							if (((devc->flag_reg >> 2) & (1 << i)) == 0) {
-								/*
-								 * This channel group was
-								 * enabled, copy from received
-								 * sample.
-								 */
-								devc->tmp_sample[i] = devc->sample[j++];
-							}
-						}
-						memcpy(devc->sample, devc->tmp_sample, 4);
-						sr_spew("Expanded sample: 0x%.8x.", sample);
-					}
-
-					/*
-					 * Pipistrello OLS sends its sample buffer backwards.
-					 * store it in reverse order here, so we can dump
-					 * this on the session bus later.
-					 */
-					offset = (devc->limit_samples - devc->num_samples) * 4;
-					for (i = 0; i <= devc->rle_count; i++) {
-						memcpy(devc->raw_sample_buf + offset + (i * 4),
-									 devc->sample, 4);
-					}
-					memset(devc->sample, 0, 4);
-					devc->num_bytes = 0;
-					devc->rle_count = 0;
-				}
-			}
+		while (index < bytes_read && devc->num_samples < devc->limit_samples) {
+			n = MIN(sample_bytes - devc->num_bytes, bytes_read - index);
+			memcpy(devc->sample + devc->num_bytes,
+				devc->ftdi_buf + index, n);
+			devc->num_bytes += n;
+			index += n;
+			if (devc->num_bytes < sample_bytes)
+				break;
+			if (pairs)
+				p_ols_process_sample_pair(devc, num_channels);
+			else
+				p_ols_process_sample(devc, num_channels);
 		}
 		return TRUE;
 	} else {
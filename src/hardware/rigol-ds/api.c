@@ -32,6 +32,13 @@
 #include "scpi.h"
 #include "protocol.h"
 
+/* Acquisition status and waveform queries change on their own. */
+static const struct sr_scpi_cache_rule cache_rules[] = {
+	{ ":TRIG:STAT?", 0 },
+	{ ":WAV:", 0 },
+	{ NULL, 0 },
+};
+
 static const uint32_t scanopts[] = {
 	SR_CONF_CONN,
 	SR_CONF_SERIALCOMM,
@@ -51,6 +58,7 @@ static const uint32_t devopts[] = {
 	SR_CONF_TRIGGER_SLOPE | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
 	SR_CONF_TRIGGER_LEVEL | SR_CONF_GET | SR_CONF_SET,
 	SR_CONF_DATA_SOURCE | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
+	SR_CONF_ANALOG_NATIVE | SR_CONF_GET | SR_CONF_SET,
 };
 
 static const uint32_t devopts_cg_analog[] = {
@@ -308,6 +316,13 @@ static struct sr_dev_inst *probe_device(struct sr_scpi_dev_inst *scpi)
 	devc->model = model;
 	devc->format = model->series->format;
 
+	/*
+	 * Don't have the cache poll the event status register, reading it
+	 * would clear the execution error bit the driver checks for.
+	 */
+	sr_scpi_cache_enable(scpi, SCPI_CACHE_TTL_DEFAULT_US, cache_rules,
+		FALSE);
+
 	/* DS1000 models with firmware before 0.2.4 used the old data format. */
 	if (model->series == SERIES(DS1000)) {
 		version = g_strsplit(hw_info->firmware_version, ".", 0);
@@ -606,6 +621,9 @@ static int config_get(uint32_t key, GVariant **data,
 		}
 		*data = g_variant_new_uint64(devc->attenuation[analog_channel]);
 		break;
+	case SR_CONF_ANALOG_NATIVE:
+		*data = g_variant_new_boolean(devc->analog_native);
+		break;
 	default:
 		return SR_ERR_NA;
 	}
@@ -733,6 +751,9 @@ static int config_set(uint32_t key, GVariant *data,
 			return SR_ERR;
 		}
 		break;
+	case SR_CONF_ANALOG_NATIVE:
+		devc->analog_native = g_variant_get_boolean(data);
+		break;
 	default:
 		return SR_ERR_NA;
 	}
@@ -946,14 +967,22 @@ static int dev_acquisition_stop(struct sr_dev_inst *sdi)
 {
 	struct dev_context *devc;
 	struct sr_scpi_dev_inst *scpi;
+	GByteArray *block;
 
 	devc = sdi->priv;
+	scpi = sdi->conn;
 
 	std_session_send_df_end(sdi);
 
+	if (devc->block_requested) {
+		/* Consume the data which was requested ahead. */
+		if (sr_scpi_get_block(scpi, NULL, &block) == SR_OK)
+			g_byte_array_free(block, TRUE);
+		devc->block_requested = FALSE;
+	}
+
 	g_slist_free(devc->enabled_channels);
 	devc->enabled_channels = NULL;
-	scpi = sdi->conn;
 	sr_scpi_source_remove(sdi->session, scpi);
 
 	return SR_OK;
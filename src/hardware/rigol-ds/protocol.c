@@ -425,6 +425,10 @@ SR_PRIV int rigol_ds_channel_start(const struct sr_dev_inst *sdi)
 
 	sr_dbg("Starting reading data from channel %d", ch->index + 1);
 
+	/* The channel was selected when its data was requested ahead. */
+	if (devc->block_requested)
+		goto done;
+
 	switch (devc->model->series->protocol) {
 	case PROTOCOL_V1:
 	case PROTOCOL_V2:
@@ -480,6 +484,7 @@ SR_PRIV int rigol_ds_channel_start(const struct sr_dev_inst *sdi)
 			return SR_ERR;
 	}
 
+done:
 	rigol_ds_set_wait_event(devc, WAIT_BLOCK);
 
 	devc->num_channel_bytes = 0;
@@ -546,21 +551,160 @@ static int rigol_ds_read_header(struct sr_dev_inst *sdi)
 	return ret;
 }
 
-SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data)
+/* Request the data block starting at offset of the current channel. */
+static int rigol_ds_block_request(const struct sr_dev_inst *sdi,
+		uint64_t offset)
 {
-	struct sr_dev_inst *sdi;
+	struct dev_context *devc;
+
+	devc = sdi->priv;
+
+	if (devc->model->series->protocol >= PROTOCOL_V4) {
+		if (rigol_ds_config_set(sdi, ":WAV:START %" PRIu64,
+				offset + 1) != SR_OK)
+			return SR_ERR;
+		if (rigol_ds_config_set(sdi, ":WAV:STOP %" PRIu64,
+				MIN(offset + ACQ_BLOCK_SIZE,
+					devc->analog_frame_size)) != SR_OK)
+			return SR_ERR;
+	}
+
+	if (devc->model->series->protocol >= PROTOCOL_V3)
+		if (sr_scpi_send(sdi->conn, ":WAV:DATA?") != SR_OK)
+			return SR_ERR;
+
+	return SR_OK;
+}
+
+/*
+ * Request the next data block while the current one is still to be
+ * converted and sent (DS1000Z series, on transports which can have
+ * several queries outstanding). When the block belongs to the next
+ * channel, it is selected as well. Settings are sent back to back, and
+ * their completion is checked once, along with the vertical reference.
+ */
+static int rigol_ds_block_prefetch(const struct sr_dev_inst *sdi,
+		struct sr_channel *ch, uint64_t offset)
+{
+	struct dev_context *devc;
 	struct sr_scpi_dev_inst *scpi;
+	const char *queries[2];
+	char *responses[2];
+	unsigned int num_queries;
+	int ret;
+
+	devc = sdi->priv;
+	scpi = sdi->conn;
+
+	if (offset == 0) {
+		if (ch->type == SR_CHANNEL_ANALOG)
+			ret = sr_scpi_send(scpi, ":WAV:SOUR CHAN%d", ch->index + 1);
+		else
+			ret = sr_scpi_send(scpi, ":WAV:SOUR D%d", ch->index);
+		if (ret != SR_OK)
+			return SR_ERR;
+		if (sr_scpi_send(scpi, devc->data_source == DATA_SOURCE_LIVE ?
+				":WAV:MODE NORM" : ":WAV:MODE RAW") != SR_OK)
+			return SR_ERR;
+	}
+	if (sr_scpi_send(scpi, ":WAV:START %" PRIu64, offset + 1) != SR_OK)
+		return SR_ERR;
+	if (sr_scpi_send(scpi, ":WAV:STOP %" PRIu64,
+			MIN(offset + ACQ_BLOCK_SIZE, devc->analog_frame_size)) != SR_OK)
+		return SR_ERR;
+
+	num_queries = 0;
+	queries[num_queries++] = "*OPC?";
+	if (offset == 0 && ch->type == SR_CHANNEL_ANALOG)
+		queries[num_queries++] = ":WAV:YREF?";
+	ret = sr_scpi_get_strings_pipelined(scpi, queries, num_queries,
+		responses);
+	if (ret != SR_OK)
+		return ret;
+	if (num_queries > 1)
+		ret = sr_atoi(responses[1], &devc->vert_reference[ch->index]);
+	g_free(responses[0]);
+	if (num_queries > 1)
+		g_free(responses[1]);
+	if (ret != SR_OK)
+		return ret;
+
+	if (sr_scpi_send(scpi, ":WAV:DATA?") != SR_OK)
+		return SR_ERR;
+	devc->block_requested = TRUE;
+
+	return SR_OK;
+}
+
+/* Approximate a value by a rational, for the analog encoding. */
+static void rigol_ds_rational(struct sr_rational *r, double value)
+{
+	sr_rational_set(r, llround(value * 1000000000), 1000000000);
+}
+
+/* Send a chunk of analog samples from the acquisition buffer. */
+static void rigol_ds_send_analog(const struct sr_dev_inst *sdi,
+		struct sr_channel *ch, int len)
+{
 	struct dev_context *devc;
 	struct sr_datafeed_packet packet;
 	struct sr_datafeed_analog analog;
 	struct sr_analog_encoding encoding;
 	struct sr_analog_meaning meaning;
 	struct sr_analog_spec spec;
+	float vdiv, vdivlog, scale, offset;
+	int digits;
+
+	devc = sdi->priv;
+
+	/* Samples are (value - reference) * vdiv - offset. */
+	vdiv = devc->vdiv[ch->index] / 25.6;
+	if (devc->model->series->protocol >= PROTOCOL_V3) {
+		scale = vdiv;
+		offset = -devc->vert_reference[ch->index] * vdiv;
+	} else {
+		scale = -vdiv;
+		offset = 128 * vdiv;
+	}
+	offset -= devc->vert_offset[ch->index];
+
+	vdivlog = log10f(vdiv);
+	digits = -(int)vdivlog + (vdivlog < 0.0);
+	sr_analog_init(&analog, &encoding, &meaning, &spec, digits);
+	analog.meaning->channels = g_slist_append(NULL, ch);
+	analog.num_samples = len;
+	analog.meaning->mq = SR_MQ_VOLTAGE;
+	analog.meaning->unit = SR_UNIT_VOLT;
+	analog.meaning->mqflags = 0;
+	if (devc->analog_native) {
+		analog.encoding->unitsize = 1;
+		analog.encoding->is_float = FALSE;
+		analog.encoding->is_signed = FALSE;
+		rigol_ds_rational(&analog.encoding->scale, scale);
+		rigol_ds_rational(&analog.encoding->offset, offset);
+		analog.data = devc->buffer;
+	} else {
+		sr_conv_u8_to_float(devc->buffer, devc->data, len, scale, offset);
+		analog.data = devc->data;
+	}
+	packet.type = SR_DF_ANALOG;
+	packet.payload = &analog;
+	sr_session_send(sdi, &packet);
+	g_slist_free(analog.meaning->channels);
+}
+
+SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data)
+{
+	struct sr_dev_inst *sdi;
+	struct sr_scpi_dev_inst *scpi;
+	struct dev_context *devc;
+	struct sr_datafeed_packet packet;
 	struct sr_datafeed_logic logic;
-	double vdiv, offset;
-	int len, i, vref;
-	struct sr_channel *ch;
+	int len;
+	struct sr_channel *ch, *next;
 	gsize expected_data_bytes;
+	uint64_t offset;
+	char terminator;
 
 	(void)fd;
 
@@ -607,19 +751,11 @@ SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data)
 			devc->analog_frame_size : devc->digital_frame_size;
 
 	if (devc->num_block_bytes == 0) {
-		if (devc->model->series->protocol >= PROTOCOL_V4) {
-			if (rigol_ds_config_set(sdi, ":WAV:START %d",
-					devc->num_channel_bytes + 1) != SR_OK)
-				return TRUE;
-			if (rigol_ds_config_set(sdi, ":WAV:STOP %d",
-					MIN(devc->num_channel_bytes + ACQ_BLOCK_SIZE,
-						devc->analog_frame_size)) != SR_OK)
-				return TRUE;
-		}
-
-		if (devc->model->series->protocol >= PROTOCOL_V3)
-			if (sr_scpi_send(sdi->conn, ":WAV:DATA?") != SR_OK)
-				return TRUE;
+		if (devc->block_requested)
+			devc->block_requested = FALSE;
+		else if (rigol_ds_block_request(sdi,
+				devc->num_channel_bytes) != SR_OK)
+			return TRUE;
 
 		if (sr_scpi_read_begin(scpi) != SR_OK)
 			return TRUE;
@@ -675,46 +811,11 @@ SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data)
 
 	devc->num_block_read += len;
 
-	if (ch->type == SR_CHANNEL_ANALOG) {
-		vref = devc->vert_reference[ch->index];
-		vdiv = devc->vdiv[ch->index] / 25.6;
-		offset = devc->vert_offset[ch->index];
-		if (devc->model->series->protocol >= PROTOCOL_V3)
-			for (i = 0; i < len; i++)
-				devc->data[i] = ((int)devc->buffer[i] - vref) * vdiv - offset;
-		else
-			for (i = 0; i < len; i++)
-				devc->data[i] = (128 - devc->buffer[i]) * vdiv - offset;
-		float vdivlog = log10f(vdiv);
-		int digits = -(int)vdivlog + (vdivlog < 0.0);
-		sr_analog_init(&analog, &encoding, &meaning, &spec, digits);
-		analog.meaning->channels = g_slist_append(NULL, ch);
-		analog.num_samples = len;
-		analog.data = devc->data;
-		analog.meaning->mq = SR_MQ_VOLTAGE;
-		analog.meaning->unit = SR_UNIT_VOLT;
-		analog.meaning->mqflags = 0;
-		packet.type = SR_DF_ANALOG;
-		packet.payload = &analog;
-		sr_session_send(sdi, &packet);
-		g_slist_free(analog.meaning->channels);
-	} else {
-		logic.length = len;
-		// TODO: For the MSO1000Z series, we need a way to express that
-		// this data is in fact just for a single channel, with the valid
-		// data for that channel in the LSB of each byte.
-		logic.unitsize = devc->model->series->protocol == PROTOCOL_V4 ? 1 : 2;
-		logic.data = devc->buffer;
-		packet.type = SR_DF_LOGIC;
-		packet.payload = &logic;
-		sr_session_send(sdi, &packet);
-	}
-
 	if (devc->num_block_read == devc->num_block_bytes) {
 		sr_dbg("Block has been completed");
 		if (devc->model->series->protocol >= PROTOCOL_V3) {
 			/* Discard the terminating linefeed */
-			sr_scpi_read_data(scpi, (char *)devc->buffer, 1);
+			sr_scpi_read_data(scpi, &terminator, 1);
 		}
 		if (devc->format == FORMAT_IEEE488_2) {
 			/* Prepare for possible next block */
@@ -731,11 +832,40 @@ SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data)
 			return TRUE;
 		}
 		devc->num_block_read = 0;
+
+		/* Have the scope send the next block while this one is sent. */
+		if (devc->model->series->protocol == PROTOCOL_V4
+				&& scpi->pipelining) {
+			next = NULL;
+			offset = devc->num_channel_bytes + len;
+			if (offset < expected_data_bytes) {
+				next = ch;
+			} else if (devc->channel_entry->next) {
+				next = devc->channel_entry->next->data;
+				offset = 0;
+			}
+			if (next && rigol_ds_block_prefetch(sdi, next, offset) != SR_OK)
+				sr_dbg("Failed to request the next block ahead.");
+		}
 	} else {
 		sr_dbg("%" PRIu64 " of %" PRIu64 " block bytes read",
 			devc->num_block_read, devc->num_block_bytes);
 	}
 
+	if (ch->type == SR_CHANNEL_ANALOG) {
+		rigol_ds_send_analog(sdi, ch, len);
+	} else {
+		logic.length = len;
+		// TODO: For the MSO1000Z series, we need a way to express that
+		// this data is in fact just for a single channel, with the valid
+		// data for that channel in the LSB of each byte.
+		logic.unitsize = devc->model->series->protocol == PROTOCOL_V4 ? 1 : 2;
+		logic.data = devc->buffer;
+		packet.type = SR_DF_LOGIC;
+		packet.payload = &logic;
+		sr_session_send(sdi, &packet);
+	}
+
 	devc->num_channel_bytes += len;
 
 	if (devc->num_channel_bytes < expected_data_bytes)
@@ -124,6 +124,7 @@ struct dev_context {
 	char *trigger_slope;
 	float trigger_level;
 	char *coupling[MAX_ANALOG_CHANNELS];
+	gboolean analog_native;
 
 	/* Number of frames received in total. */
 	uint64_t num_frames;
@@ -137,6 +138,8 @@ struct dev_context {
 	uint64_t num_block_bytes;
 	/* Number of data block bytes already read */
 	uint64_t num_block_read;
+	/* The next block's data has been requested ahead. */
+	gboolean block_requested;
 	/* What to wait for in *_receive */
 	enum wait_events wait_event;
 	/* Trigger/block copying/stop waiting status */
@@ -62,17 +62,20 @@ static const uint64_t samplerates[] = {
 static int upload_firmware(struct sr_context *ctx, libusb_device *dev, const char *name)
 {
 	struct libusb_device_handle *hdl = NULL;
-	unsigned char *firmware = NULL;
+	struct sr_resource_image *image;
+	unsigned char *firmware;
 	int ret = SR_ERR;
 	size_t fw_size, fw_offset = 0;
 	uint32_t part_address = 0;
 	uint16_t part_size = 0;
 	uint8_t part_final = 0;
 
-	firmware = sr_resource_load(ctx, SR_RESOURCE_FIRMWARE,
-				    name, &fw_size, 256 * 1024);
-	if (!firmware)
+	image = sr_resource_image_get(ctx, SR_RESOURCE_FIRMWARE,
+				      name, 256 * 1024);
+	if (!image)
 		goto out;
+	firmware = image->data;
+	fw_size = image->size;
 
 	sr_info("Uploading firmware '%s'.", name);
 
@@ -122,8 +125,8 @@ static int upload_firmware(struct sr_context *ctx, libusb_device *dev, const cha
  out:
 	if (hdl)
 		libusb_close(hdl);
-
-	g_free(firmware);
+	if (image)
+		sr_resource_image_unref(image);
 
 	return ret;
 }
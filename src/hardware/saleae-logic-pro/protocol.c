@@ -495,17 +495,20 @@ static int upload_bitstream(const struct sr_dev_inst *sdi,
 			    const char *name)
 {
 	struct drv_context *drvc = sdi->driver->context;
-	unsigned char *bitstream = NULL;
+	struct sr_resource_image *image;
+	unsigned char *bitstream;
 	uint8_t req[2];
 	uint8_t rsp[1];
 	uint8_t reg_val;
 	int ret = SR_ERR;
 	size_t bs_size, bs_offset = 0, bs_part_size;
 
-	bitstream = sr_resource_load(drvc->sr_ctx, SR_RESOURCE_FIRMWARE,
-				     name, &bs_size, 512 * 1024);
-	if (!bitstream)
+	image = sr_resource_image_get(drvc->sr_ctx, SR_RESOURCE_FIRMWARE,
+				      name, 512 * 1024);
+	if (!image)
 		goto out;
+	bitstream = image->data;
+	bs_size = image->size;
 
 	sr_info("Uploading bitstream '%s'.", name);
 
@@ -514,7 +517,7 @@ static int upload_bitstream(const struct sr_dev_inst *sdi,
 
 	ret = transact(sdi, req, sizeof(req), rsp, sizeof(rsp));
 	if (ret != SR_OK)
-		return ret;
+		goto out;
 	if (rsp[0] != 0x00) {
 		sr_err("Failed to start bitstream upload (0x%02x).", rsp[0]);
 		ret = SR_ERR;
@@ -548,7 +551,8 @@ static int upload_bitstream(const struct sr_dev_inst *sdi,
 	}
 
  out:
-	g_free(bitstream);
+	if (image)
+		sr_resource_image_unref(image);
 
 	return ret;
 }
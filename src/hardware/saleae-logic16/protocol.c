@@ -34,6 +34,9 @@
 #define FPGA_FIRMWARE_18	"saleae-logic16-fpga-18.bitstream"
 #define FPGA_FIRMWARE_33	"saleae-logic16-fpga-33.bitstream"
 
+/* Upper limit for the size of an FPGA bitstream, for safety. */
+#define FPGA_FIRMWARE_MAX_SIZE	(1024 * 1024)
+
 #define MAX_SAMPLE_RATE		SR_MHZ(100)
 #define MAX_SAMPLE_RATE_X_CH	SR_MHZ(300)
 
@@ -458,17 +461,39 @@ static int configure_led(const struct sr_dev_inst *sdi)
 	return set_led_mode(sdi, 1, 6250, 0, 1);
 }
 
+static int send_fpga_bitstream(const struct sr_dev_inst *sdi,
+			       const struct sr_resource_image *bitstream)
+{
+	size_t offset, chunksize;
+	int ret;
+	uint8_t command[64];
+
+	command[0] = COMMAND_FPGA_UPLOAD_INIT;
+	if ((ret = do_ep1_command(sdi, command, 1, NULL, 0)) != SR_OK)
+		return ret;
+
+	for (offset = 0; offset < bitstream->size; offset += chunksize) {
+		chunksize = MIN(bitstream->size - offset, sizeof(command) - 2);
+		command[0] = COMMAND_FPGA_UPLOAD_SEND_DATA;
+		command[1] = chunksize;
+		memcpy(&command[2], bitstream->data + offset, chunksize);
+
+		ret = do_ep1_command(sdi, command, chunksize + 2, NULL, 0);
+		if (ret != SR_OK)
+			return ret;
+	}
+
+	return SR_OK;
+}
+
 static int upload_fpga_bitstream(const struct sr_dev_inst *sdi,
 				 enum voltage_range vrange)
 {
-	uint64_t sum;
-	struct sr_resource bitstream;
+	struct sr_resource_image *bitstream;
 	struct dev_context *devc;
 	struct drv_context *drvc;
 	const char *name;
-	ssize_t chunksize;
 	int ret;
-	uint8_t command[64];
 
 	devc = sdi->priv;
 	drvc = sdi->driver->context;
@@ -489,41 +514,19 @@ static int upload_fpga_bitstream(const struct sr_dev_inst *sdi,
 			return SR_ERR;
 		}
 
+		bitstream = sr_resource_image_get(drvc->sr_ctx,
+				SR_RESOURCE_FIRMWARE, name, FPGA_FIRMWARE_MAX_SIZE);
+		if (!bitstream)
+			return SR_ERR;
+
 		sr_info("Uploading FPGA bitstream '%s'.", name);
-		ret = sr_resource_open(drvc->sr_ctx, &bitstream,
-				SR_RESOURCE_FIRMWARE, name);
+		ret = send_fpga_bitstream(sdi, bitstream);
+		if (ret == SR_OK)
+			sr_info("FPGA bitstream upload (%zu bytes) done.",
+				bitstream->size);
+		sr_resource_image_unref(bitstream);
 		if (ret != SR_OK)
 			return ret;
-
-		command[0] = COMMAND_FPGA_UPLOAD_INIT;
-		if ((ret = do_ep1_command(sdi, command, 1, NULL, 0)) != SR_OK) {
-			sr_resource_close(drvc->sr_ctx, &bitstream);
-			return ret;
-		}
-
-		sum = 0;
-		while (1) {
-			chunksize = sr_resource_read(drvc->sr_ctx, &bitstream,
-					&command[2], sizeof(command) - 2);
-			if (chunksize < 0) {
-				sr_resource_close(drvc->sr_ctx, &bitstream);
-				return SR_ERR;
-			}
-			if (chunksize == 0)
-				break;
-			command[0] = COMMAND_FPGA_UPLOAD_SEND_DATA;
-			command[1] = chunksize;
-
-			ret = do_ep1_command(sdi, command, chunksize + 2,
-					NULL, 0);
-			if (ret != SR_OK) {
-				sr_resource_close(drvc->sr_ctx, &bitstream);
-				return ret;
-			}
-			sum += chunksize;
-		}
-		sr_resource_close(drvc->sr_ctx, &bitstream);
-		sr_info("FPGA bitstream upload (%" PRIu64 " bytes) done.", sum);
 	}
 
 	/* This needs to be called before accessing any FPGA registers. */
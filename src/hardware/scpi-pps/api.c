@@ -299,103 +299,140 @@ static int dev_clear(const struct sr_dev_driver *di)
 	return std_dev_clear_with_callback(di, (std_dev_clear_callback)clear_helper);
 }
 
-static int config_get(uint32_t key, GVariant **data,
-	const struct sr_dev_inst *sdi, const struct sr_channel_group *cg)
+/* Map a config key to its query command, and the type of its value. */
+static int get_key_cmd(uint32_t key, const GVariantType **gvtype)
 {
-	struct dev_context *devc;
-	const GVariantType *gvtype;
-	unsigned int i;
-	int cmd, ret;
-	const char *s;
-
-	if (!sdi)
-		return SR_ERR_ARG;
-
-	devc = sdi->priv;
-
-	if (cg) {
-		/*
-		 * These options only apply to channel groups with a single
-		 * channel -- they're per-channel settings for the device.
-		 */
+	int cmd;
 
-		/*
-		 * Config keys are handled below depending on whether a channel
-		 * group was provided by the frontend. However some of these
-		 * take a CG on one PPS but not on others. Check the device's
-		 * profile for that here, and NULL out the channel group as needed.
-		 */
-		for (i = 0; i < devc->device->num_devopts; i++) {
-			if (devc->device->devopts[i] == key) {
-				cg = NULL;
-				break;
-			}
-		}
-	}
-
-	gvtype = NULL;
+	*gvtype = NULL;
 	cmd = -1;
 	switch (key) {
 	case SR_CONF_ENABLED:
-		gvtype = G_VARIANT_TYPE_BOOLEAN;
+		*gvtype = G_VARIANT_TYPE_BOOLEAN;
 		cmd = SCPI_CMD_GET_OUTPUT_ENABLED;
 		break;
 	case SR_CONF_VOLTAGE:
-		gvtype = G_VARIANT_TYPE_DOUBLE;
+		*gvtype = G_VARIANT_TYPE_DOUBLE;
 		cmd = SCPI_CMD_GET_MEAS_VOLTAGE;
 		break;
 	case SR_CONF_VOLTAGE_TARGET:
-		gvtype = G_VARIANT_TYPE_DOUBLE;
+		*gvtype = G_VARIANT_TYPE_DOUBLE;
 		cmd = SCPI_CMD_GET_VOLTAGE_TARGET;
 		break;
 	case SR_CONF_OUTPUT_FREQUENCY:
-		gvtype = G_VARIANT_TYPE_DOUBLE;
+		*gvtype = G_VARIANT_TYPE_DOUBLE;
 		cmd = SCPI_CMD_GET_MEAS_FREQUENCY;
 		break;
 	case SR_CONF_OUTPUT_FREQUENCY_TARGET:
-		gvtype = G_VARIANT_TYPE_DOUBLE;
+		*gvtype = G_VARIANT_TYPE_DOUBLE;
 		cmd = SCPI_CMD_GET_FREQUENCY_TARGET;
 		break;
 	case SR_CONF_CURRENT:
-		gvtype = G_VARIANT_TYPE_DOUBLE;
+		*gvtype = G_VARIANT_TYPE_DOUBLE;
 		cmd = SCPI_CMD_GET_MEAS_CURRENT;
 		break;
 	case SR_CONF_CURRENT_LIMIT:
-		gvtype = G_VARIANT_TYPE_DOUBLE;
+		*gvtype = G_VARIANT_TYPE_DOUBLE;
 		cmd = SCPI_CMD_GET_CURRENT_LIMIT;
 		break;
 	case SR_CONF_OVER_VOLTAGE_PROTECTION_ENABLED:
-		gvtype = G_VARIANT_TYPE_BOOLEAN;
+		*gvtype = G_VARIANT_TYPE_BOOLEAN;
 		cmd = SCPI_CMD_GET_OVER_VOLTAGE_PROTECTION_ENABLED;
 		break;
 	case SR_CONF_OVER_VOLTAGE_PROTECTION_ACTIVE:
-		gvtype = G_VARIANT_TYPE_BOOLEAN;
+		*gvtype = G_VARIANT_TYPE_BOOLEAN;
 		cmd = SCPI_CMD_GET_OVER_VOLTAGE_PROTECTION_ACTIVE;
 		break;
 	case SR_CONF_OVER_VOLTAGE_PROTECTION_THRESHOLD:
-		gvtype = G_VARIANT_TYPE_DOUBLE;
+		*gvtype = G_VARIANT_TYPE_DOUBLE;
 		cmd = SCPI_CMD_GET_OVER_VOLTAGE_PROTECTION_THRESHOLD;
 		break;
 	case SR_CONF_OVER_CURRENT_PROTECTION_ENABLED:
-		gvtype = G_VARIANT_TYPE_BOOLEAN;
+		*gvtype = G_VARIANT_TYPE_BOOLEAN;
 		cmd = SCPI_CMD_GET_OVER_CURRENT_PROTECTION_ENABLED;
 		break;
 	case SR_CONF_OVER_CURRENT_PROTECTION_ACTIVE:
-		gvtype = G_VARIANT_TYPE_BOOLEAN;
+		*gvtype = G_VARIANT_TYPE_BOOLEAN;
 		cmd = SCPI_CMD_GET_OVER_CURRENT_PROTECTION_ACTIVE;
 		break;
 	case SR_CONF_OVER_CURRENT_PROTECTION_THRESHOLD:
-		gvtype = G_VARIANT_TYPE_DOUBLE;
+		*gvtype = G_VARIANT_TYPE_DOUBLE;
 		cmd = SCPI_CMD_GET_OVER_CURRENT_PROTECTION_THRESHOLD;
 		break;
 	case SR_CONF_OVER_TEMPERATURE_PROTECTION:
-		gvtype = G_VARIANT_TYPE_BOOLEAN;
+		*gvtype = G_VARIANT_TYPE_BOOLEAN;
 		cmd = SCPI_CMD_GET_OVER_TEMPERATURE_PROTECTION;
 		break;
 	case SR_CONF_REGULATION:
-		gvtype = G_VARIANT_TYPE_STRING;
+		*gvtype = G_VARIANT_TYPE_STRING;
 		cmd = SCPI_CMD_GET_OUTPUT_REGULATION;
+		break;
 	}
+
+	return cmd;
+}
+
+/*
+ * The Rigol DP800 series return CV/CC/UR, Philips PM2800 return VOLT/CURR.
+ * We always return a GVariant string in the Rigol notation.
+ */
+static int fixup_regulation(GVariant **data)
+{
+	const char *s;
+
+	s = g_variant_get_string(*data, NULL);
+	if (!strcmp(s, "VOLT")) {
+		g_variant_unref(*data);
+		*data = g_variant_new_string("CV");
+	} else if (!strcmp(s, "CURR")) {
+		g_variant_unref(*data);
+		*data = g_variant_new_string("CC");
+	}
+
+	s = g_variant_get_string(*data, NULL);
+	if (strcmp(s, "CV") && strcmp(s, "CC") && strcmp(s, "UR")) {
+		sr_dbg("Unknown response to SCPI_CMD_GET_OUTPUT_REGULATION: %s", s);
+		return SR_ERR_DATA;
+	}
+
+	return SR_OK;
+}
+
+/* Whether the device takes key without a channel group. */
+static gboolean is_devopt(const struct dev_context *devc, uint32_t key)
+{
+	unsigned int i;
+
+	for (i = 0; i < devc->device->num_devopts; i++) {
+		if (devc->device->devopts[i] == key)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static int config_get(uint32_t key, GVariant **data,
+	const struct sr_dev_inst *sdi, const struct sr_channel_group *cg)
+{
+	struct dev_context *devc;
+	const GVariantType *gvtype;
+	int cmd, ret;
+
+	if (!sdi)
+		return SR_ERR_ARG;
+
+	devc = sdi->priv;
+
+	/*
+	 * Config keys are handled below depending on whether a channel
+	 * group was provided by the frontend. However some of these
+	 * take a CG on one PPS but not on others. Check the device's
+	 * profile for that here, and NULL out the channel group as needed.
+	 */
+	if (cg && is_devopt(devc, key))
+		cg = NULL;
+
+	cmd = get_key_cmd(key, &gvtype);
 	if (!gvtype)
 		return SR_ERR_NA;
 
@@ -403,28 +440,74 @@ static int config_get(uint32_t key, GVariant **data,
 		select_channel(sdi, cg->channels->data);
 	ret = scpi_cmd_resp(sdi, devc->device->commands, data, gvtype, cmd);
 
-	if (cmd == SCPI_CMD_GET_OUTPUT_REGULATION) {
-		/*
-		 * The Rigol DP800 series return CV/CC/UR, Philips PM2800
-		 * return VOLT/CURR. We always return a GVariant string in
-		 * the Rigol notation.
-		 */
-		s = g_variant_get_string(*data, NULL);
-		if (!strcmp(s, "VOLT")) {
-			g_variant_unref(*data);
-			*data = g_variant_new_string("CV");
-		} else if (!strcmp(s, "CURR")) {
-			g_variant_unref(*data);
-			*data = g_variant_new_string("CC");
+	if (ret == SR_OK && cmd == SCPI_CMD_GET_OUTPUT_REGULATION)
+		ret = fixup_regulation(data);
+
+	return ret;
+}
+
+/*
+ * Read all requested keys with one compound SCPI query, rather than one
+ * round trip per key. Keys which the query didn't return are left to the
+ * caller, which queries them one by one.
+ */
+static int config_get_multi(struct sr_config *configs, unsigned int num_configs,
+	const struct sr_dev_inst *sdi, const struct sr_channel_group *cg)
+{
+	struct dev_context *devc;
+	const GVariantType **gvtypes;
+	GVariant **data;
+	gboolean need_cg;
+	unsigned int i;
+	int *cmds;
+	int ret;
+
+	if (!sdi)
+		return SR_ERR_ARG;
+
+	devc = sdi->priv;
+
+	/*
+	 * IEEE 488.2 requires compound queries, but not all supplies get
+	 * them right. Only use them where known to work.
+	 */
+	if (!(devc->device->features & PPS_COMPOUND_QUERY))
+		return SR_ERR_NA;
+
+	gvtypes = g_malloc0_n(num_configs, sizeof(*gvtypes));
+	cmds = g_malloc0_n(num_configs, sizeof(*cmds));
+	data = g_malloc0_n(num_configs, sizeof(*data));
+	need_cg = FALSE;
+	for (i = 0; i < num_configs; i++) {
+		cmds[i] = get_key_cmd(configs[i].key, &gvtypes[i]);
+		if (!gvtypes[i]) {
+			/* Not a query, have it skipped by the command lookup. */
+			gvtypes[i] = G_VARIANT_TYPE_UNIT;
+			cmds[i] = -1;
 		}
+		if (cg && !is_devopt(devc, configs[i].key))
+			need_cg = TRUE;
+	}
 
-		s = g_variant_get_string(*data, NULL);
-		if (strcmp(s, "CV") && strcmp(s, "CC") && strcmp(s, "UR")) {
-			sr_dbg("Unknown response to SCPI_CMD_GET_OUTPUT_REGULATION: %s", s);
-			ret = SR_ERR_DATA;
+	/* The selected channel applies to all queries in the message. */
+	if (need_cg)
+		select_channel(sdi, cg->channels->data);
+	ret = scpi_cmd_resp_multi(sdi, devc->device->commands, data,
+		gvtypes, cmds, num_configs);
+
+	for (i = 0; i < num_configs; i++) {
+		if (data[i] && cmds[i] == SCPI_CMD_GET_OUTPUT_REGULATION
+				&& fixup_regulation(&data[i]) != SR_OK) {
+			g_variant_unref(data[i]);
+			data[i] = NULL;
 		}
+		configs[i].data = data[i];
 	}
 
+	g_free(data);
+	g_free(cmds);
+	g_free(gvtypes);
+
 	return ret;
 }
 
@@ -653,6 +736,7 @@ static struct sr_dev_driver scpi_pps_driver_info = {
 	.dev_acquisition_start = dev_acquisition_start,
 	.dev_acquisition_stop = dev_acquisition_stop,
 	.context = NULL,
+	.config_get_multi = config_get_multi,
 };
 
 static struct sr_dev_driver hp_ib_pps_driver_info = {
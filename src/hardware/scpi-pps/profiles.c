@@ -616,7 +616,7 @@ SR_PRIV const struct scpi_pps pps_profiles[] = {
 	},
 
 	/* HP 6632B */
-	{ "HP", "6632B", 0,
+	{ "HP", "6632B", PPS_COMPOUND_QUERY,
 		ARRAY_AND_SIZE(hp_6632b_devopts),
 		ARRAY_AND_SIZE(hp_6632b_devopts_cg),
 		ARRAY_AND_SIZE(hp_6632b_ch),
@@ -72,12 +72,14 @@ enum pps_scpi_cmds {
  * channel_group_spec.features.
  */
 enum pps_features {
-	PPS_OTP           = (1 << 0),
-	PPS_OVP           = (1 << 1),
-	PPS_OCP           = (1 << 2),
-	PPS_INDEPENDENT   = (1 << 3),
-	PPS_SERIES        = (1 << 4),
-	PPS_PARALLEL      = (1 << 5),
+	PPS_OTP            = (1 << 0),
+	PPS_OVP            = (1 << 1),
+	PPS_OCP            = (1 << 2),
+	PPS_INDEPENDENT    = (1 << 3),
+	PPS_SERIES         = (1 << 4),
+	PPS_PARALLEL       = (1 << 5),
+	/* Answers compound queries, see config_get_multi(). */
+	PPS_COMPOUND_QUERY = (1 << 6),
 };
 
 struct scpi_pps {
@@ -42,6 +42,7 @@ static const uint32_t devopts[] = {
 	SR_CONF_CONTINUOUS,
 	SR_CONF_LIMIT_SAMPLES | SR_CONF_SET,
 	SR_CONF_LIMIT_MSEC | SR_CONF_SET,
+	SR_CONF_COALESCE_SAMPLES | SR_CONF_GET | SR_CONF_SET,
 };
 
 static GSList *scan(struct sr_dev_driver *di, GSList *options)
@@ -140,16 +141,51 @@ scan_cleanup:
 	return std_scan_complete(di, devices);
 }
 
+static int config_get(uint32_t key, GVariant **data,
+	const struct sr_dev_inst *sdi, const struct sr_channel_group *cg)
+{
+	struct dev_context *devc;
+
+	(void)cg;
+
+	if (!sdi)
+		return SR_ERR_ARG;
+
+	devc = sdi->priv;
+
+	switch (key) {
+	case SR_CONF_COALESCE_SAMPLES:
+		*data = g_variant_new_uint64(devc->coalesce_samples);
+		break;
+	default:
+		return SR_ERR_NA;
+	}
+
+	return SR_OK;
+}
+
 static int config_set(uint32_t key, GVariant *data,
 	const struct sr_dev_inst *sdi, const struct sr_channel_group *cg)
 {
 	struct dev_context *devc;
+	uint64_t num;
 
 	(void)cg;
 
 	devc = sdi->priv;
 
-	return sr_sw_limits_config_set(&devc->limits, key, data);
+	switch (key) {
+	case SR_CONF_COALESCE_SAMPLES:
+		num = g_variant_get_uint64(data);
+		if (num > DMM_COALESCE_MAX)
+			return SR_ERR_ARG;
+		devc->coalesce_samples = num;
+		break;
+	default:
+		return sr_sw_limits_config_set(&devc->limits, key, data);
+	}
+
+	return SR_OK;
 }
 
 static int config_list(uint32_t key, GVariant **data,
@@ -168,13 +204,25 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 	sr_sw_limits_acquisition_start(&devc->limits);
 	std_session_send_df_header(sdi);
 
+	/* Note: digits/spec_digits will be overridden by the DMM parsers. */
+	sr_analog_init(&devc->held, &devc->held_encoding, &devc->held_meaning,
+		&devc->held_spec, 0);
+	devc->num_held = 0;
+
 	serial = sdi->conn;
-	serial_source_add(sdi->session, serial, G_IO_IN, 50,
+	serial_reactor_add(sdi->session, serial, G_IO_IN, 50,
 		      receive_data, (void *)sdi);
 
 	return SR_OK;
 }
 
+static int dev_acquisition_stop(struct sr_dev_inst *sdi)
+{
+	flush_readings(sdi);
+
+	return std_serial_dev_acquisition_stop(sdi);
+}
+
 #define DMM(ID, CHIPSET, VENDOR, MODEL, CONN, BAUDRATE, PACKETSIZE, TIMEOUT, \
 			DELAY, REQUEST, VALID, PARSE, DETAILS) \
 	&((struct dmm_info) { \
@@ -187,13 +235,13 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 			.scan = scan, \
 			.dev_list = std_dev_list, \
 			.dev_clear = std_dev_clear, \
-			.config_get = NULL, \
+			.config_get = config_get, \
 			.config_set = config_set, \
 			.config_list = config_list, \
 			.dev_open = std_serial_dev_open, \
 			.dev_close = std_serial_dev_close, \
 			.dev_acquisition_start = dev_acquisition_start, \
-			.dev_acquisition_stop = std_serial_dev_acquisition_stop, \
+			.dev_acquisition_stop = dev_acquisition_stop, \
 			.context = NULL, \
 		}, \
 		VENDOR, MODEL, CONN, BAUDRATE, PACKETSIZE, TIMEOUT, DELAY, \
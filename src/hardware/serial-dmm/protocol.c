@@ -27,15 +27,75 @@
 #include "libsigrok-internal.h"
 #include "protocol.h"
 
-static void log_dmm_packet(const uint8_t *buf)
+static void log_dmm_packet(const uint8_t *buf, int len)
 {
-	sr_dbg("DMM packet: %02x %02x %02x %02x %02x %02x %02x "
-	       "%02x %02x %02x %02x %02x %02x %02x %02x %02x "
-	       "%02x %02x %02x %02x %02x %02x %02x",
-	       buf[0], buf[1], buf[2], buf[3], buf[4], buf[5], buf[6],
-	       buf[7], buf[8], buf[9], buf[10], buf[11], buf[12], buf[13],
-	       buf[14], buf[15], buf[16], buf[17], buf[18], buf[19], buf[20],
-	       buf[21], buf[22]);
+	GString *text;
+	int i;
+
+	/* Don't pay for formatting what won't get logged. */
+	if (sr_log_loglevel_get() < SR_LOG_DBG)
+		return;
+
+	text = g_string_sized_new(3 * len);
+	for (i = 0; i < len; i++)
+		g_string_append_printf(text, " %02x", buf[i]);
+	sr_dbg("DMM packet:%s", text->str);
+	g_string_free(text, TRUE);
+}
+
+/** Send the readings which were held back, if any. */
+SR_PRIV void flush_readings(struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	struct sr_datafeed_packet packet;
+
+	devc = sdi->priv;
+	if (!devc->num_held)
+		return;
+
+	devc->held.data = devc->held_values;
+	devc->held.num_samples = devc->num_held;
+	packet.type = SR_DF_ANALOG;
+	packet.payload = &devc->held;
+	sr_session_send(sdi, &packet);
+	devc->num_held = 0;
+}
+
+static gboolean same_format(const struct sr_datafeed_analog *a,
+		const struct sr_datafeed_analog *b)
+{
+	return a->meaning->mq == b->meaning->mq
+		&& a->meaning->mqflags == b->meaning->mqflags
+		&& a->meaning->unit == b->meaning->unit
+		&& a->encoding->digits == b->encoding->digits
+		&& a->spec->spec_digits == b->spec->spec_digits;
+}
+
+/*
+ * Hold back a reading, to send runs of readings of the same format in
+ * one packet. The run ends when the format changes, the configured
+ * number of readings is reached, or the first one gets too old.
+ */
+static void hold_reading(struct sr_dev_inst *sdi,
+		const struct sr_datafeed_analog *analog, float value)
+{
+	struct dev_context *devc;
+
+	devc = sdi->priv;
+
+	if (devc->num_held && !same_format(&devc->held, analog))
+		flush_readings(sdi);
+
+	if (!devc->num_held) {
+		devc->held_encoding = *analog->encoding;
+		devc->held_meaning = *analog->meaning;
+		devc->held_spec = *analog->spec;
+		devc->held_since = g_get_monotonic_time();
+	}
+	devc->held_values[devc->num_held++] = value;
+
+	if (devc->num_held >= devc->coalesce_samples)
+		flush_readings(sdi);
 }
 
 static void handle_packet(const uint8_t *buf, struct sr_dev_inst *sdi,
@@ -52,7 +112,7 @@ static void handle_packet(const uint8_t *buf, struct sr_dev_inst *sdi,
 
 	dmm = (struct dmm_info *)sdi->driver;
 
-	log_dmm_packet(buf);
+	log_dmm_packet(buf, dmm->packet_size);
 	devc = sdi->priv;
 
 	/* Note: digits/spec_digits will be overridden by the DMM parsers. */
@@ -71,9 +131,13 @@ static void handle_packet(const uint8_t *buf, struct sr_dev_inst *sdi,
 
 	if (analog.meaning->mq != 0) {
 		/* Got a measurement. */
-		packet.type = SR_DF_ANALOG;
-		packet.payload = &analog;
-		sr_session_send(sdi, &packet);
+		if (devc->coalesce_samples > 1) {
+			hold_reading(sdi, &analog, floatval);
+		} else {
+			packet.type = SR_DF_ANALOG;
+			packet.payload = &analog;
+			sr_session_send(sdi, &packet);
+		}
 		sr_sw_limits_update_samples_read(&devc->limits, 1);
 	}
 }
@@ -187,6 +251,10 @@ int receive_data(int fd, int revents, void *cb_data)
 			return FALSE;
 	}
 
+	if (devc->num_held && g_get_monotonic_time() - devc->held_since
+			>= DMM_COALESCE_MAX_AGE_MS * 1000)
+		flush_readings(sdi);
+
 	if (sr_sw_limits_check(&devc->limits))
 		sr_dev_acquisition_stop(sdi);
 
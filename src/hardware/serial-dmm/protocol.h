@@ -60,9 +60,27 @@ struct dmm_info {
 
 #define DMM_BUFSIZE 256
 
+/* Upper limit for the number of readings in one analog packet. */
+#define DMM_COALESCE_MAX		1024
+/* Send coalesced readings no later than this after the first one. */
+#define DMM_COALESCE_MAX_AGE_MS		250
+
 struct dev_context {
 	struct sr_sw_limits limits;
 
+	/*
+	 * Consecutive readings of the same format, held back to be sent
+	 * in one analog packet.
+	 */
+	uint64_t coalesce_samples;
+	float held_values[DMM_COALESCE_MAX];
+	size_t num_held;
+	int64_t held_since;
+	struct sr_datafeed_analog held;
+	struct sr_analog_encoding held_encoding;
+	struct sr_analog_meaning held_meaning;
+	struct sr_analog_spec held_spec;
+
 	uint8_t buf[DMM_BUFSIZE];
 	int bufoffset;
 	int buflen;
@@ -75,6 +93,7 @@ struct dev_context {
 };
 
 SR_PRIV int req_packet(struct sr_dev_inst *sdi);
+SR_PRIV void flush_readings(struct sr_dev_inst *sdi);
 SR_PRIV int receive_data(int fd, int revents, void *cb_data);
 
 #endif
@@ -261,7 +261,13 @@ static int dev_open(struct sr_dev_inst *sdi)
 
 		sdi->status = SR_ST_ACTIVE;
 
-		devc->active_fpga_config = FPGA_NOCONF;
+		/*
+		 * The FPGA keeps its configuration while the device is
+		 * closed, so the bitstream need not be sent again. The
+		 * self test catches the case that it was lost anyway.
+		 */
+		if (i > 0)
+			devc->active_fpga_config = FPGA_NOCONF;
 		devc->short_transfer_quirk = FALSE;
 		devc->state = STATE_IDLE;
 
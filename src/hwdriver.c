@@ -179,6 +179,36 @@ static struct sr_key_info sr_key_info_config[] = {
 		"Under-voltage condition active", NULL},
 	{SR_CONF_TRIGGER_LEVEL, SR_T_FLOAT, "triggerlevel",
 		"Trigger level", NULL},
+	{SR_CONF_ADAPTIVE_TRANSFERS, SR_T_BOOL, "adaptive_transfers",
+		"Adaptive USB transfers", NULL},
+	{SR_CONF_TRANSFER_SIZE_RANGE, SR_T_UINT64_RANGE, "transfer_size_range",
+		"USB transfer size range", NULL},
+	{SR_CONF_NUM_TRANSFERS_RANGE, SR_T_UINT64_RANGE, "num_transfers_range",
+		"Number of USB transfers range", NULL},
+	{SR_CONF_TRANSFER_SIZE, SR_T_UINT64, "transfer_size",
+		"USB transfer size", NULL},
+	{SR_CONF_NUM_TRANSFERS, SR_T_UINT64, "num_transfers",
+		"Number of USB transfers", NULL},
+	{SR_CONF_ANALOG_NATIVE, SR_T_BOOL, "analog_native",
+		"Native analog encoding", NULL},
+	{SR_CONF_BENCHMARK, SR_T_BOOL, "benchmark",
+		"Benchmark mode", NULL},
+	{SR_CONF_PACKET_SIZE, SR_T_UINT64, "packet_size",
+		"Packet size", NULL},
+	{SR_CONF_LOGIC_UNITSIZE, SR_T_UINT64, "logic_unitsize",
+		"Logic unit size", NULL},
+	{SR_CONF_EDGE_INTERVAL, SR_T_UINT64, "edge_interval",
+		"Edge interval", NULL},
+	{SR_CONF_GLITCH_INTERVAL, SR_T_UINT64, "glitch_interval",
+		"Glitch interval", NULL},
+	{SR_CONF_BURST_LENGTH, SR_T_UINT64, "burst_length",
+		"Burst length", NULL},
+	{SR_CONF_NOISE_LEVEL, SR_T_FLOAT, "noise_level",
+		"Noise level", NULL},
+	{SR_CONF_WORKER_THREADS, SR_T_UINT64, "worker_threads",
+		"Worker threads", NULL},
+	{SR_CONF_COALESCE_SAMPLES, SR_T_UINT64, "coalesce_samples",
+		"Readings per packet", NULL},
 
 	/* Special stuff */
 	{SR_CONF_SESSIONFILE, SR_T_STRING, "sessionfile",
@@ -397,6 +427,9 @@ SR_API int sr_driver_init(struct sr_context *ctx, struct sr_dev_driver *driver)
 
 	/* No log message here, too verbose and not very useful. */
 
+	if ((ret = sr_libusb_init(ctx)) != SR_OK)
+		return ret;
+
 	if ((ret = driver->init(driver, ctx)) < 0)
 		sr_err("Failed to initialize the driver: %d.", ret);
 
@@ -535,6 +568,678 @@ SR_API GSList *sr_driver_scan(struct sr_dev_driver *driver, GSList *options)
 	return l;
 }
 
+/** @cond PRIVATE */
+/* Maximum number of driver scans running at the same time. */
+#define SCAN_MAX_THREADS 16
+
+/* The scan of one driver, run on a worker thread. */
+struct scan_job {
+	struct scan_all *scan;
+	struct sr_dev_driver *driver;
+	/* Copies of the scan options supported by the driver. */
+	GSList *options;
+	/* Monotonic time the scan started, 0 while queued. */
+	int64_t started;
+	GSList *devices;
+	/* Set by the calling thread once the result is handled. */
+	gboolean handled;
+	/* Cached devices the job looks for, and the one it scans for. */
+	GSList *entries;
+	const struct sr_discovery_entry *entry;
+	/* Whether all of them were found. */
+	gboolean verified;
+};
+
+/* State shared by sr_driver_scan_all() and the jobs it queued. */
+struct scan_all {
+	struct sr_context *ctx;
+	gint refcount;
+	GMutex mutex;
+	GAsyncQueue *results;
+	struct scan_job *jobs;
+	unsigned int num_jobs;
+};
+
+/* Connections in use by scan worker threads, and the thread using each. */
+static GMutex claim_mutex;
+static GCond claim_cond;
+static GHashTable *claims;
+
+/* The job of a scan worker thread, NULL on other threads. */
+static GPrivate scan_worker_job;
+/** @endcond */
+
+/**
+ * Claim a connection (serial port, USB device, ...) before probing it.
+ *
+ * On scan worker threads of sr_driver_scan_all(), this waits until no
+ * other worker uses the connection, so that concurrent driver scans
+ * don't talk to the same device at the same time. It does nothing on
+ * other threads.
+ *
+ * @param conn Connection identifier, e.g. the serial port name.
+ *
+ * @private
+ */
+SR_PRIV void sr_scan_claim(const char *conn)
+{
+	GThread *self, *owner;
+
+	if (!g_private_get(&scan_worker_job))
+		return;
+
+	self = g_thread_self();
+	g_mutex_lock(&claim_mutex);
+	if (!claims)
+		claims = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, NULL);
+	while ((owner = g_hash_table_lookup(claims, conn)) && owner != self)
+		g_cond_wait(&claim_cond, &claim_mutex);
+	if (!owner)
+		g_hash_table_insert(claims, g_strdup(conn), self);
+	g_mutex_unlock(&claim_mutex);
+}
+
+/**
+ * Release a connection claimed with sr_scan_claim().
+ *
+ * @param conn Connection identifier.
+ *
+ * @private
+ */
+SR_PRIV void sr_scan_release(const char *conn)
+{
+	if (!g_private_get(&scan_worker_job))
+		return;
+
+	g_mutex_lock(&claim_mutex);
+	if (claims && g_hash_table_lookup(claims, conn) == g_thread_self()) {
+		g_hash_table_remove(claims, conn);
+		g_cond_broadcast(&claim_cond);
+	}
+	g_mutex_unlock(&claim_mutex);
+}
+
+/**
+ * Add newly found devices to their driver's list of instances.
+ *
+ * Scan worker threads of sr_driver_scan_all() leave the list alone, the
+ * calling thread adds the devices it reports once it handles the scan's
+ * result, and frees the others.
+ *
+ * @param drvc The driver's context.
+ * @param devices The devices found.
+ *
+ * @private
+ */
+SR_PRIV void sr_scan_instances_add(struct drv_context *drvc, GSList *devices)
+{
+	if (g_private_get(&scan_worker_job))
+		return;
+
+	drvc->instances = g_slist_concat(drvc->instances, g_slist_copy(devices));
+}
+
+/**
+ * Add devices found by scans which timed out to their drivers' lists,
+ * so that they are freed along with the others.
+ *
+ * @param ctx The libsigrok context.
+ *
+ * @private
+ */
+SR_PRIV void sr_scan_adopt_late(struct sr_context *ctx)
+{
+	struct sr_dev_inst *sdi;
+	struct drv_context *drvc;
+	GSList *l, *devices;
+
+	g_mutex_lock(&ctx->late_mutex);
+	devices = ctx->late_devices;
+	ctx->late_devices = NULL;
+	g_mutex_unlock(&ctx->late_mutex);
+
+	for (l = devices; l; l = l->next) {
+		sdi = l->data;
+		drvc = sdi->driver->context;
+		drvc->instances = g_slist_append(drvc->instances, sdi);
+	}
+	g_slist_free(devices);
+}
+
+static gboolean claimed_by(gpointer key, gpointer value, gpointer user_data)
+{
+	(void)key;
+
+	return value == user_data;
+}
+
+/* Release whatever the scan left claimed, e.g. a port left open. */
+static void scan_release_all(void)
+{
+	g_mutex_lock(&claim_mutex);
+	if (claims && g_hash_table_foreach_remove(claims, claimed_by,
+			g_thread_self()))
+		g_cond_broadcast(&claim_cond);
+	g_mutex_unlock(&claim_mutex);
+}
+
+static void scan_all_unref(struct scan_all *scan)
+{
+	struct scan_job *job;
+	struct sr_dev_inst *sdi;
+	GSList *l;
+	unsigned int i;
+
+	if (!g_atomic_int_dec_and_test(&scan->refcount))
+		return;
+
+	/*
+	 * This may run on a worker thread, so devices found too late are
+	 * left for the next sr_driver_scan_all() call to adopt.
+	 */
+	while ((job = g_async_queue_try_pop(scan->results))) {
+		for (l = job->devices; l; l = l->next) {
+			sdi = l->data;
+			sdi->driver = job->driver;
+		}
+		g_mutex_lock(&scan->ctx->late_mutex);
+		scan->ctx->late_devices = g_slist_concat(scan->ctx->late_devices,
+			job->devices);
+		g_mutex_unlock(&scan->ctx->late_mutex);
+		job->devices = NULL;
+	}
+	g_async_queue_unref(scan->results);
+	for (i = 0; i < scan->num_jobs; i++)
+		g_slist_free_full(scan->jobs[i].options,
+			(GDestroyNotify)sr_config_free);
+	g_free(scan->jobs);
+	g_mutex_clear(&scan->mutex);
+	g_free(scan);
+}
+
+static void scan_worker(gpointer data, gpointer user_data)
+{
+	struct scan_job *job;
+	struct scan_all *scan;
+	char *claim;
+
+	(void)user_data;
+
+	job = data;
+	scan = job->scan;
+
+	g_mutex_lock(&scan->mutex);
+	job->started = g_get_monotonic_time();
+	g_mutex_unlock(&scan->mutex);
+
+	/* A driver must not scan twice at once, e.g. after a timeout. */
+	g_private_set(&scan_worker_job, job);
+	claim = g_strconcat("driver/", job->driver->name, NULL);
+	sr_scan_claim(claim);
+	job->devices = sr_driver_scan(job->driver, job->options);
+	scan_release_all();
+	g_private_set(&scan_worker_job, NULL);
+	g_free(claim);
+
+	g_async_queue_push(scan->results, job);
+	scan_all_unref(scan);
+}
+
+/* Copy the options the driver supports. */
+static GSList *scan_options(struct sr_dev_driver *driver, GSList *options)
+{
+	struct sr_config *src;
+	GArray *keys;
+	GSList *l, *result;
+	unsigned int i;
+
+	if (!options || !(keys = sr_driver_scan_options_list(driver)))
+		return NULL;
+
+	result = NULL;
+	for (l = options; l; l = l->next) {
+		src = l->data;
+		for (i = 0; i < keys->len; i++) {
+			if (g_array_index(keys, uint32_t, i) != src->key)
+				continue;
+			result = g_slist_append(result,
+				sr_config_new(src->key, src->data));
+			break;
+		}
+	}
+	g_array_free(keys, TRUE);
+
+	return result;
+}
+
+/* What to do with the devices found by the jobs of a scan. */
+struct scan_result {
+	GHashTable *conns;
+	sr_driver_scan_callback cb;
+	void *cb_data;
+	/* All devices reported, to record in the discovery cache. */
+	GSList *found;
+};
+
+/*
+ * Free devices a scan found but doesn't report, with the driver's own
+ * dev_clear(), which takes over the list.
+ */
+static void scan_discard(struct sr_dev_driver *driver, GSList *devices)
+{
+	struct drv_context *drvc;
+	GSList *instances;
+
+	if (!devices)
+		return;
+
+	drvc = driver->context;
+	instances = drvc->instances;
+	drvc->instances = devices;
+	sr_dev_clear(driver);
+	drvc->instances = instances;
+}
+
+/*
+ * Pass the devices found by a driver on. Devices on a connection which
+ * a device reported earlier is already on are left out.
+ */
+static void scan_report(struct scan_job *job, void *data)
+{
+	struct scan_result *result;
+	struct sr_dev_inst *sdi;
+	GSList *l, *devices, *skipped;
+
+	result = data;
+	devices = skipped = NULL;
+	for (l = job->devices; l; l = l->next) {
+		sdi = l->data;
+		if (sdi->connection_id) {
+			if (g_hash_table_contains(result->conns,
+					sdi->connection_id)) {
+				sr_dbg("%s: %s is already claimed, skipping.",
+					job->driver->name, sdi->connection_id);
+				skipped = g_slist_append(skipped, sdi);
+				continue;
+			}
+			g_hash_table_add(result->conns,
+				g_strdup(sdi->connection_id));
+		}
+		devices = g_slist_append(devices, sdi);
+	}
+	g_slist_free(job->devices);
+	job->devices = NULL;
+	scan_discard(job->driver, skipped);
+
+	/* The driver's list is only changed on this thread. */
+	sr_scan_instances_add(job->driver->context, devices);
+	if (devices)
+		result->cb(job->driver, devices, result->cb_data);
+	result->found = g_slist_concat(result->found, devices);
+}
+
+/*
+ * Keep the devices a job looking for cached devices found, if it found
+ * all of them.
+ */
+static void scan_verify(struct scan_job *job, void *data)
+{
+	struct sr_context *ctx;
+	struct sr_dev_inst *sdi;
+	GSList *l, *e, *devices;
+	unsigned int matched;
+
+	ctx = data;
+	devices = NULL;
+	matched = 0;
+	for (e = job->entries; e; e = e->next) {
+		for (l = job->devices; l; l = l->next) {
+			sdi = l->data;
+			if (!sr_discovery_match(ctx, e->data, sdi))
+				continue;
+			devices = g_slist_append(devices, sdi);
+			job->devices = g_slist_delete_link(job->devices, l);
+			matched++;
+			break;
+		}
+	}
+	/* Devices which aren't in the cache are found by a full scan. */
+	scan_discard(job->driver, job->devices);
+
+	job->verified = matched == g_slist_length(job->entries);
+	if (job->verified) {
+		job->devices = devices;
+	} else {
+		sr_dbg("%s: Cached devices not found.", job->driver->name);
+		scan_discard(job->driver, devices);
+		job->devices = NULL;
+	}
+}
+
+static struct scan_all *scan_new(struct sr_context *ctx,
+		unsigned int max_jobs)
+{
+	struct scan_all *scan;
+
+	scan = g_malloc0(sizeof(*scan));
+	scan->ctx = ctx;
+	scan->refcount = 1;
+	g_mutex_init(&scan->mutex);
+	scan->results = g_async_queue_new();
+	scan->jobs = g_malloc0_n(MAX(max_jobs, 1), sizeof(*scan->jobs));
+
+	return scan;
+}
+
+/* Add a job scanning with a driver, which takes over the options. */
+static struct scan_job *scan_add(struct sr_context *ctx,
+		struct scan_all *scan, struct sr_dev_driver *driver,
+		GSList *options)
+{
+	struct scan_job *job;
+
+	if (!driver->context && sr_driver_init(ctx, driver) != SR_OK) {
+		g_slist_free_full(options, (GDestroyNotify)sr_config_free);
+		return NULL;
+	}
+
+	job = &scan->jobs[scan->num_jobs++];
+	job->scan = scan;
+	job->driver = driver;
+	job->options = options;
+
+	return job;
+}
+
+/*
+ * Run the jobs of a scan, passing each job that finishes in time to the
+ * handler, on the calling thread. Consumes the caller's reference.
+ */
+static int scan_run(struct sr_context *ctx, struct scan_all *scan,
+		int64_t timeout_us, void (*handler)(struct scan_job *, void *),
+		void *data)
+{
+	struct scan_job *job;
+	int64_t now, wait_us, deadline;
+	unsigned int i, pending;
+	int ret;
+
+	/* Only queue jobs once the job array is complete. */
+	for (i = 0; i < scan->num_jobs; i++) {
+		g_atomic_int_inc(&scan->refcount);
+		g_thread_pool_push(ctx->scan_pool, &scan->jobs[i], NULL);
+	}
+
+	ret = SR_OK;
+	pending = scan->num_jobs;
+	while (pending) {
+		/* Give up on drivers past their deadline. */
+		now = g_get_monotonic_time();
+		deadline = G_MAXINT64;
+		g_mutex_lock(&scan->mutex);
+		for (i = 0; i < scan->num_jobs; i++) {
+			job = &scan->jobs[i];
+			if (job->handled || !job->started || timeout_us <= 0)
+				continue;
+			if (now < job->started + timeout_us) {
+				deadline = MIN(deadline, job->started + timeout_us);
+				continue;
+			}
+			sr_warn("%s: Scan timed out.", job->driver->name);
+			job->handled = TRUE;
+			pending--;
+			ret = SR_ERR_TIMEOUT;
+		}
+		g_mutex_unlock(&scan->mutex);
+		if (!pending)
+			break;
+
+		/* Queued jobs have no deadline yet, check back on them. */
+		wait_us = deadline == G_MAXINT64 ? 100 * 1000 : deadline - now;
+		if (timeout_us <= 0)
+			job = g_async_queue_pop(scan->results);
+		else
+			job = g_async_queue_timeout_pop(scan->results,
+				MIN(wait_us, 100 * 1000));
+		if (!job)
+			continue;
+		/* Timed out, keep the devices without reporting them. */
+		if (job->handled) {
+			sr_scan_instances_add(job->driver->context,
+				job->devices);
+			g_slist_free(job->devices);
+			job->devices = NULL;
+			continue;
+		}
+		job->handled = TRUE;
+		pending--;
+		handler(job, data);
+	}
+
+	return ret;
+}
+
+static struct sr_dev_driver *driver_find(struct sr_dev_driver **drivers,
+		const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; drivers[i]; i++) {
+		if (!strcmp(drivers[i]->name, name))
+			return drivers[i];
+	}
+
+	return NULL;
+}
+
+/* Options to find a cached device again with. */
+static GSList *entry_options(struct sr_dev_driver *driver,
+		const struct sr_discovery_entry *entry)
+{
+	GSList *l, *options;
+
+	l = NULL;
+	if (entry->conn)
+		l = g_slist_append(l, sr_config_new(SR_CONF_CONN,
+			g_variant_new_string(entry->conn)));
+	if (entry->serialcomm)
+		l = g_slist_append(l, sr_config_new(SR_CONF_SERIALCOMM,
+			g_variant_new_string(entry->serialcomm)));
+	options = scan_options(driver, l);
+	g_slist_free_full(l, (GDestroyNotify)sr_config_free);
+
+	return options;
+}
+
+/*
+ * Look for the devices in the discovery cache, with one job per driver
+ * and connection. Drivers which didn't find all the devices they found
+ * before are marked in the rescan table, the others are reported.
+ */
+static int scan_cached(struct sr_context *ctx, struct sr_dev_driver **drivers,
+		GSList *entries, int64_t timeout_us, struct scan_result *result,
+		GHashTable *rescan)
+{
+	struct sr_discovery_entry *entry;
+	struct sr_dev_driver *driver;
+	struct scan_all *scan;
+	struct scan_job *job;
+	GSList *l;
+	unsigned int i;
+	int ret;
+
+	scan = scan_new(ctx, g_slist_length(entries));
+	for (l = entries; l; l = l->next) {
+		entry = l->data;
+		if (!(driver = driver_find(drivers, entry->driver)))
+			continue;
+		for (i = 0; i < scan->num_jobs; i++) {
+			job = &scan->jobs[i];
+			if (job->driver == driver
+					&& !g_strcmp0(job->entry->conn, entry->conn)
+					&& !g_strcmp0(job->entry->serialcomm,
+						entry->serialcomm))
+				break;
+		}
+		if (i == scan->num_jobs) {
+			job = scan_add(ctx, scan, driver,
+				entry_options(driver, entry));
+			if (!job)
+				continue;
+			job->entry = entry;
+		}
+		job->entries = g_slist_append(job->entries, entry);
+	}
+
+	ret = scan_run(ctx, scan, timeout_us, scan_verify, ctx);
+
+	for (i = 0; i < scan->num_jobs; i++) {
+		job = &scan->jobs[i];
+		if (!job->verified)
+			g_hash_table_add(rescan, job->driver);
+	}
+	for (i = 0; i < scan->num_jobs; i++) {
+		job = &scan->jobs[i];
+		if (!job->verified)
+			continue;
+		/* Some other device of the same driver is gone. */
+		if (g_hash_table_contains(rescan, job->driver)) {
+			scan_discard(job->driver, job->devices);
+			job->devices = NULL;
+			continue;
+		}
+		scan_report(job, result);
+	}
+	for (i = 0; i < scan->num_jobs; i++)
+		g_slist_free(scan->jobs[i].entries);
+	scan_all_unref(scan);
+
+	return ret;
+}
+
+/**
+ * Scan for devices with several drivers at once.
+ *
+ * The scans run concurrently on a pool of worker threads, so that the
+ * time taken is that of the slowest driver rather than the sum over all
+ * drivers. Drivers which haven't been initialized yet are initialized
+ * first.
+ *
+ * Results are passed to the callback as they arrive, on the calling
+ * thread. A device whose connection ID matches that of a device reported
+ * earlier is not reported again. While scanning, probes of the same
+ * serial port or USB device by different drivers are serialized.
+ *
+ * A driver that doesn't finish scanning within the timeout is given up
+ * on. Its scan keeps running in the background, devices it finds are
+ * not reported. sr_exit() waits for such scans to end.
+ *
+ * If the discovery cache is enabled (see sr_discovery_cache_enable()) and
+ * no options are given, only the devices the drivers found in their last
+ * scan without options are looked for again, as long as the cache is
+ * valid and holds the results of all of the drivers. Drivers which don't
+ * find all of their cached devices scan in full.
+ *
+ * @param ctx A libsigrok context object allocated by a previous call to
+ *            sr_init(). Must not be NULL.
+ * @param drivers NULL-terminated list of drivers, as returned by
+ *                sr_driver_list(), or NULL for all drivers.
+ * @param options A list of 'struct sr_config' options. Each driver is
+ *                passed the ones it supports as scan options. Can be NULL.
+ * @param timeout_us Time each driver may take to scan, in microseconds,
+ *                   or 0 for no limit.
+ * @param cb Function called with the driver and a list of the devices it
+ *           found, for each driver that found any. The list is freed
+ *           after the callback returns, the devices are not.
+ * @param cb_data Opaque pointer passed to the callback.
+ *
+ * @retval SR_OK All drivers finished scanning.
+ * @retval SR_ERR_TIMEOUT Some drivers didn't finish in time.
+ * @retval SR_ERR_ARG Invalid argument.
+ * @retval SR_ERR Failed to start worker threads.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_driver_scan_all(struct sr_context *ctx,
+		struct sr_dev_driver **drivers, GSList *options,
+		int64_t timeout_us, sr_driver_scan_callback cb, void *cb_data)
+{
+	struct scan_all *scan;
+	struct scan_result result;
+	GHashTable *rescan;
+	GSList *entries;
+	GError *error;
+	gboolean cached;
+	unsigned int i, n;
+	int ret;
+
+	if (!ctx || !cb)
+		return SR_ERR_ARG;
+
+	sr_scan_adopt_late(ctx);
+
+	if (!drivers)
+		drivers = sr_driver_list(ctx);
+	for (n = 0; drivers[n]; n++)
+		;
+
+	/* The cache holds what scans without options found. */
+	entries = NULL;
+	cached = !options && sr_discovery_lookup(ctx, drivers, &entries);
+
+	if (!ctx->scan_pool) {
+		error = NULL;
+		ctx->scan_pool = g_thread_pool_new(scan_worker, NULL,
+			SCAN_MAX_THREADS, FALSE, &error);
+		if (!ctx->scan_pool) {
+			sr_err("Failed to create scan threads: %s.",
+				error->message);
+			g_error_free(error);
+			return SR_ERR;
+		}
+	}
+
+	memset(&result, 0, sizeof(result));
+	result.conns = g_hash_table_new_full(g_str_hash, g_str_equal,
+		g_free, NULL);
+	result.cb = cb;
+	result.cb_data = cb_data;
+	rescan = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	ret = SR_OK;
+	if (cached) {
+		sr_dbg("Looking for %u cached devices.",
+			g_slist_length(entries));
+		ret = scan_cached(ctx, drivers, entries, timeout_us, &result,
+			rescan);
+	}
+
+	if (!cached || g_hash_table_size(rescan) > 0) {
+		scan = scan_new(ctx, n);
+		for (i = 0; i < n; i++) {
+			if (cached && !g_hash_table_contains(rescan, drivers[i]))
+				continue;
+			scan_add(ctx, scan, drivers[i],
+				scan_options(drivers[i], options));
+		}
+		if (scan_run(ctx, scan, timeout_us, scan_report,
+				&result) != SR_OK)
+			ret = SR_ERR_TIMEOUT;
+		scan_all_unref(scan);
+
+		/* Devices of drivers which timed out would be missing. */
+		if (!options && ret == SR_OK)
+			sr_discovery_store(ctx, drivers, result.found);
+	}
+
+	g_hash_table_destroy(rescan);
+	g_hash_table_destroy(result.conns);
+	g_slist_free(result.found);
+
+	return ret;
+}
+
 /**
  * Call driver cleanup function for all drivers.
  *
@@ -840,6 +1545,186 @@ SR_API int sr_config_set(const struct sr_dev_inst *sdi,
 	return ret;
 }
 
+/**
+ * Query the values of several configuration keys at once.
+ *
+ * Drivers which can combine several queries into a single exchange with
+ * the device (e.g. by joining SCPI queries with ';') implement this
+ * natively. For all other drivers, and for keys the driver's combined
+ * query did not return, this falls back to querying the keys one by one.
+ *
+ * @param[in] driver The sr_dev_driver struct to query. Must not be NULL.
+ * @param[in] sdi (optional) If the keys are specific to a device, this must
+ *            contain a pointer to the struct sr_dev_inst to be checked.
+ *            Otherwise it must be NULL. If sdi is != NULL, sdi->priv must
+ *            also be != NULL.
+ * @param[in] cg The channel group on the device for which to query the
+ *               values, or NULL.
+ * @param[in,out] configs Array of num_configs entries. The key of each
+ *                entry selects the configuration key (SR_CONF_*) to query,
+ *                its data field receives the value. The caller is given
+ *                ownership of every GVariant returned. Entries whose key
+ *                could not be queried have their data field set to NULL.
+ * @param[in] num_configs Number of entries in configs.
+ *
+ * @retval SR_OK Success. Check each entry's data field for the keys which
+ *         could actually be read.
+ * @retval SR_ERR Error.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_config_get_multi(const struct sr_dev_driver *driver,
+		const struct sr_dev_inst *sdi,
+		const struct sr_channel_group *cg,
+		struct sr_config *configs, unsigned int num_configs)
+{
+	struct sr_config *batch;
+	unsigned int *index;
+	unsigned int i, num_batch;
+	int ret;
+
+	if (!driver || (!configs && num_configs))
+		return SR_ERR;
+
+	if (sdi && !sdi->priv) {
+		sr_err("Can't get config (sdi != NULL, sdi->priv == NULL).");
+		return SR_ERR;
+	}
+
+	for (i = 0; i < num_configs; i++)
+		configs[i].data = NULL;
+
+	if (!driver->config_get || !num_configs)
+		return SR_OK;
+
+	/* Only pass keys on to the driver which it publishes for reading. */
+	batch = g_malloc0(num_configs * sizeof(*batch));
+	index = g_malloc(num_configs * sizeof(*index));
+	num_batch = 0;
+	for (i = 0; i < num_configs; i++) {
+		if (check_key(driver, sdi, cg, configs[i].key, SR_CONF_GET, NULL) != SR_OK)
+			continue;
+		index[num_batch] = i;
+		batch[num_batch++].key = configs[i].key;
+	}
+
+	if (num_batch > 1 && driver->config_get_multi) {
+		ret = driver->config_get_multi(batch, num_batch, sdi, cg);
+		if (ret != SR_OK && ret != SR_ERR_NA)
+			sr_dbg("Combined query failed (%d), querying keys "
+				"one by one.", ret);
+		for (i = 0; i < num_batch; i++) {
+			if (!batch[i].data)
+				continue;
+			log_key(sdi, cg, batch[i].key, SR_CONF_GET, batch[i].data);
+			configs[index[i]].data = g_variant_ref_sink(batch[i].data);
+		}
+	}
+
+	/* Query whatever is still missing one key at a time. */
+	for (i = 0; i < num_batch; i++) {
+		if (configs[index[i]].data)
+			continue;
+		ret = driver->config_get(batch[i].key, &batch[i].data, sdi, cg);
+		if (ret == SR_OK) {
+			log_key(sdi, cg, batch[i].key, SR_CONF_GET, batch[i].data);
+			configs[index[i]].data = g_variant_ref_sink(batch[i].data);
+		} else if (ret == SR_ERR_CHANNEL_GROUP) {
+			sr_err("%s: No channel group specified.",
+				(sdi) ? sdi->driver->name : "unknown");
+		}
+	}
+
+	g_free(index);
+	g_free(batch);
+
+	return SR_OK;
+}
+
+/**
+ * Set the values of several configuration keys in a device instance at once.
+ *
+ * All keys and values are checked before any of them is applied. Drivers
+ * which can combine several settings into a single exchange with the
+ * device implement this natively, for all other drivers the keys are set
+ * one by one, in the order given.
+ *
+ * @param[in] sdi The device instance. Must not be NULL. sdi->driver and
+ *                sdi->priv must not be NULL either.
+ * @param[in] cg The channel group on the device for which to set the
+ *               values, or NULL.
+ * @param[in] configs Array of num_configs keys (SR_CONF_*) and new values.
+ *            Floating references can be passed in; their refcounts will be
+ *            sunk and unreferenced after use.
+ * @param[in] num_configs Number of entries in configs.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR Error.
+ * @retval SR_ERR_ARG The driver doesn't know one of the keys, or one of the
+ *         values has the wrong type. None of the keys were set.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_config_set_multi(const struct sr_dev_inst *sdi,
+		const struct sr_channel_group *cg,
+		struct sr_config *configs, unsigned int num_configs)
+{
+	unsigned int i;
+	int ret;
+
+	if (!configs && num_configs)
+		return SR_ERR;
+
+	for (i = 0; i < num_configs; i++) {
+		if (configs[i].data)
+			g_variant_ref_sink(configs[i].data);
+	}
+
+	ret = SR_OK;
+	if (!sdi || !sdi->driver || !sdi->priv)
+		ret = SR_ERR;
+	else if (!sdi->driver->config_set)
+		ret = SR_ERR_ARG;
+	else if (sdi->status != SR_ST_ACTIVE) {
+		sr_err("%s: Device instance not active, can't set config.",
+			sdi->driver->name);
+		ret = SR_ERR_DEV_CLOSED;
+	}
+
+	for (i = 0; i < num_configs && ret == SR_OK; i++) {
+		if (!configs[i].data)
+			ret = SR_ERR;
+		else if (check_key(sdi->driver, sdi, cg, configs[i].key,
+				SR_CONF_SET, configs[i].data) != SR_OK)
+			ret = SR_ERR_ARG;
+		else
+			ret = sr_variant_type_check(configs[i].key, configs[i].data);
+	}
+
+	if (ret == SR_OK && num_configs > 1 && sdi->driver->config_set_multi) {
+		for (i = 0; i < num_configs; i++)
+			log_key(sdi, cg, configs[i].key, SR_CONF_SET, configs[i].data);
+		ret = sdi->driver->config_set_multi(configs, num_configs, sdi, cg);
+	} else {
+		for (i = 0; i < num_configs && ret == SR_OK; i++) {
+			log_key(sdi, cg, configs[i].key, SR_CONF_SET, configs[i].data);
+			ret = sdi->driver->config_set(configs[i].key,
+				configs[i].data, sdi, cg);
+		}
+	}
+
+	for (i = 0; i < num_configs; i++) {
+		if (configs[i].data)
+			g_variant_unref(configs[i].data);
+	}
+
+	if (ret == SR_ERR_CHANNEL_GROUP)
+		sr_err("%s: No channel group specified.",
+			(sdi) ? sdi->driver->name : "unknown");
+
+	return ret;
+}
+
 /**
  * Apply configuration settings to the device hardware.
  *
@@ -345,6 +345,16 @@ struct sr_context {
 	sr_resource_close_callback resource_close_cb;
 	sr_resource_read_callback resource_read_cb;
 	void *resource_cb_data;
+	/* Resources loaded by sr_resource_image_get(). */
+	GHashTable *resource_images;
+	GMutex resource_mutex;
+	/* Worker threads of sr_driver_scan_all(), created on first use. */
+	GThreadPool *scan_pool;
+	/* Devices found by scans which timed out, see sr_scan_adopt_late(). */
+	GSList *late_devices;
+	GMutex late_mutex;
+	/* Device discovery cache, if enabled. */
+	struct sr_discovery *discovery;
 };
 
 /** Input module metadata keys. */
@@ -712,6 +722,9 @@ struct sr_usb_dev_inst {
 #endif
 
 #ifdef HAVE_LIBSERIALPORT
+/** Size of the read-ahead buffer of a serial port. */
+#define SERIAL_RCV_BUFSIZE	512
+
 struct sr_serial_dev_inst {
 	/** Port name, e.g. '/dev/tty42'. */
 	char *port;
@@ -719,6 +732,14 @@ struct sr_serial_dev_inst {
 	char *serialcomm;
 	/** libserialport port handle */
 	struct sp_port *data;
+	/** Event set to wait for receive data, created on first use. */
+	struct sp_event_set *rcv_events;
+	/** Data read ahead by line based readers, not yet consumed. */
+	uint8_t rcv_buffer[SERIAL_RCV_BUFSIZE];
+	size_t rcv_head, rcv_fill;
+	/** Receive callback of the port's event source, if any. */
+	sr_receive_data_callback rcv_cb;
+	void *rcv_cb_data;
 };
 #endif
 
@@ -734,6 +755,10 @@ struct drv_context {
 	GSList *instances;
 };
 
+/*--- backend.c -------------------------------------------------------------*/
+
+SR_PRIV int sr_libusb_init(struct sr_context *ctx);
+
 /*--- log.c -----------------------------------------------------------------*/
 
 #if defined(G_OS_WIN32) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 4))
@@ -836,6 +861,38 @@ SR_PRIV struct sr_config *sr_config_new(uint32_t key, GVariant *data);
 SR_PRIV void sr_config_free(struct sr_config *src);
 SR_PRIV int sr_dev_acquisition_start(struct sr_dev_inst *sdi);
 SR_PRIV int sr_dev_acquisition_stop(struct sr_dev_inst *sdi);
+SR_PRIV void sr_scan_claim(const char *conn);
+SR_PRIV void sr_scan_release(const char *conn);
+SR_PRIV void sr_scan_instances_add(struct drv_context *drvc, GSList *devices);
+SR_PRIV void sr_scan_adopt_late(struct sr_context *ctx);
+
+/*--- discovery.c -----------------------------------------------------------*/
+
+/** A device found by an earlier scan, as recorded in the discovery cache. */
+struct sr_discovery_entry {
+	/** Name of the driver which found the device. */
+	char *driver;
+	/** SR_CONF_CONN to find the device again with, or NULL. */
+	char *conn;
+	/** SR_CONF_SERIALCOMM to find the device again with, or NULL. */
+	char *serialcomm;
+	/** Connection ID of the device, or NULL. */
+	char *connection_id;
+	/** USB vendor and product ID, if it is a USB device. */
+	uint16_t vid;
+	uint16_t pid;
+	/** Serial number of the device, or NULL. */
+	char *serial_num;
+};
+
+SR_PRIV void sr_discovery_free(struct sr_context *ctx);
+SR_PRIV gboolean sr_discovery_lookup(struct sr_context *ctx,
+		struct sr_dev_driver **drivers, GSList **entries);
+SR_PRIV gboolean sr_discovery_match(struct sr_context *ctx,
+		const struct sr_discovery_entry *entry,
+		const struct sr_dev_inst *sdi);
+SR_PRIV void sr_discovery_store(struct sr_context *ctx,
+		struct sr_dev_driver **drivers, GSList *devices);
 
 /*--- session.c -------------------------------------------------------------*/
 
@@ -869,6 +926,8 @@ struct sr_session {
 	unsigned int stop_check_id;
 	/** Whether the session has been started. */
 	gboolean running;
+	/** Shared event source for serial ports, see serial_reactor_add(). */
+	struct serial_reactor *serial_reactor;
 };
 
 SR_PRIV int sr_session_source_add_internal(struct sr_session *session,
@@ -923,6 +982,17 @@ SR_PRIV int sr_analog_init(struct sr_datafeed_analog *analog,
                            struct sr_analog_spec *spec,
                            int digits);
 
+/*--- conversion.c ----------------------------------------------------------*/
+
+SR_PRIV void sr_conv_fill_samples(uint8_t *dst, const uint8_t *sample,
+		size_t size, size_t count);
+SR_PRIV void sr_conv_deinterleave_u8(const uint8_t *input, uint8_t *even,
+		uint8_t *odd, size_t count);
+SR_PRIV void sr_conv_u8_to_float(const uint8_t *input, float *output,
+		size_t count, float scale, float offset);
+SR_PRIV void sr_conv_s16le_to_float(const uint8_t *input, float *output,
+		size_t count, float scale, float offset);
+
 /*--- std.c -----------------------------------------------------------------*/
 
 typedef int (*dev_close_callback)(struct sr_dev_inst *sdi);
@@ -990,6 +1060,25 @@ SR_PRIV int std_cg_idx(const struct sr_channel_group *cg, struct sr_channel_grou
 
 /*--- resource.c ------------------------------------------------------------*/
 
+/** Size of a resource checksum string (SHA-256 in hex), including the NUL. */
+#define SR_RESOURCE_CHECKSUM_SIZE 65
+
+/** A resource loaded into memory, see sr_resource_image_get(). */
+struct sr_resource_image {
+	/** Resource type (SR_RESOURCE_FIRMWARE, ...) */
+	int type;
+	/** Name of the resource. */
+	char *name;
+	/** Contents of the resource. */
+	uint8_t *data;
+	/** Size of the contents in bytes. */
+	size_t size;
+	/** SHA-256 of the contents, to tell images apart. */
+	char checksum[SR_RESOURCE_CHECKSUM_SIZE];
+	/** References held by the context and by users of the image. */
+	gint refcount;
+};
+
 SR_PRIV int64_t sr_file_get_size(FILE *file);
 
 SR_PRIV int sr_resource_open(struct sr_context *ctx,
@@ -1003,6 +1092,11 @@ SR_PRIV gssize sr_resource_read(struct sr_context *ctx,
 SR_PRIV void *sr_resource_load(struct sr_context *ctx, int type,
 		const char *name, size_t *size, size_t max_size)
 		G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+SR_PRIV struct sr_resource_image *sr_resource_image_get(
+		struct sr_context *ctx, int type, const char *name,
+		size_t max_size);
+SR_PRIV void sr_resource_image_unref(struct sr_resource_image *image);
+SR_PRIV void sr_resource_images_free(struct sr_context *ctx);
 
 /*--- strutil.c -------------------------------------------------------------*/
 
@@ -1012,6 +1106,10 @@ SR_PRIV int sr_atod(const char *str, double *ret);
 SR_PRIV int sr_atof(const char *str, float *ret);
 SR_PRIV int sr_atod_ascii(const char *str, double *ret);
 SR_PRIV int sr_atof_ascii(const char *str, float *ret);
+SR_PRIV int sr_parse_floatv(const char *str, float *values, size_t max,
+		size_t *count);
+SR_PRIV int sr_parse_uint8v(const char *str, uint8_t *values, size_t max,
+		size_t *count);
 
 /*--- soft-trigger.c --------------------------------------------------------*/
 
@@ -1075,6 +1173,9 @@ SR_PRIV int serial_source_add(struct sr_session *session,
 		sr_receive_data_callback cb, void *cb_data);
 SR_PRIV int serial_source_remove(struct sr_session *session,
 		struct sr_serial_dev_inst *serial);
+SR_PRIV int serial_reactor_add(struct sr_session *session,
+		struct sr_serial_dev_inst *serial, int events, int timeout,
+		sr_receive_data_callback cb, void *cb_data);
 SR_PRIV GSList *sr_serial_find_usb(uint16_t vendor_id, uint16_t product_id);
 SR_PRIV int serial_timeout(struct sr_serial_dev_inst *port, int num_bytes);
 #endif
@@ -1098,6 +1199,46 @@ SR_PRIV void sr_usb_close(struct sr_usb_dev_inst *usb);
 SR_PRIV int usb_source_add(struct sr_session *session, struct sr_context *ctx,
 		int timeout, sr_receive_data_callback cb, void *cb_data);
 SR_PRIV int usb_source_remove(struct sr_session *session, struct sr_context *ctx);
+
+/** USB event thread handle, see usb_thread_source_add(). */
+struct sr_usb_thread;
+
+/** A transfer completion, handed from the USB event thread to the session. */
+struct sr_usb_completion {
+	/**
+	 * The transfer, if it was not resubmitted by the event thread.
+	 * The completion callback must then resubmit or free it.
+	 * NULL if the transfer is already back in flight.
+	 */
+	struct libusb_transfer *transfer;
+	/** The received data. Only valid during the completion callback. */
+	unsigned char *buffer;
+	/** Number of bytes received. */
+	int length;
+	/** Status of the transfer. */
+	enum libusb_transfer_status status;
+	/** The transfer's user data. */
+	void *user_data;
+};
+
+typedef void (*sr_usb_completion_callback)(
+		const struct sr_usb_completion *completion, void *cb_data);
+
+SR_PRIV int usb_thread_source_add(struct sr_session *session,
+		struct sr_context *ctx, unsigned int num_transfers,
+		struct libusb_device_handle *devhdl, size_t buffer_size,
+		unsigned int num_spare, gboolean realtime,
+		sr_usb_completion_callback cb, void *cb_data,
+		struct sr_usb_thread **uthread);
+SR_PRIV void usb_thread_transfer_done(struct sr_usb_thread *uthread,
+		struct libusb_transfer *transfer);
+SR_PRIV void usb_thread_abort(struct sr_usb_thread *uthread);
+SR_PRIV unsigned char *usb_thread_buffer_alloc(struct sr_usb_thread *uthread);
+SR_PRIV void usb_thread_buffer_free(struct sr_usb_thread *uthread,
+		unsigned char *buffer);
+SR_PRIV void usb_thread_set_transfer_length(struct sr_usb_thread *uthread,
+		size_t length);
+SR_PRIV unsigned int usb_thread_get_overruns(struct sr_usb_thread *uthread);
 SR_PRIV int usb_get_port_path(libusb_device *dev, char *path, int path_len);
 SR_PRIV gboolean usb_match_manuf_prod(libusb_device *dev,
 		const char *manufacturer, const char *product);
@@ -1106,6 +1247,8 @@ SR_PRIV gboolean usb_match_manuf_prod(libusb_device *dev,
 
 /*--- modbus/modbus.c -------------------------------------------------------*/
 
+struct modbus_cache;
+
 struct sr_modbus_dev_inst {
 	const char *name;
 	const char *prefix;
@@ -1124,7 +1267,38 @@ struct sr_modbus_dev_inst {
 	int (*close)(void *priv);
 	void (*free)(void *priv);
 	unsigned int read_timeout_ms;
+	/* Number of requests which may be outstanding, see sr_modbus_read_multi(). */
+	unsigned int max_outstanding;
+	/* Reply bytes of unrequested values worth saving a separate request. */
+	unsigned int merge_gap;
 	void *priv;
+	/* Cached coil and register values. */
+	struct modbus_cache *cache;
+};
+
+/*
+ * Time to live for cached holding registers and coils. Another master on
+ * the bus, or the device's own keypad, may write them behind our back.
+ */
+#define MODBUS_CACHE_TTL_DEFAULT_US (5 * 1000 * 1000)
+
+enum sr_modbus_table {
+	SR_MODBUS_COILS,
+	SR_MODBUS_HOLDING_REGISTERS,
+};
+
+/* One range of coils or registers to read, see sr_modbus_read_multi(). */
+struct sr_modbus_read {
+	enum sr_modbus_table table;
+	int address;
+	int count;
+	/* Receives the values, as sr_modbus_read_coils() or
+	 * sr_modbus_read_holding_registers() would store them. */
+	void *data;
+	/* Time to live of cached values in us, 0 to not cache, -1 for no limit. */
+	int64_t ttl_us;
+	/* Result of this read. */
+	int ret;
 };
 
 SR_PRIV GSList *sr_modbus_scan(struct drv_context *drvc, GSList *options,
@@ -1157,6 +1331,13 @@ SR_PRIV int sr_modbus_write_multiple_registers(struct sr_modbus_dev_inst*modbus,
 SR_PRIV int sr_modbus_close(struct sr_modbus_dev_inst *modbus);
 SR_PRIV void sr_modbus_free(struct sr_modbus_dev_inst *modbus);
 
+/*--- modbus/batch.c --------------------------------------------------------*/
+
+SR_PRIV int sr_modbus_read_multi(struct sr_modbus_dev_inst *modbus,
+		struct sr_modbus_read *reads, unsigned int num_reads);
+SR_PRIV void sr_modbus_cache_invalidate(struct sr_modbus_dev_inst *modbus);
+SR_PRIV void modbus_cache_free(struct sr_modbus_dev_inst *modbus);
+
 /*--- hardware/dmm/es519xx.c ------------------------------------------------*/
 
 /**
@@ -0,0 +1,373 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Batched reads of coils and holding registers.
+ *
+ * Each Modbus transaction costs a request, a reply header and checksum,
+ * and the device's turnaround time, which on a serial line at 9600 baud
+ * is worth dozens of register values. sr_modbus_read_multi() therefore
+ * sorts the reads a driver needs, merges reads of adjacent (or nearly
+ * adjacent, see merge_gap) addresses into a single request, and keeps up
+ * to max_outstanding requests in flight on transports that can match
+ * replies to requests.
+ *
+ * Values of rarely changing registers, like settings, can be served from
+ * a cache for a given time. Any request which isn't a read drops all
+ * cached values, since writes commonly affect other registers as well.
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+#define LOG_PREFIX "modbus"
+
+#define MAX_REGISTERS	125
+#define MAX_COILS	2000
+
+struct modbus_cache {
+	GHashTable *entries;
+};
+
+struct modbus_cache_entry {
+	uint16_t value;
+	/* Monotonic time after which the entry is stale, or -1. */
+	int64_t expires;
+};
+
+/* A single request, covering one or more reads. */
+struct modbus_span {
+	enum sr_modbus_table table;
+	int start;
+	int end;
+	/* Raw register values or packed coil bits, as received. */
+	uint8_t data[2 * MAX_REGISTERS];
+	unsigned int num_reads;
+	int ret;
+};
+
+#define CACHE_KEY(table, address) \
+	GUINT_TO_POINTER(((unsigned int)(table) << 16) | (address))
+
+SR_PRIV void modbus_cache_free(struct sr_modbus_dev_inst *modbus)
+{
+	if (!modbus->cache)
+		return;
+
+	g_hash_table_destroy(modbus->cache->entries);
+	g_free(modbus->cache);
+	modbus->cache = NULL;
+}
+
+/**
+ * Drop all cached coil and register values.
+ *
+ * @param modbus Previously initialized Modbus device structure.
+ */
+SR_PRIV void sr_modbus_cache_invalidate(struct sr_modbus_dev_inst *modbus)
+{
+	if (!modbus->cache || !g_hash_table_size(modbus->cache->entries))
+		return;
+
+	sr_spew("Dropping %u cached values.",
+		g_hash_table_size(modbus->cache->entries));
+	g_hash_table_remove_all(modbus->cache->entries);
+}
+
+static int read_size(enum sr_modbus_table table, int count)
+{
+	return table == SR_MODBUS_COILS ? (count + 7) / 8 : 2 * count;
+}
+
+/* Serve a read from the cache, if all of its values are fresh. */
+static gboolean cache_lookup(struct sr_modbus_dev_inst *modbus,
+		struct sr_modbus_read *read, int64_t now)
+{
+	struct modbus_cache_entry *entry;
+	uint8_t *data;
+	int i;
+
+	if (!modbus->cache || !read->ttl_us)
+		return FALSE;
+
+	for (i = 0; i < read->count; i++) {
+		entry = g_hash_table_lookup(modbus->cache->entries,
+			CACHE_KEY(read->table, read->address + i));
+		if (!entry || (entry->expires >= 0 && now > entry->expires))
+			return FALSE;
+	}
+
+	data = read->data;
+	if (read->table == SR_MODBUS_COILS)
+		memset(data, 0, read_size(read->table, read->count));
+	for (i = 0; i < read->count; i++) {
+		entry = g_hash_table_lookup(modbus->cache->entries,
+			CACHE_KEY(read->table, read->address + i));
+		if (read->table == SR_MODBUS_COILS)
+			data[i / 8] |= (entry->value & 1) << (i % 8);
+		else
+			memcpy(data + 2 * i, &entry->value, 2);
+	}
+
+	return TRUE;
+}
+
+static void cache_store(struct sr_modbus_dev_inst *modbus,
+		const struct sr_modbus_read *read, int64_t now)
+{
+	struct modbus_cache_entry *entry;
+	const uint8_t *data;
+	int i;
+
+	if (!read->ttl_us)
+		return;
+
+	if (!modbus->cache) {
+		modbus->cache = g_malloc0(sizeof(*modbus->cache));
+		modbus->cache->entries = g_hash_table_new_full(g_direct_hash,
+			g_direct_equal, NULL, g_free);
+	}
+
+	data = read->data;
+	for (i = 0; i < read->count; i++) {
+		entry = g_malloc(sizeof(*entry));
+		if (read->table == SR_MODBUS_COILS)
+			entry->value = (data[i / 8] >> (i % 8)) & 1;
+		else
+			memcpy(&entry->value, data + 2 * i, 2);
+		entry->expires = read->ttl_us < 0 ? -1 : now + read->ttl_us;
+		g_hash_table_replace(modbus->cache->entries,
+			CACHE_KEY(read->table, read->address + i), entry);
+	}
+}
+
+static int compare_reads(const void *a, const void *b)
+{
+	const struct sr_modbus_read *ra, *rb;
+
+	ra = *(struct sr_modbus_read * const *)a;
+	rb = *(struct sr_modbus_read * const *)b;
+
+	if (ra->table != rb->table)
+		return ra->table - rb->table;
+
+	return ra->address - rb->address;
+}
+
+/* Whether read can join span without exceeding the limits. */
+static gboolean span_accepts(const struct sr_modbus_dev_inst *modbus,
+		const struct modbus_span *span, const struct sr_modbus_read *read)
+{
+	int end, gap;
+
+	if (read->table != span->table)
+		return FALSE;
+
+	end = MAX(span->end, read->address + read->count);
+	if (end - span->start > (span->table == SR_MODBUS_COILS ?
+			MAX_COILS : MAX_REGISTERS))
+		return FALSE;
+
+	/* Unrequested values in between cost reply bytes. */
+	gap = MAX(read->address - span->end, 0);
+	if (!gap)
+		return TRUE;
+
+	return (unsigned int)(read_size(span->table, span->end - span->start + gap)
+		- read_size(span->table, span->end - span->start)) <= modbus->merge_gap;
+}
+
+static int span_send(struct sr_modbus_dev_inst *modbus,
+		struct modbus_span *span)
+{
+	if (span->table == SR_MODBUS_COILS)
+		return sr_modbus_read_coils(modbus, span->start,
+			span->end - span->start, NULL);
+
+	return sr_modbus_read_holding_registers(modbus, span->start,
+		span->end - span->start, NULL);
+}
+
+static int span_receive(struct sr_modbus_dev_inst *modbus,
+		struct modbus_span *span)
+{
+	if (span->table == SR_MODBUS_COILS)
+		return sr_modbus_read_coils(modbus, -1,
+			span->end - span->start, span->data);
+
+	return sr_modbus_read_holding_registers(modbus, -1,
+		span->end - span->start, (uint16_t *)span->data);
+}
+
+/* Copy the values of a read out of the span which covered it. */
+static void span_extract(const struct modbus_span *span,
+		struct sr_modbus_read *read)
+{
+	uint8_t *data;
+	int i, bit;
+
+	data = read->data;
+	if (span->table != SR_MODBUS_COILS) {
+		memcpy(data, span->data + 2 * (read->address - span->start),
+			2 * read->count);
+		return;
+	}
+
+	memset(data, 0, read_size(read->table, read->count));
+	for (i = 0; i < read->count; i++) {
+		bit = read->address - span->start + i;
+		data[i / 8] |= ((span->data[bit / 8] >> (bit % 8)) & 1) << (i % 8);
+	}
+}
+
+/* Issue the requests of all spans, with up to depth of them outstanding. */
+static void spans_transfer(struct sr_modbus_dev_inst *modbus,
+		struct modbus_span *spans, unsigned int num_spans)
+{
+	unsigned int sent, received, depth;
+	int ret;
+
+	depth = MAX(modbus->max_outstanding, 1);
+	sent = received = 0;
+	while (received < num_spans) {
+		while (sent < num_spans && sent - received < depth) {
+			if ((ret = span_send(modbus, &spans[sent])) != SR_OK) {
+				/* Collect what is in flight, give up on the rest. */
+				for (; num_spans > sent; num_spans--)
+					spans[num_spans - 1].ret = ret;
+				break;
+			}
+			sent++;
+		}
+		if (received == sent)
+			break;
+		spans[received].ret = span_receive(modbus, &spans[received]);
+		if (spans[received].ret != SR_OK
+				&& spans[received].ret != SR_ERR_DATA
+				&& received + 1 < sent) {
+			/* Replies of later requests can't be matched anymore. */
+			sr_err("Lost track of outstanding Modbus requests.");
+			for (received++; received < num_spans; received++)
+				spans[received].ret = SR_ERR;
+			break;
+		}
+		received++;
+	}
+}
+
+/**
+ * Read several ranges of coils and holding registers.
+ *
+ * Reads are served from the cache if possible, otherwise reads of the same
+ * table at adjacent addresses are merged into a single request, subject to
+ * the device's merge_gap. Requests are pipelined up to max_outstanding.
+ * A merged request which the device rejects is retried as individual reads,
+ * in case the device doesn't implement some address in between.
+ *
+ * @param modbus Previously initialized Modbus device structure.
+ * @param reads Array of reads, the result of each read is stored in its ret
+ *              field.
+ * @param num_reads Number of entries in reads.
+ *
+ * @return SR_OK if all reads succeeded, otherwise the error of the first
+ *         read which failed.
+ */
+SR_PRIV int sr_modbus_read_multi(struct sr_modbus_dev_inst *modbus,
+		struct sr_modbus_read *reads, unsigned int num_reads)
+{
+	struct sr_modbus_read **pending;
+	struct modbus_span *spans;
+	unsigned int i, num_pending, num_spans, *span_of;
+	int64_t now;
+	int ret;
+
+	now = g_get_monotonic_time();
+	pending = g_malloc(num_reads * sizeof(*pending));
+	num_pending = 0;
+	for (i = 0; i < num_reads; i++) {
+		if (reads[i].address < 0 || reads[i].count < 1
+				|| reads[i].address + reads[i].count > 0x10000
+				|| reads[i].count > (reads[i].table == SR_MODBUS_COILS ?
+					MAX_COILS : MAX_REGISTERS)) {
+			reads[i].ret = SR_ERR_ARG;
+			continue;
+		}
+		reads[i].ret = SR_OK;
+		if (!cache_lookup(modbus, &reads[i], now))
+			pending[num_pending++] = &reads[i];
+	}
+
+	qsort(pending, num_pending, sizeof(*pending), compare_reads);
+
+	spans = g_malloc(num_pending * sizeof(*spans));
+	span_of = g_malloc(num_pending * sizeof(*span_of));
+	num_spans = 0;
+	for (i = 0; i < num_pending; i++) {
+		if (!num_spans || !span_accepts(modbus, &spans[num_spans - 1],
+				pending[i])) {
+			spans[num_spans].table = pending[i]->table;
+			spans[num_spans].start = pending[i]->address;
+			spans[num_spans].end = pending[i]->address;
+			spans[num_spans].num_reads = 0;
+			num_spans++;
+		}
+		spans[num_spans - 1].end = MAX(spans[num_spans - 1].end,
+			pending[i]->address + pending[i]->count);
+		spans[num_spans - 1].num_reads++;
+		span_of[i] = num_spans - 1;
+	}
+
+	if (num_spans)
+		sr_spew("Reading %u ranges with %u requests.", num_pending,
+			num_spans);
+	spans_transfer(modbus, spans, num_spans);
+
+	now = g_get_monotonic_time();
+	for (i = 0; i < num_pending; i++) {
+		ret = spans[span_of[i]].ret;
+		if (ret == SR_ERR_DATA && spans[span_of[i]].num_reads > 1) {
+			/* Maybe the gap wasn't readable, try on its own. */
+			ret = pending[i]->table == SR_MODBUS_COILS ?
+				sr_modbus_read_coils(modbus, pending[i]->address,
+					pending[i]->count, pending[i]->data) :
+				sr_modbus_read_holding_registers(modbus,
+					pending[i]->address, pending[i]->count,
+					pending[i]->data);
+		} else if (ret == SR_OK) {
+			span_extract(&spans[span_of[i]], pending[i]);
+		}
+		pending[i]->ret = ret;
+		if (ret == SR_OK)
+			cache_store(modbus, pending[i], now);
+	}
+
+	g_free(span_of);
+	g_free(spans);
+	g_free(pending);
+
+	for (i = 0; i < num_reads; i++)
+		if (reads[i].ret != SR_OK)
+			return reads[i].ret;
+
+	return SR_OK;
+}
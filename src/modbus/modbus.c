@@ -125,7 +125,7 @@ SR_PRIV GSList *sr_modbus_scan(struct drv_context *drvc, GSList *options,
 
 	/* Tack a copy of the newly found devices onto the driver list. */
 	if (devices)
-		drvc->instances = g_slist_concat(drvc->instances, g_slist_copy(devices));
+		sr_scan_instances_add(drvc, devices);
 
 	return devices;
 }
@@ -216,6 +216,14 @@ SR_PRIV int sr_modbus_source_remove(struct sr_session *session,
 	return modbus->source_remove(session, modbus->priv);
 }
 
+enum {
+	MODBUS_READ_COILS = 0x01,
+	MODBUS_READ_HOLDING_REGISTERS = 0x03,
+	MODBUS_READ_INPUT_REGISTERS = 0x04,
+	MODBUS_WRITE_COIL = 0x05,
+	MODBUS_WRITE_MULTIPLE_REGISTERS = 0x10,
+};
+
 /**
  * Send a Modbus command.
  *
@@ -232,6 +240,10 @@ SR_PRIV int sr_modbus_request(struct sr_modbus_dev_inst *modbus,
 	if (!request || request_size < 1)
 		return SR_ERR_ARG;
 
+	/* Anything but a read may change values in the cache. */
+	if (request[0] > MODBUS_READ_INPUT_REGISTERS)
+		sr_modbus_cache_invalidate(modbus);
+
 	return modbus->send(modbus->priv, request, request_size);
 }
 
@@ -312,13 +324,6 @@ SR_PRIV int sr_modbus_request_reply(struct sr_modbus_dev_inst *modbus,
 	return sr_modbus_reply(modbus, reply, reply_size);
 }
 
-enum {
-	MODBUS_READ_COILS = 0x01,
-	MODBUS_READ_HOLDING_REGISTERS = 0x03,
-	MODBUS_WRITE_COIL = 0x05,
-	MODBUS_WRITE_MULTIPLE_REGISTERS = 0x10,
-};
-
 static int sr_modbus_error_check(const uint8_t *reply)
 {
 	const char *function = "UNKNOWN";
@@ -572,6 +577,7 @@ SR_PRIV int sr_modbus_close(struct sr_modbus_dev_inst *modbus)
  */
 SR_PRIV void sr_modbus_free(struct sr_modbus_dev_inst *modbus)
 {
+	modbus_cache_free(modbus);
 	modbus->free(modbus->priv);
 	g_free(modbus->priv);
 	g_free(modbus);
@@ -27,6 +27,7 @@
 #define LOG_PREFIX "modbus_serial"
 
 #define BUFFER_SIZE 1024
+#define MAX_PDU_SIZE 253
 
 struct modbus_serial_rtu {
 	struct sr_serial_dev_inst *serial;
@@ -106,21 +107,19 @@ static int modbus_serial_rtu_send(void *priv,
 	int result;
 	struct modbus_serial_rtu *modbus = priv;
 	struct sr_serial_dev_inst *serial = modbus->serial;
-	uint8_t slave_addr = modbus->slave_addr;
+	uint8_t frame[1 + MAX_PDU_SIZE + 2];
 	uint16_t crc;
 
-	result = serial_write_blocking(serial, &slave_addr, sizeof(slave_addr), 0);
-	if (result < 0)
-		return result;
-
-	result = serial_write_blocking(serial, buffer, buffer_size, 0);
-	if (result < 0)
-		return result;
+	if (buffer_size > MAX_PDU_SIZE)
+		return SR_ERR_ARG;
 
-	crc = modbus_serial_rtu_crc(0xFFFF, &slave_addr, sizeof(slave_addr));
-	crc = modbus_serial_rtu_crc(crc, buffer, buffer_size);
+	/* Send the frame in one go, gaps would end it prematurely. */
+	frame[0] = modbus->slave_addr;
+	memcpy(frame + 1, buffer, buffer_size);
+	crc = modbus_serial_rtu_crc(0xFFFF, frame, 1 + buffer_size);
+	memcpy(frame + 1 + buffer_size, &crc, sizeof(crc));
 
-	result = serial_write_blocking(serial, &crc, sizeof(crc), 0);
+	result = serial_write_blocking(serial, frame, 1 + buffer_size + 2, 0);
 	if (result < 0)
 		return result;
 
@@ -206,4 +205,6 @@ SR_PRIV const struct sr_modbus_dev_inst modbus_serial_rtu_dev = {
 	.read_end      = modbus_serial_rtu_read_end,
 	.close         = modbus_serial_rtu_close,
 	.free          = modbus_serial_rtu_free,
+	/* The line is shared, a slave only answers the current request. */
+	.max_outstanding = 1,
 };
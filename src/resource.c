@@ -20,6 +20,7 @@
 #include <config.h>
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <libsigrok/libsigrok.h>
@@ -245,6 +246,8 @@ SR_API int sr_resource_set_hooks(struct sr_context *ctx,
 		sr_err("%s: inconsistent callback pointers.", __func__);
 		return SR_ERR_ARG;
 	}
+	/* Cached images may not be what the new hooks provide. */
+	sr_resource_images_free(ctx);
 	return SR_OK;
 }
 
@@ -332,23 +335,34 @@ SR_PRIV gssize sr_resource_read(struct sr_context *ctx,
 }
 
 /**
- * Load a resource into memory.
+ * Release a reference to an image returned by sr_resource_image_get().
  *
- * @param ctx libsigrok context. Must not be NULL.
- * @param type Resource type ID.
- * @param name Name of the resource. Must not be NULL.
- * @param[out] size Size in bytes of the returned buffer. Must not be NULL.
- * @param max_size Size limit. Error out if the resource is larger than this.
- *
- * @return A buffer containing the resource data, or NULL on failure. Must
- *         be freed by the caller using g_free().
+ * @param image The image. Must not be NULL.
  *
  * @private
  */
-SR_PRIV void *sr_resource_load(struct sr_context *ctx,
-		int type, const char *name, size_t *size, size_t max_size)
+SR_PRIV void sr_resource_image_unref(struct sr_resource_image *image)
+{
+	if (!g_atomic_int_dec_and_test(&image->refcount))
+		return;
+
+	g_free(image->name);
+	g_free(image->data);
+	g_free(image);
+}
+
+static void image_free(void *data)
+{
+	sr_resource_image_unref(data);
+}
+
+/* Read a whole resource into a new image. */
+static struct sr_resource_image *image_load(struct sr_context *ctx,
+		int type, const char *name, size_t max_size)
 {
 	struct sr_resource res;
+	struct sr_resource_image *image;
+	char *checksum;
 	void *buf;
 	size_t res_size;
 	gssize n_read;
@@ -382,7 +396,123 @@ SR_PRIV void *sr_resource_load(struct sr_context *ctx,
 		return NULL;
 	}
 
-	*size = res_size;
+	image = g_malloc0(sizeof(*image));
+	image->refcount = 1;
+	image->type = type;
+	image->name = g_strdup(name);
+	image->data = buf;
+	image->size = res_size;
+	checksum = g_compute_checksum_for_data(G_CHECKSUM_SHA256,
+		buf, res_size);
+	g_strlcpy(image->checksum, checksum, sizeof(image->checksum));
+	g_free(checksum);
+
+	return image;
+}
+
+/**
+ * Get the contents of a resource, loading it only once per context.
+ *
+ * Images are kept in memory until the context is shut down, or until
+ * the resource hooks are changed. This saves reading firmware files
+ * again each time a device is opened.
+ *
+ * @param ctx libsigrok context. Must not be NULL.
+ * @param type Resource type ID.
+ * @param name Name of the resource. Must not be NULL.
+ * @param max_size Size limit. Larger resources are not loaded.
+ *
+ * @return A reference to the image, or NULL on failure. Release it with
+ *         sr_resource_image_unref() once done. The image stays valid
+ *         until then, even if the context drops its images.
+ *
+ * @private
+ */
+SR_PRIV struct sr_resource_image *sr_resource_image_get(
+		struct sr_context *ctx, int type, const char *name,
+		size_t max_size)
+{
+	struct sr_resource_image *image;
+	char *key;
+
+	key = g_strdup_printf("%d/%s", type, name);
+
+	g_mutex_lock(&ctx->resource_mutex);
+	if (!ctx->resource_images)
+		ctx->resource_images = g_hash_table_new_full(g_str_hash,
+			g_str_equal, g_free, image_free);
+	image = g_hash_table_lookup(ctx->resource_images, key);
+	if (image) {
+		sr_dbg("Using cached '%s' (%s).", name, image->checksum);
+		g_free(key);
+	} else if ((image = image_load(ctx, type, name, max_size))) {
+		g_hash_table_insert(ctx->resource_images, key, image);
+	} else {
+		g_free(key);
+	}
+	if (image)
+		g_atomic_int_inc(&image->refcount);
+	g_mutex_unlock(&ctx->resource_mutex);
+
+	if (image && image->size > max_size) {
+		sr_err("Size %zu of '%s' exceeds limit %zu.",
+			image->size, name, max_size);
+		sr_resource_image_unref(image);
+		return NULL;
+	}
+
+	return image;
+}
+
+/**
+ * Drop all images kept by sr_resource_image_get().
+ *
+ * @private
+ */
+SR_PRIV void sr_resource_images_free(struct sr_context *ctx)
+{
+	g_mutex_lock(&ctx->resource_mutex);
+	if (ctx->resource_images)
+		g_hash_table_destroy(ctx->resource_images);
+	ctx->resource_images = NULL;
+	g_mutex_unlock(&ctx->resource_mutex);
+}
+
+/**
+ * Load a resource into memory.
+ *
+ * The data is a copy of the image kept by sr_resource_image_get().
+ *
+ * @param ctx libsigrok context. Must not be NULL.
+ * @param type Resource type ID.
+ * @param name Name of the resource. Must not be NULL.
+ * @param[out] size Size in bytes of the returned buffer. Must not be NULL.
+ * @param max_size Size limit. Error out if the resource is larger than this.
+ *
+ * @return A buffer containing the resource data, or NULL on failure. Must
+ *         be freed by the caller using g_free().
+ *
+ * @private
+ */
+SR_PRIV void *sr_resource_load(struct sr_context *ctx,
+		int type, const char *name, size_t *size, size_t max_size)
+{
+	struct sr_resource_image *image;
+	void *buf;
+
+	if (!(image = sr_resource_image_get(ctx, type, name, max_size)))
+		return NULL;
+
+	buf = g_try_malloc(image->size);
+	if (!buf) {
+		sr_err("Failed to allocate buffer for '%s'.", name);
+		sr_resource_image_unref(image);
+		return NULL;
+	}
+	memcpy(buf, image->data, image->size);
+
+	*size = image->size;
+	sr_resource_image_unref(image);
 	return buf;
 }
 
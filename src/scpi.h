@@ -70,6 +70,13 @@ struct scpi_command {
 	const char *string;
 };
 
+/*
+ * Receives len bytes of a definite length block, with remaining more bytes
+ * to follow. Returns the number of bytes consumed, or SR_ERR*.
+ */
+typedef int (*sr_scpi_block_callback)(const uint8_t *data, size_t len,
+		size_t remaining, void *cb_data);
+
 struct sr_scpi_hw_info {
 	char *manufacturer;
 	char *model;
@@ -77,6 +84,21 @@ struct sr_scpi_hw_info {
 	char *firmware_version;
 };
 
+/* Time without data after which no more stale responses are expected. */
+#define SCPI_DRAIN_QUIET_US (50 * 1000)
+
+/* Time to live for cached settings, bounds how long front panel changes go unnoticed. */
+#define SCPI_CACHE_TTL_DEFAULT_US (5 * 1000 * 1000)
+
+struct sr_scpi_cache_rule {
+	/* Start of the commands this rule applies to. */
+	const char *prefix;
+	/* Time to live of responses in us, 0 to not cache, -1 for no limit. */
+	int64_t ttl_us;
+};
+
+struct scpi_cache;
+
 struct sr_scpi_dev_inst {
 	const char *name;
 	const char *prefix;
@@ -93,12 +115,18 @@ struct sr_scpi_dev_inst {
 	int (*read_data)(void *priv, char *buf, int maxlen);
 	int (*write_data)(void *priv, char *buf, int len);
 	int (*read_complete)(void *priv);
+	/* Discard received data which wasn't read, optional. */
+	void (*drain)(void *priv);
 	int (*close)(struct sr_scpi_dev_inst *scpi);
 	void (*free)(void *priv);
 	unsigned int read_timeout_us;
+	/* Responses are framed, several queries may be outstanding. */
+	gboolean pipelining;
 	void *priv;
 	/* Only used for quirk workarounds, notably the Rigol DS1000 series. */
 	uint64_t firmware_version;
+	/* Query response cache, see sr_scpi_cache_enable(). */
+	struct scpi_cache *cache;
 };
 
 SR_PRIV GSList *sr_scpi_scan(struct drv_context *drvc, GSList *options,
@@ -126,6 +154,12 @@ SR_PRIV int sr_scpi_read_response(struct sr_scpi_dev_inst *scpi,
 			GString *response, gint64 abs_timeout_us);
 SR_PRIV int sr_scpi_get_string(struct sr_scpi_dev_inst *scpi,
 			const char *command, char **scpi_response);
+SR_PRIV int sr_scpi_get_strings_pipelined(struct sr_scpi_dev_inst *scpi,
+			const char **commands, unsigned int num_commands,
+			char **scpi_responses);
+SR_PRIV int sr_scpi_get_strings(struct sr_scpi_dev_inst *scpi,
+			const char **commands, unsigned int num_commands,
+			char **scpi_responses);
 SR_PRIV int sr_scpi_get_bool(struct sr_scpi_dev_inst *scpi,
 			const char *command, gboolean *scpi_response);
 SR_PRIV int sr_scpi_get_int(struct sr_scpi_dev_inst *scpi,
@@ -143,6 +177,23 @@ SR_PRIV int sr_scpi_get_data(struct sr_scpi_dev_inst *scpi,
 			const char *command, GString **scpi_response);
 SR_PRIV int sr_scpi_get_block(struct sr_scpi_dev_inst *scpi,
 			const char *command, GByteArray **scpi_response);
+SR_PRIV int sr_scpi_get_block_buf(struct sr_scpi_dev_inst *scpi,
+			const char *command, GByteArray *data);
+SR_PRIV int sr_scpi_get_block_cb(struct sr_scpi_dev_inst *scpi,
+			const char *command, uint8_t *buf, size_t bufsize,
+			sr_scpi_block_callback cb, void *cb_data);
+SR_PRIV void sr_scpi_cache_enable(struct sr_scpi_dev_inst *scpi,
+		int64_t ttl_us, const struct sr_scpi_cache_rule *rules,
+		gboolean check_esr);
+SR_PRIV void sr_scpi_cache_invalidate(struct sr_scpi_dev_inst *scpi);
+SR_PRIV void scpi_cache_free(struct sr_scpi_dev_inst *scpi);
+SR_PRIV void scpi_cache_reopened(struct sr_scpi_dev_inst *scpi);
+SR_PRIV void scpi_cache_sent(struct sr_scpi_dev_inst *scpi,
+		const char *message);
+SR_PRIV char *scpi_cache_lookup(struct sr_scpi_dev_inst *scpi,
+		const char *command);
+SR_PRIV void scpi_cache_store(struct sr_scpi_dev_inst *scpi,
+		const char *command, const char *response);
 SR_PRIV int sr_scpi_get_hw_id(struct sr_scpi_dev_inst *scpi,
 			struct sr_scpi_hw_info **scpi_response);
 SR_PRIV void sr_scpi_hw_info_free(struct sr_scpi_hw_info *hw_info);
@@ -154,5 +205,9 @@ SR_PRIV int scpi_cmd(const struct sr_dev_inst *sdi,
 SR_PRIV int scpi_cmd_resp(const struct sr_dev_inst *sdi,
 		const struct scpi_command *cmdtable,
 		GVariant **gvar, const GVariantType *gvtype, int command, ...);
+SR_PRIV int scpi_cmd_resp_multi(const struct sr_dev_inst *sdi,
+		const struct scpi_command *cmdtable, GVariant **gvars,
+		const GVariantType **gvtypes, const int *commands,
+		unsigned int num_commands);
 
 #endif
@@ -0,0 +1,267 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Cache of query responses, keyed by the query's command string.
+ *
+ * Instrument settings rarely change unless we change them, so responses
+ * to setting queries can be served from memory instead of costing a round
+ * trip to the device. Entries are dropped:
+ *  - after a per-command time to live,
+ *  - whenever a message which isn't a pure query is sent (settings, *RST,
+ *    *RCL, ...), since any setting can affect others,
+ *  - when the standard event status register reports a user request
+ *    (front panel activity) or power on. Whenever the driver reads it,
+ *    the response is checked. Drivers which don't read it themselves can
+ *    have it polled before serving a cached response, at most every
+ *    SCPI_CACHE_ESR_INTERVAL_US.
+ *
+ * Common commands ('*' prefix) are never cached.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "scpi.h"
+
+#define LOG_PREFIX "scpi/cache"
+
+#define SCPI_CACHE_ESR_INTERVAL_US (250 * 1000)
+
+/* Standard event status register bits. */
+#define SCPI_ESR_URQ (1 << 6)
+#define SCPI_ESR_PON (1 << 7)
+
+struct scpi_cache {
+	GHashTable *entries;
+	int64_t ttl_us;
+	const struct sr_scpi_cache_rule *rules;
+	gboolean check_esr;
+	int64_t esr_checked;
+};
+
+struct scpi_cache_entry {
+	char *response;
+	/* Monotonic time after which the entry is stale, or -1. */
+	int64_t expires;
+};
+
+static void cache_entry_free(void *data)
+{
+	struct scpi_cache_entry *entry;
+
+	entry = data;
+	g_free(entry->response);
+	g_free(entry);
+}
+
+/* Time to live of responses to a command, 0 if not to be cached. */
+static int64_t cache_ttl(const struct scpi_cache *cache, const char *command)
+{
+	const struct sr_scpi_cache_rule *rule;
+	size_t len;
+
+	if (command[0] == '*')
+		return 0;
+
+	for (rule = cache->rules; rule && rule->prefix; rule++) {
+		len = strlen(rule->prefix);
+		if (!g_ascii_strncasecmp(command, rule->prefix, len))
+			return rule->ttl_us;
+	}
+
+	return cache->ttl_us;
+}
+
+/* Check whether all message units of a program message are queries. */
+static gboolean is_query(const char *message)
+{
+	const char *p;
+	gboolean query;
+
+	query = FALSE;
+	for (p = message; *p; p++) {
+		if (*p == '?') {
+			query = TRUE;
+		} else if (*p == ';') {
+			if (!query)
+				return FALSE;
+			query = FALSE;
+		} else if (*p == ' ' && !query) {
+			/* Header ended without a '?', this sets something. */
+			return FALSE;
+		}
+	}
+
+	return query;
+}
+
+/**
+ * Enable caching of query responses.
+ *
+ * @param scpi Previously initialised SCPI device structure.
+ * @param ttl_us Default time to live of responses in microseconds, or
+ *        -1 to keep them until invalidated.
+ * @param rules Optional array of rules, terminated by an entry with a NULL
+ *        prefix. The first rule whose prefix matches the start of a query
+ *        overrides the default time to live. A time to live of 0 excludes
+ *        matching queries from caching, e.g. status polls.
+ * @param check_esr Whether to poll the standard event status register for
+ *        front panel activity before serving cached responses. Reading
+ *        the register clears it, so drivers which evaluate any of its
+ *        bits themselves must not enable this.
+ */
+SR_PRIV void sr_scpi_cache_enable(struct sr_scpi_dev_inst *scpi,
+		int64_t ttl_us, const struct sr_scpi_cache_rule *rules,
+		gboolean check_esr)
+{
+	struct scpi_cache *cache;
+
+	if (!scpi->cache) {
+		cache = g_malloc0(sizeof(*cache));
+		cache->entries = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, cache_entry_free);
+		scpi->cache = cache;
+	}
+
+	cache = scpi->cache;
+	cache->ttl_us = ttl_us;
+	cache->rules = rules;
+	cache->check_esr = check_esr;
+	cache->esr_checked = 0;
+	g_hash_table_remove_all(cache->entries);
+}
+
+/**
+ * Drop all cached responses.
+ *
+ * @param scpi Previously initialised SCPI device structure.
+ */
+SR_PRIV void sr_scpi_cache_invalidate(struct sr_scpi_dev_inst *scpi)
+{
+	struct scpi_cache *cache;
+
+	if (!(cache = scpi->cache))
+		return;
+
+	if (g_hash_table_size(cache->entries))
+		sr_spew("Dropping %u cached responses.",
+			g_hash_table_size(cache->entries));
+	g_hash_table_remove_all(cache->entries);
+}
+
+SR_PRIV void scpi_cache_free(struct sr_scpi_dev_inst *scpi)
+{
+	struct scpi_cache *cache;
+
+	if (!(cache = scpi->cache))
+		return;
+
+	g_hash_table_destroy(cache->entries);
+	g_free(cache);
+	scpi->cache = NULL;
+}
+
+/* Force a status check before the next cached response is served. */
+SR_PRIV void scpi_cache_reopened(struct sr_scpi_dev_inst *scpi)
+{
+	if (scpi->cache)
+		scpi->cache->esr_checked = 0;
+}
+
+/* Account for a message sent to the device. */
+SR_PRIV void scpi_cache_sent(struct sr_scpi_dev_inst *scpi,
+		const char *message)
+{
+	if (!scpi->cache || is_query(message))
+		return;
+
+	sr_scpi_cache_invalidate(scpi);
+}
+
+/* Return a copy of the cached response to command, or NULL. */
+SR_PRIV char *scpi_cache_lookup(struct sr_scpi_dev_inst *scpi,
+		const char *command)
+{
+	struct scpi_cache *cache;
+	struct scpi_cache_entry *entry;
+	int64_t now;
+	char *response;
+
+	cache = scpi->cache;
+	if (!cache || !cache_ttl(cache, command))
+		return NULL;
+	if (!(entry = g_hash_table_lookup(cache->entries, command)))
+		return NULL;
+
+	now = g_get_monotonic_time();
+	if (entry->expires >= 0 && now > entry->expires) {
+		g_hash_table_remove(cache->entries, command);
+		return NULL;
+	}
+
+	if (cache->check_esr && now - cache->esr_checked > SCPI_CACHE_ESR_INTERVAL_US) {
+		/* The response passes through scpi_cache_store(). */
+		cache->esr_checked = now;
+		response = NULL;
+		if (sr_scpi_get_string(scpi, "*ESR?", &response) != SR_OK)
+			sr_scpi_cache_invalidate(scpi);
+		g_free(response);
+		if (!(entry = g_hash_table_lookup(cache->entries, command)))
+			return NULL;
+	}
+
+	sr_spew("Cached response to '%s': '%.70s'.", command, entry->response);
+
+	return g_strdup(entry->response);
+}
+
+/* Store the response to command, subject to the cache rules. */
+SR_PRIV void scpi_cache_store(struct sr_scpi_dev_inst *scpi,
+		const char *command, const char *response)
+{
+	struct scpi_cache *cache;
+	struct scpi_cache_entry *entry;
+	int64_t ttl;
+	int esr;
+
+	if (!(cache = scpi->cache))
+		return;
+
+	/* Whoever reads the event status register, look at it here. */
+	if (!g_ascii_strcasecmp(command, "*ESR?")) {
+		cache->esr_checked = g_get_monotonic_time();
+		if (sr_atoi(response, &esr) != SR_OK
+				|| (esr & (SCPI_ESR_URQ | SCPI_ESR_PON))) {
+			sr_dbg("Event status '%s', instrument state may have "
+				"changed.", response);
+			sr_scpi_cache_invalidate(scpi);
+		}
+		return;
+	}
+
+	if (!(ttl = cache_ttl(cache, command)))
+		return;
+
+	entry = g_malloc(sizeof(*entry));
+	entry->response = g_strdup(response);
+	entry->expires = ttl < 0 ? -1 : g_get_monotonic_time() + ttl;
+	g_hash_table_replace(cache->entries, g_strdup(command), entry);
+}
@@ -18,6 +18,7 @@
  */
 
 #include <config.h>
+#include <string.h>
 #include <strings.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
@@ -86,12 +87,41 @@ SR_PRIV int scpi_cmd(const struct sr_dev_inst *sdi, const struct scpi_command *c
 	return ret;
 }
 
+/* Convert a query response to the GVariant type the caller asked for. */
+static int scpi_resp_to_variant(const char *s, const GVariantType *gvtype,
+		GVariant **gvar)
+{
+	double d;
+
+	/* Straight SCPI getters to GVariant types. */
+	if (g_variant_type_equal(gvtype, G_VARIANT_TYPE_BOOLEAN)) {
+		if (!g_ascii_strcasecmp(s, "ON") || !g_ascii_strcasecmp(s, "1")
+				|| !g_ascii_strcasecmp(s, "YES"))
+			*gvar = g_variant_new_boolean(TRUE);
+		else if (!g_ascii_strcasecmp(s, "OFF") || !g_ascii_strcasecmp(s, "0")
+				|| !g_ascii_strcasecmp(s, "NO"))
+			*gvar = g_variant_new_boolean(FALSE);
+		else
+			return SR_ERR;
+	} else if (g_variant_type_equal(gvtype, G_VARIANT_TYPE_DOUBLE)) {
+		if (sr_atod_ascii(s, &d) != SR_OK)
+			return SR_ERR_DATA;
+		*gvar = g_variant_new_double(d);
+	} else if (g_variant_type_equal(gvtype, G_VARIANT_TYPE_STRING)) {
+		*gvar = g_variant_new_string(s);
+	} else {
+		sr_err("Unable to convert to desired GVariant type.");
+		return SR_ERR_NA;
+	}
+
+	return SR_OK;
+}
+
 SR_PRIV int scpi_cmd_resp(const struct sr_dev_inst *sdi, const struct scpi_command *cmdtable,
 		GVariant **gvar, const GVariantType *gvtype, int command, ...)
 {
 	struct sr_scpi_dev_inst *scpi;
 	va_list args;
-	double d;
 	int ret;
 	char *s;
 	const char *cmd;
@@ -108,29 +138,57 @@ SR_PRIV int scpi_cmd_resp(const struct sr_dev_inst *sdi, const struct scpi_comma
 	if (ret != SR_OK)
 		return ret;
 
-	/* Straight SCPI getters to GVariant types. */
-	if (g_variant_type_equal(gvtype, G_VARIANT_TYPE_BOOLEAN)) {
-		if ((ret = sr_scpi_get_string(scpi, NULL, &s)) != SR_OK)
-			return ret;
-		if (!g_ascii_strcasecmp(s, "ON") || !g_ascii_strcasecmp(s, "1")
-				|| !g_ascii_strcasecmp(s, "YES"))
-			*gvar = g_variant_new_boolean(TRUE);
-		else if (!g_ascii_strcasecmp(s, "OFF") || !g_ascii_strcasecmp(s, "0")
-				|| !g_ascii_strcasecmp(s, "NO"))
-			*gvar = g_variant_new_boolean(FALSE);
-		else
-			ret = SR_ERR;
-		g_free(s);
-	} else if (g_variant_type_equal(gvtype, G_VARIANT_TYPE_DOUBLE)) {
-		if ((ret = sr_scpi_get_double(scpi, NULL, &d)) == SR_OK)
-			*gvar = g_variant_new_double(d);
-	} else if (g_variant_type_equal(gvtype, G_VARIANT_TYPE_STRING)) {
-		if ((ret = sr_scpi_get_string(scpi, NULL, &s)) == SR_OK)
-			*gvar = g_variant_new_string(s);
-	} else {
-		sr_err("Unable to convert to desired GVariant type.");
-		ret = SR_ERR_NA;
+	if ((ret = sr_scpi_get_string(scpi, NULL, &s)) != SR_OK)
+		return ret;
+	ret = scpi_resp_to_variant(s, gvtype, gvar);
+	g_free(s);
+
+	return ret;
+}
+
+/*
+ * Run several argument-less queries from a command table as one compound
+ * SCPI message. Commands the device doesn't implement, and responses which
+ * don't convert to the requested type, leave their gvars entry NULL.
+ */
+SR_PRIV int scpi_cmd_resp_multi(const struct sr_dev_inst *sdi,
+		const struct scpi_command *cmdtable, GVariant **gvars,
+		const GVariantType **gvtypes, const int *commands,
+		unsigned int num_commands)
+{
+	const char **cmds;
+	char **responses;
+	unsigned int *index;
+	unsigned int i, num;
+	int ret;
+
+	for (i = 0; i < num_commands; i++)
+		gvars[i] = NULL;
+
+	cmds = g_malloc0_n(num_commands + 1, sizeof(*cmds));
+	index = g_malloc0_n(num_commands + 1, sizeof(*index));
+	num = 0;
+	for (i = 0; i < num_commands; i++) {
+		if (!(cmds[num] = scpi_cmd_get(cmdtable, commands[i])))
+			continue;
+		if (strchr(cmds[num], '%'))
+			continue;
+		index[num++] = i;
 	}
 
+	responses = g_malloc0_n(num + 1, sizeof(*responses));
+	ret = sr_scpi_get_strings(sdi->conn, cmds, num, responses);
+	for (i = 0; i < num && ret == SR_OK; i++) {
+		if (scpi_resp_to_variant(responses[i], gvtypes[index[i]],
+				&gvars[index[i]]) != SR_OK)
+			gvars[index[i]] = NULL;
+	}
+	for (i = 0; i < num; i++)
+		g_free(responses[i]);
+
+	g_free(responses);
+	g_free(index);
+	g_free(cmds);
+
 	return ret;
 }
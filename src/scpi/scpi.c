@@ -29,6 +29,12 @@
 #define SCPI_READ_RETRIES 100
 #define SCPI_READ_RETRY_TIMEOUT_US (10 * 1000)
 
+/* First read of a block, covers the longest header ("#9" plus 9 digits). */
+#define SCPI_BLOCK_HEADER_READ 64
+
+/* Maximum number of pipelined queries awaiting their response. */
+#define SCPI_PIPELINE_DEPTH 16
+
 /**
  * Parse a string representation of a boolean-like value into a gboolean.
  * Similar to sr_parse_boolstring but rejects strings which do not represent
@@ -170,7 +176,7 @@ SR_PRIV GSList *sr_scpi_scan(struct drv_context *drvc, GSList *options,
 
 	/* Tack a copy of the newly found devices onto the driver list. */
 	if (devices)
-		drvc->instances = g_slist_concat(drvc->instances, g_slist_copy(devices));
+		sr_scan_instances_add(drvc, devices);
 
 	return devices;
 }
@@ -214,6 +220,8 @@ SR_PRIV struct sr_scpi_dev_inst *scpi_dev_inst_new(struct drv_context *drvc,
  */
 SR_PRIV int sr_scpi_open(struct sr_scpi_dev_inst *scpi)
 {
+	scpi_cache_reopened(scpi);
+
 	return scpi->open(scpi);
 }
 
@@ -301,6 +309,8 @@ SR_PRIV int sr_scpi_send_variadic(struct sr_scpi_dev_inst *scpi,
 	if (buf[len - 1] != '\n')
 		buf[len] = '\n';
 
+	scpi_cache_sent(scpi, buf);
+
 	/* Send command. */
 	ret = scpi->send(scpi->priv, buf);
 
@@ -349,6 +359,8 @@ SR_PRIV int sr_scpi_read_data(struct sr_scpi_dev_inst *scpi,
 SR_PRIV int sr_scpi_write_data(struct sr_scpi_dev_inst *scpi,
 			char *buf, int maxlen)
 {
+	sr_scpi_cache_invalidate(scpi);
+
 	return scpi->write_data(scpi->priv, buf, maxlen);
 }
 
@@ -387,6 +399,7 @@ SR_PRIV void sr_scpi_free(struct sr_scpi_dev_inst *scpi)
 	if (!scpi)
 		return;
 
+	scpi_cache_free(scpi);
 	scpi->free(scpi->priv);
 	g_free(scpi->priv);
 	g_free(scpi);
@@ -405,6 +418,10 @@ SR_PRIV int sr_scpi_get_string(struct sr_scpi_dev_inst *scpi,
 			       const char *command, char **scpi_response)
 {
 	GString *response;
+
+	if (command && (*scpi_response = scpi_cache_lookup(scpi, command)))
+		return SR_OK;
+
 	response = g_string_sized_new(1024);
 
 	if (sr_scpi_get_data(scpi, command, &response) != SR_OK) {
@@ -424,11 +441,198 @@ SR_PRIV int sr_scpi_get_string(struct sr_scpi_dev_inst *scpi,
 	sr_spew("Got response: '%.70s', length %" G_GSIZE_FORMAT ".",
 		response->str, response->len);
 
+	if (command)
+		scpi_cache_store(scpi, command, response->str);
+
 	*scpi_response = g_string_free(response, FALSE);
 
 	return SR_OK;
 }
 
+/*
+ * Discard responses which are still on their way, so that they aren't
+ * taken for the responses to later queries.
+ */
+static void scpi_drain(struct sr_scpi_dev_inst *scpi)
+{
+	if (scpi->drain)
+		scpi->drain(scpi->priv);
+}
+
+/**
+ * Send several SCPI queries as one compound message, and split the reply.
+ *
+ * The queries are joined with ';' (IEEE 488.2 program message unit
+ * separator). Queries which don't start at the root of the command tree
+ * get a leading ':', so that each one is interpreted independently of
+ * the previous one. The device answers with one response message which
+ * holds the individual responses separated by ';'.
+ *
+ * @param scpi Previously initialised SCPI device structure.
+ * @param commands Array of num_commands SCPI queries.
+ * @param num_commands Number of queries.
+ * @param scpi_responses Array of num_commands pointers where to store the
+ *        responses. The caller must g_free() them after use. Upon failure
+ *        all of them are NULL.
+ *
+ * @return SR_OK on success, SR_ERR_DATA if the reply doesn't hold one
+ *         response per query (any further responses are discarded),
+ *         other SR_ERR* on failure.
+ */
+SR_PRIV int sr_scpi_get_strings(struct sr_scpi_dev_inst *scpi,
+		const char **commands, unsigned int num_commands,
+		char **scpi_responses)
+{
+	GString *message;
+	char *response, *p, *start;
+	gboolean quoted;
+	unsigned int i;
+	char quote;
+	int ret;
+
+	for (i = 0; i < num_commands; i++)
+		scpi_responses[i] = NULL;
+	if (!num_commands)
+		return SR_OK;
+
+	message = g_string_sized_new(256);
+	for (i = 0; i < num_commands; i++) {
+		if (i > 0) {
+			g_string_append_c(message, ';');
+			if (commands[i][0] != ':' && commands[i][0] != '*')
+				g_string_append_c(message, ':');
+		}
+		g_string_append(message, commands[i]);
+	}
+	ret = sr_scpi_send(scpi, "%s", message->str);
+	g_string_free(message, TRUE);
+	if (ret != SR_OK)
+		return ret;
+
+	response = NULL;
+	if ((ret = sr_scpi_get_string(scpi, NULL, &response)) != SR_OK)
+		return ret;
+
+	/* Split at separators outside of quoted string responses. */
+	i = 0;
+	quoted = FALSE;
+	quote = '\0';
+	start = response;
+	for (p = response; ; p++) {
+		if (quoted) {
+			if (*p == quote)
+				quoted = FALSE;
+			else if (*p)
+				continue;
+		} else if (*p == '"' || *p == '\'') {
+			quoted = TRUE;
+			quote = *p;
+			continue;
+		}
+		if (*p && *p != ';')
+			continue;
+		if (i == num_commands)
+			break;
+		scpi_responses[i++] = g_strstrip(g_strndup(start, p - start));
+		if (!*p)
+			break;
+		start = p + 1;
+	}
+
+	if (i != num_commands || *p) {
+		sr_dbg("Expected %u responses, got '%.70s'.", num_commands,
+			response);
+		for (i = 0; i < num_commands; i++) {
+			g_free(scpi_responses[i]);
+			scpi_responses[i] = NULL;
+		}
+		/* Responses may have come as separate messages. */
+		scpi_drain(scpi);
+		ret = SR_ERR_DATA;
+	}
+	g_free(response);
+
+	return ret;
+}
+
+/**
+ * Send several SCPI queries back to back, and read their responses.
+ *
+ * Up to SCPI_PIPELINE_DEPTH queries are sent before their responses are
+ * read, which saves a round trip per query on network transports. The
+ * responses are matched to the queries in order. Responses in the cache
+ * are served from there, the others are stored to it.
+ *
+ * Not all instruments queue responses: IEEE 488.2 allows a device to
+ * discard pending output upon receiving a new query ("query interrupted").
+ * Only use this with instruments known to support it, else see
+ * sr_scpi_get_strings(). Transports which can't tell responses apart
+ * fall back to one query at a time.
+ *
+ * @param scpi Previously initialised SCPI device structure.
+ * @param commands Array of num_commands SCPI queries.
+ * @param num_commands Number of queries.
+ * @param scpi_responses Array of num_commands pointers where to store the
+ *        responses. The caller must g_free() them after use. Upon failure
+ *        all of them are NULL.
+ *
+ * @return SR_OK on success, SR_ERR* on failure. After a failure, the
+ *         responses to queries which were sent may still arrive.
+ */
+SR_PRIV int sr_scpi_get_strings_pipelined(struct sr_scpi_dev_inst *scpi,
+		const char **commands, unsigned int num_commands,
+		char **scpi_responses)
+{
+	unsigned int *pending, num_pending, sent, received, i;
+	unsigned int depth;
+	int ret;
+
+	for (i = 0; i < num_commands; i++)
+		scpi_responses[i] = NULL;
+
+	/* Look up all cached responses before anything is sent. */
+	pending = g_malloc(num_commands * sizeof(*pending));
+	num_pending = 0;
+	for (i = 0; i < num_commands; i++) {
+		scpi_responses[i] = scpi_cache_lookup(scpi, commands[i]);
+		if (!scpi_responses[i])
+			pending[num_pending++] = i;
+	}
+
+	depth = scpi->pipelining ? SCPI_PIPELINE_DEPTH : 1;
+	ret = SR_OK;
+	sent = received = 0;
+	while (received < num_pending) {
+		while (sent < num_pending && sent - received < depth) {
+			ret = sr_scpi_send(scpi, "%s", commands[pending[sent]]);
+			if (ret != SR_OK)
+				break;
+			sent++;
+		}
+		if (ret != SR_OK)
+			break;
+		i = pending[received];
+		ret = sr_scpi_get_string(scpi, NULL, &scpi_responses[i]);
+		if (ret != SR_OK)
+			break;
+		scpi_cache_store(scpi, commands[i], scpi_responses[i]);
+		received++;
+	}
+
+	if (ret != SR_OK) {
+		sr_dbg("Pipelined query '%s' failed, %u of %u sent.",
+			commands[pending[MIN(sent, num_pending - 1)]], sent,
+			num_pending);
+		for (i = 0; i < num_commands; i++) {
+			g_free(scpi_responses[i]);
+			scpi_responses[i] = NULL;
+		}
+	}
+	g_free(pending);
+
+	return ret;
+}
+
 /**
  * Do a non-blocking read of up to the allocated length, and
  * check if a timeout has occured.
@@ -677,33 +881,24 @@ SR_PRIV int sr_scpi_get_floatv(struct sr_scpi_dev_inst *scpi,
 			       const char *command, GArray **scpi_response)
 {
 	int ret;
-	float tmp;
 	char *response;
-	gchar **ptr, **tokens;
+	size_t count;
 	GArray *response_array;
 
 	response = NULL;
-	tokens = NULL;
 
 	ret = sr_scpi_get_string(scpi, command, &response);
 	if (ret != SR_OK && !response)
 		return ret;
 
-	tokens = g_strsplit(response, ",", 0);
-	ptr = tokens;
-
-	response_array = g_array_sized_new(TRUE, FALSE, sizeof(float), 256);
-
-	while (*ptr) {
-		if (sr_atof_ascii(*ptr, &tmp) == SR_OK)
-			response_array = g_array_append_val(response_array,
-							    tmp);
-		else
-			ret = SR_ERR_DATA;
-
-		ptr++;
-	}
-	g_strfreev(tokens);
+	/* Size the array once, then parse straight into it. */
+	sr_parse_floatv(response, NULL, 0, &count);
+	response_array = g_array_sized_new(TRUE, FALSE, sizeof(float), count);
+	g_array_set_size(response_array, count);
+	if (sr_parse_floatv(response, (float *)response_array->data, count,
+			&count) != SR_OK)
+		ret = SR_ERR_DATA;
+	g_array_set_size(response_array, count);
 	g_free(response);
 
 	if (ret != SR_OK && response_array->len == 0) {
@@ -733,33 +928,24 @@ SR_PRIV int sr_scpi_get_floatv(struct sr_scpi_dev_inst *scpi,
 SR_PRIV int sr_scpi_get_uint8v(struct sr_scpi_dev_inst *scpi,
 			       const char *command, GArray **scpi_response)
 {
-	int tmp, ret;
+	int ret;
 	char *response;
-	gchar **ptr, **tokens;
+	size_t count;
 	GArray *response_array;
 
 	response = NULL;
-	tokens = NULL;
 
 	ret = sr_scpi_get_string(scpi, command, &response);
 	if (ret != SR_OK && !response)
 		return ret;
 
-	tokens = g_strsplit(response, ",", 0);
-	ptr = tokens;
-
-	response_array = g_array_sized_new(TRUE, FALSE, sizeof(uint8_t), 256);
-
-	while (*ptr) {
-		if (sr_atoi(*ptr, &tmp) == SR_OK)
-			response_array = g_array_append_val(response_array,
-							    tmp);
-		else
-			ret = SR_ERR_DATA;
-
-		ptr++;
-	}
-	g_strfreev(tokens);
+	sr_parse_uint8v(response, NULL, 0, &count);
+	response_array = g_array_sized_new(TRUE, FALSE, sizeof(uint8_t), count);
+	g_array_set_size(response_array, count);
+	if (sr_parse_uint8v(response, (uint8_t *)response_array->data, count,
+			&count) != SR_OK)
+		ret = SR_ERR_DATA;
+	g_array_set_size(response_array, count);
 	g_free(response);
 
 	if (response_array->len == 0) {
@@ -773,28 +959,20 @@ SR_PRIV int sr_scpi_get_uint8v(struct sr_scpi_dev_inst *scpi,
 	return ret;
 }
 
-/**
- * Send a SCPI command, read the reply, parse it as binary data with a
- * "definite length block" header and store the as an result in scpi_response.
- *
- * @param scpi Previously initialised SCPI device structure.
- * @param command The SCPI command to send to the device (can be NULL).
- * @param scpi_response Pointer where to store the parsed result.
- *
- * @return SR_OK upon successfully parsing all values, SR_ERR* upon a parsing
- *         error or upon no response. The allocated response must be freed by
- *         the caller in the case of an SR_OK as well as in the case of
- *         parsing error.
+/*
+ * Receive the start of a definite length block: send the optional command,
+ * read until the '#' marker and the complete length spec were seen, and
+ * return the block's length. Data bytes which were received along with the
+ * header are moved to the start of buf, their count is stored in fill.
  */
-SR_PRIV int sr_scpi_get_block(struct sr_scpi_dev_inst *scpi,
-			       const char *command, GByteArray **scpi_response)
+static int scpi_block_header(struct sr_scpi_dev_inst *scpi,
+		const char *command, uint8_t *buf, size_t bufsize, size_t *fill,
+		size_t *datalen, gint64 *timeout)
 {
+	char lenbuf[10];
+	size_t len, hdrlen;
+	long llen, dlen;
 	int ret;
-	GString* response;
-	char buf[10];
-	long llen;
-	long datalen;
-	gint64 timeout;
 
 	if (command)
 		if (sr_scpi_send(scpi, command) != SR_OK)
@@ -803,24 +981,7 @@ SR_PRIV int sr_scpi_get_block(struct sr_scpi_dev_inst *scpi,
 	if (sr_scpi_read_begin(scpi) != SR_OK)
 		return SR_ERR;
 
-	/*
-	 * Assume an initial maximum length, optionally gets adjusted below.
-	 * Prepare a NULL return value for when error paths will be taken.
-	 */
-	response = g_string_sized_new(1024);
-
-	timeout = g_get_monotonic_time() + scpi->read_timeout_us;
-
-	*scpi_response = NULL;
-
-	/* Get (the first chunk of) the response. */
-	while (response->len < 2) {
-		ret = sr_scpi_read_response(scpi, response, timeout);
-		if (ret < 0) {
-			g_string_free(response, TRUE);
-			return ret;
-		}
-	}
+	*timeout = g_get_monotonic_time() + scpi->read_timeout_us;
 
 	/*
 	 * SCPI protocol data blocks are preceeded with a length spec.
@@ -829,65 +990,240 @@ SR_PRIV int sr_scpi_get_block(struct sr_scpi_dev_inst *scpi,
 	 * respective number of characters which specify the data block's
 	 * length. Raw data bytes follow (thus one must no longer assume
 	 * that the received input stream would be an ASCIIZ string).
-	 *
-	 * Get the data block length, and strip off the length spec from
-	 * the input buffer, leaving just the data bytes.
 	 */
-	if (response->str[0] != '#') {
-		g_string_free(response, TRUE);
-		return SR_ERR_DATA;
-	}
-	buf[0] = response->str[1];
-	buf[1] = '\0';
-	ret = sr_atol(buf, &llen);
-	if ((ret != SR_OK) || (llen == 0)) {
-		g_string_free(response, TRUE);
-		return ret;
+	len = 0;
+	hdrlen = 2;
+	llen = 0;
+	bufsize = MIN(bufsize, SCPI_BLOCK_HEADER_READ);
+	while (len < hdrlen) {
+		ret = sr_scpi_read_data(scpi, (char *)buf + len, bufsize - len);
+		if (ret < 0) {
+			sr_err("Incompletely read SCPI response.");
+			return SR_ERR;
+		}
+		if (ret == 0 && g_get_monotonic_time() > *timeout) {
+			sr_err("Timed out waiting for SCPI response.");
+			return SR_ERR_TIMEOUT;
+		}
+		len += ret;
+		/* Skip a terminator left over from the previous response. */
+		while (hdrlen == 2 && len > 0 && g_ascii_isspace(buf[0]))
+			memmove(buf, buf + 1, --len);
+		if (len < 2 || hdrlen > 2)
+			continue;
+		if (buf[0] != '#')
+			return SR_ERR_DATA;
+		lenbuf[0] = buf[1];
+		lenbuf[1] = '\0';
+		if (sr_atol(lenbuf, &llen) != SR_OK || llen == 0) {
+			/* Indefinite length blocks ("#0") are not supported. */
+			return SR_ERR_DATA;
+		}
+		hdrlen = 2 + llen;
 	}
 
-	while (response->len < (unsigned long)(2 + llen)) {
-		ret = sr_scpi_read_response(scpi, response, timeout);
+	memcpy(lenbuf, &buf[2], llen);
+	lenbuf[llen] = '\0';
+	if (sr_atol(lenbuf, &dlen) != SR_OK || dlen < 0)
+		return SR_ERR_DATA;
+
+	*datalen = dlen;
+	*fill = MIN(len - hdrlen, *datalen);
+	memmove(buf, &buf[hdrlen], *fill);
+
+	return SR_OK;
+}
+
+/* Read len more bytes of a block straight into buf. */
+static int scpi_block_read(struct sr_scpi_dev_inst *scpi, uint8_t *buf,
+		size_t len, gint64 *timeout)
+{
+	int ret;
+
+	while (len > 0) {
+		ret = sr_scpi_read_data(scpi, (char *)buf, MIN(len, G_MAXINT));
 		if (ret < 0) {
-			g_string_free(response, TRUE);
-			return ret;
+			sr_err("Incompletely read SCPI response.");
+			return SR_ERR;
 		}
+		if (ret > 0) {
+			*timeout = g_get_monotonic_time() + scpi->read_timeout_us;
+		} else if (g_get_monotonic_time() > *timeout) {
+			sr_err("Timed out waiting for SCPI response.");
+			return SR_ERR_TIMEOUT;
+		}
+		buf += ret;
+		len -= ret;
 	}
 
-	memcpy(buf, &response->str[2], llen);
-	buf[llen] = '\0';
-	ret = sr_atol(buf, &datalen);
-	if ((ret != SR_OK) || (datalen == 0)) {
-		g_string_free(response, TRUE);
-		return ret;
+	return SR_OK;
+}
+
+/*
+ * Consume the response message terminator which follows a block's data,
+ * so that it isn't taken for the next response.
+ */
+static int scpi_block_end(struct sr_scpi_dev_inst *scpi, gint64 timeout)
+{
+	char c;
+	int ret;
+
+	while (!sr_scpi_read_complete(scpi)) {
+		ret = sr_scpi_read_data(scpi, &c, 1);
+		if (ret < 0) {
+			sr_err("Incompletely read SCPI response.");
+			return SR_ERR;
+		}
+		if (ret == 0 && g_get_monotonic_time() > timeout) {
+			sr_err("Timed out waiting for SCPI response.");
+			return SR_ERR_TIMEOUT;
+		}
 	}
-	g_string_erase(response, 0, 2 + llen);
 
-	/*
-	 * If the initially assumed length does not cover the data block
-	 * length, then re-allocate the buffer size to the now known
-	 * length, and keep reading more chunks of response data.
-	 */
-	if (response->len < (unsigned long)(datalen)) {
-		int oldlen = response->len;
-		g_string_set_size(response, datalen);
-		g_string_set_size(response, oldlen);
+	return SR_OK;
+}
+
+/**
+ * Send a SCPI command, read the reply, parse it as binary data with a
+ * "definite length block" header and store the as an result in scpi_response.
+ *
+ * @param scpi Previously initialised SCPI device structure.
+ * @param command The SCPI command to send to the device (can be NULL).
+ * @param scpi_response Pointer where to store the parsed result.
+ *
+ * @return SR_OK upon successfully parsing all values, SR_ERR* upon a parsing
+ *         error or upon no response. The allocated response must be freed by
+ *         the caller in the case of an SR_OK as well as in the case of
+ *         parsing error.
+ */
+SR_PRIV int sr_scpi_get_block(struct sr_scpi_dev_inst *scpi,
+			       const char *command, GByteArray **scpi_response)
+{
+	int ret;
+
+	*scpi_response = g_byte_array_new();
+	ret = sr_scpi_get_block_buf(scpi, command, *scpi_response);
+	if (ret != SR_OK) {
+		g_byte_array_free(*scpi_response, TRUE);
+		*scpi_response = NULL;
 	}
 
-	while (response->len < (unsigned long)(datalen)) {
-		ret = sr_scpi_read_response(scpi, response, timeout);
+	return ret;
+}
+
+/**
+ * Send a SCPI command, and read a "definite length block" reply into a
+ * caller provided byte array.
+ *
+ * The array is sized once the block's length is known, and the data is
+ * read into it directly. Reusing the same array for subsequent blocks
+ * avoids reallocations as long as blocks don't grow.
+ *
+ * @param scpi Previously initialised SCPI device structure.
+ * @param command The SCPI command to send to the device (can be NULL).
+ * @param data Byte array to receive the block's data. Its previous content
+ *        is discarded.
+ *
+ * @return SR_OK upon success, SR_ERR* upon a parsing error or upon no
+ *         response.
+ */
+SR_PRIV int sr_scpi_get_block_buf(struct sr_scpi_dev_inst *scpi,
+		const char *command, GByteArray *data)
+{
+	uint8_t head[SCPI_BLOCK_HEADER_READ];
+	size_t fill, datalen;
+	gint64 timeout;
+	int ret;
+
+	g_byte_array_set_size(data, 0);
+
+	ret = scpi_block_header(scpi, command, head, sizeof(head), &fill,
+		&datalen, &timeout);
+	if (ret != SR_OK)
+		return ret;
+
+	g_byte_array_set_size(data, datalen);
+	memcpy(data->data, head, fill);
+	ret = scpi_block_read(scpi, data->data + fill, datalen - fill, &timeout);
+	if (ret == SR_OK)
+		ret = scpi_block_end(scpi, timeout);
+	if (ret != SR_OK)
+		g_byte_array_set_size(data, 0);
+
+	return ret;
+}
+
+/**
+ * Send a SCPI command, and pass a "definite length block" reply to a
+ * callback in chunks while it is being received.
+ *
+ * Data is read into the caller provided buffer, and passed to the callback
+ * whenever more of it arrived. The callback returns how many bytes it has
+ * consumed. Bytes it didn't consume are passed again, followed by more
+ * data, in the next call. This way it can e.g. wait for a complete header,
+ * or for complete samples. The last call has remaining set to 0, bytes
+ * left unconsumed by it are discarded.
+ *
+ * @param scpi Previously initialised SCPI device structure.
+ * @param command The SCPI command to send to the device (can be NULL).
+ * @param buf Buffer to receive data into.
+ * @param bufsize Size of buf. Must exceed the largest amount of data which
+ *        the callback leaves unconsumed.
+ * @param cb Callback to process received data.
+ * @param cb_data Opaque data for the callback.
+ *
+ * @return SR_OK upon success, SR_ERR* upon a parsing error, upon no response,
+ *         or the error returned by the callback.
+ */
+SR_PRIV int sr_scpi_get_block_cb(struct sr_scpi_dev_inst *scpi,
+		const char *command, uint8_t *buf, size_t bufsize,
+		sr_scpi_block_callback cb, void *cb_data)
+{
+	size_t fill, remaining, len;
+	gint64 timeout;
+	int ret;
+
+	if (bufsize < SCPI_BLOCK_HEADER_READ)
+		return SR_ERR_ARG;
+
+	ret = scpi_block_header(scpi, command, buf, bufsize, &fill,
+		&remaining, &timeout);
+	if (ret != SR_OK)
+		return ret;
+	remaining -= fill;
+
+	while (TRUE) {
+		if (fill > 0) {
+			if ((ret = cb(buf, fill, remaining, cb_data)) < 0)
+				return ret;
+			fill -= ret;
+			memmove(buf, buf + ret, fill);
+		}
+		if (!remaining)
+			break;
+		if (fill == bufsize) {
+			sr_err("Block callback doesn't consume any data.");
+			return SR_ERR_BUG;
+		}
+
+		/* Take whatever is available, but at least one byte. */
+		len = MIN(MIN(bufsize - fill, remaining), G_MAXINT);
+		while ((ret = sr_scpi_read_data(scpi, (char *)buf + fill, len)) == 0) {
+			if (g_get_monotonic_time() > timeout) {
+				sr_err("Timed out waiting for SCPI response.");
+				return SR_ERR_TIMEOUT;
+			}
+		}
 		if (ret < 0) {
-			g_string_free(response, TRUE);
-			return ret;
+			sr_err("Incompletely read SCPI response.");
+			return SR_ERR;
 		}
-		if (ret > 0)
-			timeout = g_get_monotonic_time() + scpi->read_timeout_us;
+		timeout = g_get_monotonic_time() + scpi->read_timeout_us;
+		fill += ret;
+		remaining -= ret;
 	}
 
-	/* Convert received data to byte array. */
-	*scpi_response = g_byte_array_new_take(
-		(guint8*)g_string_free(response, FALSE), datalen);
-
-	return SR_OK;
+	return scpi_block_end(scpi, timeout);
 }
 
 /**
@@ -172,6 +172,21 @@ static int scpi_serial_read_complete(void *priv)
 	return sscpi->got_newline;
 }
 
+static void scpi_serial_drain(void *priv)
+{
+	struct scpi_serial *sscpi = priv;
+	char buf[256];
+	size_t num;
+	int len;
+
+	num = 0;
+	while ((len = serial_read_blocking(sscpi->serial, buf, sizeof(buf),
+			SCPI_DRAIN_QUIET_US / 1000)) > 0)
+		num += len;
+	if (num)
+		sr_dbg("Discarded %zu bytes of unread responses.", num);
+}
+
 static int scpi_serial_close(struct sr_scpi_dev_inst *scpi)
 {
 	struct scpi_serial *sscpi = scpi->priv;
@@ -199,6 +214,7 @@ SR_PRIV const struct sr_scpi_dev_inst scpi_serial_dev = {
 	.read_begin    = scpi_serial_read_begin,
 	.read_data     = scpi_serial_read_data,
 	.read_complete = scpi_serial_read_complete,
+	.drain         = scpi_serial_drain,
 	.close         = scpi_serial_close,
 	.free          = scpi_serial_free,
 };
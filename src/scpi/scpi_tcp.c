@@ -27,6 +27,7 @@
 #include <string.h>
 #include <unistd.h>
 #ifndef _WIN32
+#include <sys/select.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -41,6 +42,16 @@
 
 #define LENGTH_BYTES 4
 
+/*
+ * Size of the receive buffer. Data is received in chunks of up to this
+ * size, and handed out to callers from there. Responses to pipelined
+ * queries which arrive back to back are separated from the buffer.
+ */
+#define RX_BUFFER_SIZE (64 * 1024)
+
+/* Response message terminator, "\n" or "\r\n". */
+#define TERMINATOR_MAX 2
+
 struct scpi_tcp {
 	char *address;
 	char *port;
@@ -49,6 +60,16 @@ struct scpi_tcp {
 	int length_bytes_read;
 	int response_length;
 	int response_bytes_read;
+	/* Receive buffer, valid data is in rx_buf[rx_start..rx_end). */
+	uint8_t *rx_buf;
+	size_t rx_start;
+	size_t rx_end;
+	/* Framing of raw responses, see scpi_tcp_raw_read_data(). */
+	gboolean complete;
+	gboolean in_block;
+	uint64_t block_left;
+	gboolean after_block;
+	gboolean skip_terminator;
 };
 
 static int scpi_tcp_dev_inst_new(void *priv, struct drv_context *drvc,
@@ -112,6 +133,11 @@ static int scpi_tcp_open(struct sr_scpi_dev_inst *scpi)
 		return SR_ERR;
 	}
 
+	if (!tcp->rx_buf)
+		tcp->rx_buf = g_malloc(RX_BUFFER_SIZE);
+	tcp->rx_start = tcp->rx_end = 0;
+	tcp->in_block = tcp->after_block = FALSE;
+
 	return SR_OK;
 }
 
@@ -161,26 +187,189 @@ static int scpi_tcp_read_begin(void *priv)
 	tcp->response_bytes_read = 0;
 	tcp->length_bytes_read = 0;
 
+	/* The previous response was a block, its terminator wasn't read. */
+	tcp->skip_terminator = tcp->after_block;
+	tcp->complete = FALSE;
+	tcp->in_block = FALSE;
+	tcp->after_block = FALSE;
+
+	return SR_OK;
+}
+
+/*
+ * Receive into the buffer until at least want bytes are available, while
+ * holding no more than limit bytes. Not receiving past the known end of
+ * a response leaves later data in the socket, so that it still polls as
+ * readable for callers which read one chunk per event.
+ */
+static int scpi_tcp_fill(struct scpi_tcp *tcp, size_t want, uint64_t limit)
+{
+	size_t space;
+	ssize_t len;
+
+	if (tcp->rx_start == tcp->rx_end) {
+		tcp->rx_start = tcp->rx_end = 0;
+	} else if (tcp->rx_start + want > RX_BUFFER_SIZE) {
+		memmove(tcp->rx_buf, tcp->rx_buf + tcp->rx_start,
+			tcp->rx_end - tcp->rx_start);
+		tcp->rx_end -= tcp->rx_start;
+		tcp->rx_start = 0;
+	}
+
+	while (tcp->rx_end - tcp->rx_start < want) {
+		space = RX_BUFFER_SIZE - tcp->rx_end;
+		space = MIN(space, limit - (tcp->rx_end - tcp->rx_start));
+		len = recv(tcp->socket, (char *)tcp->rx_buf + tcp->rx_end,
+			space, 0);
+		if (len < 0) {
+			sr_err("Receive error: %s", g_strerror(errno));
+			return SR_ERR;
+		}
+		if (len == 0) {
+			sr_err("Connection closed by peer.");
+			return SR_ERR;
+		}
+		tcp->rx_end += len;
+	}
+
 	return SR_OK;
 }
 
+/*
+ * Receive up to maxlen bytes of a response which has limit bytes left.
+ * Large reads go straight to the caller's buffer when nothing is
+ * buffered, smaller ones are served from the receive buffer.
+ */
+static int scpi_tcp_read_buffered(struct scpi_tcp *tcp, char *buf,
+		size_t maxlen, uint64_t limit)
+{
+	size_t len;
+	ssize_t ret;
+
+	len = MIN(maxlen, limit);
+	if (tcp->rx_start == tcp->rx_end && len >= RX_BUFFER_SIZE) {
+		ret = recv(tcp->socket, buf, len, 0);
+		if (ret < 0) {
+			sr_err("Receive error: %s", g_strerror(errno));
+			return SR_ERR;
+		}
+		if (ret == 0) {
+			sr_err("Connection closed by peer.");
+			return SR_ERR;
+		}
+		return ret;
+	}
+
+	if (scpi_tcp_fill(tcp, 1, limit) != SR_OK)
+		return SR_ERR;
+	len = MIN(len, tcp->rx_end - tcp->rx_start);
+	memcpy(buf, tcp->rx_buf + tcp->rx_start, len);
+	tcp->rx_start += len;
+
+	return len;
+}
+
+/* Check for a definite length block at the start of a raw response. */
+static int scpi_tcp_raw_block_start(struct scpi_tcp *tcp)
+{
+	char lenbuf[10];
+	const uint8_t *p;
+	unsigned int digits;
+	long dlen;
+
+	if (scpi_tcp_fill(tcp, 1, RX_BUFFER_SIZE) != SR_OK)
+		return SR_ERR;
+	if (tcp->rx_buf[tcp->rx_start] != '#')
+		return SR_OK;
+
+	if (scpi_tcp_fill(tcp, 2, RX_BUFFER_SIZE) != SR_OK)
+		return SR_ERR;
+	p = tcp->rx_buf + tcp->rx_start;
+	if (p[1] < '1' || p[1] > '9')
+		return SR_OK;
+
+	digits = p[1] - '0';
+	if (scpi_tcp_fill(tcp, 2 + digits, RX_BUFFER_SIZE) != SR_OK)
+		return SR_ERR;
+	p = tcp->rx_buf + tcp->rx_start;
+	memcpy(lenbuf, p + 2, digits);
+	lenbuf[digits] = '\0';
+	if (sr_atol(lenbuf, &dlen) != SR_OK || dlen < 0)
+		return SR_OK;
+
+	tcp->in_block = TRUE;
+	tcp->block_left = 2 + digits + dlen;
+
+	return SR_OK;
+}
+
+/*
+ * Raw responses are framed as IEEE 488.2 response messages: they end at
+ * a newline, unless it is part of a definite length block ("#<n><len>")
+ * at the start of the response. The data of such a block is passed
+ * without looking for a newline, and the response counts as complete
+ * after it. When the caller doesn't read the terminator following the
+ * block, it is dropped at the start of the next response.
+ *
+ * Data of subsequent responses remains in the receive buffer, so that
+ * several queries can be sent before their responses are read.
+ */
 static int scpi_tcp_raw_read_data(void *priv, char *buf, int maxlen)
 {
 	struct scpi_tcp *tcp = priv;
+	const uint8_t *p, *nl;
+	size_t avail;
 	int len;
 
-	len = recv(tcp->socket, buf, maxlen, 0);
+	if (maxlen <= 0)
+		return 0;
 
-	if (len < 0) {
-		sr_err("Receive error: %s", g_strerror(errno));
-		return SR_ERR;
+	while (tcp->skip_terminator) {
+		if (scpi_tcp_fill(tcp, 1, TERMINATOR_MAX) != SR_OK)
+			return SR_ERR;
+		p = tcp->rx_buf + tcp->rx_start;
+		if (*p == '\r') {
+			tcp->rx_start++;
+		} else {
+			if (*p == '\n')
+				tcp->rx_start++;
+			tcp->skip_terminator = FALSE;
+		}
 	}
 
-	tcp->length_bytes_read = LENGTH_BYTES;
-	tcp->response_length = len < maxlen ? len : maxlen + 1;
-	tcp->response_bytes_read = len;
+	if (tcp->response_bytes_read == 0 && !tcp->in_block)
+		if (scpi_tcp_raw_block_start(tcp) != SR_OK)
+			return SR_ERR;
 
-	return len;
+	if (tcp->in_block) {
+		len = scpi_tcp_read_buffered(tcp, buf, maxlen, tcp->block_left);
+		if (len < 0)
+			return len;
+		tcp->block_left -= len;
+		if (!tcp->block_left) {
+			tcp->in_block = FALSE;
+			tcp->after_block = TRUE;
+		}
+		tcp->response_bytes_read += len;
+		return len;
+	}
+
+	/* Only a block's terminator is expected after its data. */
+	if (scpi_tcp_fill(tcp, 1, tcp->after_block ?
+			TERMINATOR_MAX : RX_BUFFER_SIZE) != SR_OK)
+		return SR_ERR;
+	p = tcp->rx_buf + tcp->rx_start;
+	avail = MIN((size_t)maxlen, tcp->rx_end - tcp->rx_start);
+	if ((nl = memchr(p, '\n', avail))) {
+		avail = nl - p + 1;
+		tcp->complete = TRUE;
+		tcp->after_block = FALSE;
+	}
+	memcpy(buf, p, avail);
+	tcp->rx_start += avail;
+	tcp->response_bytes_read += avail;
+
+	return avail;
 }
 
 static int scpi_tcp_raw_write_data(void *priv, char *buf, int len)
@@ -204,36 +393,35 @@ static int scpi_tcp_rigol_read_data(void *priv, char *buf, int maxlen)
 	int len;
 
 	if (tcp->length_bytes_read < LENGTH_BYTES) {
-		len = recv(tcp->socket, tcp->length_buf + tcp->length_bytes_read,
-				LENGTH_BYTES - tcp->length_bytes_read, 0);
-		if (len < 0) {
-			sr_err("Receive error: %s", g_strerror(errno));
+		if (scpi_tcp_fill(tcp, LENGTH_BYTES, RX_BUFFER_SIZE) != SR_OK)
 			return SR_ERR;
-		}
-
-		tcp->length_bytes_read += len;
-
-		if (tcp->length_bytes_read < LENGTH_BYTES)
-			return 0;
-		else
-			tcp->response_length = RL32(tcp->length_buf);
+		memcpy(tcp->length_buf, tcp->rx_buf + tcp->rx_start,
+			LENGTH_BYTES);
+		tcp->rx_start += LENGTH_BYTES;
+		tcp->length_bytes_read = LENGTH_BYTES;
+		tcp->response_length = RL32(tcp->length_buf);
 	}
 
 	if (tcp->response_bytes_read >= tcp->response_length)
 		return SR_ERR;
 
-	len = recv(tcp->socket, buf, maxlen, 0);
-
-	if (len < 0) {
-		sr_err("Receive error: %s", g_strerror(errno));
-		return SR_ERR;
-	}
+	len = scpi_tcp_read_buffered(tcp, buf, maxlen,
+		tcp->response_length - tcp->response_bytes_read);
+	if (len < 0)
+		return len;
 
 	tcp->response_bytes_read += len;
 
 	return len;
 }
 
+static int scpi_tcp_raw_read_complete(void *priv)
+{
+	struct scpi_tcp *tcp = priv;
+
+	return tcp->complete || tcp->after_block;
+}
+
 static int scpi_tcp_read_complete(void *priv)
 {
 	struct scpi_tcp *tcp = priv;
@@ -242,6 +430,35 @@ static int scpi_tcp_read_complete(void *priv)
 			tcp->response_bytes_read >= tcp->response_length);
 }
 
+static void scpi_tcp_drain(void *priv)
+{
+	struct scpi_tcp *tcp = priv;
+	struct timeval tv;
+	fd_set fds;
+	char buf[256];
+	size_t num;
+	int len;
+
+	num = tcp->rx_end - tcp->rx_start;
+	tcp->rx_start = tcp->rx_end = 0;
+	tcp->in_block = FALSE;
+	tcp->after_block = FALSE;
+
+	while (TRUE) {
+		FD_ZERO(&fds);
+		FD_SET(tcp->socket, &fds);
+		tv.tv_sec = 0;
+		tv.tv_usec = SCPI_DRAIN_QUIET_US;
+		if (select(tcp->socket + 1, &fds, NULL, NULL, &tv) <= 0)
+			break;
+		if ((len = recv(tcp->socket, buf, sizeof(buf), 0)) <= 0)
+			break;
+		num += len;
+	}
+	if (num)
+		sr_dbg("Discarded %zu bytes of unread responses.", num);
+}
+
 static int scpi_tcp_close(struct sr_scpi_dev_inst *scpi)
 {
 	struct scpi_tcp *tcp = scpi->priv;
@@ -258,6 +475,7 @@ static void scpi_tcp_free(void *priv)
 
 	g_free(tcp->address);
 	g_free(tcp->port);
+	g_free(tcp->rx_buf);
 }
 
 SR_PRIV const struct sr_scpi_dev_inst scpi_tcp_raw_dev = {
@@ -272,9 +490,11 @@ SR_PRIV const struct sr_scpi_dev_inst scpi_tcp_raw_dev = {
 	.read_begin    = scpi_tcp_read_begin,
 	.read_data     = scpi_tcp_raw_read_data,
 	.write_data    = scpi_tcp_raw_write_data,
-	.read_complete = scpi_tcp_read_complete,
+	.read_complete = scpi_tcp_raw_read_complete,
+	.drain         = scpi_tcp_drain,
 	.close         = scpi_tcp_close,
 	.free          = scpi_tcp_free,
+	.pipelining    = TRUE,
 };
 
 SR_PRIV const struct sr_scpi_dev_inst scpi_tcp_rigol_dev = {
@@ -289,6 +509,8 @@ SR_PRIV const struct sr_scpi_dev_inst scpi_tcp_rigol_dev = {
 	.read_begin    = scpi_tcp_read_begin,
 	.read_data     = scpi_tcp_rigol_read_data,
 	.read_complete = scpi_tcp_read_complete,
+	.drain         = scpi_tcp_drain,
 	.close         = scpi_tcp_close,
 	.free          = scpi_tcp_free,
+	.pipelining    = TRUE,
 };
@@ -31,6 +31,11 @@
 #ifdef G_OS_WIN32
 #include <windows.h> /* for HANDLE */
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#endif
 
 /** @cond PRIVATE */
 #define LOG_PREFIX "serial"
@@ -78,6 +83,8 @@ SR_PRIV int serial_open(struct sr_serial_dev_inst *serial, int flags)
 
 	sr_spew("Opening serial port '%s' (flags %d).", serial->port, flags);
 
+	sr_scan_claim(serial->port);
+
 	sp_get_port_by_name(serial->port, &serial->data);
 
 	if (flags & SERIAL_RDWR)
@@ -90,12 +97,14 @@ SR_PRIV int serial_open(struct sr_serial_dev_inst *serial, int flags)
 	switch (ret) {
 	case SP_ERR_ARG:
 		sr_err("Attempt to open serial port with invalid parameters.");
+		sr_scan_release(serial->port);
 		return SR_ERR_ARG;
 	case SP_ERR_FAIL:
 		error = sp_last_error_message();
 		sr_err("Error opening port (%d): %s.",
 			sp_last_error_code(), error);
 		sp_free_error_message(error);
+		sr_scan_release(serial->port);
 		return SR_ERR;
 	}
 
@@ -132,7 +141,14 @@ SR_PRIV int serial_close(struct sr_serial_dev_inst *serial)
 
 	sr_spew("Closing serial port %s.", serial->port);
 
+	serial->rcv_head = serial->rcv_fill = 0;
+	if (serial->rcv_events) {
+		sp_free_event_set(serial->rcv_events);
+		serial->rcv_events = NULL;
+	}
+
 	ret = sp_close(serial->data);
+	sr_scan_release(serial->port);
 
 	switch (ret) {
 	case SP_ERR_ARG:
@@ -179,6 +195,7 @@ SR_PRIV int serial_flush(struct sr_serial_dev_inst *serial)
 
 	sr_spew("Flushing serial port %s.", serial->port);
 
+	serial->rcv_head = serial->rcv_fill = 0;
 	ret = sp_flush(serial->data, SP_BUF_BOTH);
 
 	switch (ret) {
@@ -313,7 +330,7 @@ SR_PRIV int serial_write_nonblocking(struct sr_serial_dev_inst *serial,
 	return _serial_write(serial, buf, count, 1, 0);
 }
 
-static int _serial_read(struct sr_serial_dev_inst *serial, void *buf,
+static int serial_read_port(struct sr_serial_dev_inst *serial, void *buf,
 		size_t count, int nonblocking, unsigned int timeout_ms)
 {
 	ssize_t ret;
@@ -351,6 +368,101 @@ static int _serial_read(struct sr_serial_dev_inst *serial, void *buf,
 	return ret;
 }
 
+/*
+ * Wait up to timeout_ms for receive data to become available, without
+ * consuming it. Falls back to a short sleep if the port can't be waited
+ * on, so that callers polling in a loop don't spin.
+ */
+static void serial_rcv_wait(struct sr_serial_dev_inst *serial,
+		unsigned int timeout_ms)
+{
+	/* Note: sp_wait() treats a timeout of 0 as infinite. */
+	if (timeout_ms == 0)
+		return;
+
+	if (!serial->rcv_events) {
+		if (sp_new_event_set(&serial->rcv_events) != SP_OK) {
+			serial->rcv_events = NULL;
+			goto fallback;
+		}
+		if (sp_add_port_events(serial->rcv_events, serial->data,
+				SP_EVENT_RX_READY) != SP_OK) {
+			sp_free_event_set(serial->rcv_events);
+			serial->rcv_events = NULL;
+			goto fallback;
+		}
+	}
+
+	if (sp_wait(serial->rcv_events, timeout_ms) == SP_OK)
+		return;
+
+fallback:
+	g_usleep(MIN(timeout_ms, 2) * 1000);
+}
+
+/*
+ * Read everything that is available into the read-ahead buffer. If
+ * nothing is, wait up to timeout_ms for the first byte to arrive.
+ */
+static int serial_rcv_fill(struct sr_serial_dev_inst *serial,
+		unsigned int timeout_ms)
+{
+	size_t avail;
+	int ret;
+
+	avail = serial->rcv_fill - serial->rcv_head;
+	if (serial->rcv_head > 0) {
+		memmove(serial->rcv_buffer,
+			serial->rcv_buffer + serial->rcv_head, avail);
+		serial->rcv_head = 0;
+		serial->rcv_fill = avail;
+	}
+	if (avail == sizeof(serial->rcv_buffer))
+		return 0;
+
+	ret = serial_read_port(serial, serial->rcv_buffer + avail,
+		sizeof(serial->rcv_buffer) - avail, 1, 0);
+	if (ret == 0) {
+		serial_rcv_wait(serial, timeout_ms);
+		ret = serial_read_port(serial, serial->rcv_buffer + avail,
+			sizeof(serial->rcv_buffer) - avail, 1, 0);
+	}
+	if (ret > 0)
+		serial->rcv_fill += ret;
+
+	return ret;
+}
+
+static int _serial_read(struct sr_serial_dev_inst *serial, void *buf,
+		size_t count, int nonblocking, unsigned int timeout_ms)
+{
+	size_t taken;
+	int ret;
+
+	if (!serial) {
+		sr_dbg("Invalid serial port.");
+		return SR_ERR;
+	}
+
+	/* Hand out data which line based readers have read ahead first. */
+	taken = MIN(count, serial->rcv_fill - serial->rcv_head);
+	if (taken > 0) {
+		memcpy(buf, serial->rcv_buffer + serial->rcv_head, taken);
+		serial->rcv_head += taken;
+		if (serial->rcv_head == serial->rcv_fill)
+			serial->rcv_head = serial->rcv_fill = 0;
+		if (taken == count)
+			return taken;
+	}
+
+	ret = serial_read_port(serial, (uint8_t *)buf + taken, count - taken,
+		nonblocking, timeout_ms);
+	if (ret < 0)
+		return taken ? (int)taken : ret;
+
+	return taken + ret;
+}
+
 /**
  * Read a number of bytes from the specified serial port, block until finished.
  *
@@ -601,6 +713,8 @@ SR_PRIV int serial_set_paramstr(struct sr_serial_dev_inst *serial,
  * @param[in] timeout_ms How long to wait for a line to come in.
  *
  * Reading stops when CR of LR is found, which is stripped from the buffer.
+ * All data which is available gets read at once. Data beyond the end of
+ * the line is kept for subsequent reads from the port.
  *
  * @retval SR_OK Success.
  * @retval SR_ERR Failure.
@@ -611,7 +725,8 @@ SR_PRIV int serial_readline(struct sr_serial_dev_inst *serial, char **buf,
 		int *buflen, gint64 timeout_ms)
 {
 	gint64 start, remaining;
-	int maxlen, len;
+	int maxlen;
+	char c;
 
 	if (!serial) {
 		sr_dbg("Invalid serial port.");
@@ -624,33 +739,28 @@ SR_PRIV int serial_readline(struct sr_serial_dev_inst *serial, char **buf,
 	}
 
 	start = g_get_monotonic_time();
-	remaining = timeout_ms;
 
 	maxlen = *buflen;
-	*buflen = len = 0;
-	while (1) {
-		len = maxlen - *buflen - 1;
-		if (len < 1)
-			break;
-		len = sp_blocking_read(serial->data, *buf + *buflen, 1, remaining);
-		if (len > 0) {
-			*buflen += len;
-			*(*buf + *buflen) = '\0';
-			if (*buflen > 0 && (*(*buf + *buflen - 1) == '\r'
-					|| *(*buf + *buflen - 1) == '\n')) {
-				/* Strip CR/LF and terminate. */
-				*(*buf + --*buflen) = '\0';
+	*buflen = 0;
+	while (*buflen < maxlen - 1) {
+		if (serial->rcv_head == serial->rcv_fill) {
+			/* Reduce timeout by time elapsed. */
+			remaining = timeout_ms - ((g_get_monotonic_time() - start) / 1000);
+			if (remaining <= 0)
+				/* Timeout */
 				break;
-			}
+			if (serial_rcv_fill(serial, remaining) < 0)
+				break;
+			continue;
 		}
-		/* Reduce timeout by time elapsed. */
-		remaining = timeout_ms - ((g_get_monotonic_time() - start) / 1000);
-		if (remaining <= 0)
-			/* Timeout */
+		c = serial->rcv_buffer[serial->rcv_head++];
+		if (c == '\r' || c == '\n')
+			/* Strip CR/LF. */
 			break;
-		if (len < 1)
-			g_usleep(2000);
+		*(*buf + (*buflen)++) = c;
 	}
+	if (maxlen > 0)
+		*(*buf + *buflen) = '\0';
 	if (*buflen)
 		sr_dbg("Received %d: '%s'.", *buflen, *buf);
 
@@ -667,9 +777,9 @@ SR_PRIV int serial_readline(struct sr_serial_dev_inst *serial, char **buf,
  * @param is_valid Callback that assesses whether the packet is valid or not.
  * @param[in] timeout_ms The timeout after which, if no packet is detected, to
  *                       abort scanning.
- * @param[in] baudrate The baudrate of the serial port. This parameter is not
- *                     critical, but it helps fine tune the serial port polling
- *                     delay.
+ * @param[in] baudrate The baudrate of the serial port. Only used for
+ *                     diagnostics, the routine waits for receive data
+ *                     instead of polling.
  *
  * @retval SR_OK Valid packet was found within the given timeout.
  * @retval SR_ERR Failure.
@@ -682,7 +792,7 @@ SR_PRIV int serial_stream_detect(struct sr_serial_dev_inst *serial,
 				 packet_valid_callback is_valid,
 				 uint64_t timeout_ms, int baudrate)
 {
-	uint64_t start, time, byte_delay_us;
+	uint64_t start, time;
 	size_t ibuf, i, maxlen;
 	ssize_t len;
 
@@ -696,13 +806,12 @@ SR_PRIV int serial_stream_detect(struct sr_serial_dev_inst *serial,
 		return SR_ERR;
 	}
 
-	/* Assume 8n1 transmission. That is 10 bits for every byte. */
-	byte_delay_us = 10 * ((1000 * 1000) / baudrate);
 	start = g_get_monotonic_time();
 
 	i = ibuf = len = 0;
 	while (ibuf < maxlen) {
-		len = serial_read_nonblocking(serial, &buf[ibuf], 1);
+		/* Take all data that is available, read-ahead data first. */
+		len = serial_read_nonblocking(serial, &buf[ibuf], maxlen - ibuf);
 		if (len > 0) {
 			ibuf += len;
 		} else if (len == 0) {
@@ -714,7 +823,7 @@ SR_PRIV int serial_stream_detect(struct sr_serial_dev_inst *serial,
 		time = g_get_monotonic_time() - start;
 		time /= 1000;
 
-		if ((ibuf - i) >= packet_size) {
+		while ((ibuf - i) >= packet_size) {
 			/* We have at least a packet's worth of data. */
 			if (is_valid(&buf[i])) {
 				sr_spew("Found valid %zu-byte packet after "
@@ -734,7 +843,7 @@ SR_PRIV int serial_stream_detect(struct sr_serial_dev_inst *serial,
 			break;
 		}
 		if (len < 1)
-			g_usleep(byte_delay_us);
+			serial_rcv_wait(serial, timeout_ms - time);
 	}
 
 	*buflen = ibuf;
@@ -795,6 +904,35 @@ typedef int event_handle;
 #endif
 /** @endcond */
 
+/*
+ * Invoke the receive callback of a port's event source. Data which was
+ * read ahead doesn't make the port poll readable, so keep invoking the
+ * callback for as long as such data is left and the callback consumes
+ * some of it.
+ */
+static int serial_rcv_dispatch(int fd, int revents, void *cb_data)
+{
+	struct sr_serial_dev_inst *serial;
+	size_t pending, left;
+	int ret;
+
+	serial = cb_data;
+	pending = SIZE_MAX;
+	while (1) {
+		ret = serial->rcv_cb(fd, revents, serial->rcv_cb_data);
+		/* The callback may have removed the source. */
+		if (ret == G_SOURCE_REMOVE || !serial->rcv_cb)
+			break;
+		left = serial->rcv_fill - serial->rcv_head;
+		if (left == 0 || left >= pending)
+			break;
+		pending = left;
+		revents = G_IO_IN;
+	}
+
+	return ret;
+}
+
 /** @private */
 SR_PRIV int serial_source_add(struct sr_session *session,
 		struct sr_serial_dev_inst *serial, int events, int timeout,
@@ -804,6 +942,7 @@ SR_PRIV int serial_source_add(struct sr_session *session,
 	gintptr poll_fd;
 	unsigned int poll_events;
 	enum sp_event mask = 0;
+	int ret;
 
 	if ((events & (G_IO_IN|G_IO_ERR)) && (events & G_IO_OUT)) {
 		sr_err("Cannot poll input/error and output simultaneously.");
@@ -849,14 +988,259 @@ SR_PRIV int serial_source_add(struct sr_session *session,
 	 * for the same serial port. However, these fixed keys will soon be
 	 * removed from the API anyway, so this is OK for now.
 	 */
-	return sr_session_fd_source_add(session, serial->data,
-			poll_fd, poll_events, timeout, cb, cb_data);
+	if (!(events & G_IO_IN))
+		return sr_session_fd_source_add(session, serial->data,
+				poll_fd, poll_events, timeout, cb, cb_data);
+
+	serial->rcv_cb = cb;
+	serial->rcv_cb_data = cb_data;
+	ret = sr_session_fd_source_add(session, serial->data, poll_fd,
+			poll_events, timeout, serial_rcv_dispatch, serial);
+	if (ret != SR_OK)
+		serial->rcv_cb = NULL;
+
+	return ret;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+/** @cond PRIVATE */
+#define SERIAL_REACTOR_TICK_MS		10
+#define SERIAL_REACTOR_MAX_EVENTS	64
+/** @endcond */
+
+struct serial_reactor_port {
+	struct sr_serial_dev_inst *serial;
+	int fd;
+	int64_t timeout_us;
+	int64_t due_us;
+	sr_receive_data_callback cb;
+	void *cb_data;
+};
+
+/*
+ * One epoll instance per session, which is the only event source the
+ * session's main loop polls for all ports that were added to it. A
+ * single wakeup then dispatches all ports that have data pending, no
+ * matter how many ports there are.
+ */
+struct serial_reactor {
+	struct sr_session *session;
+	int epfd;
+	GSList *ports;
+	gboolean dispatching;
+	gboolean empty;
+};
+
+static void serial_reactor_free(struct serial_reactor *reactor)
+{
+	reactor->session->serial_reactor = NULL;
+	close(reactor->epfd);
+	g_slist_free_full(reactor->ports, g_free);
+	g_free(reactor);
+}
+
+/* Remove the session source once the last port is gone. */
+static void serial_reactor_check_empty(struct serial_reactor *reactor)
+{
+	GSList *l;
+
+	for (l = reactor->ports; l; l = l->next) {
+		if (((struct serial_reactor_port *)l->data)->cb)
+			return;
+	}
+	if (reactor->empty)
+		return;
+	reactor->empty = TRUE;
+	sr_session_source_remove_internal(reactor->session, reactor);
+	if (!reactor->dispatching)
+		serial_reactor_free(reactor);
+}
+
+/* Detach a port, dispatch may still refer to it and releases it later. */
+static void serial_reactor_port_remove(struct serial_reactor *reactor,
+		struct serial_reactor_port *port)
+{
+	epoll_ctl(reactor->epfd, EPOLL_CTL_DEL, port->fd, NULL);
+	port->serial->rcv_cb = NULL;
+	port->cb = NULL;
+	if (!reactor->dispatching) {
+		reactor->ports = g_slist_remove(reactor->ports, port);
+		g_free(port);
+	}
+	serial_reactor_check_empty(reactor);
+}
+
+static int serial_reactor_dispatch(int fd, int revents, void *cb_data)
+{
+	struct serial_reactor *reactor;
+	struct serial_reactor_port *port;
+	struct epoll_event events[SERIAL_REACTOR_MAX_EVENTS];
+	GSList *l, *next;
+	int64_t now;
+	int i, num;
+
+	(void)fd;
+	(void)revents;
+
+	reactor = cb_data;
+	reactor->dispatching = TRUE;
+
+	num = epoll_wait(reactor->epfd, events, ARRAY_SIZE(events), 0);
+	now = g_get_monotonic_time();
+	for (i = 0; i < num; i++) {
+		port = events[i].data.ptr;
+		if (!port->cb)
+			continue;
+		port->due_us = now + port->timeout_us;
+		/* Callbacks detach by returning FALSE, as with serial_source_add(). */
+		if (!serial_rcv_dispatch(port->fd, G_IO_IN, port->serial)
+				&& port->cb)
+			serial_reactor_port_remove(reactor, port);
+	}
+
+	/* Timeouts, with the granularity of the reactor's tick. */
+	for (l = reactor->ports; l; l = l->next) {
+		port = l->data;
+		if (!port->cb || port->timeout_us < 0 || port->due_us > now)
+			continue;
+		port->due_us = now + port->timeout_us;
+		if (!serial_rcv_dispatch(port->fd, 0, port->serial) && port->cb)
+			serial_reactor_port_remove(reactor, port);
+	}
+
+	/* Release ports which were removed by their callbacks. */
+	for (l = reactor->ports; l; l = next) {
+		next = l->next;
+		port = l->data;
+		if (port->cb)
+			continue;
+		reactor->ports = g_slist_delete_link(reactor->ports, l);
+		g_free(port);
+	}
+
+	reactor->dispatching = FALSE;
+	if (reactor->empty) {
+		serial_reactor_free(reactor);
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+#endif
+
+/**
+ * Add a serial port to the session's shared serial reactor.
+ *
+ * This is a drop-in replacement for serial_source_add(), meant for
+ * drivers of which many devices may run in one session, such as
+ * multimeters. All ports share a single event source, backed by epoll,
+ * so the cost of a main loop iteration doesn't grow with the number of
+ * ports. The callback gets invoked with G_IO_IN when data is pending,
+ * or with 0 when timeout ms have passed without the port being
+ * dispatched. Timeouts have a granularity of 10 ms. A callback which
+ * returns FALSE gets detached.
+ *
+ * Where epoll is not available, this falls back to serial_source_add().
+ * In either case, the port gets removed with serial_source_remove().
+ *
+ * @private
+ */
+SR_PRIV int serial_reactor_add(struct sr_session *session,
+		struct sr_serial_dev_inst *serial, int events, int timeout,
+		sr_receive_data_callback cb, void *cb_data)
+{
+#ifdef HAVE_SYS_EPOLL_H
+	struct serial_reactor *reactor;
+	struct serial_reactor_port *port;
+	struct epoll_event ev;
+	int fd, ret;
+
+	if (events != G_IO_IN || sp_get_port_handle(serial->data, &fd) != SP_OK)
+		return serial_source_add(session, serial, events, timeout,
+			cb, cb_data);
+
+	if (!(reactor = session->serial_reactor)) {
+		reactor = g_malloc0(sizeof(*reactor));
+		reactor->session = session;
+		reactor->epfd = epoll_create1(EPOLL_CLOEXEC);
+		if (reactor->epfd < 0) {
+			sr_err("Failed to create epoll instance: %s.",
+				g_strerror(errno));
+			g_free(reactor);
+			return SR_ERR;
+		}
+		ret = sr_session_fd_source_add(session, reactor, reactor->epfd,
+			G_IO_IN, SERIAL_REACTOR_TICK_MS,
+			serial_reactor_dispatch, reactor);
+		if (ret != SR_OK) {
+			close(reactor->epfd);
+			g_free(reactor);
+			return ret;
+		}
+		session->serial_reactor = reactor;
+	}
+
+	port = g_malloc0(sizeof(*port));
+	port->serial = serial;
+	port->fd = fd;
+	port->timeout_us = (timeout >= 0) ? 1000 * (int64_t)timeout : -1;
+	port->due_us = g_get_monotonic_time() + port->timeout_us;
+	port->cb = cb;
+	port->cb_data = cb_data;
+	serial->rcv_cb = cb;
+	serial->rcv_cb_data = cb_data;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = port;
+	if (epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		sr_err("Failed to add port %s to epoll: %s.", serial->port,
+			g_strerror(errno));
+		g_free(port);
+		serial->rcv_cb = NULL;
+		serial_reactor_check_empty(reactor);
+		return SR_ERR;
+	}
+	reactor->ports = g_slist_append(reactor->ports, port);
+
+	return SR_OK;
+#else
+	return serial_source_add(session, serial, events, timeout, cb, cb_data);
+#endif
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+static int serial_reactor_remove(struct sr_session *session,
+		struct sr_serial_dev_inst *serial)
+{
+	struct serial_reactor *reactor;
+	struct serial_reactor_port *port;
+	GSList *l;
+
+	if (!(reactor = session->serial_reactor))
+		return SR_ERR_ARG;
+
+	for (l = reactor->ports; l; l = l->next) {
+		port = l->data;
+		if (port->serial != serial || !port->cb)
+			continue;
+		serial_reactor_port_remove(reactor, port);
+		return SR_OK;
+	}
+
+	return SR_ERR_ARG;
+}
+#endif
+
 /** @private */
 SR_PRIV int serial_source_remove(struct sr_session *session,
 		struct sr_serial_dev_inst *serial)
 {
+	serial->rcv_cb = NULL;
+#ifdef HAVE_SYS_EPOLL_H
+	if (serial_reactor_remove(session, serial) == SR_OK)
+		return SR_OK;
+#endif
 	return sr_session_source_remove_internal(session, serial->data);
 }
 
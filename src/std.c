@@ -571,7 +571,7 @@ SR_PRIV GSList *std_scan_complete(struct sr_dev_driver *di, GSList *devices)
 		sdi->driver = di;
 	}
 
-	drvc->instances = g_slist_concat(drvc->instances, g_slist_copy(devices));
+	sr_scan_instances_add(drvc, devices);
 
 	return devices;
 }
@@ -18,6 +18,9 @@
  */
 
 #include <config.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -321,6 +324,280 @@ SR_API int sr_parse_rational(const char *str, struct sr_rational *ret)
 	return SR_OK;
 }
 
+/* Number of separator characters in the first len bytes of str. */
+static size_t count_separators(const char *str, size_t len)
+{
+	size_t i, count;
+#ifdef __SSE2__
+	__m128i sep, acc, zero;
+	unsigned int n;
+
+	count = 0;
+	sep = _mm_set1_epi8(',');
+	zero = _mm_setzero_si128();
+	for (i = 0; i + 16 <= len; ) {
+		/* Byte counters, summed up before they can overflow. */
+		acc = _mm_setzero_si128();
+		for (n = 0; n < 255 && i + 16 <= len; n++, i += 16)
+			acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(sep,
+				_mm_loadu_si128((const __m128i *)(str + i))));
+		acc = _mm_sad_epu8(acc, zero);
+		count += _mm_cvtsi128_si32(acc)
+			+ _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+	}
+#else
+	count = 0;
+	i = 0;
+#endif
+
+	for (; i < len; i++)
+		if (str[i] == ',')
+			count++;
+
+	return count;
+}
+
+/* Powers of ten which are exactly representable as double. */
+static const double exact_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/*
+ * Parse one decimal floating point number at str, which must span all of
+ * the element up to end. Numbers with at most 19 significant digits,
+ * whose mantissa and power of ten are exact doubles, take a single
+ * correctly rounded multiplication or division (Clinger's fast path).
+ * Anything else goes through g_ascii_strtod(). Either way the result is
+ * the same as sr_atof_ascii() returns.
+ */
+static int parse_float(const char *str, const char *end, float *ret)
+{
+	const char *p;
+	char *endptr;
+	uint64_t mantissa;
+	double tmp;
+	int digits, any_digits, exponent, exp_digits, exp_value;
+	gboolean negative, exp_negative;
+
+	p = str;
+	while (p < end && g_ascii_isspace(*p))
+		p++;
+	negative = FALSE;
+	if (p < end && (*p == '+' || *p == '-'))
+		negative = *p++ == '-';
+
+	/* Significant digits, leading zeros don't count. */
+	mantissa = 0;
+	digits = 0;
+	any_digits = 0;
+	exponent = 0;
+	for (; p < end && g_ascii_isdigit(*p); p++, any_digits++) {
+		if (mantissa || *p != '0') {
+			mantissa = mantissa * 10 + (*p - '0');
+			digits++;
+		}
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && g_ascii_isdigit(*p); p++, any_digits++) {
+			if (mantissa || *p != '0') {
+				mantissa = mantissa * 10 + (*p - '0');
+				digits++;
+			}
+			exponent--;
+		}
+	}
+	if (!any_digits)
+		goto slow;
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		p++;
+		exp_negative = FALSE;
+		if (p < end && (*p == '+' || *p == '-'))
+			exp_negative = *p++ == '-';
+		exp_value = 0;
+		for (exp_digits = 0; p < end && g_ascii_isdigit(*p); p++) {
+			exp_value = MIN(exp_value * 10 + (*p - '0'), 10000);
+			exp_digits++;
+		}
+		if (!exp_digits)
+			goto slow;
+		exponent += exp_negative ? -exp_value : exp_value;
+	}
+
+	if (p != end || digits > 19 || mantissa > (UINT64_C(1) << 53)
+			|| exponent < -22 || exponent > 22)
+		goto slow;
+
+	tmp = mantissa;
+	if (exponent < 0)
+		tmp /= exact_pow10[-exponent];
+	else
+		tmp *= exact_pow10[exponent];
+	*ret = (float)(negative ? -tmp : tmp);
+
+	return SR_OK;
+
+slow:
+	errno = 0;
+	endptr = NULL;
+	tmp = g_ascii_strtod(str, &endptr);
+	if (endptr != end || endptr == str || errno)
+		return SR_ERR;
+	*ret = (float)tmp;
+
+	return SR_OK;
+}
+
+/* Parse one base 10 integer at str, which must span all of the element. */
+static int parse_int(const char *str, const char *end, int *ret)
+{
+	const char *p;
+	int64_t tmp;
+	gboolean negative;
+
+	p = str;
+	while (p < end && g_ascii_isspace(*p))
+		p++;
+	negative = FALSE;
+	if (p < end && (*p == '+' || *p == '-'))
+		negative = *p++ == '-';
+	if (p == end)
+		return SR_ERR;
+
+	tmp = 0;
+	for (; p < end; p++) {
+		if (!g_ascii_isdigit(*p))
+			return SR_ERR;
+		tmp = tmp * 10 + (*p - '0');
+		if (tmp > (int64_t)G_MAXINT + 1)
+			return SR_ERR;
+	}
+	if (negative)
+		tmp = -tmp;
+	if (tmp > G_MAXINT)
+		return SR_ERR;
+	*ret = tmp;
+
+	return SR_OK;
+}
+
+/**
+ * @private
+ *
+ * Convert a comma separated list of numeric values to floats.
+ *
+ * Elements are converted like sr_atof_ascii() does, ignoring the locale,
+ * but without splitting the string up first. Use this for long lists like
+ * ASCII waveform data.
+ *
+ * @param str The comma separated list. An empty string has no elements.
+ * @param values Array to store the values in, or NULL to only count the
+ *               elements.
+ * @param max The number of values the array has space for.
+ * @param count Pointer where to store the number of values stored (or
+ *              elements counted).
+ *
+ * @retval SR_OK All elements were converted.
+ * @retval SR_ERR_DATA Some elements are not valid numbers, or there were
+ *                     more than max elements. The valid values (up to max)
+ *                     are stored nonetheless.
+ * @retval SR_ERR_ARG Invalid argument.
+ */
+SR_PRIV int sr_parse_floatv(const char *str, float *values, size_t max,
+		size_t *count)
+{
+	const char *p, *end;
+	size_t len, n;
+	int ret;
+
+	if (!str || !count)
+		return SR_ERR_ARG;
+
+	len = strlen(str);
+	if (!values) {
+		*count = len ? count_separators(str, len) + 1 : 0;
+		return SR_OK;
+	}
+
+	ret = SR_OK;
+	n = 0;
+	for (p = str; len; p = end + 1) {
+		if (!(end = memchr(p, ',', str + len - p)))
+			end = str + len;
+		if (n == max) {
+			ret = SR_ERR_DATA;
+			break;
+		}
+		if (parse_float(p, end, &values[n]) == SR_OK)
+			n++;
+		else
+			ret = SR_ERR_DATA;
+		if (end == str + len)
+			break;
+	}
+	*count = n;
+
+	return ret;
+}
+
+/**
+ * @private
+ *
+ * Convert a comma separated list of integers to unsigned 8 bit values.
+ *
+ * Elements are converted like sr_atoi() does, and are then truncated to
+ * 8 bits.
+ *
+ * @param str The comma separated list. An empty string has no elements.
+ * @param values Array to store the values in, or NULL to only count the
+ *               elements.
+ * @param max The number of values the array has space for.
+ * @param count Pointer where to store the number of values stored (or
+ *              elements counted).
+ *
+ * @retval SR_OK All elements were converted.
+ * @retval SR_ERR_DATA Some elements are not valid integers, or there were
+ *                     more than max elements. The valid values (up to max)
+ *                     are stored nonetheless.
+ * @retval SR_ERR_ARG Invalid argument.
+ */
+SR_PRIV int sr_parse_uint8v(const char *str, uint8_t *values, size_t max,
+		size_t *count)
+{
+	const char *p, *end;
+	size_t len, n;
+	int ret, tmp;
+
+	if (!str || !count)
+		return SR_ERR_ARG;
+
+	len = strlen(str);
+	if (!values) {
+		*count = len ? count_separators(str, len) + 1 : 0;
+		return SR_OK;
+	}
+
+	ret = SR_OK;
+	n = 0;
+	for (p = str; len; p = end + 1) {
+		if (!(end = memchr(p, ',', str + len - p)))
+			end = str + len;
+		if (n == max) {
+			ret = SR_ERR_DATA;
+			break;
+		}
+		if (parse_int(p, end, &tmp) == SR_OK)
+			values[n++] = (uint8_t)tmp;
+		else
+			ret = SR_ERR_DATA;
+		if (end == str + len)
+			break;
+	}
+	*count = n;
+
+	return ret;
+}
+
 /**
  * Convert a numeric value value to its "natural" string representation
  * in SI units.
@@ -20,10 +20,16 @@
  */
 
 #include <config.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
 #include <glib.h>
 #include <libusb.h>
+#ifdef G_OS_UNIX
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
 
@@ -399,13 +405,18 @@ SR_PRIV int sr_usb_open(libusb_context *usb_ctx, struct sr_usb_dev_inst *usb)
 {
 	struct libusb_device **devlist;
 	struct libusb_device_descriptor des;
+	char conn[32];
 	int ret, r, cnt, i, a, b;
 
 	sr_dbg("Trying to open USB device %d.%d.", usb->bus, usb->address);
 
+	snprintf(conn, sizeof(conn), "usb/%d.%d", usb->bus, usb->address);
+	sr_scan_claim(conn);
+
 	if ((cnt = libusb_get_device_list(usb_ctx, &devlist)) < 0) {
 		sr_err("Failed to retrieve device list: %s.",
 		       libusb_error_name(cnt));
+		sr_scan_release(conn);
 		return SR_ERR;
 	}
 
@@ -436,15 +447,22 @@ SR_PRIV int sr_usb_open(libusb_context *usb_ctx, struct sr_usb_dev_inst *usb)
 	}
 
 	libusb_free_device_list(devlist, 1);
+	if (ret != SR_OK)
+		sr_scan_release(conn);
 
 	return ret;
 }
 
 SR_PRIV void sr_usb_close(struct sr_usb_dev_inst *usb)
 {
+	char conn[32];
+
 	libusb_close(usb->devhdl);
 	usb->devhdl = NULL;
 	sr_dbg("Closed USB device %d.%d.", usb->bus, usb->address);
+
+	snprintf(conn, sizeof(conn), "usb/%d.%d", usb->bus, usb->address);
+	sr_scan_release(conn);
 }
 
 SR_PRIV int usb_source_add(struct sr_session *session, struct sr_context *ctx,
@@ -470,6 +488,565 @@ SR_PRIV int usb_source_remove(struct sr_session *session, struct sr_context *ctx
 	return sr_session_source_remove_internal(session, ctx->libusb_ctx);
 }
 
+/** Number of slots in the ring of a USB event thread.
+ * Must be a power of two.
+ * @internal
+ */
+#define USB_THREAD_RING_MIN	16
+
+/** Single-producer single-consumer ring of completed transfers.
+ *
+ * The producer and the consumer each own one index, and only ever read
+ * the other side's index. With GLib's atomic accessors acting as full
+ * barriers, this needs no locking.
+ * @internal
+ */
+struct usb_thread_ring {
+	struct sr_usb_completion *slots;
+	unsigned int mask;
+	int head;
+	int tail;
+};
+
+/** Custom GLib event source for libusb I/O handled on a separate thread.
+ * @internal
+ */
+struct sr_usb_thread {
+	GSource base;
+
+	/* Needed to keep track of installed sources */
+	struct sr_session *session;
+
+	struct libusb_context *usb_ctx;
+	GThread *thread;
+	gboolean realtime;
+	int stop;
+	/* Set by usb_thread_abort(), stops resubmission of transfers. */
+	int abort;
+
+	/* Completed transfers, event thread -> session. */
+	struct usb_thread_ring ready;
+	/* Spare transfer buffers, session -> event thread. */
+	struct usb_thread_ring spare;
+	/* Capacity of each buffer, and the length to submit transfers with. */
+	size_t buffer_size;
+	int transfer_length;
+	/* Device handle for zero-copy buffers, or NULL for heap buffers. */
+	struct libusb_device_handle *devhdl;
+	/* Buffers from libusb_dev_mem_alloc(), others are heap memory. */
+	GHashTable *dev_mem_buffers;
+	/* Set once libusb_dev_mem_alloc() failed. */
+	gboolean dev_mem_exhausted;
+	/* Spare buffer kept back by the event thread after a failed submit. */
+	unsigned char *stash;
+
+	/* Transfers which completed while no spare buffer was available. */
+	int num_overruns;
+
+	sr_usb_completion_callback cb;
+	void *cb_data;
+};
+
+static void usb_thread_ring_init(struct usb_thread_ring *ring,
+		unsigned int min_slots)
+{
+	unsigned int size;
+
+	size = USB_THREAD_RING_MIN;
+	while (size < min_slots)
+		size <<= 1;
+
+	ring->slots = g_malloc0(size * sizeof(ring->slots[0]));
+	ring->mask = size - 1;
+	ring->head = 0;
+	ring->tail = 0;
+}
+
+/** Append an item to a ring. Only to be called by the producer side.
+ */
+static gboolean usb_thread_ring_push(struct usb_thread_ring *ring,
+		const struct sr_usb_completion *item)
+{
+	unsigned int head, tail;
+
+	head = g_atomic_int_get(&ring->head);
+	tail = g_atomic_int_get(&ring->tail);
+	if (head - tail > ring->mask)
+		return FALSE;
+
+	ring->slots[head & ring->mask] = *item;
+	g_atomic_int_set(&ring->head, head + 1);
+
+	return TRUE;
+}
+
+/** Take the oldest item from a ring. Only to be called by the consumer side.
+ */
+static gboolean usb_thread_ring_pop(struct usb_thread_ring *ring,
+		struct sr_usb_completion *item)
+{
+	unsigned int head, tail;
+
+	tail = g_atomic_int_get(&ring->tail);
+	head = g_atomic_int_get(&ring->head);
+	if (head == tail)
+		return FALSE;
+
+	*item = ring->slots[tail & ring->mask];
+	g_atomic_int_set(&ring->tail, tail + 1);
+
+	return TRUE;
+}
+
+static gboolean usb_thread_ring_empty(struct usb_thread_ring *ring)
+{
+	return g_atomic_int_get(&ring->head) == g_atomic_int_get(&ring->tail);
+}
+
+/** Raise the scheduling priority of the calling thread, if permitted.
+ */
+static void usb_thread_set_realtime(void)
+{
+#if defined(G_OS_UNIX) && defined(_POSIX_THREAD_PRIORITY_SCHEDULING) \
+		&& (_POSIX_THREAD_PRIORITY_SCHEDULING > 0)
+	struct sched_param param;
+	int ret;
+
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+
+	ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+	if (ret != 0)
+		sr_dbg("Cannot use real-time scheduling for USB event "
+			"thread: %s.", g_strerror(ret));
+#else
+	sr_dbg("Real-time scheduling not supported on this platform.");
+#endif
+}
+
+/** Check whether zero-copy buffers can be allocated for a device.
+ *
+ * @return @a devhdl if libusb_dev_mem_alloc() works, NULL otherwise.
+ */
+static struct libusb_device_handle *usb_thread_dev_mem_probe(
+		struct libusb_device_handle *devhdl, size_t size)
+{
+#if (LIBUSB_API_VERSION >= 0x01000105)
+	unsigned char *buf;
+
+	if (!devhdl)
+		return NULL;
+	/* Not all platforms and kernels support this. */
+	if (!(buf = libusb_dev_mem_alloc(devhdl, size))) {
+		sr_dbg("Zero-copy USB buffers not available.");
+		return NULL;
+	}
+	libusb_dev_mem_free(devhdl, buf, size);
+
+	return devhdl;
+#else
+	(void)devhdl;
+	(void)size;
+
+	return NULL;
+#endif
+}
+
+/** Main function of the USB event thread.
+ */
+static void *usb_thread_run(void *data)
+{
+	struct sr_usb_thread *uthread;
+	struct timeval tv;
+	int ret;
+
+	uthread = data;
+
+	if (uthread->realtime)
+		usb_thread_set_realtime();
+
+	while (!g_atomic_int_get(&uthread->stop)) {
+		/*
+		 * The timeout only bounds the time it takes to notice a
+		 * stop request on libusb versions that cannot interrupt
+		 * a thread waiting for events.
+		 */
+		tv.tv_sec = 0;
+		tv.tv_usec = 100000;
+		ret = libusb_handle_events_timeout_completed(uthread->usb_ctx,
+				&tv, &uthread->stop);
+		if (ret < 0 && ret != LIBUSB_ERROR_INTERRUPTED) {
+			sr_err("Failed to handle USB events: %s.",
+				libusb_error_name(ret));
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/** USB thread event source prepare() method.
+ */
+static gboolean usb_thread_prepare(GSource *source, int *timeout)
+{
+	struct sr_usb_thread *uthread;
+
+	uthread = (struct sr_usb_thread *)source;
+	*timeout = -1;
+
+	return !usb_thread_ring_empty(&uthread->ready);
+}
+
+/** USB thread event source check() method.
+ */
+static gboolean usb_thread_check(GSource *source)
+{
+	struct sr_usb_thread *uthread;
+
+	uthread = (struct sr_usb_thread *)source;
+
+	return !usb_thread_ring_empty(&uthread->ready);
+}
+
+/** USB thread event source dispatch() method.
+ *
+ * Hands all queued transfer completions to the driver, and recycles the
+ * buffers of those which have been resubmitted already.
+ */
+static gboolean usb_thread_dispatch(GSource *source,
+		GSourceFunc callback, void *user_data)
+{
+	struct sr_usb_thread *uthread;
+	struct sr_usb_completion item;
+
+	(void)callback;
+	(void)user_data;
+
+	uthread = (struct sr_usb_thread *)source;
+
+	while (!g_source_is_destroyed(source)
+			&& usb_thread_ring_pop(&uthread->ready, &item)) {
+		uthread->cb(&item, uthread->cb_data);
+		if (item.transfer)
+			continue;
+		/* The spare ring is sized to hold every buffer. */
+		item.length = 0;
+		usb_thread_ring_push(&uthread->spare, &item);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+/** USB thread event source finalize() method.
+ */
+static void usb_thread_finalize(GSource *source)
+{
+	struct sr_usb_thread *uthread;
+	struct sr_usb_completion item;
+
+	uthread = (struct sr_usb_thread *)source;
+
+	sr_spew("%s", __func__);
+
+	if (uthread->thread) {
+		g_atomic_int_set(&uthread->stop, 1);
+#if (LIBUSB_API_VERSION >= 0x01000105)
+		libusb_interrupt_event_handler(uthread->usb_ctx);
+#endif
+		g_thread_join(uthread->thread);
+		uthread->thread = NULL;
+	}
+
+	if (uthread->num_overruns > 0)
+		sr_dbg("%d transfers completed without a spare buffer.",
+			uthread->num_overruns);
+
+	if (uthread->ready.slots) {
+		while (usb_thread_ring_pop(&uthread->ready, &item)) {
+			if (!item.transfer)
+				usb_thread_buffer_free(uthread, item.buffer);
+		}
+	}
+	if (uthread->spare.slots) {
+		while (usb_thread_ring_pop(&uthread->spare, &item))
+			usb_thread_buffer_free(uthread, item.buffer);
+	}
+	if (uthread->stash)
+		usb_thread_buffer_free(uthread, uthread->stash);
+	if (uthread->dev_mem_buffers)
+		g_hash_table_destroy(uthread->dev_mem_buffers);
+	g_free(uthread->ready.slots);
+	g_free(uthread->spare.slots);
+
+	if (uthread->session)
+		sr_session_source_destroyed(uthread->session,
+				uthread->usb_ctx, source);
+}
+
+/**
+ * Add an event source which handles libusb events on a separate thread.
+ *
+ * Unlike usb_source_add(), transfers complete on a dedicated thread, so
+ * that resubmission does not depend on how quickly the session main loop
+ * gets around to process them. The driver's transfer callback must hand
+ * each completed transfer to usb_thread_transfer_done(), and @a cb will
+ * then be invoked from the session main loop with the transfer data.
+ *
+ * All transfers handed to the event thread must use buffers obtained
+ * from usb_thread_buffer_alloc(). Buffers are exchanged between the
+ * transfers and the pool of spare buffers, so the driver must release
+ * transfer->buffer with usb_thread_buffer_free().
+ *
+ * If @a devhdl is not NULL, buffers are allocated with
+ * libusb_dev_mem_alloc() where supported, which lets the kernel DMA
+ * directly into them. Otherwise heap memory is used, as it is for all
+ * buffers allocated once the kernel's zero-copy memory runs out.
+ *
+ * The source is removed with usb_source_remove().
+ *
+ * @param session The session the event source belongs to.
+ * @param ctx The sigrok context whose libusb context to handle events for.
+ * @param num_transfers The maximum number of transfers in flight.
+ * @param devhdl The device handle to allocate buffers for. Can be NULL.
+ * @param buffer_size The capacity of each transfer buffer in bytes.
+ *                    This is also the initial transfer length.
+ * @param num_spare Number of spare buffers to allocate.
+ * @param realtime Whether to request real-time scheduling for the thread.
+ * @param cb Callback to invoke on the session thread for each completion.
+ * @param cb_data User data to pass to @a cb.
+ * @param uthread Will be set to the new event thread handle on success.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_MALLOC Out of memory.
+ * @retval SR_ERR Other error.
+ */
+SR_PRIV int usb_thread_source_add(struct sr_session *session,
+		struct sr_context *ctx, unsigned int num_transfers,
+		struct libusb_device_handle *devhdl, size_t buffer_size,
+		unsigned int num_spare, gboolean realtime,
+		sr_usb_completion_callback cb, void *cb_data,
+		struct sr_usb_thread **uthread)
+{
+	static GSourceFuncs usb_thread_funcs = {
+		.prepare  = &usb_thread_prepare,
+		.check    = &usb_thread_check,
+		.dispatch = &usb_thread_dispatch,
+		.finalize = &usb_thread_finalize
+	};
+	GSource *source;
+	struct sr_usb_thread *ut;
+	struct sr_usb_completion item;
+	GError *error;
+	unsigned int i;
+	int ret;
+
+	source = g_source_new(&usb_thread_funcs, sizeof(struct sr_usb_thread));
+	ut = (struct sr_usb_thread *)source;
+
+	g_source_set_name(source, "usb-thread");
+
+	ut->usb_ctx = ctx->libusb_ctx;
+	ut->realtime = realtime;
+	ut->stop = 0;
+	ut->abort = 0;
+	ut->buffer_size = buffer_size;
+	ut->transfer_length = (int)buffer_size;
+	ut->devhdl = usb_thread_dev_mem_probe(devhdl, buffer_size);
+	if (ut->devhdl)
+		ut->dev_mem_buffers = g_hash_table_new(NULL, NULL);
+	ut->dev_mem_exhausted = FALSE;
+	ut->num_overruns = 0;
+	ut->cb = cb;
+	ut->cb_data = cb_data;
+
+	/* Every transfer may be retired while all spares are queued. */
+	usb_thread_ring_init(&ut->ready, num_transfers + num_spare);
+	usb_thread_ring_init(&ut->spare, num_transfers + num_spare);
+
+	memset(&item, 0, sizeof(item));
+	for (i = 0; i < num_spare; i++) {
+		if (!(item.buffer = usb_thread_buffer_alloc(ut))) {
+			sr_err("USB spare buffer malloc failed.");
+			g_source_unref(source);
+			return SR_ERR_MALLOC;
+		}
+		usb_thread_ring_push(&ut->spare, &item);
+	}
+
+	error = NULL;
+	ut->thread = g_thread_try_new("usb-events", usb_thread_run, ut, &error);
+	if (!ut->thread) {
+		sr_err("Failed to start USB event thread: %s.", error->message);
+		g_error_free(error);
+		g_source_unref(source);
+		return SR_ERR;
+	}
+
+	/* From here on, finalize() unregisters the source. */
+	ut->session = session;
+
+	ret = sr_session_source_add_internal(session, ctx->libusb_ctx, source);
+	g_source_unref(source);
+
+	if (ret == SR_OK)
+		*uthread = ut;
+
+	return ret;
+}
+
+/**
+ * Hand a completed transfer over to the session main loop.
+ *
+ * This is meant to be called from the driver's transfer callback, which
+ * runs on the USB event thread. If the transfer completed successfully
+ * and a spare buffer is available, the data buffer is queued for the
+ * session and the transfer is resubmitted right away with the spare
+ * buffer. Otherwise the transfer itself is queued, and the completion
+ * callback becomes responsible for resubmitting or freeing it.
+ *
+ * @param uthread The event thread handle.
+ * @param transfer The completed transfer.
+ */
+SR_PRIV void usb_thread_transfer_done(struct sr_usb_thread *uthread,
+		struct libusb_transfer *transfer)
+{
+	struct sr_usb_completion item, spare;
+	int ret;
+
+	item.transfer = transfer;
+	item.buffer = transfer->buffer;
+	item.length = transfer->actual_length;
+	item.status = transfer->status;
+	item.user_data = transfer->user_data;
+
+	if (item.length > 0 && !g_atomic_int_get(&uthread->abort)
+			&& !g_atomic_int_get(&uthread->stop)
+			&& (item.status == LIBUSB_TRANSFER_COMPLETED
+			|| item.status == LIBUSB_TRANSFER_TIMED_OUT)) {
+		if (uthread->stash) {
+			spare.buffer = uthread->stash;
+			uthread->stash = NULL;
+		} else if (!usb_thread_ring_pop(&uthread->spare, &spare)) {
+			spare.buffer = NULL;
+			g_atomic_int_inc(&uthread->num_overruns);
+		}
+		if (spare.buffer) {
+			transfer->buffer = spare.buffer;
+			transfer->length = g_atomic_int_get(
+					&uthread->transfer_length);
+			ret = libusb_submit_transfer(transfer);
+			if (ret == LIBUSB_SUCCESS) {
+				item.transfer = NULL;
+			} else {
+				sr_err("%s: %s", __func__,
+					libusb_error_name(ret));
+				/* Keep the spare, retire the transfer. */
+				transfer->buffer = item.buffer;
+				uthread->stash = spare.buffer;
+			}
+		}
+	}
+
+	usb_thread_ring_push(&uthread->ready, &item);
+	g_main_context_wakeup(g_source_get_context(&uthread->base));
+}
+
+/**
+ * Stop a USB event thread from resubmitting transfers.
+ *
+ * Transfers which complete after this call are queued for the completion
+ * callback, which then has to free them. This must be called before the
+ * driver cancels its transfers. Otherwise a transfer which completes
+ * while they are being cancelled could be resubmitted behind the
+ * driver's back, and stay in flight.
+ *
+ * @param uthread The event thread handle.
+ */
+SR_PRIV void usb_thread_abort(struct sr_usb_thread *uthread)
+{
+	g_atomic_int_set(&uthread->abort, 1);
+}
+
+/**
+ * Allocate a transfer buffer for use with a USB event thread.
+ *
+ * Zero-copy memory is limited (see usbfs_memory_mb), so once
+ * libusb_dev_mem_alloc() fails, this and all further buffers of the
+ * event thread come from the heap.
+ *
+ * @param uthread The event thread handle.
+ *
+ * @return A buffer of the capacity passed to usb_thread_source_add(),
+ *         or NULL if out of memory.
+ */
+SR_PRIV unsigned char *usb_thread_buffer_alloc(struct sr_usb_thread *uthread)
+{
+#if (LIBUSB_API_VERSION >= 0x01000105)
+	unsigned char *buf;
+
+	if (uthread->devhdl && !uthread->dev_mem_exhausted) {
+		buf = libusb_dev_mem_alloc(uthread->devhdl,
+				uthread->buffer_size);
+		if (buf) {
+			g_hash_table_add(uthread->dev_mem_buffers, buf);
+			return buf;
+		}
+		sr_dbg("Zero-copy USB buffers exhausted after %u, "
+			"using heap memory.",
+			g_hash_table_size(uthread->dev_mem_buffers));
+		uthread->dev_mem_exhausted = TRUE;
+	}
+#endif
+	return g_try_malloc(uthread->buffer_size);
+}
+
+/**
+ * Release a transfer buffer allocated by usb_thread_buffer_alloc().
+ *
+ * @param uthread The event thread handle.
+ * @param buffer The buffer to release. Can be NULL.
+ */
+SR_PRIV void usb_thread_buffer_free(struct sr_usb_thread *uthread,
+		unsigned char *buffer)
+{
+	if (!buffer)
+		return;
+#if (LIBUSB_API_VERSION >= 0x01000105)
+	if (uthread->dev_mem_buffers
+			&& g_hash_table_remove(uthread->dev_mem_buffers, buffer)) {
+		libusb_dev_mem_free(uthread->devhdl, buffer,
+				uthread->buffer_size);
+		return;
+	}
+#endif
+	g_free(buffer);
+}
+
+/**
+ * Change the length of transfers resubmitted by a USB event thread.
+ *
+ * @param uthread The event thread handle.
+ * @param length The new transfer length in bytes. Must not exceed the
+ *               buffer capacity passed to usb_thread_source_add().
+ */
+SR_PRIV void usb_thread_set_transfer_length(struct sr_usb_thread *uthread,
+		size_t length)
+{
+	length = MIN(length, uthread->buffer_size);
+	g_atomic_int_set(&uthread->transfer_length, (int)length);
+}
+
+/**
+ * Get the number of transfers which completed while no spare buffer was
+ * available, i.e. which had to wait for the session to catch up.
+ *
+ * @param uthread The event thread handle.
+ */
+SR_PRIV unsigned int usb_thread_get_overruns(struct sr_usb_thread *uthread)
+{
+	return g_atomic_int_get(&uthread->num_overruns);
+}
+
 SR_PRIV int usb_get_port_path(libusb_device *dev, char *path, int path_len)
 {
 	uint8_t port_numbers[8];
@@ -85,6 +85,84 @@ START_TEST(test_analog_to_float)
 }
 END_TEST
 
+START_TEST(test_analog_to_float_u8)
+{
+	int ret;
+	unsigned int i;
+	uint8_t data[100];
+	float fout[100];
+	struct sr_channel ch;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+
+	sr_analog_init_(&analog, &encoding, &meaning, &spec, 2);
+	encoding.unitsize = 1;
+	encoding.is_float = FALSE;
+	encoding.is_signed = FALSE;
+	sr_rational_set(&encoding.scale, 5, 64);
+	sr_rational_set(&encoding.offset, -10, 1);
+	analog.num_samples = ARRAY_SIZE(data);
+	analog.data = data;
+	meaning.channels = g_slist_append(NULL, &ch);
+
+	for (i = 0; i < ARRAY_SIZE(data); i++)
+		data[i] = i * 53;
+
+	ret = sr_analog_to_float(&analog, fout);
+	fail_unless(ret == SR_OK, "sr_analog_to_float() failed: %d.", ret);
+	for (i = 0; i < ARRAY_SIZE(data); i++)
+		fail_unless(fout[i] == (data[i] - 128.0f) / 12.8f,
+			"%f != %f (i=%d)", fout[i], (data[i] - 128.0f) / 12.8f, i);
+
+	g_slist_free(meaning.channels);
+}
+END_TEST
+
+/* Signed 16-bit little-endian samples, starting at an odd address. */
+START_TEST(test_analog_to_float_s16)
+{
+	int ret;
+	unsigned int i;
+	uint8_t data[2 * 101 + 1];
+	int16_t v;
+	float fout[101], expected;
+	struct sr_channel ch;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+
+	sr_analog_init_(&analog, &encoding, &meaning, &spec, 2);
+	encoding.unitsize = 2;
+	encoding.is_float = FALSE;
+	encoding.is_signed = TRUE;
+	encoding.is_bigendian = FALSE;
+	sr_rational_set(&encoding.scale, 1, 256);
+	sr_rational_set(&encoding.offset, -1, 2);
+	analog.num_samples = ARRAY_SIZE(fout);
+	analog.data = data + 1;
+	meaning.channels = g_slist_append(NULL, &ch);
+
+	for (i = 0; i < ARRAY_SIZE(fout); i++) {
+		v = i * 661 - 32768;
+		data[1 + 2 * i] = v & 0xff;
+		data[2 + 2 * i] = (v >> 8) & 0xff;
+	}
+
+	ret = sr_analog_to_float(&analog, fout);
+	fail_unless(ret == SR_OK, "sr_analog_to_float() failed: %d.", ret);
+	for (i = 0; i < ARRAY_SIZE(fout); i++) {
+		expected = (int16_t)(i * 661 - 32768) / 256.0f - 0.5f;
+		fail_unless(fout[i] == expected, "%f != %f (i=%d)", fout[i],
+			expected, i);
+	}
+
+	g_slist_free(meaning.channels);
+}
+END_TEST
+
 START_TEST(test_analog_to_float_null)
 {
 	int ret;
@@ -383,6 +461,8 @@ Suite *suite_analog(void)
 
 	tc = tcase_create("analog_to_float");
 	tcase_add_test(tc, test_analog_to_float);
+	tcase_add_test(tc, test_analog_to_float_u8);
+	tcase_add_test(tc, test_analog_to_float_s16);
 	tcase_add_test(tc, test_analog_to_float_null);
 	tcase_add_test(tc, test_analog_si_prefix);
 	tcase_add_test(tc, test_analog_si_prefix_null);
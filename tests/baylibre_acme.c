@@ -0,0 +1,329 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <check.h>
+#include <glib/gstdio.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#if defined(HAVE_HW_BAYLIBRE_ACME)
+
+#define NUM_SAMPLES	100
+#define SAMPLERATE	500
+
+#define IIO_DEV		"sys/bus/iio/devices/iio:device0/"
+
+/*
+ * Fake sysfs tree of an ACME cape with two energy probes: probe 1 bound
+ * to the ina226 hwmon driver, probe 2 to the ina2xx IIO driver. Both
+ * read 1.5 W, 0.3 A and 5 V. The IIO probe's raw attributes read 1 V,
+ * so that buffered and attribute reads can be told apart.
+ */
+static const struct {
+	const char *path;
+	const char *contents;
+} fake_files[] = {
+	{ "sys/class/i2c-adapter/i2c-1/1-0040/name", "ina226\n" },
+	{ "sys/class/i2c-adapter/i2c-1/1-0040/hwmon/hwmon3/name", "ina226\n" },
+	{ "sys/class/hwmon/hwmon3/power1_input", "1500000\n" },
+	{ "sys/class/hwmon/hwmon3/curr1_input", "300\n" },
+	{ "sys/class/hwmon/hwmon3/in1_input", "5000\n" },
+	{ "sys/class/hwmon/hwmon3/shunt_resistor", "10000\n" },
+	{ "sys/class/hwmon/hwmon3/update_interval", "1\n" },
+	{ "sys/class/i2c-adapter/i2c-1/1-0041/name", "ina226\n" },
+	{ "sys/class/i2c-adapter/i2c-1/1-0041/iio:device0/name", "ina226\n" },
+	{ IIO_DEV "in_voltage1_raw", "800\n" },
+	{ IIO_DEV "in_voltage1_scale", "1.250000000\n" },
+	{ IIO_DEV "in_power2_raw", "60\n" },
+	{ IIO_DEV "in_power2_scale", "25\n" },
+	{ IIO_DEV "in_current3_raw", "300\n" },
+	{ IIO_DEV "in_current3_scale", "1\n" },
+	{ IIO_DEV "in_shunt_resistor", "10000\n" },
+	{ IIO_DEV "scan_elements/in_voltage0_en", "0\n" },
+	{ IIO_DEV "scan_elements/in_voltage0_index", "0\n" },
+	{ IIO_DEV "scan_elements/in_voltage0_type", "le:s16/16>>0\n" },
+	{ IIO_DEV "scan_elements/in_voltage1_en", "0\n" },
+	{ IIO_DEV "scan_elements/in_voltage1_index", "1\n" },
+	{ IIO_DEV "scan_elements/in_voltage1_type", "le:u16/16>>0\n" },
+	{ IIO_DEV "scan_elements/in_power2_en", "0\n" },
+	{ IIO_DEV "scan_elements/in_power2_index", "2\n" },
+	{ IIO_DEV "scan_elements/in_power2_type", "le:u16/16>>0\n" },
+	{ IIO_DEV "scan_elements/in_current3_en", "0\n" },
+	{ IIO_DEV "scan_elements/in_current3_index", "3\n" },
+	{ IIO_DEV "scan_elements/in_current3_type", "le:s16/16>>0\n" },
+	{ IIO_DEV "scan_elements/in_timestamp_en", "1\n" },
+	{ IIO_DEV "scan_elements/in_timestamp_index", "4\n" },
+	{ IIO_DEV "scan_elements/in_timestamp_type", "le:s64/64>>0\n" },
+	{ IIO_DEV "buffer/enable", "0\n" },
+	{ IIO_DEV "buffer/length", "2\n" },
+};
+
+static void fake_file(const char *root, const char *path, const char *contents,
+		gssize len)
+{
+	char *name, *dir;
+
+	name = g_build_filename(root, path, NULL);
+	dir = g_path_get_dirname(name);
+	g_mkdir_with_parents(dir, 0755);
+	fail_unless(g_file_set_contents(name, contents, len, NULL),
+		"Failed to create %s.", name);
+	g_free(dir);
+	g_free(name);
+}
+
+static char *fake_read(const char *root, const char *path)
+{
+	char *name, *contents;
+
+	name = g_build_filename(root, path, NULL);
+	contents = NULL;
+	g_file_get_contents(name, &contents, NULL, NULL);
+	g_free(name);
+
+	return contents;
+}
+
+/* Revision B probe EEPROM: type USB, no shunt value, no power switch. */
+static void fake_eeprom(const char *root, unsigned int addr)
+{
+	char path[64], eeprom[61];
+
+	memset(eeprom, 0, sizeof(eeprom));
+	eeprom[3] = 1;
+	eeprom[7] = 'B';
+	snprintf(path, sizeof(path),
+		"sys/class/i2c-dev/i2c-1/device/1-00%02x/eeprom", addr + 0x10);
+	fake_file(root, path, eeprom, sizeof(eeprom));
+}
+
+/*
+ * Buffered scans of the IIO probe: bus voltage, power and current, the
+ * last one being current.
+ */
+static void fake_scans(const char *root)
+{
+	static const uint8_t scans[] = {
+		0x10, 0x00, 0x20, 0x00, 0x30, 0x00,
+		0x11, 0x00, 0x21, 0x00, 0x31, 0x00,
+		0xa0, 0x0f, 0x3c, 0x00, 0x2c, 0x01,
+	};
+
+	fake_file(root, "dev/iio:device0", (const char *)scans, sizeof(scans));
+}
+
+static char *fake_tree(void)
+{
+	char *root;
+	unsigned int i;
+
+	root = g_dir_make_tmp("acme-XXXXXX", NULL);
+	fail_unless(root != NULL, "Failed to create the fake sysfs tree.");
+	for (i = 0; i < G_N_ELEMENTS(fake_files); i++)
+		fake_file(root, fake_files[i].path, fake_files[i].contents, -1);
+	fake_eeprom(root, 0x40);
+	fake_eeprom(root, 0x41);
+
+	return root;
+}
+
+static void remove_tree(const char *path)
+{
+	GDir *dir;
+	const char *name;
+	char *child;
+
+	if ((dir = g_dir_open(path, 0, NULL))) {
+		while ((name = g_dir_read_name(dir))) {
+			child = g_build_filename(path, name, NULL);
+			remove_tree(child);
+			g_free(child);
+		}
+		g_dir_close(dir);
+	}
+	g_remove(path);
+}
+
+static void fake_tree_remove(char *root)
+{
+	remove_tree(root);
+	g_free(root);
+}
+
+/* Power, current and voltage of the hwmon probe. */
+static const float hwmon_values[] = { 1.5, 0.3, 5.0 };
+
+struct received {
+	/* Same, of the IIO probe. */
+	float expected[3];
+	unsigned int frames;
+	unsigned int packets;
+	gboolean mismatch;
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_analog *analog;
+	struct received *rx;
+	float values[2];
+	int i;
+
+	(void)sdi;
+
+	rx = cb_data;
+	if (packet->type == SR_DF_FRAME_END)
+		rx->frames++;
+	if (packet->type != SR_DF_ANALOG)
+		return;
+
+	rx->packets++;
+	analog = packet->payload;
+	if (g_slist_length(analog->meaning->channels) != 2
+			|| analog->num_samples != 1) {
+		rx->mismatch = TRUE;
+		return;
+	}
+
+	sr_analog_to_float(analog, values);
+	if (analog->meaning->mq == SR_MQ_POWER)
+		i = 0;
+	else if (analog->meaning->mq == SR_MQ_CURRENT)
+		i = 1;
+	else
+		i = 2;
+	if (fabsf(values[0] - hwmon_values[i]) > 1e-5
+			|| fabsf(values[1] - rx->expected[i]) > 1e-5)
+		rx->mismatch = TRUE;
+}
+
+static void run_acquisition(const char *root, float voltage)
+{
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	struct sr_session *session;
+	struct received rx;
+	struct sr_config src;
+	GSList *options, *devices;
+	char *contents;
+	int ret;
+
+	driver = srtest_driver_get("baylibre-acme");
+	srtest_driver_init(srtest_ctx, driver);
+	/* Have the driver look up sysfs in the fake tree. */
+	src.key = SR_CONF_CONN;
+	src.data = g_variant_ref_sink(g_variant_new_string(root));
+	options = g_slist_append(NULL, &src);
+	devices = sr_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(src.data);
+	fail_unless(devices != NULL, "Fake ACME not detected.");
+	sdi = devices->data;
+	g_slist_free(devices);
+	fail_unless(g_slist_length(sr_dev_inst_channel_groups_get(sdi)) == 2,
+		"Expected two probes.");
+
+	ret = sr_session_new(srtest_ctx, &session);
+	fail_unless(ret == SR_OK, "sr_session_new() failed: %d.", ret);
+	ret = sr_session_dev_add(session, sdi);
+	fail_unless(ret == SR_OK, "sr_session_dev_add() failed: %d.", ret);
+	ret = sr_dev_open(sdi);
+	fail_unless(ret == SR_OK, "sr_dev_open() failed: %d.", ret);
+	ret = sr_config_set(sdi, NULL, SR_CONF_SAMPLERATE,
+		g_variant_new_uint64(SAMPLERATE));
+	fail_unless(ret == SR_OK, "Failed to set samplerate: %d.", ret);
+	ret = sr_config_set(sdi, NULL, SR_CONF_LIMIT_SAMPLES,
+		g_variant_new_uint64(NUM_SAMPLES));
+	fail_unless(ret == SR_OK, "Failed to set sample limit: %d.", ret);
+
+	memset(&rx, 0, sizeof(rx));
+	rx.expected[0] = 1.5;
+	rx.expected[1] = 0.3;
+	rx.expected[2] = voltage;
+	sr_session_datafeed_callback_add(session, datafeed_in, &rx);
+	ret = sr_session_start(session);
+	fail_unless(ret == SR_OK, "sr_session_start() failed: %d.", ret);
+	ret = sr_session_run(session);
+	fail_unless(ret == SR_OK, "sr_session_run() failed: %d.", ret);
+
+	fail_unless(rx.frames >= NUM_SAMPLES, "Received %u samples.", rx.frames);
+	fail_unless(rx.packets == 3 * rx.frames,
+		"Received %u packets for %u samples.", rx.packets, rx.frames);
+	fail_unless(!rx.mismatch, "Received data does not match.");
+
+	sr_dev_close(sdi);
+	sr_session_destroy(session);
+
+	/* The IIO buffer is set up, and disabled again. */
+	contents = fake_read(root, IIO_DEV "buffer/enable");
+	fail_unless(contents && atoi(contents) == 0, "Buffer left enabled.");
+	g_free(contents);
+	contents = fake_read(root, IIO_DEV "scan_elements/in_timestamp_en");
+	fail_unless(contents && atoi(contents) == (voltage == 5.0 ? 0 : 1),
+		"Unexpected timestamp scan element state.");
+	g_free(contents);
+}
+
+/* Check samples of hwmon and buffered IIO probes. */
+START_TEST(test_buffered)
+{
+	char *root;
+
+	root = fake_tree();
+	fake_scans(root);
+	run_acquisition(root, 5.0);
+	fake_tree_remove(root);
+}
+END_TEST
+
+/* Without the IIO device node, the probe's attributes are read. */
+START_TEST(test_attributes)
+{
+	char *root;
+
+	root = fake_tree();
+	run_acquisition(root, 1.0);
+	fake_tree_remove(root);
+}
+END_TEST
+
+#endif
+
+Suite *suite_baylibre_acme(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("baylibre-acme");
+
+	tc = tcase_create("sampling");
+#if defined(HAVE_HW_BAYLIBRE_ACME)
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_buffered);
+	tcase_add_test(tc, test_attributes);
+#endif
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,260 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#if defined(HAVE_HW_BEAGLELOGIC) && !defined(_WIN32)
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define NUM_SAMPLES	(4 * 1024 * 1024)
+
+/*
+ * Minimal stand-in for a BeagleLogic TCP server. It answers the queries
+ * the driver issues, and streams a counting pattern upon "get". It
+ * serves the scan connection and the device connection, then exits.
+ */
+struct server {
+	int listen_fd;
+	int port;
+	GThread *thread;
+};
+
+static void server_reply(int fd, const char *reply)
+{
+	ssize_t ret;
+
+	ret = send(fd, reply, strlen(reply), 0);
+	(void)ret;
+}
+
+static void server_stream(int fd)
+{
+	uint8_t buf[64 * 1024];
+	size_t i, sent, len;
+	ssize_t ret;
+
+	for (sent = 0; sent < NUM_SAMPLES; sent += ret) {
+		len = MIN(sizeof(buf), NUM_SAMPLES - sent);
+		for (i = 0; i < len; i++)
+			buf[i] = (sent + i) & 0xff;
+		if ((ret = send(fd, buf, len, 0)) <= 0)
+			return;
+	}
+}
+
+static void server_command(int fd, const char *cmd)
+{
+	if (!strcmp(cmd, "version"))
+		server_reply(fd, "BeagleLogic 1.0\n");
+	else if (!strcmp(cmd, "memalloc"))
+		server_reply(fd, "33554432\n");
+	else if (!strcmp(cmd, "samplerate"))
+		server_reply(fd, "100000000\n");
+	else if (!strcmp(cmd, "sampleunit"))
+		server_reply(fd, "1\n");
+	else if (!strcmp(cmd, "triggerflags"))
+		server_reply(fd, "0\n");
+	else if (!strcmp(cmd, "bufunitsize"))
+		server_reply(fd, "4194304\n");
+	else if (!strcmp(cmd, "get"))
+		server_stream(fd);
+	else if (strchr(cmd, ' '))
+		server_reply(fd, "ok\n");
+}
+
+static gpointer server_thread(gpointer data)
+{
+	struct server *srv;
+	char buf[256], *line, *nl;
+	size_t fill;
+	ssize_t len;
+	int fd, conn;
+
+	srv = data;
+	for (conn = 0; conn < 2; conn++) {
+		if ((fd = accept(srv->listen_fd, NULL, NULL)) < 0)
+			break;
+		fill = 0;
+		while ((len = recv(fd, buf + fill, sizeof(buf) - fill - 1, 0)) > 0) {
+			fill += len;
+			buf[fill] = '\0';
+			line = buf;
+			while ((nl = strchr(line, '\n'))) {
+				*nl = '\0';
+				server_command(fd, line);
+				line = nl + 1;
+			}
+			fill = strlen(line);
+			memmove(buf, line, fill);
+		}
+		close(fd);
+	}
+
+	return NULL;
+}
+
+static void server_start(struct server *srv)
+{
+	struct sockaddr_in addr;
+	socklen_t addrlen;
+
+	srv->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	fail_unless(srv->listen_fd >= 0, "socket() failed.");
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	addrlen = sizeof(addr);
+	fail_unless(bind(srv->listen_fd, (struct sockaddr *)&addr, addrlen) == 0,
+		"bind() failed.");
+	fail_unless(listen(srv->listen_fd, 2) == 0, "listen() failed.");
+	fail_unless(getsockname(srv->listen_fd, (struct sockaddr *)&addr,
+		&addrlen) == 0, "getsockname() failed.");
+	srv->port = ntohs(addr.sin_port);
+
+	srv->thread = g_thread_new("bl-server", server_thread, srv);
+}
+
+static void server_stop(struct server *srv)
+{
+	g_thread_join(srv->thread);
+	close(srv->listen_fd);
+}
+
+struct received {
+	uint64_t bytes;
+	gboolean mismatch;
+	gboolean end;
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_logic *logic;
+	const uint8_t *data;
+	struct received *rx;
+	uint64_t i;
+
+	(void)sdi;
+
+	rx = cb_data;
+	if (packet->type == SR_DF_END)
+		rx->end = TRUE;
+	if (packet->type != SR_DF_LOGIC)
+		return;
+
+	logic = packet->payload;
+	data = logic->data;
+	for (i = 0; i < logic->length; i++) {
+		if (data[i] != ((rx->bytes + i) & 0xff))
+			rx->mismatch = TRUE;
+	}
+	rx->bytes += logic->length;
+}
+
+/* Check that a complete stream arrives in order, without gaps. */
+START_TEST(test_tcp_stream)
+{
+	struct server srv;
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	struct sr_session *session;
+	struct sr_config src[2];
+	struct received rx;
+	GSList *options, *devices;
+	char *conn;
+	int ret;
+
+	server_start(&srv);
+
+	driver = srtest_driver_get("beaglelogic");
+	srtest_driver_init(srtest_ctx, driver);
+
+	conn = g_strdup_printf("tcp/127.0.0.1/%d/nodelay/quickack", srv.port);
+	src[0].key = SR_CONF_CONN;
+	src[0].data = g_variant_ref_sink(g_variant_new_string(conn));
+	src[1].key = SR_CONF_NUM_LOGIC_CHANNELS;
+	src[1].data = g_variant_ref_sink(g_variant_new_int32(8));
+	options = g_slist_append(NULL, &src[0]);
+	options = g_slist_append(options, &src[1]);
+	devices = sr_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(src[0].data);
+	g_variant_unref(src[1].data);
+	g_free(conn);
+	fail_unless(devices != NULL, "Stand-in server not detected.");
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	ret = sr_session_new(srtest_ctx, &session);
+	fail_unless(ret == SR_OK, "sr_session_new() failed: %d.", ret);
+	ret = sr_session_dev_add(session, sdi);
+	fail_unless(ret == SR_OK, "sr_session_dev_add() failed: %d.", ret);
+	ret = sr_dev_open(sdi);
+	fail_unless(ret == SR_OK, "sr_dev_open() failed: %d.", ret);
+	ret = sr_config_set(sdi, NULL, SR_CONF_LIMIT_SAMPLES,
+		g_variant_new_uint64(NUM_SAMPLES));
+	fail_unless(ret == SR_OK, "Failed to set sample limit: %d.", ret);
+
+	memset(&rx, 0, sizeof(rx));
+	sr_session_datafeed_callback_add(session, datafeed_in, &rx);
+	ret = sr_session_start(session);
+	fail_unless(ret == SR_OK, "sr_session_start() failed: %d.", ret);
+	ret = sr_session_run(session);
+	fail_unless(ret == SR_OK, "sr_session_run() failed: %d.", ret);
+
+	fail_unless(rx.end, "No end packet received.");
+	fail_unless(rx.bytes == NUM_SAMPLES, "Received %" PRIu64 " bytes.",
+		rx.bytes);
+	fail_unless(!rx.mismatch, "Received data does not match.");
+
+	sr_dev_close(sdi);
+	sr_session_destroy(session);
+	server_stop(&srv);
+}
+END_TEST
+
+#endif
+
+Suite *suite_beaglelogic_tcp(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("beaglelogic-tcp");
+
+	tc = tcase_create("stream");
+#if defined(HAVE_HW_BEAGLELOGIC) && !defined(_WIN32)
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_tcp_stream);
+#endif
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,175 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmarks, which print their timings rather than check anything.
+ * They are not part of "make check", build them with "make tests/bench".
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libsigrok/libsigrok.h>
+#include "../src/libsigrok-internal.h"
+
+#define NUM_LIST_VALUES	(1000 * 1000)
+
+/*
+ * Compare sr_parse_floatv() against splitting the list and converting
+ * each element, like the SCPI helpers used to do.
+ */
+static void bench_parse_floatv(void)
+{
+	GString *list;
+	GArray *array;
+	gchar **tokens, **ptr;
+	float *values, tmp;
+	gint64 start, split_us, parse_us;
+	size_t count, i;
+	int ret;
+
+	list = g_string_sized_new(NUM_LIST_VALUES * 14);
+	for (i = 0; i < NUM_LIST_VALUES; i++)
+		g_string_append_printf(list, "%s%+.5E", i ? "," : "",
+			((int)(i * 7919 % 2001) - 1000) * 1e-3);
+
+	start = g_get_monotonic_time();
+	array = g_array_sized_new(FALSE, FALSE, sizeof(float), 256);
+	tokens = g_strsplit(list->str, ",", 0);
+	for (ptr = tokens; *ptr; ptr++) {
+		tmp = g_ascii_strtod(*ptr, NULL);
+		g_array_append_val(array, tmp);
+	}
+	g_strfreev(tokens);
+	split_us = g_get_monotonic_time() - start;
+
+	values = g_malloc(NUM_LIST_VALUES * sizeof(float));
+	start = g_get_monotonic_time();
+	ret = sr_parse_floatv(list->str, values, NUM_LIST_VALUES, &count);
+	parse_us = g_get_monotonic_time() - start;
+
+	printf("sr_parse_floatv: %d values, split %.1f ms, parse %.1f ms%s.\n",
+		NUM_LIST_VALUES, split_us / 1000.0, parse_us / 1000.0,
+		(ret != SR_OK || count != array->len
+			|| memcmp(values, array->data, count * sizeof(float)))
+		? ", results DIFFER" : "");
+
+	g_free(values);
+	g_array_free(array, TRUE);
+	g_string_free(list, TRUE);
+}
+
+/* Same for sr_parse_uint8v(), against converting with strtol(). */
+static void bench_parse_uint8v(void)
+{
+	GString *list;
+	GArray *array;
+	gchar **tokens, **ptr;
+	uint8_t *values, tmp;
+	gint64 start, split_us, parse_us;
+	size_t count, i;
+	int ret;
+
+	list = g_string_sized_new(NUM_LIST_VALUES * 4);
+	for (i = 0; i < NUM_LIST_VALUES; i++)
+		g_string_append_printf(list, "%s%u", i ? "," : "",
+			(unsigned int)(i * 7919 % 256));
+
+	start = g_get_monotonic_time();
+	array = g_array_sized_new(FALSE, FALSE, sizeof(uint8_t), 256);
+	tokens = g_strsplit(list->str, ",", 0);
+	for (ptr = tokens; *ptr; ptr++) {
+		tmp = strtol(*ptr, NULL, 10);
+		g_array_append_val(array, tmp);
+	}
+	g_strfreev(tokens);
+	split_us = g_get_monotonic_time() - start;
+
+	values = g_malloc(NUM_LIST_VALUES);
+	start = g_get_monotonic_time();
+	ret = sr_parse_uint8v(list->str, values, NUM_LIST_VALUES, &count);
+	parse_us = g_get_monotonic_time() - start;
+
+	printf("sr_parse_uint8v: %d values, split %.1f ms, parse %.1f ms%s.\n",
+		NUM_LIST_VALUES, split_us / 1000.0, parse_us / 1000.0,
+		(ret != SR_OK || count != array->len
+			|| memcmp(values, array->data, count))
+		? ", results DIFFER" : "");
+
+	g_free(values);
+	g_array_free(array, TRUE);
+	g_string_free(list, TRUE);
+}
+
+static gint64 startup_time(void)
+{
+	struct sr_context *sr_ctx;
+	struct sr_dev_driver **drivers;
+	GSList *devices;
+	gint64 start;
+	int i;
+
+	start = g_get_monotonic_time();
+	if (sr_init(&sr_ctx) != SR_OK)
+		return -1;
+	drivers = sr_driver_list(sr_ctx);
+	for (i = 0; drivers[i]; i++) {
+		if (!strcmp(drivers[i]->name, "demo"))
+			break;
+	}
+	devices = NULL;
+	if (drivers[i] && sr_driver_init(sr_ctx, drivers[i]) == SR_OK)
+		devices = sr_driver_scan(drivers[i], NULL);
+	sr_exit(sr_ctx);
+	if (!devices)
+		return -1;
+	g_slist_free(devices);
+
+	return g_get_monotonic_time() - start;
+}
+
+/* Start-up of a program using one driver: sr_init(), a scan, sr_exit(). */
+static void bench_startup(void)
+{
+	gint64 lazy, checked;
+
+	sr_log_loglevel_set(SR_LOG_WARN);
+	g_unsetenv("SIGROK_SANITY_CHECKS");
+	lazy = startup_time();
+	g_setenv("SIGROK_SANITY_CHECKS", "1", TRUE);
+	checked = startup_time();
+	g_unsetenv("SIGROK_SANITY_CHECKS");
+
+	if (lazy < 0 || checked < 0) {
+		printf("Start-up: demo driver not available.\n");
+		return;
+	}
+	printf("Start-up and demo scan: %.2f ms, %.2f ms with sanity checks.\n",
+		lazy / 1000.0, checked / 1000.0);
+}
+
+int main(void)
+{
+	bench_parse_floatv();
+	bench_parse_uint8v();
+	bench_startup();
+
+	return 0;
+}
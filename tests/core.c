@@ -19,6 +19,7 @@
 
 #include <config.h>
 #include <stdlib.h>
+#include <string.h>
 #include <check.h>
 #include <libsigrok/libsigrok.h>
 #include "lib.h"
@@ -162,6 +163,50 @@ START_TEST(test_exit_null)
 }
 END_TEST
 
+#if defined(HAVE_HW_DEMO) && defined(HAVE_LIBUSB_1_0)
+static int libusb_log(void *cb_data, int loglevel, const char *format,
+		va_list args)
+{
+	(void)loglevel;
+	(void)args;
+
+	if (!strcmp(format, "backend: Initialized libusb."))
+		(*(int *)cb_data)++;
+
+	return SR_OK;
+}
+
+/* Check that libusb is only set up once a driver is initialized. */
+START_TEST(test_libusb_deferred)
+{
+	struct sr_context *sr_ctx;
+	struct sr_dev_driver **drivers;
+	int i, ret, num_inits;
+
+	num_inits = 0;
+	sr_log_callback_set(libusb_log, &num_inits);
+
+	ret = sr_init(&sr_ctx);
+	fail_unless(ret == SR_OK, "sr_init() failed: %d.", ret);
+	fail_unless(num_inits == 0, "libusb set up by sr_init().");
+
+	drivers = sr_driver_list(sr_ctx);
+	for (i = 0; drivers[i]; i++) {
+		if (!strcmp(drivers[i]->name, "demo"))
+			break;
+	}
+	fail_unless(drivers[i] != NULL, "demo driver not found.");
+	ret = sr_driver_init(sr_ctx, drivers[i]);
+	fail_unless(ret == SR_OK, "sr_driver_init() failed: %d.", ret);
+	fail_unless(num_inits == 1, "libusb not set up.");
+
+	ret = sr_exit(sr_ctx);
+	fail_unless(ret == SR_OK, "sr_exit() failed: %d.", ret);
+	sr_log_callback_set_default();
+}
+END_TEST
+#endif
+
 Suite *suite_core(void)
 {
 	Suite *s;
@@ -179,5 +224,11 @@ Suite *suite_core(void)
 	tcase_add_test(tc, test_exit_null);
 	suite_add_tcase(s, tc);
 
+	tc = tcase_create("startup");
+#if defined(HAVE_HW_DEMO) && defined(HAVE_LIBUSB_1_0)
+	tcase_add_test(tc, test_libusb_deferred);
+#endif
+	suite_add_tcase(s, tc);
+
 	return s;
 }
@@ -19,6 +19,8 @@
 
 #include <config.h>
 #include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
 #include <check.h>
 #include <libsigrok/libsigrok.h>
 #include "lib.h"
@@ -40,6 +42,216 @@ START_TEST(test_driver_init_all)
 }
 END_TEST
 
+#ifdef HAVE_HW_DEMO
+/*
+ * Check that several keys can be set and read back at once, and that
+ * keys the device doesn't know are left unset, without failing the rest.
+ */
+START_TEST(test_config_multi)
+{
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	struct sr_config src[3];
+	GSList *devices;
+	int ret;
+
+	driver = srtest_driver_get("demo");
+	srtest_driver_init(srtest_ctx, driver);
+	devices = sr_driver_scan(driver, NULL);
+	fail_unless(devices != NULL, "No demo device found.");
+	sdi = devices->data;
+	g_slist_free(devices);
+	ret = sr_dev_open(sdi);
+	fail_unless(ret == SR_OK, "sr_dev_open() failed: %d.", ret);
+
+	src[0].key = SR_CONF_SAMPLERATE;
+	src[0].data = g_variant_new_uint64(SR_KHZ(19));
+	src[1].key = SR_CONF_LIMIT_SAMPLES;
+	src[1].data = g_variant_new_uint64(1234);
+	ret = sr_config_set_multi(sdi, NULL, src, 2);
+	fail_unless(ret == SR_OK, "sr_config_set_multi() failed: %d.", ret);
+
+	src[2].key = SR_CONF_VOLTAGE;
+	ret = sr_config_get_multi(driver, sdi, NULL, src, 3);
+	fail_unless(ret == SR_OK, "sr_config_get_multi() failed: %d.", ret);
+	fail_unless(src[0].data && g_variant_get_uint64(src[0].data) == SR_KHZ(19),
+		"Incorrect samplerate.");
+	fail_unless(src[1].data && g_variant_get_uint64(src[1].data) == 1234,
+		"Incorrect sample limit.");
+	fail_unless(src[2].data == NULL, "Got a value for an unknown key.");
+	g_variant_unref(src[0].data);
+	g_variant_unref(src[1].data);
+
+	sr_dev_close(sdi);
+}
+END_TEST
+
+static void scan_all_cb(struct sr_dev_driver *driver, GSList *devices,
+		void *cb_data)
+{
+	unsigned int *num_demo;
+
+	num_demo = cb_data;
+	if (!strcmp(driver->name, "demo"))
+		*num_demo += g_slist_length(devices);
+}
+
+/*
+ * Check that a concurrent scan reports the devices found, and adds them
+ * to the driver's list of instances.
+ */
+START_TEST(test_scan_all)
+{
+	struct sr_dev_driver *drivers[2];
+	unsigned int num_demo;
+	GSList *devices;
+	int ret;
+
+	drivers[0] = srtest_driver_get("demo");
+	drivers[1] = NULL;
+	num_demo = 0;
+	ret = sr_driver_scan_all(srtest_ctx, drivers, NULL, 10 * 1000 * 1000,
+		scan_all_cb, &num_demo);
+	fail_unless(ret == SR_OK, "sr_driver_scan_all() failed: %d.", ret);
+	fail_unless(num_demo == 1, "Found %u demo devices.", num_demo);
+
+	devices = sr_dev_list(drivers[0]);
+	fail_unless(g_slist_length(devices) == 1,
+		"%u demo devices in the driver's list.", g_slist_length(devices));
+}
+END_TEST
+
+/*
+ * Drop the devices from the discovery cache file, keeping the rest, or
+ * have them carry a serial number the devices don't have.
+ */
+static void discovery_edit_devices(const char *path, gboolean forget)
+{
+	GKeyFile *kf;
+	char **groups, *data;
+	unsigned int i;
+	gsize len;
+
+	kf = g_key_file_new();
+	fail_unless(g_key_file_load_from_file(kf, path, G_KEY_FILE_NONE, NULL),
+		"Discovery cache not written.");
+	groups = g_key_file_get_groups(kf, NULL);
+	for (i = 0; groups[i]; i++) {
+		if (!g_str_has_prefix(groups[i], "device "))
+			continue;
+		if (forget)
+			g_key_file_remove_group(kf, groups[i], NULL);
+		else
+			g_key_file_set_string(kf, groups[i], "serial_num",
+				"gone");
+	}
+	g_strfreev(groups);
+	data = g_key_file_to_data(kf, &len, NULL);
+	fail_unless(g_file_set_contents(path, data, len, NULL),
+		"Failed to rewrite the discovery cache.");
+	g_free(data);
+	g_key_file_free(kf);
+}
+
+static unsigned int scan_demo(struct sr_dev_driver **drivers)
+{
+	unsigned int num_demo;
+	int ret;
+
+	num_demo = 0;
+	ret = sr_driver_scan_all(srtest_ctx, drivers, NULL, 10 * 1000 * 1000,
+		scan_all_cb, &num_demo);
+	fail_unless(ret == SR_OK, "sr_driver_scan_all() failed: %d.", ret);
+
+	return num_demo;
+}
+
+/*
+ * Check that scans use the discovery cache: a driver which found nothing
+ * before isn't scanned again until the cache is invalidated.
+ */
+START_TEST(test_scan_cached)
+{
+	struct sr_dev_driver *drivers[2];
+	unsigned int num_demo;
+	char *dir, *path;
+	int ret;
+
+	dir = g_dir_make_tmp("sr-discovery-XXXXXX", NULL);
+	fail_unless(dir != NULL, "Failed to create temporary directory.");
+	path = g_build_filename(dir, "discovery.ini", NULL);
+	ret = sr_discovery_cache_enable(srtest_ctx, path);
+	fail_unless(ret == SR_OK, "sr_discovery_cache_enable() failed: %d.",
+		ret);
+
+	drivers[0] = srtest_driver_get("demo");
+	drivers[1] = NULL;
+	num_demo = scan_demo(drivers);
+	fail_unless(num_demo == 1, "Found %u demo devices.", num_demo);
+
+	/* Have the cache say that the demo driver found nothing. */
+	discovery_edit_devices(path, TRUE);
+	ret = sr_discovery_cache_enable(srtest_ctx, path);
+	fail_unless(ret == SR_OK, "sr_discovery_cache_enable() failed: %d.",
+		ret);
+	num_demo = scan_demo(drivers);
+	fail_unless(num_demo == 0, "Demo driver scanned despite the cache.");
+
+	sr_discovery_cache_invalidate(srtest_ctx);
+	num_demo = scan_demo(drivers);
+	fail_unless(num_demo == 1, "Found %u demo devices.", num_demo);
+
+	sr_discovery_cache_invalidate(srtest_ctx);
+	g_rmdir(dir);
+	g_free(path);
+	g_free(dir);
+}
+END_TEST
+
+/*
+ * Check that a driver whose cached devices are gone scans in full, and
+ * that only the devices of that scan end up in the driver's list.
+ */
+START_TEST(test_scan_cache_stale)
+{
+	struct sr_dev_driver *drivers[2];
+	unsigned int num_demo;
+	GSList *devices;
+	char *dir, *path;
+	int ret;
+
+	dir = g_dir_make_tmp("sr-discovery-XXXXXX", NULL);
+	fail_unless(dir != NULL, "Failed to create temporary directory.");
+	path = g_build_filename(dir, "discovery.ini", NULL);
+	ret = sr_discovery_cache_enable(srtest_ctx, path);
+	fail_unless(ret == SR_OK, "sr_discovery_cache_enable() failed: %d.",
+		ret);
+
+	drivers[0] = srtest_driver_get("demo");
+	drivers[1] = NULL;
+	num_demo = scan_demo(drivers);
+	fail_unless(num_demo == 1, "Found %u demo devices.", num_demo);
+	sr_dev_clear(drivers[0]);
+
+	/* The cached device doesn't match what the driver finds now. */
+	discovery_edit_devices(path, FALSE);
+	ret = sr_discovery_cache_enable(srtest_ctx, path);
+	fail_unless(ret == SR_OK, "sr_discovery_cache_enable() failed: %d.",
+		ret);
+	num_demo = scan_demo(drivers);
+	fail_unless(num_demo == 1, "Found %u demo devices.", num_demo);
+	devices = sr_dev_list(drivers[0]);
+	fail_unless(g_slist_length(devices) == 1,
+		"%u demo devices in the driver's list.", g_slist_length(devices));
+
+	sr_discovery_cache_invalidate(srtest_ctx);
+	g_rmdir(dir);
+	g_free(path);
+	g_free(dir);
+}
+END_TEST
+#endif
+
 /*
  * Check whether setting a samplerate works.
  *
@@ -70,6 +282,12 @@ Suite *suite_driver_all(void)
 	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
 	tcase_add_test(tc, test_driver_available);
 	tcase_add_test(tc, test_driver_init_all);
+#ifdef HAVE_HW_DEMO
+	tcase_add_test(tc, test_config_multi);
+	tcase_add_test(tc, test_scan_all);
+	tcase_add_test(tc, test_scan_cached);
+	tcase_add_test(tc, test_scan_cache_stale);
+#endif
 	// TODO: Currently broken.
 	// tcase_add_test(tc, test_config_get_set_samplerate);
 	suite_add_tcase(s, tc);
@@ -24,6 +24,12 @@
 #include <glib/gstdio.h>
 #include <check.h>
 #include <libsigrok/libsigrok.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
 #include "lib.h"
 
 struct sr_context *srtest_ctx;
@@ -160,3 +166,119 @@ GArray *srtest_get_enabled_logic_channels(const struct sr_dev_inst *sdi)
 
 	return channels;
 }
+
+#ifndef _WIN32
+static void scpi_server_message(struct srtest_scpi_server *srv, int fd,
+		char *message)
+{
+	GString *reply;
+	char **units, *unit;
+	gsize len;
+	ssize_t ret;
+	unsigned int i;
+
+	g_atomic_int_inc(&srv->num_messages);
+
+	reply = g_string_sized_new(256);
+	units = g_strsplit(message, ";", 0);
+	for (i = 0; units[i]; i++) {
+		unit = g_strstrip(units[i]);
+		if (*unit == ':')
+			unit++;
+		len = reply->len;
+		if (!srv->handler(unit, reply, srv->cb_data) && strchr(unit, '?'))
+			g_string_append_c(reply, '0');
+		if (len && reply->len > len)
+			g_string_insert_c(reply, len, ';');
+	}
+	g_strfreev(units);
+
+	if (!reply->len) {
+		g_string_free(reply, TRUE);
+		return;
+	}
+
+	g_string_append_c(reply, '\n');
+	len = srv->split ? reply->len / 2 : reply->len;
+	ret = send(fd, reply->str, len, 0);
+	if (len < reply->len)
+		ret = send(fd, reply->str + len, reply->len - len, 0);
+	(void)ret;
+	g_string_free(reply, TRUE);
+}
+
+static gpointer scpi_server_thread(gpointer data)
+{
+	struct srtest_scpi_server *srv;
+	char buf[1024], *line, *nl;
+	size_t fill;
+	ssize_t len;
+	int fd, conn;
+
+	srv = data;
+	for (conn = 0; conn < srv->num_conns; conn++) {
+		if ((fd = accept(srv->listen_fd, NULL, NULL)) < 0)
+			break;
+		fill = 0;
+		while ((len = recv(fd, buf + fill, sizeof(buf) - fill - 1, 0)) > 0) {
+			fill += len;
+			buf[fill] = '\0';
+			line = buf;
+			while ((nl = strchr(line, '\n'))) {
+				*nl = '\0';
+				scpi_server_message(srv, fd, line);
+				line = nl + 1;
+			}
+			fill = strlen(line);
+			memmove(buf, line, fill);
+		}
+		close(fd);
+	}
+
+	return NULL;
+}
+
+/*
+ * Start a stand-in SCPI instrument. It answers each message with one
+ * response message, joining the responses to compound queries with ';'.
+ * It serves srv->num_conns connections (default 2: scan and device),
+ * then exits.
+ */
+void srtest_scpi_server_start(struct srtest_scpi_server *srv)
+{
+	struct sockaddr_in addr;
+	socklen_t addrlen;
+
+	if (!srv->num_conns)
+		srv->num_conns = 2;
+
+	srv->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	fail_unless(srv->listen_fd >= 0, "socket() failed.");
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	addrlen = sizeof(addr);
+	fail_unless(bind(srv->listen_fd, (struct sockaddr *)&addr, addrlen) == 0,
+		"bind() failed.");
+	fail_unless(listen(srv->listen_fd, 2) == 0, "listen() failed.");
+	fail_unless(getsockname(srv->listen_fd, (struct sockaddr *)&addr,
+		&addrlen) == 0, "getsockname() failed.");
+	srv->port = ntohs(addr.sin_port);
+
+	srv->thread = g_thread_new("scpi-server", scpi_server_thread, srv);
+}
+
+void srtest_scpi_server_stop(struct srtest_scpi_server *srv)
+{
+	g_thread_join(srv->thread);
+	close(srv->listen_fd);
+}
+
+/* Connection string for the stand-in, to be g_free()d. */
+char *srtest_scpi_server_conn(const struct srtest_scpi_server *srv)
+{
+	return g_strdup_printf("tcp-raw/127.0.0.1/%d", srv->port);
+}
+#endif
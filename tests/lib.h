@@ -41,6 +41,35 @@ void srtest_check_samplerate(struct sr_context *sr_ctx, const char *drivername,
 
 GArray *srtest_get_enabled_logic_channels(const struct sr_dev_inst *sdi);
 
+#ifndef _WIN32
+/*
+ * Handler for the program message units a stand-in SCPI instrument
+ * receives, with any leading ':' removed. Appends the response to reply
+ * for queries, returns FALSE for units it doesn't know.
+ */
+typedef gboolean (*srtest_scpi_handler)(const char *unit, GString *reply,
+		void *cb_data);
+
+/* Stand-in SCPI instrument on a local raw TCP socket. */
+struct srtest_scpi_server {
+	int listen_fd;
+	int port;
+	GThread *thread;
+	/* Number of connections to serve before the server exits. */
+	int num_conns;
+	/* Send each response in two parts. */
+	gboolean split;
+	/* Number of program messages received so far. */
+	int num_messages;
+	srtest_scpi_handler handler;
+	void *cb_data;
+};
+
+void srtest_scpi_server_start(struct srtest_scpi_server *srv);
+void srtest_scpi_server_stop(struct srtest_scpi_server *srv);
+char *srtest_scpi_server_conn(const struct srtest_scpi_server *srv);
+#endif
+
 Suite *suite_core(void);
 Suite *suite_driver_all(void);
 Suite *suite_input_all(void);
@@ -53,5 +82,11 @@ Suite *suite_version(void);
 Suite *suite_device(void);
 Suite *suite_trigger(void);
 Suite *suite_analog(void);
+Suite *suite_baylibre_acme(void);
+Suite *suite_beaglelogic_tcp(void);
+Suite *suite_scpi_tcp(void);
+Suite *suite_rigol_ds_tcp(void);
+Suite *suite_maynuo_m97_rtu(void);
+Suite *suite_serial_meter(void);
 
 #endif
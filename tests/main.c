@@ -29,6 +29,9 @@ int main(void)
 	Suite *s;
 	SRunner *srunner;
 
+	/* Have sr_init() check all drivers and modules. */
+	g_setenv("SIGROK_SANITY_CHECKS", "1", TRUE);
+
 	s = suite_create("mastersuite");
 	srunner = srunner_create(s);
 
@@ -45,6 +48,12 @@ int main(void)
 	srunner_add_suite(srunner, suite_device());
 	srunner_add_suite(srunner, suite_trigger());
 	srunner_add_suite(srunner, suite_analog());
+	srunner_add_suite(srunner, suite_baylibre_acme());
+	srunner_add_suite(srunner, suite_beaglelogic_tcp());
+	srunner_add_suite(srunner, suite_scpi_tcp());
+	srunner_add_suite(srunner, suite_rigol_ds_tcp());
+	srunner_add_suite(srunner, suite_maynuo_m97_rtu());
+	srunner_add_suite(srunner, suite_serial_meter());
 
 	srunner_run_all(srunner, CK_VERBOSE);
 	ret = srunner_ntests_failed(srunner);
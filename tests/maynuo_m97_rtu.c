@@ -0,0 +1,445 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* posix_openpt() and friends. */
+#define _XOPEN_SOURCE 600
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#if defined(HAVE_HW_MAYNUO_M97) && defined(HAVE_LIBSERIALPORT) && !defined(_WIN32)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define NUM_POLLS	20
+
+#define COIL_BASE	0x0500
+#define NUM_COILS	0x28
+#define REG_BASE	0x0A00
+#define NUM_REGS	0x108
+
+/* Addresses of the maynuo-m97 register map which the test looks at. */
+#define ISTATE		0x0510
+#define IOVER		0x0520
+#define UOVER		0x0521
+#define HEAT		0x0523
+#define UNREG		0x0525
+#define IFIX		0x0A01
+#define UFIX		0x0A03
+#define IMAX		0x0A34
+#define UMAX		0x0A36
+#define U		0x0B00
+#define I		0x0B02
+#define SETMODE		0x0B04
+#define MODEL		0x0B06
+#define EDITION		0x0B07
+
+/*
+ * Stand-in for a Maynuo M9812 electronic load, answering Modbus RTU
+ * requests on the master side of a pseudo terminal. The driver opens the
+ * slave side as its serial port.
+ */
+struct load {
+	int fd;
+	char *port;
+	GThread *thread;
+	gint stop;
+	gint transactions;
+	uint8_t coils[NUM_COILS];
+	uint16_t regs[NUM_REGS];
+};
+
+static uint16_t rtu_crc(const uint8_t *buf, size_t len)
+{
+	uint16_t crc;
+	int i;
+
+	crc = 0xFFFF;
+	while (len--) {
+		crc ^= *buf++;
+		for (i = 0; i < 8; i++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+	}
+
+	return crc;
+}
+
+static void load_set_float(struct load *load, int address, float value)
+{
+	uint32_t u;
+
+	memcpy(&u, &value, sizeof(u));
+	load->regs[address - REG_BASE] = u >> 16;
+	load->regs[address - REG_BASE + 1] = u & 0xFFFF;
+}
+
+static void load_reply(struct load *load, uint8_t *reply, size_t len)
+{
+	uint16_t crc;
+	ssize_t ret;
+
+	crc = rtu_crc(reply, len);
+	reply[len++] = crc & 0xFF;
+	reply[len++] = crc >> 8;
+	ret = write(load->fd, reply, len);
+	(void)ret;
+}
+
+/* Handle one complete request frame. */
+static void load_request(struct load *load, const uint8_t *req)
+{
+	uint8_t reply[256];
+	int address, count, i;
+
+	address = (req[2] << 8) | req[3];
+	count = (req[4] << 8) | req[5];
+	reply[0] = req[0];
+	reply[1] = req[1];
+	g_atomic_int_inc(&load->transactions);
+
+	switch (req[1]) {
+	case 0x01:
+		if (address < COIL_BASE || address + count > COIL_BASE + NUM_COILS)
+			break;
+		reply[2] = (count + 7) / 8;
+		memset(reply + 3, 0, reply[2]);
+		for (i = 0; i < count; i++)
+			reply[3 + i / 8] |= load->coils[address - COIL_BASE + i] << (i % 8);
+		load_reply(load, reply, 3 + reply[2]);
+		return;
+	case 0x03:
+		if (address < REG_BASE || address + count > REG_BASE + NUM_REGS)
+			break;
+		reply[2] = 2 * count;
+		for (i = 0; i < count; i++) {
+			reply[3 + 2 * i] = load->regs[address - REG_BASE + i] >> 8;
+			reply[4 + 2 * i] = load->regs[address - REG_BASE + i] & 0xFF;
+		}
+		load_reply(load, reply, 3 + reply[2]);
+		return;
+	case 0x05:
+		if (address < COIL_BASE || address >= COIL_BASE + NUM_COILS)
+			break;
+		load->coils[address - COIL_BASE] = count == 0xFF00;
+		memcpy(reply, req, 6);
+		load_reply(load, reply, 6);
+		return;
+	case 0x10:
+		if (address < REG_BASE || address + count > REG_BASE + NUM_REGS)
+			break;
+		for (i = 0; i < count; i++)
+			load->regs[address - REG_BASE + i] =
+				(req[7 + 2 * i] << 8) | req[8 + 2 * i];
+		memcpy(reply, req, 6);
+		load_reply(load, reply, 6);
+		return;
+	}
+
+	/* Illegal data address. */
+	reply[1] |= 0x80;
+	reply[2] = 0x02;
+	load_reply(load, reply, 3);
+}
+
+/* Length of the request frame at the start of buf, 0 if incomplete. */
+static size_t frame_length(const uint8_t *buf, size_t len)
+{
+	size_t need;
+
+	if (len < 7)
+		return 0;
+	need = buf[1] == 0x10 ? 9 + buf[6] : 8;
+
+	return len >= need ? need : 0;
+}
+
+static gpointer load_thread(gpointer data)
+{
+	struct load *load;
+	struct pollfd pfd;
+	uint8_t buf[512];
+	size_t fill, flen;
+	ssize_t len;
+
+	load = data;
+	fill = 0;
+	while (!g_atomic_int_get(&load->stop)) {
+		pfd.fd = load->fd;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, 10) <= 0 || !(pfd.revents & POLLIN)) {
+			/* The slave side isn't open (POLLHUP), wait for it. */
+			if (pfd.revents & POLLHUP)
+				g_usleep(1000);
+			continue;
+		}
+		len = read(load->fd, buf + fill, sizeof(buf) - fill);
+		if (len <= 0) {
+			if (len < 0 && errno != EIO && errno != EAGAIN)
+				break;
+			g_usleep(1000);
+			continue;
+		}
+		fill += len;
+		while ((flen = frame_length(buf, fill))) {
+			if (rtu_crc(buf, flen) == 0 && buf[0] == 1)
+				load_request(load, buf);
+			memmove(buf, buf + flen, fill - flen);
+			fill -= flen;
+		}
+		if (fill == sizeof(buf))
+			fill = 0;
+	}
+
+	return NULL;
+}
+
+static void load_start(struct load *load)
+{
+	struct termios tio;
+
+	memset(load, 0, sizeof(*load));
+	load->fd = posix_openpt(O_RDWR | O_NOCTTY);
+	fail_unless(load->fd >= 0, "posix_openpt() failed.");
+	fail_unless(grantpt(load->fd) == 0 && unlockpt(load->fd) == 0,
+		"Failed to unlock the pseudo terminal.");
+	load->port = g_strdup(ptsname(load->fd));
+
+	/* No line discipline, the frames are binary. */
+	fail_unless(tcgetattr(load->fd, &tio) == 0, "tcgetattr() failed.");
+	tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR
+		| ICRNL | IXON);
+	tio.c_oflag &= ~OPOST;
+	tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+	tio.c_cflag &= ~(CSIZE | PARENB);
+	tio.c_cflag |= CS8;
+	tcsetattr(load->fd, TCSANOW, &tio);
+
+	load->regs[MODEL - REG_BASE] = 101;
+	load->regs[EDITION - REG_BASE] = 12;
+	load->regs[SETMODE - REG_BASE] = 1;
+	load->coils[ISTATE - COIL_BASE] = 1;
+	load->coils[UOVER - COIL_BASE] = 1;
+	load_set_float(load, U, 12.5);
+	load_set_float(load, I, 1.25);
+	load_set_float(load, UFIX, 13.0);
+	load_set_float(load, IFIX, 2.0);
+	load_set_float(load, UMAX, 150.0);
+	load_set_float(load, IMAX, 30.0);
+
+	load->thread = g_thread_new("m97-load", load_thread, load);
+}
+
+static void load_stop(struct load *load)
+{
+	g_atomic_int_set(&load->stop, 1);
+	g_thread_join(load->thread);
+	close(load->fd);
+	g_free(load->port);
+}
+
+static struct sr_dev_inst *load_device(struct load *load,
+		struct sr_dev_driver **driver)
+{
+	struct sr_dev_inst *sdi;
+	struct sr_config src;
+	GSList *options, *devices;
+	int ret;
+
+	*driver = srtest_driver_get("maynuo-m97");
+	srtest_driver_init(srtest_ctx, *driver);
+
+	src.key = SR_CONF_CONN;
+	src.data = g_variant_ref_sink(g_variant_new_string(load->port));
+	options = g_slist_append(NULL, &src);
+	devices = sr_driver_scan(*driver, options);
+	g_slist_free(options);
+	g_variant_unref(src.data);
+	fail_unless(devices != NULL, "Stand-in load not detected.");
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	ret = sr_dev_open(sdi);
+	fail_unless(ret == SR_OK, "sr_dev_open() failed: %d.", ret);
+
+	return sdi;
+}
+
+static const uint32_t poll_keys[] = {
+	SR_CONF_VOLTAGE,
+	SR_CONF_CURRENT,
+	SR_CONF_VOLTAGE_TARGET,
+	SR_CONF_CURRENT_LIMIT,
+	SR_CONF_OVER_VOLTAGE_PROTECTION_THRESHOLD,
+	SR_CONF_OVER_CURRENT_PROTECTION_THRESHOLD,
+	SR_CONF_ENABLED,
+	SR_CONF_REGULATION,
+	SR_CONF_OVER_VOLTAGE_PROTECTION_ACTIVE,
+	SR_CONF_OVER_CURRENT_PROTECTION_ACTIVE,
+	SR_CONF_OVER_TEMPERATURE_PROTECTION_ACTIVE,
+};
+
+static void get_all(struct sr_dev_driver *driver, struct sr_dev_inst *sdi,
+		struct sr_config *src)
+{
+	struct sr_channel_group *cg;
+	unsigned int i;
+	int ret;
+
+	cg = sr_dev_inst_channel_groups_get(sdi)->data;
+	for (i = 0; i < G_N_ELEMENTS(poll_keys); i++)
+		src[i].key = poll_keys[i];
+	ret = sr_config_get_multi(driver, sdi, cg, src, G_N_ELEMENTS(poll_keys));
+	fail_unless(ret == SR_OK, "sr_config_get_multi() failed: %d.", ret);
+	for (i = 0; i < G_N_ELEMENTS(poll_keys); i++)
+		fail_unless(src[i].data != NULL, "No value for key %u.", i);
+}
+
+static void free_all(struct sr_config *src)
+{
+	unsigned int i;
+
+	for (i = 0; i < G_N_ELEMENTS(poll_keys); i++)
+		g_variant_unref(src[i].data);
+}
+
+/* Check that batched reads return the right values, with few requests. */
+START_TEST(test_get_multi)
+{
+	struct load load;
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	struct sr_channel_group *cg;
+	struct sr_config src[G_N_ELEMENTS(poll_keys)];
+	int ret, before, first, second;
+
+	load_start(&load);
+	sdi = load_device(&load, &driver);
+	cg = sr_dev_inst_channel_groups_get(sdi)->data;
+
+	before = g_atomic_int_get(&load.transactions);
+	get_all(driver, sdi, src);
+	first = g_atomic_int_get(&load.transactions) - before;
+	fail_unless(g_variant_get_double(src[0].data) == 12.5, "Wrong voltage.");
+	fail_unless(g_variant_get_double(src[1].data) == 1.25, "Wrong current.");
+	fail_unless(g_variant_get_double(src[2].data) == 13.0,
+		"Wrong voltage target.");
+	fail_unless(g_variant_get_double(src[3].data) == 2.0,
+		"Wrong current limit.");
+	fail_unless(g_variant_get_double(src[4].data) == 150.0,
+		"Wrong OVP threshold.");
+	fail_unless(g_variant_get_double(src[5].data) == 30.0,
+		"Wrong OCP threshold.");
+	fail_unless(g_variant_get_boolean(src[6].data), "Wrong input state.");
+	fail_unless(!strcmp(g_variant_get_string(src[7].data, NULL), "CC"),
+		"Wrong regulation.");
+	fail_unless(g_variant_get_boolean(src[8].data), "Wrong OVP state.");
+	fail_unless(!g_variant_get_boolean(src[9].data), "Wrong OCP state.");
+	fail_unless(!g_variant_get_boolean(src[10].data), "Wrong OTP state.");
+	free_all(src);
+
+	/* Settings come from the cache now. */
+	before = g_atomic_int_get(&load.transactions);
+	get_all(driver, sdi, src);
+	second = g_atomic_int_get(&load.transactions) - before;
+	free_all(src);
+	fail_unless(first <= 4 && second < first,
+		"%d and %d requests for %d keys.", first, second,
+		(int)G_N_ELEMENTS(poll_keys));
+
+	/* A write drops cached values. */
+	ret = sr_config_set(sdi, cg, SR_CONF_VOLTAGE_TARGET,
+		g_variant_new_double(14.0));
+	fail_unless(ret == SR_OK, "sr_config_set() failed: %d.", ret);
+	get_all(driver, sdi, src);
+	fail_unless(g_variant_get_double(src[2].data) == 14.0,
+		"Stale voltage target.");
+	free_all(src);
+
+	sr_dev_close(sdi);
+	load_stop(&load);
+}
+END_TEST
+
+/*
+ * Check that measured values are read on every poll, while the settings
+ * keep coming from the cache.
+ */
+START_TEST(test_poll_fresh)
+{
+	struct load load;
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	struct sr_config src[G_N_ELEMENTS(poll_keys)];
+	int i, before, first, requests;
+
+	load_start(&load);
+	sdi = load_device(&load, &driver);
+
+	before = g_atomic_int_get(&load.transactions);
+	get_all(driver, sdi, src);
+	first = g_atomic_int_get(&load.transactions) - before;
+	free_all(src);
+
+	for (i = 0; i < NUM_POLLS; i++) {
+		load_set_float(&load, U, 10.0 + i);
+		before = g_atomic_int_get(&load.transactions);
+		get_all(driver, sdi, src);
+		requests = g_atomic_int_get(&load.transactions) - before;
+		fail_unless(g_variant_get_double(src[0].data) == 10.0 + i,
+			"Stale voltage in poll %d.", i);
+		fail_unless(g_variant_get_double(src[2].data) == 13.0,
+			"Wrong voltage target in poll %d.", i);
+		fail_unless(requests > 0 && requests < first,
+			"%d requests in poll %d, %d in the first one.",
+			requests, i, first);
+		free_all(src);
+	}
+
+	sr_dev_close(sdi);
+	load_stop(&load);
+}
+END_TEST
+
+#endif
+
+Suite *suite_maynuo_m97_rtu(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("maynuo-m97-rtu");
+
+	tc = tcase_create("modbus");
+#if defined(HAVE_HW_MAYNUO_M97) && defined(HAVE_LIBSERIALPORT) && !defined(_WIN32)
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_get_multi);
+	tcase_add_test(tc, test_poll_fresh);
+#endif
+	suite_add_tcase(s, tc);
+
+	return s;
+}
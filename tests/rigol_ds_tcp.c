@@ -0,0 +1,285 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#if defined(HAVE_HW_RIGOL_DS) && !defined(_WIN32)
+
+#define NUM_CHANNELS	4
+#define NUM_FRAMES	10
+#define FRAME_SAMPLES	1200
+
+/*
+ * Stand-in for a Rigol DS1104Z in live mode. Waveform data is a counting
+ * pattern, offset per channel. Vertical settings are 1 V/div, no offset
+ * and a reference of 127, so that a sample value v stands for
+ * (v - 127) / 25.6 V.
+ */
+struct scope {
+	int source;
+	unsigned int start;
+	unsigned int stop;
+	/* *OPC? queries since the last data request. */
+	unsigned int num_opc;
+	/* Data requests for channels after the first one of a frame. */
+	unsigned int num_later_requests;
+	/* Those of them which took more than one *OPC? round trip. */
+	unsigned int num_unbatched;
+};
+
+static const struct {
+	const char *query;
+	const char *response;
+} scope_responses[] = {
+	{ "*IDN?", "RIGOL TECHNOLOGIES,DS1104Z,DS1ZA000000001,00.04.04.SP3" },
+	{ "*OPC?", "1" },
+	{ "*ESR?", "0" },
+	{ "TIM:SCAL?", "5.000000e-07" },
+	{ "TIM:OFFS?", "0.000000e+00" },
+	{ "TRIG:EDGE:SOUR?", "CHAN1" },
+	{ "TRIG:EDGE:SLOP?", "POS" },
+	{ "TRIG:EDGE:LEV?", "0.000000e+00" },
+	{ "TRIG:STAT?", "TD" },
+	{ "WAV:YREF?", "127" },
+};
+
+static uint8_t scope_sample(int source, unsigned int i)
+{
+	return (i + 16 * source) & 0xff;
+}
+
+static gboolean scope_handler(const char *unit, GString *reply,
+		void *cb_data)
+{
+	struct scope *scope;
+	const char *p;
+	unsigned int i;
+
+	scope = cb_data;
+
+	if (!strcmp(unit, "*OPC?"))
+		scope->num_opc++;
+
+	for (i = 0; i < G_N_ELEMENTS(scope_responses); i++) {
+		if (g_ascii_strcasecmp(unit, scope_responses[i].query))
+			continue;
+		g_string_append(reply, scope_responses[i].response);
+		return TRUE;
+	}
+
+	if (g_str_has_prefix(unit, "CHAN") && (p = strchr(unit, ':'))) {
+		if (!strcmp(p, ":DISP?") || !strcmp(p, ":PROB?"))
+			g_string_append(reply, "1");
+		else if (!strcmp(p, ":SCAL?"))
+			g_string_append(reply, "1.000000e+00");
+		else if (!strcmp(p, ":OFFS?"))
+			g_string_append(reply, "0.000000e+00");
+		else if (!strcmp(p, ":COUP?"))
+			g_string_append(reply, "DC");
+		else
+			return FALSE;
+		return TRUE;
+	}
+
+	if (sscanf(unit, "WAV:SOUR CHAN%d", &scope->source) == 1)
+		return TRUE;
+	if (sscanf(unit, "WAV:START %u", &scope->start) == 1)
+		return TRUE;
+	if (sscanf(unit, "WAV:STOP %u", &scope->stop) == 1)
+		return TRUE;
+	if (!strcmp(unit, "WAV:DATA?")) {
+		if (scope->source > 1) {
+			scope->num_later_requests++;
+			if (scope->num_opc != 1)
+				scope->num_unbatched++;
+		}
+		scope->num_opc = 0;
+		g_string_append_printf(reply, "#9%09u",
+			scope->stop - scope->start + 1);
+		for (i = scope->start - 1; i < scope->stop; i++)
+			g_string_append_c(reply, scope_sample(scope->source, i));
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+struct received {
+	uint64_t samples[NUM_CHANNELS];
+	unsigned int frames;
+	gboolean mismatch;
+	gboolean native;
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_analog *analog;
+	struct sr_channel *ch;
+	struct received *rx;
+	float *values, expected;
+	uint32_t i;
+	uint64_t n;
+
+	(void)sdi;
+
+	rx = cb_data;
+	if (packet->type == SR_DF_FRAME_END)
+		rx->frames++;
+	if (packet->type != SR_DF_ANALOG)
+		return;
+
+	analog = packet->payload;
+	ch = analog->meaning->channels->data;
+	if (ch->index >= NUM_CHANNELS || analog->encoding->is_float == rx->native) {
+		rx->mismatch = TRUE;
+		return;
+	}
+
+	values = g_malloc(analog->num_samples * sizeof(float));
+	sr_analog_to_float(analog, values);
+	n = rx->samples[ch->index] % FRAME_SAMPLES;
+	for (i = 0; i < analog->num_samples; i++) {
+		expected = (scope_sample(ch->index + 1, n + i) - 127) / 25.6;
+		if (fabsf(values[i] - expected) > 0.001)
+			rx->mismatch = TRUE;
+	}
+	g_free(values);
+	rx->samples[ch->index] += analog->num_samples;
+}
+
+static void run_frames(gboolean native)
+{
+	struct srtest_scpi_server srv;
+	struct scope scope;
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	struct sr_session *session;
+	struct sr_config src;
+	struct received rx;
+	GSList *options, *devices;
+	unsigned int i;
+	char *conn;
+	int ret;
+
+	memset(&scope, 0, sizeof(scope));
+	memset(&srv, 0, sizeof(srv));
+	srv.handler = scope_handler;
+	srv.cb_data = &scope;
+	srtest_scpi_server_start(&srv);
+
+	driver = srtest_driver_get("rigol-ds");
+	srtest_driver_init(srtest_ctx, driver);
+
+	conn = srtest_scpi_server_conn(&srv);
+	src.key = SR_CONF_CONN;
+	src.data = g_variant_ref_sink(g_variant_new_string(conn));
+	options = g_slist_append(NULL, &src);
+	devices = sr_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(src.data);
+	g_free(conn);
+	fail_unless(devices != NULL, "Stand-in scope not detected.");
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	ret = sr_session_new(srtest_ctx, &session);
+	fail_unless(ret == SR_OK, "sr_session_new() failed: %d.", ret);
+	ret = sr_session_dev_add(session, sdi);
+	fail_unless(ret == SR_OK, "sr_session_dev_add() failed: %d.", ret);
+	ret = sr_dev_open(sdi);
+	fail_unless(ret == SR_OK, "sr_dev_open() failed: %d.", ret);
+	ret = sr_config_set(sdi, NULL, SR_CONF_LIMIT_FRAMES,
+		g_variant_new_uint64(NUM_FRAMES));
+	fail_unless(ret == SR_OK, "Failed to set frame limit: %d.", ret);
+	ret = sr_config_set(sdi, NULL, SR_CONF_ANALOG_NATIVE,
+		g_variant_new_boolean(native));
+	fail_unless(ret == SR_OK, "Failed to set native encoding: %d.", ret);
+
+	memset(&rx, 0, sizeof(rx));
+	rx.native = native;
+	sr_session_datafeed_callback_add(session, datafeed_in, &rx);
+	ret = sr_session_start(session);
+	fail_unless(ret == SR_OK, "sr_session_start() failed: %d.", ret);
+	ret = sr_session_run(session);
+	fail_unless(ret == SR_OK, "sr_session_run() failed: %d.", ret);
+
+	fail_unless(rx.frames == NUM_FRAMES, "Received %u frames.", rx.frames);
+	for (i = 0; i < NUM_CHANNELS; i++)
+		fail_unless(rx.samples[i] == NUM_FRAMES * FRAME_SAMPLES,
+			"Received %" PRIu64 " samples on CH%u.", rx.samples[i],
+			i + 1);
+	fail_unless(!rx.mismatch, "Received data does not match.");
+
+	sr_dev_close(sdi);
+	sr_session_destroy(session);
+	srtest_scpi_server_stop(&srv);
+
+	/*
+	 * The next channel's data gets requested ahead, with its settings
+	 * confirmed by a single *OPC? query.
+	 */
+	fail_unless(scope.num_later_requests == NUM_FRAMES * (NUM_CHANNELS - 1),
+		"%u data requests for later channels.",
+		scope.num_later_requests);
+	fail_unless(scope.num_unbatched == 0,
+		"%u data requests took several round trips.",
+		scope.num_unbatched);
+}
+
+/* Check that frames of all channels arrive complete and in order. */
+START_TEST(test_live_frames)
+{
+	run_frames(FALSE);
+}
+END_TEST
+
+/* Same, with the scope's samples passed along unconverted. */
+START_TEST(test_live_frames_native)
+{
+	run_frames(TRUE);
+}
+END_TEST
+
+#endif
+
+Suite *suite_rigol_ds_tcp(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("rigol-ds-tcp");
+
+	tc = tcase_create("live");
+#if defined(HAVE_HW_RIGOL_DS) && !defined(_WIN32)
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_live_frames);
+	tcase_add_test(tc, test_live_frames_native);
+#endif
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,428 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#if defined(HAVE_HW_SCPI_PPS) && !defined(_WIN32)
+
+#define NUM_QUERIES	100
+
+/*
+ * Minimal stand-in for a SCPI power supply (HP 6632B). Each response is
+ * sent in two parts, so that the client has to reassemble it.
+ */
+static const struct {
+	const char *query;
+	const char *response;
+} server_responses[] = {
+	{ "*IDN?", "HP,6632B,0,A.01.01" },
+	{ "OUTP:STAT?", "1" },
+	{ "MEAS:VOLT?", "+4.998000E+00" },
+	{ "MEAS:CURR?", "+1.250000E-01" },
+	{ "SOUR:VOLT?", "+5.000000E+00" },
+	{ "SOUR:CURR?", "+1.000000E+00" },
+};
+
+static gboolean server_handler(const char *unit, GString *reply,
+		void *cb_data)
+{
+	unsigned int i;
+
+	(void)cb_data;
+
+	for (i = 0; i < G_N_ELEMENTS(server_responses); i++) {
+		if (g_ascii_strcasecmp(unit, server_responses[i].query))
+			continue;
+		g_string_append(reply, server_responses[i].response);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void server_start(struct srtest_scpi_server *srv)
+{
+	memset(srv, 0, sizeof(*srv));
+	srv->split = TRUE;
+	srv->handler = server_handler;
+	srtest_scpi_server_start(srv);
+}
+
+static struct sr_dev_inst *server_device(struct srtest_scpi_server *srv,
+		struct sr_dev_driver **driver)
+{
+	struct sr_dev_inst *sdi;
+	struct sr_config src;
+	GSList *options, *devices;
+	char *conn;
+	int ret;
+
+	*driver = srtest_driver_get("scpi-pps");
+	srtest_driver_init(srtest_ctx, *driver);
+
+	conn = srtest_scpi_server_conn(srv);
+	src.key = SR_CONF_CONN;
+	src.data = g_variant_ref_sink(g_variant_new_string(conn));
+	options = g_slist_append(NULL, &src);
+	devices = sr_driver_scan(*driver, options);
+	g_slist_free(options);
+	g_variant_unref(src.data);
+	g_free(conn);
+	fail_unless(devices != NULL, "Stand-in server not detected.");
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	ret = sr_dev_open(sdi);
+	fail_unless(ret == SR_OK, "sr_dev_open() failed: %d.", ret);
+
+	return sdi;
+}
+
+/* Check that fragmented and compound responses are read correctly. */
+START_TEST(test_responses)
+{
+	struct srtest_scpi_server srv;
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	struct sr_channel_group *cg;
+	struct sr_config src[4];
+	GVariant *gvar;
+	unsigned int i;
+	int ret;
+
+	server_start(&srv);
+	sdi = server_device(&srv, &driver);
+	cg = sr_dev_inst_channel_groups_get(sdi)->data;
+
+	for (i = 0; i < 10; i++) {
+		gvar = NULL;
+		ret = sr_config_get(driver, sdi, cg, SR_CONF_VOLTAGE_TARGET, &gvar);
+		fail_unless(ret == SR_OK, "sr_config_get() failed: %d.", ret);
+		fail_unless(g_variant_get_double(gvar) == 5.0,
+			"Incorrect voltage target.");
+		g_variant_unref(gvar);
+	}
+
+	src[0].key = SR_CONF_VOLTAGE;
+	src[1].key = SR_CONF_CURRENT;
+	src[2].key = SR_CONF_CURRENT_LIMIT;
+	src[3].key = SR_CONF_ENABLED;
+	ret = sr_config_get_multi(driver, sdi, cg, src, 4);
+	fail_unless(ret == SR_OK, "sr_config_get_multi() failed: %d.", ret);
+	for (i = 0; i < 4; i++)
+		fail_unless(src[i].data != NULL, "No value for key %u.", i);
+	fail_unless(g_variant_get_double(src[0].data) == 4.998,
+		"Incorrect voltage.");
+	fail_unless(g_variant_get_double(src[1].data) == 0.125,
+		"Incorrect current.");
+	fail_unless(g_variant_get_double(src[2].data) == 1.0,
+		"Incorrect current limit.");
+	fail_unless(g_variant_get_boolean(src[3].data),
+		"Incorrect output state.");
+	for (i = 0; i < 4; i++)
+		g_variant_unref(src[i].data);
+
+	sr_dev_close(sdi);
+	srtest_scpi_server_stop(&srv);
+}
+END_TEST
+
+/*
+ * Check that every query costs exactly one round trip, even though the
+ * responses arrive in parts.
+ */
+START_TEST(test_round_trips)
+{
+	struct srtest_scpi_server srv;
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	struct sr_channel_group *cg;
+	GVariant *gvar;
+	unsigned int i;
+	int ret, num_messages;
+
+	server_start(&srv);
+	sdi = server_device(&srv, &driver);
+	cg = sr_dev_inst_channel_groups_get(sdi)->data;
+
+	/* Have the channel selected, if the device needs that. */
+	gvar = NULL;
+	ret = sr_config_get(driver, sdi, cg, SR_CONF_VOLTAGE, &gvar);
+	fail_unless(ret == SR_OK, "sr_config_get() failed: %d.", ret);
+	g_variant_unref(gvar);
+
+	num_messages = g_atomic_int_get(&srv.num_messages);
+	for (i = 0; i < NUM_QUERIES; i++) {
+		gvar = NULL;
+		ret = sr_config_get(driver, sdi, cg, SR_CONF_VOLTAGE, &gvar);
+		fail_unless(ret == SR_OK, "sr_config_get() failed: %d.", ret);
+		fail_unless(g_variant_get_double(gvar) == 4.998,
+			"Incorrect voltage.");
+		g_variant_unref(gvar);
+	}
+	num_messages = g_atomic_int_get(&srv.num_messages) - num_messages;
+	fail_unless(num_messages == NUM_QUERIES,
+		"%d queries took %d messages.", NUM_QUERIES, num_messages);
+
+	sr_dev_close(sdi);
+	srtest_scpi_server_stop(&srv);
+}
+END_TEST
+
+#endif
+
+#if defined(HAVE_HW_HP_3457A) && !defined(_WIN32)
+
+/* HP 3457A stand-in, which reports the revision from cb_data. */
+static gboolean hp_3457a_handler(const char *unit, GString *reply,
+		void *cb_data)
+{
+	if (!g_ascii_strcasecmp(unit, "ID?"))
+		g_string_append(reply, "HP3457A");
+	else if (!g_ascii_strcasecmp(unit, "REV?"))
+		g_string_append(reply, cb_data);
+	else
+		return FALSE;
+
+	return TRUE;
+}
+
+static void check_revision(struct sr_dev_driver *driver, const char *rev,
+		const char *expected)
+{
+	struct srtest_scpi_server srv;
+	struct sr_dev_inst *sdi;
+	struct sr_config src;
+	GSList *options, *devices;
+	const char *version;
+	char *conn;
+
+	memset(&srv, 0, sizeof(srv));
+	srv.num_conns = 1;
+	srv.handler = hp_3457a_handler;
+	srv.cb_data = (void *)rev;
+	srtest_scpi_server_start(&srv);
+
+	conn = srtest_scpi_server_conn(&srv);
+	src.key = SR_CONF_CONN;
+	src.data = g_variant_ref_sink(g_variant_new_string(conn));
+	options = g_slist_append(NULL, &src);
+	devices = sr_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(src.data);
+	g_free(conn);
+	fail_unless(devices != NULL, "Stand-in server not detected.");
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	version = sr_dev_inst_version_get(sdi);
+	fail_unless(version && !strcmp(version, expected),
+		"REV? '%s' gave version %s, expected %s.", rev, version,
+		expected);
+
+	srtest_scpi_server_stop(&srv);
+}
+
+/* Float lists reach sr_scpi_get_floatv() through the revision query. */
+START_TEST(test_floatv)
+{
+	struct sr_dev_driver *driver;
+
+	driver = srtest_driver_get("hp-3457a");
+	srtest_driver_init(srtest_ctx, driver);
+
+	check_revision(driver, "12,3", "12.3");
+	check_revision(driver, "+1.2E+01, 3.9E0", "12.3");
+	check_revision(driver, "1,2,3", "1.2");
+	/* Lists with invalid elements are rejected as a whole. */
+	check_revision(driver, "12,,3", "0.0");
+	check_revision(driver, "12,x", "0.0");
+}
+END_TEST
+
+#endif
+
+#if defined(HAVE_HW_HAMEG_HMO) && !defined(_WIN32)
+
+#define CACHE_TTL_US	(5 * 1000 * 1000)
+
+/*
+ * Hameg HMO1002 stand-in with CH1 enabled, counting the queries of its
+ * timebase (a cached setting) and acquired points (live, never cached).
+ */
+struct hmo_scope {
+	int num_timebase;
+	int num_points;
+};
+
+static gboolean hmo_handler(const char *unit, GString *reply, void *cb_data)
+{
+	struct hmo_scope *scope;
+
+	scope = cb_data;
+
+	if (!strcmp(unit, "*IDN?")) {
+		g_string_append(reply, "HAMEG,HMO1002,000000000,05.527");
+	} else if (!strcmp(unit, "*OPC?") || !strcmp(unit, "CHAN1:STAT?")) {
+		g_string_append(reply, "1");
+	} else if (!strcmp(unit, "TIM:SCAL?")) {
+		g_atomic_int_inc(&scope->num_timebase);
+		g_string_append(reply, "1.000000E-03");
+	} else if (!strcmp(unit, "CHAN1:DATA:POINTS?")) {
+		g_atomic_int_inc(&scope->num_points);
+		g_string_append(reply, "10000");
+	} else if (!strcmp(unit, "TRIG:A:SOUR?")) {
+		g_string_append(reply, "CH1");
+	} else if (!strcmp(unit, "TRIG:A:EDGE:SLOP?")) {
+		g_string_append(reply, "POS");
+	} else if (g_str_has_prefix(unit, "CHAN")
+			&& g_str_has_suffix(unit, ":SCAL?")) {
+		g_string_append(reply, "1.000000E+00");
+	} else if (g_str_has_prefix(unit, "CHAN")
+			&& g_str_has_suffix(unit, ":COUP?")) {
+		g_string_append(reply, "DC");
+	} else {
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void hmo_reopen(struct sr_dev_inst *sdi)
+{
+	int ret;
+
+	sr_dev_close(sdi);
+	ret = sr_dev_open(sdi);
+	fail_unless(ret == SR_OK, "sr_dev_open() failed: %d.", ret);
+}
+
+static void hmo_check(struct hmo_scope *scope, int num_timebase,
+		int num_points, const char *what)
+{
+	fail_unless(g_atomic_int_get(&scope->num_timebase) == num_timebase,
+		"%s: %d timebase queries, expected %d.", what,
+		g_atomic_int_get(&scope->num_timebase), num_timebase);
+	fail_unless(g_atomic_int_get(&scope->num_points) == num_points,
+		"%s: %d points queries, expected %d.", what,
+		g_atomic_int_get(&scope->num_points), num_points);
+}
+
+/*
+ * Opening the device reads the scope's state, querying the timebase
+ * twice. Check which of those queries reach the instrument.
+ */
+START_TEST(test_cache)
+{
+	struct srtest_scpi_server srv;
+	struct hmo_scope scope;
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	struct sr_config src;
+	GSList *options, *devices;
+	char *conn;
+	int ret;
+
+	memset(&scope, 0, sizeof(scope));
+	memset(&srv, 0, sizeof(srv));
+	/* Scan, and four opens. */
+	srv.num_conns = 5;
+	srv.handler = hmo_handler;
+	srv.cb_data = &scope;
+	srtest_scpi_server_start(&srv);
+
+	driver = srtest_driver_get("hameg-hmo");
+	srtest_driver_init(srtest_ctx, driver);
+
+	conn = srtest_scpi_server_conn(&srv);
+	src.key = SR_CONF_CONN;
+	src.data = g_variant_ref_sink(g_variant_new_string(conn));
+	options = g_slist_append(NULL, &src);
+	devices = sr_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(src.data);
+	g_free(conn);
+	fail_unless(devices != NULL, "Stand-in scope not detected.");
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	ret = sr_dev_open(sdi);
+	fail_unless(ret == SR_OK, "sr_dev_open() failed: %d.", ret);
+	hmo_check(&scope, 1, 1, "First open");
+
+	hmo_reopen(sdi);
+	hmo_check(&scope, 1, 2, "Cached");
+
+	/* Setting the timebase drops all responses, and reads the points. */
+	ret = sr_config_set(sdi, NULL, SR_CONF_TIMEBASE,
+		g_variant_new("(tt)", (guint64)1, (guint64)1000));
+	fail_unless(ret == SR_OK, "Failed to set timebase: %d.", ret);
+	hmo_check(&scope, 1, 3, "Set");
+	hmo_reopen(sdi);
+	hmo_check(&scope, 2, 4, "Invalidated");
+
+	g_usleep(CACHE_TTL_US + 100 * 1000);
+	hmo_reopen(sdi);
+	hmo_check(&scope, 3, 5, "Expired");
+
+	sr_dev_close(sdi);
+	srtest_scpi_server_stop(&srv);
+}
+END_TEST
+
+#endif
+
+Suite *suite_scpi_tcp(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("scpi-tcp");
+
+	tc = tcase_create("transport");
+#if defined(HAVE_HW_SCPI_PPS) && !defined(_WIN32)
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_responses);
+	tcase_add_test(tc, test_round_trips);
+#endif
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("floatv");
+#if defined(HAVE_HW_HP_3457A) && !defined(_WIN32)
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_floatv);
+#endif
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("cache");
+#if defined(HAVE_HW_HAMEG_HMO) && !defined(_WIN32)
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	/* Waits for the cached responses to expire. */
+	tcase_set_timeout(tc, 15);
+	tcase_add_test(tc, test_cache);
+#endif
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,416 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* posix_openpt() and friends. */
+#define _XOPEN_SOURCE 600
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#if (defined(HAVE_HW_BRYMEN_DMM) || defined(HAVE_HW_SERIAL_DMM)) \
+	&& defined(HAVE_LIBSERIALPORT) && !defined(_WIN32)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define MAX_PACKETS	16
+
+/*
+ * Stand-in for a multimeter which sends one reading per request, on the
+ * master side of a pseudo terminal. The driver opens the slave side as
+ * its serial port.
+ */
+struct meter {
+	int fd;
+	char *port;
+	GThread *thread;
+	gint stop;
+	/* Stop reading requests, so that the driver's writes back up. */
+	gint stalled;
+	/* Number of requests left to answer, negative to answer all. */
+	gint budget;
+	size_t request_len;
+	const uint8_t *reply;
+	size_t reply_len;
+};
+
+/* Take one reading from the budget, if there is any left. */
+static gboolean meter_take(struct meter *meter)
+{
+	int budget;
+
+	do {
+		budget = g_atomic_int_get(&meter->budget);
+		if (budget == 0)
+			return FALSE;
+		if (budget < 0)
+			return TRUE;
+	} while (!g_atomic_int_compare_and_exchange(&meter->budget,
+			budget, budget - 1));
+
+	return TRUE;
+}
+
+static gpointer meter_thread(gpointer data)
+{
+	struct meter *meter;
+	struct pollfd pfd;
+	uint8_t buf[64];
+	size_t fill;
+	ssize_t len;
+
+	meter = data;
+	fill = 0;
+	while (!g_atomic_int_get(&meter->stop)) {
+		if (g_atomic_int_get(&meter->stalled)) {
+			g_usleep(1000);
+			continue;
+		}
+		pfd.fd = meter->fd;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, 10) <= 0 || !(pfd.revents & POLLIN)) {
+			/* The slave side isn't open (POLLHUP), wait for it. */
+			if (pfd.revents & POLLHUP)
+				g_usleep(1000);
+			continue;
+		}
+		len = read(meter->fd, buf + fill, sizeof(buf) - fill);
+		if (len <= 0) {
+			if (len < 0 && errno != EIO && errno != EAGAIN)
+				break;
+			g_usleep(1000);
+			continue;
+		}
+		fill += len;
+		while (fill >= meter->request_len) {
+			if (meter_take(meter)
+					&& write(meter->fd, meter->reply,
+						meter->reply_len) < 0)
+				break;
+			fill -= meter->request_len;
+			memmove(buf, buf + meter->request_len, fill);
+		}
+	}
+
+	return NULL;
+}
+
+static void meter_start(struct meter *meter, size_t request_len,
+		const uint8_t *reply, size_t reply_len)
+{
+	struct termios tio;
+
+	memset(meter, 0, sizeof(*meter));
+	meter->fd = posix_openpt(O_RDWR | O_NOCTTY);
+	fail_unless(meter->fd >= 0, "posix_openpt() failed.");
+	fail_unless(grantpt(meter->fd) == 0 && unlockpt(meter->fd) == 0,
+		"Failed to unlock the pseudo terminal.");
+	meter->port = g_strdup(ptsname(meter->fd));
+
+	/* No line discipline, some of the packets are binary. */
+	fail_unless(tcgetattr(meter->fd, &tio) == 0, "tcgetattr() failed.");
+	tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR
+		| ICRNL | IXON);
+	tio.c_oflag &= ~OPOST;
+	tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+	tio.c_cflag &= ~(CSIZE | PARENB);
+	tio.c_cflag |= CS8;
+	tcsetattr(meter->fd, TCSANOW, &tio);
+
+	meter->budget = -1;
+	meter->request_len = request_len;
+	meter->reply = reply;
+	meter->reply_len = reply_len;
+	meter->thread = g_thread_new("meter", meter_thread, meter);
+}
+
+static void meter_stop(struct meter *meter)
+{
+	g_atomic_int_set(&meter->stop, 1);
+	g_thread_join(meter->thread);
+	close(meter->fd);
+	g_free(meter->port);
+}
+
+static struct sr_dev_inst *meter_device(struct meter *meter,
+		const char *drivername, struct sr_session **session)
+{
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	struct sr_config src;
+	GSList *options, *devices;
+	int ret;
+
+	driver = srtest_driver_get(drivername);
+	srtest_driver_init(srtest_ctx, driver);
+
+	src.key = SR_CONF_CONN;
+	src.data = g_variant_ref_sink(g_variant_new_string(meter->port));
+	options = g_slist_append(NULL, &src);
+	devices = sr_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(src.data);
+	fail_unless(devices != NULL, "Stand-in meter not detected.");
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	ret = sr_session_new(srtest_ctx, session);
+	fail_unless(ret == SR_OK, "sr_session_new() failed: %d.", ret);
+	ret = sr_session_dev_add(*session, sdi);
+	fail_unless(ret == SR_OK, "sr_session_dev_add() failed: %d.", ret);
+	ret = sr_dev_open(sdi);
+	fail_unless(ret == SR_OK, "sr_dev_open() failed: %d.", ret);
+
+	return sdi;
+}
+
+struct received {
+	struct meter *meter;
+	unsigned int readings;
+	unsigned int packets;
+	uint64_t num_samples[MAX_PACKETS];
+	gboolean mismatch;
+	/* Stall the meter after this many readings, 0 for never. */
+	unsigned int stall_after;
+	/* Readings to add to the meter's budget with the first packet. */
+	int refill;
+};
+
+/* Fill the slave side's output, so that the next request times out. */
+static void block_requests(struct meter *meter)
+{
+	uint8_t buf[256];
+	int fd;
+
+	g_atomic_int_set(&meter->stalled, 1);
+	fd = open(meter->port, O_WRONLY | O_NONBLOCK | O_NOCTTY);
+	fail_unless(fd >= 0, "Failed to open %s.", meter->port);
+	memset(buf, 0, sizeof(buf));
+	while (write(fd, buf, sizeof(buf)) > 0)
+		;
+	close(fd);
+}
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_analog *analog;
+	struct received *rx;
+	float values[MAX_PACKETS * 4];
+	unsigned int i;
+
+	(void)sdi;
+
+	rx = cb_data;
+	if (packet->type != SR_DF_ANALOG)
+		return;
+
+	analog = packet->payload;
+	if (rx->packets < MAX_PACKETS)
+		rx->num_samples[rx->packets] = analog->num_samples;
+	rx->packets++;
+	if (analog->num_samples > G_N_ELEMENTS(values)) {
+		rx->mismatch = TRUE;
+		return;
+	}
+	sr_analog_to_float(analog, values);
+	for (i = 0; i < analog->num_samples; i++) {
+		if (fabsf(values[i] - 1.234f) > 1e-4)
+			rx->mismatch = TRUE;
+	}
+	rx->readings += analog->num_samples;
+
+	if (rx->stall_after && rx->readings >= rx->stall_after) {
+		rx->stall_after = 0;
+		block_requests(rx->meter);
+	}
+	if (rx->refill) {
+		g_atomic_int_add(&rx->meter->budget, rx->refill);
+		rx->refill = 0;
+	}
+}
+
+static void run_session(struct sr_session *session, struct received *rx)
+{
+	int ret;
+
+	sr_session_datafeed_callback_add(session, datafeed_in, rx);
+	ret = sr_session_start(session);
+	fail_unless(ret == SR_OK, "sr_session_start() failed: %d.", ret);
+	ret = sr_session_run(session);
+	fail_unless(ret == SR_OK, "sr_session_run() failed: %d.", ret);
+	fail_unless(!rx->mismatch, "Received data does not match.");
+}
+
+#endif
+
+#if defined(HAVE_HW_BRYMEN_DMM) && defined(HAVE_LIBSERIALPORT) \
+	&& !defined(_WIN32)
+
+#define BRYMEN_REQUEST_LEN	8
+
+/* 1.234 V DC. */
+static const uint8_t brymen_reply[] = {
+	0x10, 0x02, 0x00, 0x0c,
+	0x06, 0x00, 0x00, 0x00, ' ', ' ', '1', '.', '2', '3', '4', ' ',
+	0x06 ^ ' ' ^ ' ' ^ '1' ^ '.' ^ '2' ^ '3' ^ '4' ^ ' ', 0x10, 0x03,
+};
+
+/*
+ * Check that the shared event source dispatches the port, and that a
+ * receive callback which returns FALSE detaches the port. The session
+ * stops once no event source is left, so it doesn't return otherwise.
+ */
+START_TEST(test_reactor_detach)
+{
+	struct meter meter;
+	struct sr_dev_inst *sdi;
+	struct sr_session *session;
+	struct received rx;
+
+	meter_start(&meter, BRYMEN_REQUEST_LEN, brymen_reply,
+		sizeof(brymen_reply));
+	sdi = meter_device(&meter, "brymen-bm857", &session);
+
+	memset(&rx, 0, sizeof(rx));
+	rx.meter = &meter;
+	rx.stall_after = 3;
+	run_session(session, &rx);
+	fail_unless(rx.readings >= 3, "Received %u readings.", rx.readings);
+
+	sr_dev_close(sdi);
+	sr_session_destroy(session);
+	meter_stop(&meter);
+}
+END_TEST
+
+#endif
+
+#if defined(HAVE_HW_SERIAL_DMM) && defined(HAVE_LIBSERIALPORT) \
+	&& !defined(_WIN32)
+
+/* 1.234 V DC, in reply to a 'D' request. */
+static const uint8_t metex14_reply[] = "DC  1.234   V\r";
+
+static void run_coalesce(uint64_t coalesce, uint64_t limit, int budget,
+		int refill, struct received *rx)
+{
+	struct meter meter;
+	struct sr_dev_inst *sdi;
+	struct sr_session *session;
+	int ret;
+
+	meter_start(&meter, 1, metex14_reply, sizeof(metex14_reply) - 1);
+	sdi = meter_device(&meter, "metex-m3860m", &session);
+	ret = sr_config_set(sdi, NULL, SR_CONF_COALESCE_SAMPLES,
+		g_variant_new_uint64(coalesce));
+	fail_unless(ret == SR_OK, "Failed to set coalescing: %d.", ret);
+	ret = sr_config_set(sdi, NULL, SR_CONF_LIMIT_SAMPLES,
+		g_variant_new_uint64(limit));
+	fail_unless(ret == SR_OK, "Failed to set sample limit: %d.", ret);
+
+	memset(rx, 0, sizeof(*rx));
+	rx->meter = &meter;
+	rx->refill = refill;
+	g_atomic_int_set(&meter.budget, budget);
+	run_session(session, rx);
+	fail_unless(rx->readings == limit, "Received %u readings.",
+		rx->readings);
+
+	sr_dev_close(sdi);
+	sr_session_destroy(session);
+	meter_stop(&meter);
+}
+
+/* Readings are sent once the configured number was collected. */
+START_TEST(test_coalesce_count)
+{
+	struct received rx;
+	unsigned int i;
+
+	run_coalesce(4, 12, -1, 0, &rx);
+	fail_unless(rx.packets == 3, "Received %u packets.", rx.packets);
+	for (i = 0; i < rx.packets; i++)
+		fail_unless(rx.num_samples[i] == 4,
+			"Packet %u has %" PRIu64 " samples.", i, rx.num_samples[i]);
+}
+END_TEST
+
+/*
+ * Readings which are held for too long are sent. The meter answers
+ * three requests, and three more once those were sent.
+ */
+START_TEST(test_coalesce_age)
+{
+	struct received rx;
+
+	run_coalesce(100, 6, 3, 3, &rx);
+	fail_unless(rx.packets == 2 && rx.num_samples[0] == 3
+		&& rx.num_samples[1] == 3, "Received %u packets.", rx.packets);
+}
+END_TEST
+
+/* Readings which are held when the acquisition stops are sent. */
+START_TEST(test_coalesce_stop)
+{
+	struct received rx;
+
+	run_coalesce(100, 5, -1, 0, &rx);
+	fail_unless(rx.packets == 1 && rx.num_samples[0] == 5,
+		"Received %u packets.", rx.packets);
+}
+END_TEST
+
+#endif
+
+Suite *suite_serial_meter(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("serial-meter");
+
+	tc = tcase_create("reactor");
+#if defined(HAVE_HW_BRYMEN_DMM) && defined(HAVE_LIBSERIALPORT) \
+	&& !defined(_WIN32)
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_reactor_detach);
+#endif
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("coalesce");
+#if defined(HAVE_HW_SERIAL_DMM) && defined(HAVE_LIBSERIALPORT) \
+	&& !defined(_WIN32)
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_coalesce_count);
+	tcase_add_test(tc, test_coalesce_age);
+	tcase_add_test(tc, test_coalesce_stop);
+#endif
+	suite_add_tcase(s, tc);
+
+	return s;
+}